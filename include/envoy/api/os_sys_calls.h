@@ -2,6 +2,7 @@
 
 #include <sys/mman.h>   // for mode_t
 #include <sys/socket.h> // for sockaddr
+#include <sys/uio.h>    // for iovec
 
 #include <memory>
 #include <string>
@@ -20,6 +21,17 @@ public:
    */
   virtual int bind(int sockfd, const sockaddr* addr, socklen_t addrlen) PURE;
 
+  /**
+   * @see socket (man 2 socket)
+   */
+  virtual int socket(int domain, int type, int protocol) PURE;
+
+  /**
+   * @see sendto (man 2 sendto)
+   */
+  virtual ssize_t sendto(int sockfd, const void* buffer, size_t length, int flags,
+                         const sockaddr* addr, socklen_t addrlen) PURE;
+
   /**
    * Open file by full_path with given flags and mode.
    * @return file descriptor.
@@ -32,6 +44,11 @@ public:
    */
   virtual ssize_t write(int fd, const void* buffer, size_t num_bytes) PURE;
 
+  /**
+   * @see writev (man 2 writev)
+   */
+  virtual ssize_t writev(int fd, const iovec* iov, int iovcnt) PURE;
+
   /**
    * Release all resources allocated for fd.
    * @return zero on success, -1 returned otherwise.
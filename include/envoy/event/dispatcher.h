@@ -142,6 +142,13 @@ public:
    */
   virtual SignalEventPtr listenForSignal(int signal_num, SignalCb cb) PURE;
 
+  /**
+   * Create the dispatcher's stats in the given scope. Must be called before the dispatcher runs.
+   * @param scope supplies the scope to create the stats in.
+   * @param prefix supplies the prefix for the stat names, e.g. "server.worker_0.".
+   */
+  virtual void initializeStats(Stats::Scope& scope, const std::string& prefix) PURE;
+
   /**
    * Post a functor to the dispatcher. This is safe cross thread. The functor runs in the context
    * of the dispatcher event loop which may be on a different thread than the caller.
@@ -181,6 +181,9 @@ struct Http1Settings {
   // Enable codec to parse absolute uris. This enables forward/explicit proxy support for non TLS
   // traffic
   bool allow_absolute_url_{false};
+  // Parse common request heads that arrive in one piece with RequestHeadParser instead of
+  // http_parser. Everything else is still handled by http_parser.
+  bool fast_request_parser_{false};
 };
 
 /**
@@ -205,6 +205,20 @@ public:
    * @return boolean telling if the connection is currently above the high watermark.
    */
   virtual bool aboveHighWatermark() const PURE;
+
+  /**
+   * Forward all further data read from this connection directly to another connection inside the
+   * kernel, without copying it through user space and without running this connection's read
+   * filters. This is only possible for plaintext connections owned by the same dispatcher when
+   * this connection has no read filter other than the caller and the peer has no write filters.
+   * Forwarding stops (and any data still in flight is handed to the peer's write buffer) when
+   * either connection closes, when a filter is added to either connection, or when data is
+   * written to the peer through write().
+   * @param peer supplies the connection that data read from this connection is written to.
+   * @return bool true if forwarding was enabled, false if the caller must keep forwarding data
+   *         itself.
+   */
+  virtual bool spliceTo(Connection& peer) PURE;
 };
 
 typedef std::unique_ptr<Connection> ConnectionPtr;
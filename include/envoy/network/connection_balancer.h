@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+
+#include "envoy/common/pure.h"
+#include "envoy/network/address.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * One of the per worker listeners that share a listen socket, as seen by a ConnectionBalancer.
+ */
+class BalancedConnectionHandler {
+public:
+  virtual ~BalancedConnectionHandler() {}
+
+  /**
+   * @return uint64_t the load of the handler: the connections of its worker, plus connections
+   *         handed off to it that it has not taken yet. Safe to call from any thread.
+   */
+  virtual uint64_t numConnections() PURE;
+
+  /**
+   * Hand off a connection accepted by another handler. Safe to call from any thread, the
+   * connection is created on the handler's own dispatcher. If the handler goes away before then,
+   * the connection is closed.
+   * @param fd supplies the accepted connection's fd.
+   * @param remote_address supplies the remote address of the connection.
+   * @param local_address supplies the local address of the connection.
+   * @param using_original_dst supplies whether the local address is the original destination.
+   */
+  virtual void post(int fd, Address::InstanceConstSharedPtr remote_address,
+                    Address::InstanceConstSharedPtr local_address, bool using_original_dst) PURE;
+};
+
+/**
+ * Moves newly accepted connections between the handlers of a listener, so that long lived
+ * connections do not pile up on whichever workers happen to accept them.
+ */
+class ConnectionBalancer {
+public:
+  virtual ~ConnectionBalancer() {}
+
+  /**
+   * Add a handler to balance connections to. Safe to call from any thread.
+   * @param handler supplies the handler.
+   */
+  virtual void registerHandler(BalancedConnectionHandler& handler) PURE;
+
+  /**
+   * Remove a handler. No connection is handed off to it once this returns. Safe to call from any
+   * thread.
+   * @param handler supplies the handler.
+   */
+  virtual void unregisterHandler(BalancedConnectionHandler& handler) PURE;
+
+  /**
+   * Called by a handler for every connection it accepts, before creating the connection. Either
+   * hands the connection off to another handler or leaves it to the caller.
+   * @param current_handler supplies the handler that accepted the connection.
+   * @param fd supplies the accepted connection's fd.
+   * @param remote_address supplies the remote address of the connection.
+   * @param local_address supplies the local address of the connection.
+   * @param using_original_dst supplies whether the local address is the original destination.
+   * @return bool true if the connection has been handed off, false if current_handler should
+   *         create it.
+   */
+  virtual bool rebalance(BalancedConnectionHandler& current_handler, int fd,
+                         Address::InstanceConstSharedPtr remote_address,
+                         Address::InstanceConstSharedPtr local_address,
+                         bool using_original_dst) PURE;
+};
+
+} // namespace Network
+} // namespace Envoy
@@ -1,11 +1,13 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 
 #include "envoy/common/exception.h"
 #include "envoy/network/connection.h"
+#include "envoy/network/connection_balancer.h"
 
 namespace Envoy {
 namespace Network {
@@ -25,6 +27,17 @@ struct ListenerOptions {
   bool use_original_dst_;
   // Soft limit on size of the listener's new connection read and write buffers.
   uint32_t per_connection_buffer_limit_bytes_;
+  // If set, accepted connections may be handed off to the listener of another worker sharing the
+  // same balancer. Not owned, it must outlive the listener.
+  ConnectionBalancer* connection_balancer_;
+  // Returns the maximum number of connections accepted per wakeup of the listener, so that a
+  // connection storm does not starve the rest of the event loop. Connections left in the accept
+  // queue are accepted in the next event loop iteration. Called on every wakeup, so that the limit
+  // can follow a runtime setting. Unset or 0 means no limit.
+  std::function<uint32_t()> max_accepts_per_wakeup_;
+  // If not 0, TCP_DEFER_ACCEPT is set on the listen socket with this many seconds: connections are
+  // only accepted once the client has sent data, or the timeout has expired.
+  uint32_t tcp_defer_accept_seconds_;
 
   /**
    * Factory for ListenerOptions with bind_to_port_ set.
@@ -34,7 +47,10 @@ struct ListenerOptions {
     return {.bind_to_port_ = true,
             .use_proxy_proto_ = false,
             .use_original_dst_ = false,
-            .per_connection_buffer_limit_bytes_ = 0};
+            .per_connection_buffer_limit_bytes_ = 0,
+            .connection_balancer_ = nullptr,
+            .max_accepts_per_wakeup_ = nullptr,
+            .tcp_defer_accept_seconds_ = 0};
   }
 };
 
@@ -26,6 +26,18 @@ public:
    * for example, 7c25513b-0466-4558-a64c-12c6704f37ed
    */
   virtual std::string uuid() PURE;
+
+  /**
+   * Write a uuid4 like uuid() does, without allocating. The randomness comes from a fast per thread
+   * pseudo random generator that is seeded from the same source as uuid(), so the result is unique
+   * but not unpredictable. It is meant for identifiers such as request IDs, not for secrets.
+   * @param out supplies the buffer to write the 36 chars of the uuid4 to. No null terminator is
+   *        written.
+   */
+  virtual void fastUuid(char* out) PURE;
+
+  // Length of the uuids returned by uuid() and written by fastUuid().
+  static const size_t UUID_LENGTH = 36;
 };
 
 typedef std::unique_ptr<RandomGenerator> RandomGeneratorPtr;
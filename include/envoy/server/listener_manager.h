@@ -1,5 +1,6 @@
 #pragma once
 
+#include "envoy/network/connection_balancer.h"
 #include "envoy/network/filter.h"
 #include "envoy/network/listen_socket.h"
 #include "envoy/server/drain_manager.h"
@@ -114,6 +115,24 @@ public:
    * @return const std::string& the listener's name.
    */
   virtual const std::string& name() const PURE;
+
+  /**
+   * @return Network::ConnectionBalancer* the balancer shared by the listener's per worker
+   *         connection handling, or nullptr if new connections stay on the accepting worker.
+   */
+  virtual Network::ConnectionBalancer* connectionBalancer() PURE;
+
+  /**
+   * @return uint32_t the maximum number of connections to accept per wakeup of the listener, or 0
+   *         for no limit. Called by the workers on every wakeup.
+   */
+  virtual uint32_t maxAcceptsPerWakeup() PURE;
+
+  /**
+   * @return uint32_t the TCP_DEFER_ACCEPT timeout in seconds to set on the listen socket, or 0 to
+   *         leave it unset.
+   */
+  virtual uint32_t tcpDeferAcceptSeconds() PURE;
 };
 
 /**
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/common/pure.h"
 #include "envoy/network/address.h"
@@ -130,6 +131,12 @@ public:
    * @return uint64_t the maximum name length of a stat.
    */
   virtual uint64_t maxStatNameLength() PURE;
+
+  /**
+   * @return const std::vector<std::string>& the name suffixes of the counters to shard per
+   *         thread.
+   */
+  virtual const std::vector<std::string>& shardedCounters() PURE;
 };
 
 } // namespace Server
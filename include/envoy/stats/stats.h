@@ -5,6 +5,8 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "envoy/common/pure.h"
 
@@ -87,33 +89,36 @@ public:
 typedef std::shared_ptr<Histogram> HistogramSharedPtr;
 
 /**
- * A sink for stats. Each sink is responsible for writing stats to a backing store.
+ * The counters and gauges written out to sinks in one flush. The buffers are meant to be reused
+ * from one flush to the next, so that flushing does not allocate once they have grown to size.
  */
-class Sink {
-public:
-  virtual ~Sink() {}
-
+struct FlushSnapshot {
   /**
-   * This will be called before a sequence of flushCounter() and flushGauge() calls. Sinks can
-   * choose to optimize writing if desired with a paired endFlush() call.
+   * Release the stats referenced by the snapshot, keeping the buffers.
    */
-  virtual void beginFlush() PURE;
+  void clear() {
+    counters_.clear();
+    gauges_.clear();
+  }
 
-  /**
-   * Flush a counter delta.
-   */
-  virtual void flushCounter(const Counter& counter, uint64_t delta) PURE;
+  // Counters that changed since the previous flush, with the amount they changed by.
+  std::vector<std::pair<CounterSharedPtr, uint64_t>> counters_;
+  // Gauges that have been used, with their current value.
+  std::vector<std::pair<GaugeSharedPtr, uint64_t>> gauges_;
+};
 
-  /**
-   * Flush a gauge value.
-   */
-  virtual void flushGauge(const Gauge& gauge, uint64_t value) PURE;
+/**
+ * A sink for stats. Each sink is responsible for writing stats to a backing store.
+ */
+class Sink {
+public:
+  virtual ~Sink() {}
 
   /**
-   * This will be called after beginFlush(), some number of flushCounter(), and some number of
-   * flushGauge(). Sinks can use this to optimize writing if desired.
+   * Flush the counters and gauges of a flush interval.
+   * @param snapshot supplies the stats to flush. @see Store::latch().
    */
-  virtual void endFlush() PURE;
+  virtual void flush(const FlushSnapshot& snapshot) PURE;
 
   /**
    * Flush a histogram value.
@@ -177,6 +182,14 @@ public:
    * @return a list of all known gauges.
    */
   virtual std::list<GaugeSharedPtr> gauges() const PURE;
+
+  /**
+   * Latch the counters that changed since the previous call into a snapshot, along with the
+   * values of all used gauges. Unlike counters() and gauges() this does not allocate once the
+   * snapshot's buffers have grown to size.
+   * @param snapshot supplies the snapshot to fill. It is cleared first.
+   */
+  virtual void latch(FlushSnapshot& snapshot) PURE;
 };
 
 /**
@@ -15,12 +15,13 @@ Event::DispatcherPtr Impl::allocateDispatcher() {
 }
 
 Impl::Impl(std::chrono::milliseconds file_flush_interval_msec)
-    : os_sys_calls_(new OsSysCallsImpl()), file_flush_interval_msec_(file_flush_interval_msec) {}
+    : os_sys_calls_(new OsSysCallsImpl()), file_flush_interval_msec_(file_flush_interval_msec),
+      file_flush_thread_(std::make_shared<Filesystem::FlushThread>()) {}
 
 Filesystem::FileSharedPtr Impl::createFile(const std::string& path, Event::Dispatcher& dispatcher,
                                            Thread::BasicLockable& lock, Stats::Store& stats_store) {
   return std::make_shared<Filesystem::FileImpl>(path, dispatcher, lock, *os_sys_calls_, stats_store,
-                                                file_flush_interval_msec_);
+                                                file_flush_interval_msec_, file_flush_thread_);
 }
 
 bool Impl::fileExists(const std::string& path) { return Filesystem::fileExists(path); }
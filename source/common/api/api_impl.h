@@ -7,6 +7,8 @@
 #include "envoy/api/os_sys_calls.h"
 #include "envoy/filesystem/filesystem.h"
 
+#include "common/filesystem/filesystem_impl.h"
+
 namespace Envoy {
 namespace Api {
 
@@ -28,6 +30,9 @@ public:
 private:
   OsSysCallsPtr os_sys_calls_;
   std::chrono::milliseconds file_flush_interval_msec_;
+  // Flushes every file created by createFile(). Each file holds a reference, so the thread stays
+  // around until the last file is gone.
+  Filesystem::FlushThreadSharedPtr file_flush_thread_;
 };
 
 } // namespace Api
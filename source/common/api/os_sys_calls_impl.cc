@@ -2,6 +2,7 @@
 
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 namespace Envoy {
@@ -11,6 +12,15 @@ int OsSysCallsImpl::bind(int sockfd, const sockaddr* addr, socklen_t addrlen) {
   return ::bind(sockfd, addr, addrlen);
 }
 
+int OsSysCallsImpl::socket(int domain, int type, int protocol) {
+  return ::socket(domain, type, protocol);
+}
+
+ssize_t OsSysCallsImpl::sendto(int sockfd, const void* buffer, size_t length, int flags,
+                               const sockaddr* addr, socklen_t addrlen) {
+  return ::sendto(sockfd, buffer, length, flags, addr, addrlen);
+}
+
 int OsSysCallsImpl::open(const std::string& full_path, int flags, int mode) {
   return ::open(full_path.c_str(), flags, mode);
 }
@@ -21,6 +31,10 @@ ssize_t OsSysCallsImpl::write(int fd, const void* buffer, size_t num_bytes) {
   return ::write(fd, buffer, num_bytes);
 }
 
+ssize_t OsSysCallsImpl::writev(int fd, const iovec* iov, int iovcnt) {
+  return ::writev(fd, iov, iovcnt);
+}
+
 int OsSysCallsImpl::shmOpen(const char* name, int oflag, mode_t mode) {
   return ::shm_open(name, oflag, mode);
 }
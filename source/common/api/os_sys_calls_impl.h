@@ -9,8 +9,12 @@ class OsSysCallsImpl : public OsSysCalls {
 public:
   // Api::OsSysCalls
   int bind(int sockfd, const sockaddr* addr, socklen_t addrlen) override;
+  int socket(int domain, int type, int protocol) override;
+  ssize_t sendto(int sockfd, const void* buffer, size_t length, int flags, const sockaddr* addr,
+                 socklen_t addrlen) override;
   int open(const std::string& full_path, int flags, int mode) override;
   ssize_t write(int fd, const void* buffer, size_t num_bytes) override;
+  ssize_t writev(int fd, const iovec* iov, int iovcnt) override;
   int close(int fd) override;
   int shmOpen(const char* name, int oflag, mode_t mode) override;
   int shmUnlink(const char* name) override;
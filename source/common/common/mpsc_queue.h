@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+
+/**
+ * Intrusive, lock-free, multi-producer single-consumer FIFO queue (D. Vyukov's MPSC node based
+ * queue). Items derive from MpscQueue::Node, so pushing does not allocate. Producers never block,
+ * each push is a single atomic exchange. The consumer never takes a lock either, but can observe
+ * a producer between the two steps of a push, in which case pop() reports an empty queue until the
+ * producer finishes. The queue does not own its items.
+ */
+class MpscQueue : NonCopyable {
+public:
+  class Node {
+  public:
+    virtual ~Node() {}
+
+  private:
+    std::atomic<Node*> next_{nullptr};
+
+    friend class MpscQueue;
+  };
+
+  MpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+  /**
+   * Add an item at the end of the queue. Safe to call from any thread.
+   * @param node supplies the item. It must not be in any queue.
+   */
+  void push(Node* node) {
+    node->next_.store(nullptr, std::memory_order_relaxed);
+    Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+    // Until this store the item is not reachable from the consumer side.
+    prev->next_.store(node, std::memory_order_release);
+  }
+
+  /**
+   * Remove the item at the front of the queue. Must only be called from the consumer thread.
+   * @return Node* the item, or nullptr if the queue is empty or the next item is still being
+   *         pushed.
+   */
+  Node* pop() {
+    Node* tail = tail_;
+    Node* next = tail->next_.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      tail_ = next;
+      tail = next;
+      next = next->next_.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr) {
+      tail_ = next;
+      return tail;
+    }
+
+    if (tail != head_.load(std::memory_order_acquire)) {
+      // A producer has swapped head_ but not linked its item yet.
+      return nullptr;
+    }
+
+    // tail is the last item. Put the stub back behind it so that it can be unlinked.
+    push(&stub_);
+    next = tail->next_.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail_ = next;
+      return tail;
+    }
+    return nullptr;
+  }
+
+  /**
+   * Remove the item at the front of the queue, waiting for a producer that is in the middle of a
+   * push. Must only be called from the consumer thread, and only when the caller knows that an
+   * item has been pushed and not popped yet.
+   * @return Node* the item.
+   */
+  Node* popKnownNonEmpty() {
+    Node* node;
+    while ((node = pop()) == nullptr) {
+      // The producer is between two instructions, so this does not spin for long.
+      std::this_thread::yield();
+    }
+    return node;
+  }
+
+private:
+  // Producers push at the head, the consumer pops from the tail.
+  std::atomic<Node*> head_;
+  // Only accessed by the consumer.
+  Node* tail_;
+  Node stub_;
+};
+
+} // namespace Envoy
@@ -174,6 +174,37 @@ std::string AccessLogDateTimeFormatter::fromTime(const SystemTime& time) {
           1000);
 }
 
+void AccessLogDateTimeFormatter::appendTime(const SystemTime& time, std::string& out) {
+  const int64_t ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+  if (ms < 0) {
+    out += fromTime(time);
+    return;
+  }
+
+  // "%Y-%m-%dT%H:%M:%S" of the last second formatted on this thread.
+  static thread_local int64_t cached_second = -1;
+  static thread_local char cached[64];
+  static thread_local size_t cached_length = 0;
+  const int64_t second = ms / 1000;
+  if (second != cached_second) {
+    const time_t time_t_second = second;
+    tm current_tm;
+    gmtime_r(&time_t_second, &current_tm);
+    cached_length = strftime(cached, sizeof(cached), "%Y-%m-%dT%H:%M:%S", &current_tm);
+    cached_second = second;
+  }
+
+  const uint32_t millis = ms % 1000;
+  const char fraction[] = {'.',
+                           static_cast<char>('0' + millis / 100),
+                           static_cast<char>('0' + millis / 10 % 10),
+                           static_cast<char>('0' + millis % 10),
+                           'Z'};
+  out.append(cached, cached_length);
+  out.append(fraction, sizeof(fraction));
+}
+
 bool StringUtil::endsWith(const std::string& source, const std::string& end) {
   if (source.length() < end.length()) {
     return false;
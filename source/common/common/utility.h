@@ -40,6 +40,12 @@ private:
 class AccessLogDateTimeFormatter {
 public:
   static std::string fromTime(const SystemTime& time);
+
+  /**
+   * Append the same text fromTime() returns to a string. The date and time up to the second is
+   * formatted once per second and thread, so this only formats the milliseconds for most calls.
+   */
+  static void appendTime(const SystemTime& time, std::string& out);
 };
 
 /**
@@ -87,6 +87,15 @@ void BootstrapJson::translateBootstrap(const Json::Object& json_config,
     MessageUtil::jsonConvert(statsd_sink, *stats_sink->mutable_config());
   }
 
+  if (json_config.hasObject("binary_stats_udp_ip_address")) {
+    auto* stats_sink = stats_sinks->Add();
+    stats_sink->set_name(Config::StatsSinkNames::get().BINARY);
+    envoy::api::v2::StatsdSink binary_sink;
+    AddressJson::translateAddress(json_config.getString("binary_stats_udp_ip_address"), false,
+                                  true, *binary_sink.mutable_address());
+    MessageUtil::jsonConvert(binary_sink, *stats_sink->mutable_config());
+  }
+
   JSON_UTIL_SET_DURATION(json_config, bootstrap, stats_flush_interval);
 
   auto* watchdog = bootstrap.mutable_watchdog();
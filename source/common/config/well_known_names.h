@@ -84,12 +84,16 @@ class HttpFilterNameValues {
 public:
   // Buffer filter
   const std::string BUFFER = "envoy.buffer";
+  // Cache filter
+  const std::string CACHE = "envoy.cache";
   // CORS filter
   const std::string CORS = "envoy.cors";
   // Dynamo filter
   const std::string DYNAMO = "envoy.http_dynamo_filter";
   // Fault filter
   const std::string FAULT = "envoy.fault";
+  // Gzip filter
+  const std::string GZIP = "envoy.gzip";
   // GRPC http1 bridge filter
   const std::string GRPC_HTTP1_BRIDGE = "envoy.grpc_http1_bridge";
   // GRPC json transcoder filter
@@ -109,8 +113,8 @@ public:
   const V1Converter v1_converter_;
 
   HttpFilterNameValues()
-      : v1_converter_({BUFFER, CORS, DYNAMO, FAULT, GRPC_HTTP1_BRIDGE, GRPC_JSON_TRANSCODER,
-                       GRPC_WEB, HEALTH_CHECK, IP_TAGGING, RATE_LIMIT, ROUTER}) {}
+      : v1_converter_({BUFFER, CACHE, CORS, DYNAMO, FAULT, GRPC_HTTP1_BRIDGE, GRPC_JSON_TRANSCODER,
+                       GRPC_WEB, GZIP, HEALTH_CHECK, IP_TAGGING, RATE_LIMIT, ROUTER}) {}
 };
 
 typedef ConstSingleton<HttpFilterNameValues> HttpFilterNames;
@@ -135,6 +139,8 @@ class StatsSinkNameValues {
 public:
   // Statsd sink
   const std::string STATSD = "envoy.statsd";
+  // Binary UDP sink
+  const std::string BINARY = "envoy.binary_stats";
 };
 
 typedef ConstSingleton<StatsSinkNameValues> StatsSinkNames;
@@ -146,6 +152,8 @@ class AccessLogNameValues {
 public:
   // File access log
   const std::string FILE = "envoy.file_access_log";
+  // Binary access log
+  const std::string BINARY = "envoy.binary_access_log";
 };
 
 typedef ConstSingleton<AccessLogNameValues> AccessLogNames;
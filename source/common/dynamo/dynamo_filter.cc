@@ -5,14 +5,12 @@
 #include <string>
 #include <vector>
 
-#include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
+#include "common/dynamo/dynamo_json_scanner.h"
 #include "common/dynamo/dynamo_request_parser.h"
 #include "common/dynamo/dynamo_utility.h"
 #include "common/http/codes.h"
-#include "common/http/exception.h"
 #include "common/http/utility.h"
-#include "common/json/json_loader.h"
 
 #include "fmt/format.h"
 
@@ -29,64 +27,76 @@ Http::FilterHeadersStatus DynamoFilter::decodeHeaders(Http::HeaderMap& headers,
 }
 
 Http::FilterDataStatus DynamoFilter::decodeData(Buffer::Instance& data, bool end_stream) {
-  if (enabled_ && end_stream) {
-    onDecodeComplete(data);
+  if (enabled_) {
+    request_scanner_.scan(data);
+    if (end_stream) {
+      onDecodeComplete();
+    }
   }
 
-  if (end_stream) {
-    return Http::FilterDataStatus::Continue;
-  } else {
-    // Buffer until the complete request has been processed.
-    return Http::FilterDataStatus::StopIterationAndBuffer;
-  }
+  return Http::FilterDataStatus::Continue;
 }
 
 Http::FilterTrailersStatus DynamoFilter::decodeTrailers(Http::HeaderMap&) {
   if (enabled_) {
-    Buffer::OwnedImpl empty;
-    onDecodeComplete(empty);
+    onDecodeComplete();
   }
 
   return Http::FilterTrailersStatus::Continue;
 }
 
-void DynamoFilter::onDecodeComplete(const Buffer::Instance& data) {
-  std::string body = buildBody(decoder_callbacks_->decodingBuffer(), data);
-  if (!body.empty()) {
-    try {
-      Json::ObjectSharedPtr json_body = Json::Factory::loadFromString(body);
-      table_descriptor_ = RequestParser::parseTable(operation_, *json_body);
-    } catch (const Json::Exception& jsonEx) {
-      // Body parsing failed. This should not happen, just put a stat for that.
-      scope_.counter(fmt::format("{}invalid_req_body", stat_prefix_)).inc();
-    }
+void DynamoFilter::onDecodeComplete() {
+  if (request_scanner_.bytesScanned() == 0) {
+    return;
   }
+
+  switch (request_scanner_.finish()) {
+  case JsonScanner::Result::Invalid:
+    // Body parsing failed. This should not happen, just put a stat for that.
+    scope_.counter(fmt::format("{}invalid_req_body", stat_prefix_)).inc();
+    return;
+  case JsonScanner::Result::Truncated:
+    // Whatever was found before the limit is still used.
+    scope_.counter(fmt::format("{}req_body_scan_truncated", stat_prefix_)).inc();
+    break;
+  case JsonScanner::Result::Complete:
+    break;
+  }
+
+  table_descriptor_ = request_scanner_.tableDescriptor(operation_);
 }
 
-void DynamoFilter::onEncodeComplete(const Buffer::Instance& data) {
+void DynamoFilter::onEncodeComplete() {
   ASSERT(enabled_);
   uint64_t status = Http::Utility::getResponseStatus(*response_headers_);
   chargeBasicStats(status);
 
-  std::string body = buildBody(encoder_callbacks_->encodingBuffer(), data);
-  if (!body.empty()) {
-    try {
-      Json::ObjectSharedPtr json_body = Json::Factory::loadFromString(body);
-      chargeTablePartitionIdStats(*json_body);
-
-      if (Http::CodeUtility::is4xx(status)) {
-        chargeFailureSpecificStats(*json_body);
-      }
-      // Batch Operations will always return status 200 for a partial or full success. Check
-      // unprocessed keys to determine partial success.
-      // http://docs.aws.amazon.com/amazondynamodb/latest/developerguide/Programming.Errors.html#Programming.Errors.BatchOperations
-      if (RequestParser::isBatchOperation(operation_)) {
-        chargeUnProcessedKeysStats(*json_body);
-      }
-    } catch (const Json::Exception&) {
-      // Body parsing failed. This should not happen, just put a stat for that.
-      scope_.counter(fmt::format("{}invalid_resp_body", stat_prefix_)).inc();
-    }
+  if (response_scanner_.bytesScanned() == 0) {
+    return;
+  }
+
+  switch (response_scanner_.finish()) {
+  case JsonScanner::Result::Invalid:
+    // Body parsing failed. This should not happen, just put a stat for that.
+    scope_.counter(fmt::format("{}invalid_resp_body", stat_prefix_)).inc();
+    return;
+  case JsonScanner::Result::Truncated:
+    scope_.counter(fmt::format("{}resp_body_scan_truncated", stat_prefix_)).inc();
+    break;
+  case JsonScanner::Result::Complete:
+    break;
+  }
+
+  chargeTablePartitionIdStats(response_scanner_.partitions());
+
+  if (Http::CodeUtility::is4xx(status)) {
+    chargeFailureSpecificStats(response_scanner_.errorType());
+  }
+  // Batch Operations will always return status 200 for a partial or full success. Check
+  // unprocessed keys to determine partial success.
+  // http://docs.aws.amazon.com/amazondynamodb/latest/developerguide/Programming.Errors.html#Programming.Errors.BatchOperations
+  if (RequestParser::isBatchOperation(operation_)) {
+    chargeUnProcessedKeysStats(response_scanner_.unprocessedTables());
   }
 }
 
@@ -95,8 +105,7 @@ Http::FilterHeadersStatus DynamoFilter::encodeHeaders(Http::HeaderMap& headers,
     response_headers_ = &headers;
 
     if (end_stream) {
-      Buffer::OwnedImpl empty;
-      onEncodeComplete(empty);
+      onEncodeComplete();
     }
   }
 
@@ -104,49 +113,24 @@ Http::FilterHeadersStatus DynamoFilter::encodeHeaders(Http::HeaderMap& headers,
 }
 
 Http::FilterDataStatus DynamoFilter::encodeData(Buffer::Instance& data, bool end_stream) {
-  if (enabled_ && end_stream) {
-    onEncodeComplete(data);
+  if (enabled_) {
+    response_scanner_.scan(data);
+    if (end_stream) {
+      onEncodeComplete();
+    }
   }
 
-  if (end_stream) {
-    return Http::FilterDataStatus::Continue;
-  } else {
-    // Buffer until the complete response has been processed.
-    return Http::FilterDataStatus::StopIterationAndBuffer;
-  }
+  return Http::FilterDataStatus::Continue;
 }
 
 Http::FilterTrailersStatus DynamoFilter::encodeTrailers(Http::HeaderMap&) {
   if (enabled_) {
-    Buffer::OwnedImpl empty;
-    onEncodeComplete(empty);
+    onEncodeComplete();
   }
 
   return Http::FilterTrailersStatus::Continue;
 }
 
-std::string DynamoFilter::buildBody(const Buffer::Instance* buffered,
-                                    const Buffer::Instance& last) {
-  std::string body;
-  if (buffered) {
-    uint64_t num_slices = buffered->getRawSlices(nullptr, 0);
-    Buffer::RawSlice slices[num_slices];
-    buffered->getRawSlices(slices, num_slices);
-    for (Buffer::RawSlice& slice : slices) {
-      body.append(static_cast<const char*>(slice.mem_), slice.len_);
-    }
-  }
-
-  uint64_t num_slices = last.getRawSlices(nullptr, 0);
-  Buffer::RawSlice slices[num_slices];
-  last.getRawSlices(slices, num_slices);
-  for (Buffer::RawSlice& slice : slices) {
-    body.append(static_cast<const char*>(slice.mem_), slice.len_);
-  }
-
-  return body;
-}
-
 void DynamoFilter::chargeBasicStats(uint64_t status) {
   if (!operation_.empty()) {
     chargeStatsPerEntity(operation_, "operation", status);
@@ -193,10 +177,10 @@ void DynamoFilter::chargeStatsPerEntity(const std::string& entity, const std::st
       .recordValue(latency.count());
 }
 
-void DynamoFilter::chargeUnProcessedKeysStats(const Json::Object& json_body) {
+void DynamoFilter::chargeUnProcessedKeysStats(
+    const std::vector<std::string>& unprocessed_tables) {
   // The unprocessed keys block contains a list of tables and keys for that table that did not
   // complete apart of the batch operation. Only the table names will be logged for errors.
-  std::vector<std::string> unprocessed_tables = RequestParser::parseBatchUnProcessedKeys(json_body);
   for (const std::string& unprocessed_table : unprocessed_tables) {
     scope_
         .counter(
@@ -205,9 +189,7 @@ void DynamoFilter::chargeUnProcessedKeysStats(const Json::Object& json_body) {
   }
 }
 
-void DynamoFilter::chargeFailureSpecificStats(const Json::Object& json_body) {
-  std::string error_type = RequestParser::parseErrorType(json_body);
-
+void DynamoFilter::chargeFailureSpecificStats(const std::string& error_type) {
   if (!error_type.empty()) {
     if (table_descriptor_.table_name.empty()) {
       scope_.counter(fmt::format("{}error.no_table.{}", stat_prefix_, error_type)).inc();
@@ -222,13 +204,12 @@ void DynamoFilter::chargeFailureSpecificStats(const Json::Object& json_body) {
   }
 }
 
-void DynamoFilter::chargeTablePartitionIdStats(const Json::Object& json_body) {
+void DynamoFilter::chargeTablePartitionIdStats(
+    const std::vector<RequestParser::PartitionDescriptor>& partitions) {
   if (table_descriptor_.table_name.empty() || operation_.empty()) {
     return;
   }
 
-  std::vector<RequestParser::PartitionDescriptor> partitions =
-      RequestParser::parsePartitions(json_body);
   for (const RequestParser::PartitionDescriptor& partition : partitions) {
     std::string scope_string = Utility::buildPartitionStatString(
         stat_prefix_, table_descriptor_.table_name, operation_, partition.partition_id_);
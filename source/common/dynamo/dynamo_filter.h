@@ -2,13 +2,13 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/http/filter.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/stats/stats.h"
 
 #include "common/dynamo/dynamo_request_parser.h"
-#include "common/json/json_loader.h"
 
 namespace Envoy {
 namespace Dynamo {
@@ -18,13 +18,18 @@ namespace Dynamo {
  * It captures RPS/latencies:
  *  1) Per table per response code (and group of response codes, e.g., 2xx/3xx/etc)
  *  2) Per operation per response code (and group of response codes, e.g., 2xx/3xx/etc)
+ *
+ * Request and response bodies are not buffered. They are scanned as they stream through the
+ * filter, up to dynamodb.max_body_scan_bytes bytes each.
  */
 class DynamoFilter : public Http::StreamFilter {
 public:
   DynamoFilter(Runtime::Loader& runtime, const std::string& stat_prefix, Stats::Scope& scope)
-      : runtime_(runtime), stat_prefix_(stat_prefix + "dynamodb."), scope_(scope) {
-    enabled_ = runtime_.snapshot().featureEnabled("dynamodb.filter_enabled", 100);
-  }
+      : runtime_(runtime), stat_prefix_(stat_prefix + "dynamodb."), scope_(scope),
+        enabled_(runtime_.snapshot().featureEnabled("dynamodb.filter_enabled", 100)),
+        max_body_scan_bytes_(runtime_.snapshot().getInteger("dynamodb.max_body_scan_bytes",
+                                                            DEFAULT_MAX_BODY_SCAN_BYTES)),
+        request_scanner_(max_body_scan_bytes_), response_scanner_(max_body_scan_bytes_) {}
 
   // Http::StreamFilterBase
   void onDestroy() override {}
@@ -46,21 +51,28 @@ public:
   }
 
 private:
-  void onDecodeComplete(const Buffer::Instance& data);
-  void onEncodeComplete(const Buffer::Instance& data);
-  std::string buildBody(const Buffer::Instance* buffered, const Buffer::Instance& last);
+  // DynamoDB caps request payloads at 16MB, but the table names are expected to be found well
+  // before the end of large batch requests.
+  static const uint64_t DEFAULT_MAX_BODY_SCAN_BYTES = 1024 * 1024;
+
+  void onDecodeComplete();
+  void onEncodeComplete();
   void chargeBasicStats(uint64_t status);
   void chargeStatsPerEntity(const std::string& entity, const std::string& entity_type,
                             uint64_t status);
-  void chargeFailureSpecificStats(const Json::Object& json_body);
-  void chargeUnProcessedKeysStats(const Json::Object& json_body);
-  void chargeTablePartitionIdStats(const Json::Object& json_body);
+  void chargeFailureSpecificStats(const std::string& error_type);
+  void chargeUnProcessedKeysStats(const std::vector<std::string>& unprocessed_tables);
+  void
+  chargeTablePartitionIdStats(const std::vector<RequestParser::PartitionDescriptor>& partitions);
 
   Runtime::Loader& runtime_;
   std::string stat_prefix_;
   Stats::Scope& scope_;
 
-  bool enabled_{};
+  const bool enabled_;
+  const uint64_t max_body_scan_bytes_;
+  RequestBodyScanner request_scanner_;
+  ResponseBodyScanner response_scanner_;
   std::string operation_{};
   RequestParser::TableDescriptor table_descriptor_{"", true};
   std::string error_type_{};
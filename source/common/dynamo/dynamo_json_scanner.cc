@@ -0,0 +1,416 @@
+#include "common/dynamo/dynamo_json_scanner.h"
+
+#include <cstdint>
+#include <string>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Dynamo {
+
+namespace {
+
+bool isWhitespace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool isNumberChar(char c) {
+  return isDigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  } else if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+/**
+ * Validate a number against the JSON grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+ */
+bool validNumber(const std::string& number) {
+  const char* p = number.c_str();
+  if (*p == '-') {
+    p++;
+  }
+  if (*p == '0') {
+    p++;
+  } else if (isDigit(*p)) {
+    while (isDigit(*p)) {
+      p++;
+    }
+  } else {
+    return false;
+  }
+  if (*p == '.') {
+    p++;
+    if (!isDigit(*p)) {
+      return false;
+    }
+    while (isDigit(*p)) {
+      p++;
+    }
+  }
+  if (*p == 'e' || *p == 'E') {
+    p++;
+    if (*p == '+' || *p == '-') {
+      p++;
+    }
+    if (!isDigit(*p)) {
+      return false;
+    }
+    while (isDigit(*p)) {
+      p++;
+    }
+  }
+  return *p == '\0';
+}
+
+} // namespace
+
+const uint32_t JsonScanner::MAX_DEPTH;
+const uint32_t JsonScanner::MAX_STRING_LENGTH;
+
+JsonScanner::JsonScanner(Callbacks& callbacks, uint64_t max_bytes)
+    : callbacks_(callbacks), max_bytes_(max_bytes) {}
+
+void JsonScanner::scan(const Buffer::Instance& data) {
+  uint64_t num_slices = data.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  data.getRawSlices(slices, num_slices);
+  for (const Buffer::RawSlice& slice : slices) {
+    scan(static_cast<const char*>(slice.mem_), slice.len_);
+  }
+}
+
+void JsonScanner::scan(const char* data, uint64_t size) {
+  if (state_ == State::Invalid || state_ == State::Truncated) {
+    return;
+  }
+
+  if (bytes_scanned_ == 0) {
+    scratch_.reserve(MAX_STRING_LENGTH);
+  }
+
+  bool truncate = false;
+  if (size > max_bytes_ - bytes_scanned_) {
+    size = max_bytes_ - bytes_scanned_;
+    truncate = true;
+  }
+
+  for (uint64_t i = 0; i < size && state_ != State::Invalid; i++) {
+    consume(data[i]);
+  }
+  bytes_scanned_ += size;
+
+  // Anything trailing a complete value is not looked at once the limit is hit.
+  if (truncate && state_ != State::Invalid && state_ != State::Done) {
+    state_ = State::Truncated;
+  }
+}
+
+JsonScanner::Result JsonScanner::finish() {
+  if (state_ == State::Number && depth_ == 0) {
+    finishNumber();
+  }
+
+  switch (state_) {
+  case State::Done:
+    return Result::Complete;
+  case State::Truncated:
+    return Result::Truncated;
+  default:
+    state_ = State::Invalid;
+    return Result::Invalid;
+  }
+}
+
+void JsonScanner::consume(char c) {
+  switch (state_) {
+  case State::Value:
+    if (isWhitespace(c)) {
+      break;
+    } else if (c == '{') {
+      if (push(true)) {
+        state_ = State::ObjectKeyOrEnd;
+      }
+    } else if (c == '[') {
+      if (push(false)) {
+        state_ = State::ArrayValueOrEnd;
+      }
+    } else if (c == '"') {
+      startString(false);
+    } else if (c == '-' || isDigit(c)) {
+      scratch_.clear();
+      scratch_overflow_ = false;
+      appendChar(c);
+      state_ = State::Number;
+    } else if (c == 't' || c == 'f' || c == 'n') {
+      literal_ = c == 't' ? "true" : (c == 'f' ? "false" : "null");
+      literal_position_ = 1;
+      state_ = State::Literal;
+    } else {
+      setInvalid();
+    }
+    break;
+
+  case State::ArrayValueOrEnd:
+    if (isWhitespace(c)) {
+      break;
+    } else if (c == ']') {
+      pop();
+    } else {
+      state_ = State::Value;
+      consume(c);
+    }
+    break;
+
+  case State::ObjectKeyOrEnd:
+    if (isWhitespace(c)) {
+      break;
+    } else if (c == '"') {
+      startString(true);
+    } else if (c == '}') {
+      pop();
+    } else {
+      setInvalid();
+    }
+    break;
+
+  case State::ObjectKey:
+    if (isWhitespace(c)) {
+      break;
+    } else if (c == '"') {
+      startString(true);
+    } else {
+      setInvalid();
+    }
+    break;
+
+  case State::Colon:
+    if (isWhitespace(c)) {
+      break;
+    } else if (c == ':') {
+      state_ = State::Value;
+    } else {
+      setInvalid();
+    }
+    break;
+
+  case State::AfterValue:
+    if (isWhitespace(c)) {
+      break;
+    } else if (c == ',') {
+      state_ = inObject() ? State::ObjectKey : State::Value;
+    } else if ((c == '}' && inObject()) || (c == ']' && !inObject())) {
+      pop();
+    } else {
+      setInvalid();
+    }
+    break;
+
+  case State::String:
+    if (c == '"') {
+      finishString();
+    } else if (c == '\\') {
+      state_ = State::StringEscape;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      setInvalid();
+    } else {
+      appendChar(c);
+    }
+    break;
+
+  case State::StringEscape:
+    state_ = State::String;
+    switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      appendChar(c);
+      break;
+    case 'b':
+      appendChar('\b');
+      break;
+    case 'f':
+      appendChar('\f');
+      break;
+    case 'n':
+      appendChar('\n');
+      break;
+    case 'r':
+      appendChar('\r');
+      break;
+    case 't':
+      appendChar('\t');
+      break;
+    case 'u':
+      unicode_value_ = 0;
+      unicode_digits_ = 0;
+      state_ = State::StringUnicode;
+      break;
+    default:
+      setInvalid();
+    }
+    break;
+
+  case State::StringUnicode: {
+    int value = hexValue(c);
+    if (value < 0) {
+      setInvalid();
+      break;
+    }
+    unicode_value_ = (unicode_value_ << 4) | value;
+    if (++unicode_digits_ == 4) {
+      appendCodePoint(unicode_value_);
+      state_ = State::String;
+    }
+    break;
+  }
+
+  case State::Number:
+    if (isNumberChar(c)) {
+      appendChar(c);
+    } else {
+      finishNumber();
+      if (state_ != State::Invalid) {
+        consume(c);
+      }
+    }
+    break;
+
+  case State::Literal:
+    if (c != literal_[literal_position_]) {
+      setInvalid();
+    } else if (literal_[++literal_position_] == '\0') {
+      endValue();
+    }
+    break;
+
+  case State::Done:
+    if (!isWhitespace(c)) {
+      setInvalid();
+    }
+    break;
+
+  case State::Truncated:
+  case State::Invalid:
+    NOT_REACHED;
+  }
+}
+
+void JsonScanner::startString(bool is_key) {
+  scratch_.clear();
+  scratch_overflow_ = false;
+  string_is_key_ = is_key;
+  high_surrogate_ = 0;
+  state_ = State::String;
+}
+
+void JsonScanner::finishString() {
+  if (scratch_overflow_) {
+    scratch_.clear();
+  }
+
+  if (string_is_key_) {
+    callbacks_.onKey(depth_, scratch_);
+    state_ = State::Colon;
+  } else {
+    if (inObject()) {
+      callbacks_.onString(depth_, scratch_);
+    }
+    endValue();
+  }
+}
+
+void JsonScanner::finishNumber() {
+  if (!scratch_overflow_ && !validNumber(scratch_)) {
+    setInvalid();
+    return;
+  }
+
+  if (inObject()) {
+    if (scratch_overflow_) {
+      scratch_.clear();
+    }
+    callbacks_.onNumber(depth_, scratch_);
+  }
+  endValue();
+}
+
+void JsonScanner::appendCodePoint(uint32_t code_point) {
+  if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+    // High surrogate, wait for the low half before encoding.
+    high_surrogate_ = code_point;
+    return;
+  }
+
+  if (code_point >= 0xDC00 && code_point <= 0xDFFF && high_surrogate_ != 0) {
+    code_point = 0x10000 + ((high_surrogate_ - 0xD800) << 10) + (code_point - 0xDC00);
+  }
+  high_surrogate_ = 0;
+
+  if (code_point < 0x80) {
+    appendChar(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    appendChar(static_cast<char>(0xC0 | (code_point >> 6)));
+    appendChar(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else if (code_point < 0x10000) {
+    appendChar(static_cast<char>(0xE0 | (code_point >> 12)));
+    appendChar(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    appendChar(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else {
+    appendChar(static_cast<char>(0xF0 | (code_point >> 18)));
+    appendChar(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+    appendChar(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    appendChar(static_cast<char>(0x80 | (code_point & 0x3F)));
+  }
+}
+
+void JsonScanner::appendChar(char c) {
+  if (scratch_.size() < MAX_STRING_LENGTH) {
+    scratch_.push_back(c);
+  } else {
+    scratch_overflow_ = true;
+  }
+}
+
+bool JsonScanner::push(bool is_object) {
+  if (depth_ == MAX_DEPTH) {
+    setInvalid();
+    return false;
+  }
+
+  const uint64_t mask = 1ULL << (depth_ % 64);
+  if (is_object) {
+    container_bits_[depth_ / 64] |= mask;
+  } else {
+    container_bits_[depth_ / 64] &= ~mask;
+  }
+  depth_++;
+  return true;
+}
+
+void JsonScanner::pop() {
+  ASSERT(depth_ > 0);
+  depth_--;
+  endValue();
+}
+
+void JsonScanner::endValue() { state_ = depth_ == 0 ? State::Done : State::AfterValue; }
+
+bool JsonScanner::inObject() const {
+  if (depth_ == 0) {
+    return false;
+  }
+
+  const uint32_t level = depth_ - 1;
+  return (container_bits_[level / 64] >> (level % 64)) & 1;
+}
+
+} // namespace Dynamo
+} // namespace Envoy
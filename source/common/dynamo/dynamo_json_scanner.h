@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/common/pure.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Dynamo {
+
+/**
+ * Incremental, push style JSON scanner. Data is fed as it arrives (in arbitrary chunks) and the
+ * scanner reports object keys and scalar object members to its callbacks without building a DOM
+ * or retaining the scanned data. Scanning stops once a configurable number of bytes has been
+ * consumed so that arbitrarily large bodies cost a bounded amount of work.
+ *
+ * The scanner is deliberately limited to what the DynamoDB filter needs:
+ *  - Scalar values are only reported when they are members of an object. Array elements are
+ *    validated but not reported.
+ *  - Keys and values longer than MAX_STRING_LENGTH are reported as the empty string.
+ *  - Nesting is limited to MAX_DEPTH levels, deeper documents are treated as invalid.
+ */
+class JsonScanner : NonCopyable {
+public:
+  class Callbacks {
+  public:
+    virtual ~Callbacks() {}
+
+    /**
+     * Called for every object key.
+     * @param depth supplies the nesting depth of the object that holds the key. Keys of the
+     *        top-level object have a depth of 1.
+     * @param key supplies the unescaped key. Only valid for the duration of the call.
+     */
+    virtual void onKey(uint32_t depth, const std::string& key) PURE;
+
+    /**
+     * Called for every string value that is a member of an object. The value belongs to the key
+     * most recently reported via onKey() at the same depth.
+     * @param depth supplies the nesting depth of the object that holds the value.
+     * @param value supplies the unescaped value. Only valid for the duration of the call.
+     */
+    virtual void onString(uint32_t depth, const std::string& value) PURE;
+
+    /**
+     * Called for every number value that is a member of an object. The value belongs to the key
+     * most recently reported via onKey() at the same depth.
+     * @param depth supplies the nesting depth of the object that holds the value.
+     * @param value supplies the textual representation of the number.
+     */
+    virtual void onNumber(uint32_t depth, const std::string& value) PURE;
+  };
+
+  enum class Result {
+    // A single, well formed JSON value was scanned.
+    Complete,
+    // The byte limit was reached before the end of the value. Everything reported to the
+    // callbacks up to that point came from well formed input.
+    Truncated,
+    // The input is not well formed JSON.
+    Invalid
+  };
+
+  static const uint32_t MAX_DEPTH = 128;
+  static const uint32_t MAX_STRING_LENGTH = 256;
+
+  JsonScanner(Callbacks& callbacks, uint64_t max_bytes);
+
+  /**
+   * Scan a chunk of data. The buffer is not modified.
+   */
+  void scan(const Buffer::Instance& data);
+  void scan(const char* data, uint64_t size);
+
+  /**
+   * Signal the end of the input.
+   * @return Result the outcome of the scan.
+   */
+  Result finish();
+
+  /**
+   * @return uint64_t the number of bytes that have been scanned so far.
+   */
+  uint64_t bytesScanned() const { return bytes_scanned_; }
+
+private:
+  enum class State {
+    Value,
+    ArrayValueOrEnd,
+    ObjectKeyOrEnd,
+    ObjectKey,
+    Colon,
+    AfterValue,
+    String,
+    StringEscape,
+    StringUnicode,
+    Number,
+    Literal,
+    Done,
+    Truncated,
+    Invalid
+  };
+
+  void consume(char c);
+  void startString(bool is_key);
+  void finishString();
+  void finishNumber();
+  void appendCodePoint(uint32_t code_point);
+  void appendChar(char c);
+  bool push(bool is_object);
+  void pop();
+  void endValue();
+  bool inObject() const;
+  void setInvalid() { state_ = State::Invalid; }
+
+  Callbacks& callbacks_;
+  const uint64_t max_bytes_;
+  uint64_t bytes_scanned_{};
+  State state_{State::Value};
+  uint32_t depth_{};
+  // One bit per nesting level, set for objects and clear for arrays.
+  uint64_t container_bits_[MAX_DEPTH / 64]{};
+  // Scratch space for the key or value being scanned. It is reused for every token so that no
+  // allocation happens once it has grown to MAX_STRING_LENGTH.
+  std::string scratch_;
+  bool scratch_overflow_{};
+  bool string_is_key_{};
+  uint32_t unicode_value_{};
+  uint32_t unicode_digits_{};
+  uint32_t high_surrogate_{};
+  const char* literal_{};
+  uint32_t literal_position_{};
+};
+
+} // namespace Dynamo
+} // namespace Envoy
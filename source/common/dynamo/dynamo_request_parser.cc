@@ -2,6 +2,7 @@
 
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <string>
 #include <vector>
 
@@ -70,11 +71,9 @@ RequestParser::TableDescriptor RequestParser::parseTable(const std::string& oper
   TableDescriptor table{"", true};
 
   // Simple operations on a single table, have "TableName" explicitly specified.
-  if (find(SINGLE_TABLE_OPERATIONS.begin(), SINGLE_TABLE_OPERATIONS.end(), operation) !=
-      SINGLE_TABLE_OPERATIONS.end()) {
+  if (isSingleTableOperation(operation)) {
     table.table_name = json_data.getString("TableName", "");
-  } else if (find(BATCH_OPERATIONS.begin(), BATCH_OPERATIONS.end(), operation) !=
-             BATCH_OPERATIONS.end()) {
+  } else if (isBatchOperation(operation)) {
     Json::ObjectSharedPtr tables = json_data.getObject("RequestItems", true);
     tables->iterate([&table](const std::string& key, const Json::Object&) {
       if (table.table_name.empty()) {
@@ -103,7 +102,10 @@ std::vector<std::string> RequestParser::parseBatchUnProcessedKeys(const Json::Ob
   return unprocessed_tables;
 }
 std::string RequestParser::parseErrorType(const Json::Object& json_data) {
-  std::string error_type = json_data.getString("__type", "");
+  return supportedErrorType(json_data.getString("__type", ""));
+}
+
+std::string RequestParser::supportedErrorType(const std::string& error_type) {
   if (error_type.empty()) {
     return "";
   }
@@ -122,6 +124,11 @@ bool RequestParser::isBatchOperation(const std::string& operation) {
          BATCH_OPERATIONS.end();
 }
 
+bool RequestParser::isSingleTableOperation(const std::string& operation) {
+  return find(SINGLE_TABLE_OPERATIONS.begin(), SINGLE_TABLE_OPERATIONS.end(), operation) !=
+         SINGLE_TABLE_OPERATIONS.end();
+}
+
 std::vector<RequestParser::PartitionDescriptor>
 RequestParser::parsePartitions(const Json::Object& json_data) {
   std::vector<RequestParser::PartitionDescriptor> partition_descriptors;
@@ -142,5 +149,83 @@ RequestParser::parsePartitions(const Json::Object& json_data) {
   return partition_descriptors;
 }
 
+RequestParser::TableDescriptor
+RequestBodyScanner::tableDescriptor(const std::string& operation) const {
+  if (RequestParser::isSingleTableOperation(operation)) {
+    return {table_name_, true};
+  } else if (RequestParser::isBatchOperation(operation)) {
+    if (!batch_single_table_) {
+      return {"", false};
+    }
+    return {batch_table_name_, true};
+  }
+
+  return {"", true};
+}
+
+void RequestBodyScanner::onKey(uint32_t depth, const std::string& key) {
+  if (depth == 1) {
+    if (key == "TableName") {
+      section_ = Section::TableName;
+    } else if (key == "RequestItems") {
+      section_ = Section::RequestItems;
+    } else {
+      section_ = Section::None;
+    }
+  } else if (depth == 2 && section_ == Section::RequestItems && batch_single_table_) {
+    // Only the table names directly under "RequestItems" are of interest, the (potentially very
+    // large) per table requests are skipped over by the scanner.
+    if (batch_table_name_.empty()) {
+      batch_table_name_ = key;
+    } else if (batch_table_name_ != key) {
+      batch_table_name_.clear();
+      batch_single_table_ = false;
+    }
+  }
+}
+
+void RequestBodyScanner::onString(uint32_t depth, const std::string& value) {
+  if (depth == 1 && section_ == Section::TableName) {
+    table_name_ = value;
+  }
+}
+
+void ResponseBodyScanner::onKey(uint32_t depth, const std::string& key) {
+  if (depth == 1) {
+    if (key == "UnprocessedKeys") {
+      section_ = Section::UnprocessedKeys;
+    } else if (key == "ConsumedCapacity") {
+      section_ = Section::ConsumedCapacity;
+    } else if (key == "__type") {
+      section_ = Section::ErrorType;
+    } else {
+      section_ = Section::None;
+    }
+  } else if (depth == 2) {
+    if (section_ == Section::UnprocessedKeys) {
+      unprocessed_tables_.emplace_back(key);
+    } else if (section_ == Section::ConsumedCapacity || section_ == Section::Partitions) {
+      section_ = key == "Partitions" ? Section::Partitions : Section::ConsumedCapacity;
+    }
+  } else if (depth == 3 && section_ == Section::Partitions) {
+    partition_id_ = key;
+  }
+}
+
+void ResponseBodyScanner::onString(uint32_t depth, const std::string& value) {
+  if (depth == 1 && section_ == Section::ErrorType) {
+    error_type_ = RequestParser::supportedErrorType(value);
+  }
+}
+
+void ResponseBodyScanner::onNumber(uint32_t depth, const std::string& value) {
+  if (depth == 3 && section_ == Section::Partitions) {
+    // Capacity is rounded up to the nearest integer, see RequestParser::parsePartitions().
+    uint64_t capacity_integer =
+        static_cast<uint64_t>(std::ceil(std::strtod(value.c_str(), nullptr)));
+    partitions_.emplace_back(partition_id_, capacity_integer);
+  }
+}
+
 } // namespace Dynamo
 } // namespace Envoy
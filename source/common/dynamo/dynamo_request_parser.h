@@ -4,8 +4,10 @@
 #include <string>
 #include <vector>
 
+#include "envoy/buffer/buffer.h"
 #include "envoy/http/header_map.h"
 
+#include "common/dynamo/dynamo_json_scanner.h"
 #include "common/json/json_loader.h"
 
 namespace Envoy {
@@ -68,6 +70,12 @@ public:
    */
   static std::string parseErrorType(const Json::Object& json_data);
 
+  /**
+   * Map the "__type" field of an error response to one of the supported error types.
+   * @return empty string if the error type is not supported.
+   */
+  static std::string supportedErrorType(const std::string& error_type);
+
   /**
    * Parse unprocessed keys for batch operation results.
    * @return empty set if there are no unprocessed keys or a set of table names that did not get
@@ -80,6 +88,11 @@ public:
    */
   static bool isBatchOperation(const std::string& operation);
 
+  /**
+   * @return true if the operation is in the set of supported SINGLE_TABLE_OPERATIONS
+   */
+  static bool isSingleTableOperation(const std::string& operation);
+
   /**
    * Parse the Partition ids and the consumed capacity from the body.
    * @return empty set if there is no partition data or a set of partition data containing
@@ -100,5 +113,107 @@ private:
   RequestParser() {}
 };
 
+/**
+ * Streaming counterpart of RequestParser::parseTable(). Request body data is scanned as it flows
+ * through the filter so that the body never has to be buffered or parsed into a DOM.
+ */
+class RequestBodyScanner : public JsonScanner::Callbacks {
+public:
+  RequestBodyScanner(uint64_t max_bytes) : scanner_(*this, max_bytes) {}
+
+  /**
+   * Scan the next chunk of the request body.
+   */
+  void scan(const Buffer::Instance& data) { scanner_.scan(data); }
+
+  /**
+   * Signal the end of the request body.
+   * @return JsonScanner::Result the outcome of the scan.
+   */
+  JsonScanner::Result finish() { return scanner_.finish(); }
+
+  /**
+   * @return uint64_t the number of body bytes scanned so far.
+   */
+  uint64_t bytesScanned() const { return scanner_.bytesScanned(); }
+
+  /**
+   * @return the table descriptor for the operation, with the same semantics as
+   *         RequestParser::parseTable().
+   */
+  RequestParser::TableDescriptor tableDescriptor(const std::string& operation) const;
+
+  // Dynamo::JsonScanner::Callbacks
+  void onKey(uint32_t depth, const std::string& key) override;
+  void onString(uint32_t depth, const std::string& value) override;
+  void onNumber(uint32_t, const std::string&) override {}
+
+private:
+  enum class Section { None, TableName, RequestItems };
+
+  JsonScanner scanner_;
+  Section section_{Section::None};
+  std::string table_name_;
+  std::string batch_table_name_;
+  bool batch_single_table_{true};
+};
+
+/**
+ * Streaming counterpart of RequestParser::parseErrorType(), parseBatchUnProcessedKeys() and
+ * parsePartitions(). All three are extracted in a single pass over the response body.
+ */
+class ResponseBodyScanner : public JsonScanner::Callbacks {
+public:
+  ResponseBodyScanner(uint64_t max_bytes) : scanner_(*this, max_bytes) {}
+
+  /**
+   * Scan the next chunk of the response body.
+   */
+  void scan(const Buffer::Instance& data) { scanner_.scan(data); }
+
+  /**
+   * Signal the end of the response body.
+   * @return JsonScanner::Result the outcome of the scan.
+   */
+  JsonScanner::Result finish() { return scanner_.finish(); }
+
+  /**
+   * @return uint64_t the number of body bytes scanned so far.
+   */
+  uint64_t bytesScanned() const { return scanner_.bytesScanned(); }
+
+  /**
+   * @return the supported error type found in the body, or the empty string.
+   */
+  const std::string& errorType() const { return error_type_; }
+
+  /**
+   * @return the tables found in the "UnprocessedKeys" block of a batch operation response.
+   */
+  const std::vector<std::string>& unprocessedTables() const { return unprocessed_tables_; }
+
+  /**
+   * @return the partitions and consumed capacity found in the body.
+   */
+  const std::vector<RequestParser::PartitionDescriptor>& partitions() const {
+    return partitions_;
+  }
+
+  // Dynamo::JsonScanner::Callbacks
+  void onKey(uint32_t depth, const std::string& key) override;
+  void onString(uint32_t depth, const std::string& value) override;
+  void onNumber(uint32_t depth, const std::string& value) override;
+
+private:
+  enum class Section { None, ErrorType, UnprocessedKeys, ConsumedCapacity, Partitions };
+
+  JsonScanner scanner_;
+  Section section_{Section::None};
+  std::string partition_id_;
+  std::string error_type_;
+  std::vector<std::string> unprocessed_tables_;
+  std::vector<RequestParser::PartitionDescriptor> partitions_;
+};
+
 } // namespace Dynamo
 } // namespace Envoy
@@ -1,9 +1,9 @@
 #include "common/event/dispatcher_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <functional>
-#include <mutex>
 #include <string>
 #include <vector>
 
@@ -30,11 +30,17 @@ DispatcherImpl::DispatcherImpl()
 
 DispatcherImpl::DispatcherImpl(Buffer::WatermarkFactoryPtr&& factory)
     : buffer_factory_(std::move(factory)), base_(event_base_new()),
+      timer_wheel_(new TimerWheelScheduler(*this)),
       deferred_delete_timer_(createTimer([this]() -> void { clearDeferredDeleteList(); })),
-      post_timer_(createTimer([this]() -> void { runPostCallbacks(); })),
+      post_timer_(new TimerImpl(*this, [this]() -> void { runPostCallbacks(); })),
       current_to_delete_(&to_delete_1_) {}
 
-DispatcherImpl::~DispatcherImpl() {}
+DispatcherImpl::~DispatcherImpl() {
+  // Callbacks that never got to run.
+  while (MpscQueue::Node* node = post_queue_.pop()) {
+    delete node;
+  }
+}
 
 void DispatcherImpl::clearDeferredDeleteList() {
   ASSERT(isThreadSafe());
@@ -46,6 +52,9 @@ void DispatcherImpl::clearDeferredDeleteList() {
   }
 
   ENVOY_LOG(trace, "clearing deferred deletion list (size={})", num_to_delete);
+  window_deferred_deleted_ += num_to_delete;
+  window_max_deferred_delete_batch_ = std::max<uint64_t>(window_max_deferred_delete_batch_,
+                                                         num_to_delete);
 
   // Swap the current deletion vector so that if we do deferred delete while we are deleting, we
   // use the other vector. We will get another callback to delete that vector.
@@ -124,7 +133,7 @@ DispatcherImpl::createSslListener(Network::ConnectionHandler& conn_handler,
 
 TimerPtr DispatcherImpl::createTimer(TimerCb cb) {
   ASSERT(isThreadSafe());
-  return TimerPtr{new TimerImpl(*this, cb)};
+  return TimerPtr{new WheelTimerImpl(*this, *timer_wheel_, cb)};
 }
 
 void DispatcherImpl::deferredDelete(DeferredDeletablePtr&& to_delete) {
@@ -143,15 +152,19 @@ SignalEventPtr DispatcherImpl::listenForSignal(int signal_num, SignalCb cb) {
   return SignalEventPtr{new SignalEventImpl(*this, signal_num, cb)};
 }
 
-void DispatcherImpl::post(std::function<void()> callback) {
-  bool do_post;
-  {
-    std::unique_lock<std::mutex> lock(post_lock_);
-    do_post = post_callbacks_.empty();
-    post_callbacks_.push_back(callback);
-  }
+void DispatcherImpl::initializeStats(Stats::Scope& scope, const std::string& prefix) {
+  const std::string final_prefix = prefix + "dispatcher.";
+  stats_.reset(new DispatcherStats{ALL_DISPATCHER_STATS(POOL_COUNTER_PREFIX(scope, final_prefix),
+                                                        POOL_GAUGE_PREFIX(scope, final_prefix),
+                                                        POOL_HISTOGRAM_PREFIX(scope, final_prefix))});
+}
 
-  if (do_post) {
+void DispatcherImpl::post(std::function<void()> callback) {
+  post_queue_.push(new PostNode(std::move(callback)));
+  if (post_queue_depth_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+    post_wakeup_time_.store(std::chrono::steady_clock::now(), std::memory_order_release);
+    // This activates the timer event directly. From another thread, libevent wakes up the loop
+    // through its notification eventfd.
     post_timer_->enableTimer(std::chrono::milliseconds(0));
   }
 }
@@ -165,18 +178,115 @@ void DispatcherImpl::run(RunType type) {
   // event_base_once() before some other event, the other event might get called first.
   runPostCallbacks();
 
-  event_base_loop(base_.get(), type == RunType::NonBlock ? EVLOOP_NONBLOCK : 0);
+  if (type == RunType::Block && stats_) {
+    runMeasured();
+  } else {
+    event_base_loop(base_.get(), type == RunType::NonBlock ? EVLOOP_NONBLOCK : 0);
+  }
+}
+
+void DispatcherImpl::runMeasured() {
+  // libevent has no hooks around the wait for events, so run the loop one iteration at a time.
+  // This behaves like a single event_base_loop() call: libevent only clears the exit and break
+  // flags when a loop starts, and returns non zero once there is nothing left to wait for.
+  measuring_ = true;
+  while (true) {
+    iteration_events_ = 0;
+    const MonotonicTime start = std::chrono::steady_clock::now();
+    const int rc = event_base_loop(base_.get(), EVLOOP_ONCE);
+    recordIteration(start, std::chrono::steady_clock::now());
+    if (rc != 0 || event_base_got_exit(base_.get()) || event_base_got_break(base_.get())) {
+      break;
+    }
+  }
+  measuring_ = false;
+  flushIterationStats();
+}
+
+void DispatcherImpl::recordIteration(MonotonicTime start, MonotonicTime end) {
+  // Without any callback the iteration only waited, e.g. for a timer that had been disabled.
+  const MonotonicTime callbacks_start = iteration_events_ > 0 ? iteration_callbacks_start_ : end;
+  const std::chrono::microseconds poll_wait =
+      std::chrono::duration_cast<std::chrono::microseconds>(callbacks_start - start);
+  const std::chrono::microseconds busy =
+      std::chrono::duration_cast<std::chrono::microseconds>(end - callbacks_start);
+
+  window_iterations_++;
+  window_events_ += iteration_events_;
+  window_max_events_ = std::max(window_max_events_, iteration_events_);
+  window_busy_ += busy;
+  window_poll_wait_ += poll_wait;
+  window_max_busy_ = std::max(window_max_busy_, busy);
+
+  // Utilization is reported over windows of at least a second so that it follows load changes.
+  if (window_busy_ + window_poll_wait_ >= std::chrono::seconds(1)) {
+    flushIterationStats();
+  }
+}
+
+void DispatcherImpl::flushIterationStats() {
+  if (window_iterations_ > 0) {
+    stats_->loop_iterations_.add(window_iterations_);
+    stats_->loop_events_.add(window_events_);
+    stats_->loop_busy_us_.add(window_busy_.count());
+    stats_->loop_poll_wait_us_.add(window_poll_wait_.count());
+    const std::chrono::microseconds window_total = window_busy_ + window_poll_wait_;
+    if (window_total.count() > 0) {
+      stats_->loop_utilization_.set(100 * window_busy_.count() / window_total.count());
+    }
+    stats_->iteration_busy_max_us_.recordValue(window_max_busy_.count());
+    stats_->iteration_events_max_.recordValue(window_max_events_);
+  }
+  // Deferred deletion passes run on most busy iterations, so they are summarized per window too.
+  if (window_deferred_deleted_ > 0) {
+    stats_->deferred_deleted_.add(window_deferred_deleted_);
+    stats_->deferred_delete_batch_max_.recordValue(window_max_deferred_delete_batch_);
+  }
+
+  window_iterations_ = 0;
+  window_events_ = 0;
+  window_max_events_ = 0;
+  window_busy_ = std::chrono::microseconds(0);
+  window_poll_wait_ = std::chrono::microseconds(0);
+  window_max_busy_ = std::chrono::microseconds(0);
+  window_deferred_deleted_ = 0;
+  window_max_deferred_delete_batch_ = 0;
 }
 
 void DispatcherImpl::runPostCallbacks() {
-  std::unique_lock<std::mutex> lock(post_lock_);
-  while (!post_callbacks_.empty()) {
-    std::function<void()> callback = post_callbacks_.front();
-    post_callbacks_.pop_front();
-
-    lock.unlock();
-    callback();
-    lock.lock();
+  uint64_t pending = post_queue_depth_.load(std::memory_order_acquire);
+  if (pending > 0 && stats_) {
+    // The wakeup time is reset so that it is only recorded once. When the callbacks are picked up
+    // before the thread that posted them has set the time, there is no sample for this batch.
+    const MonotonicTime wakeup_time =
+        post_wakeup_time_.exchange(MonotonicTime::min(), std::memory_order_acq_rel);
+    if (wakeup_time != MonotonicTime::min()) {
+      stats_->post_callback_latency_us_.recordValue(
+          std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                wakeup_time)
+              .count());
+    }
+  }
+
+  while (pending > 0) {
+    if (stats_) {
+      stats_->post_queue_depth_.set(pending);
+    }
+
+    for (uint64_t i = 0; i < pending; i++) {
+      std::unique_ptr<PostNode> node(static_cast<PostNode*>(post_queue_.popKnownNonEmpty()));
+      node->callback_();
+    }
+    if (stats_) {
+      stats_->post_callbacks_.add(pending);
+    }
+
+    // Pick up whatever was posted in the meantime, nobody has woken us up for it.
+    pending = post_queue_depth_.fetch_sub(pending, std::memory_order_acq_rel) - pending;
+  }
+
+  if (stats_) {
+    stats_->post_queue_depth_.set(0);
   }
 }
 
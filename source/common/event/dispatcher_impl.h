@@ -1,22 +1,55 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <functional>
-#include <list>
-#include <mutex>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include "envoy/common/time.h"
 #include "envoy/event/deferred_deletable.h"
 #include "envoy/event/dispatcher.h"
 #include "envoy/network/connection_handler.h"
+#include "envoy/stats/stats_macros.h"
 
 #include "common/common/logger.h"
+#include "common/common/mpsc_queue.h"
 #include "common/common/thread.h"
 #include "common/event/libevent.h"
 
 namespace Envoy {
 namespace Event {
 
+class TimerWheelScheduler;
+
+/**
+ * All dispatcher stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_DISPATCHER_STATS(COUNTER, GAUGE, HISTOGRAM)                                            \
+  COUNTER(post_callbacks)                                                                          \
+  COUNTER(loop_iterations)                                                                         \
+  COUNTER(loop_events)                                                                             \
+  COUNTER(loop_busy_us)                                                                            \
+  COUNTER(loop_poll_wait_us)                                                                       \
+  COUNTER(deferred_deleted)                                                                        \
+  GAUGE  (post_queue_depth)                                                                        \
+  GAUGE  (loop_utilization)                                                                        \
+  HISTOGRAM(post_callback_latency_us)                                                              \
+  HISTOGRAM(iteration_busy_max_us)                                                                 \
+  HISTOGRAM(iteration_events_max)                                                                  \
+  HISTOGRAM(deferred_delete_batch_max)
+// clang-format on
+
+/**
+ * Struct definition for all dispatcher stats. @see stats_macros.h
+ */
+struct DispatcherStats {
+  ALL_DISPATCHER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT, GENERATE_HISTOGRAM_STRUCT)
+};
+
 /**
  * libevent implementation of Event::Dispatcher.
  */
@@ -31,6 +64,16 @@ public:
    */
   event_base& base() { return *base_; }
 
+  /**
+   * Called by the events of this dispatcher before running their callback. While the loop is being
+   * measured, the first callback of an iteration marks the end of the wait for events.
+   */
+  void onEventCallback() {
+    if (measuring_ && iteration_events_++ == 0) {
+      iteration_callbacks_start_ = std::chrono::steady_clock::now();
+    }
+  }
+
   // Event::Dispatcher
   void clearDeferredDeleteList() override;
   Network::ClientConnectionPtr
@@ -56,13 +99,24 @@ public:
   TimerPtr createTimer(TimerCb cb) override;
   void deferredDelete(DeferredDeletablePtr&& to_delete) override;
   void exit() override;
+  void initializeStats(Stats::Scope& scope, const std::string& prefix) override;
   SignalEventPtr listenForSignal(int signal_num, SignalCb cb) override;
   void post(std::function<void()> callback) override;
   void run(RunType type) override;
   Buffer::WatermarkFactory& getWatermarkFactory() override { return *buffer_factory_; }
 
 private:
+  // A posted callback. Posting allocates the node only, the callback is moved into it.
+  struct PostNode : public MpscQueue::Node {
+    PostNode(std::function<void()>&& callback) : callback_(std::move(callback)) {}
+
+    std::function<void()> callback_;
+  };
+
   void runPostCallbacks();
+  void runMeasured();
+  void recordIteration(MonotonicTime start, MonotonicTime end);
+  void flushIterationStats();
 #ifndef NDEBUG
   // Validate that an operation is thread safe, i.e. it's invoked on the same thread that the
   // dispatcher run loop is executing on. We allow run_tid_ == 0 for tests where we don't invoke
@@ -75,14 +129,39 @@ private:
   Thread::ThreadId run_tid_{};
   Buffer::WatermarkFactoryPtr buffer_factory_;
   Libevent::BasePtr base_;
+  std::unique_ptr<TimerWheelScheduler> timer_wheel_;
   TimerPtr deferred_delete_timer_;
+  // post() enables this timer from any thread. It is a plain libevent timer rather than a wheel
+  // timer, whose state is only safe to touch on the dispatcher thread, since event_active() takes
+  // the event base lock.
   TimerPtr post_timer_;
   std::vector<DeferredDeletablePtr> to_delete_1_;
   std::vector<DeferredDeletablePtr> to_delete_2_;
   std::vector<DeferredDeletablePtr>* current_to_delete_;
-  std::mutex post_lock_;
-  std::list<std::function<void()>> post_callbacks_;
+  std::unique_ptr<DispatcherStats> stats_;
+  MpscQueue post_queue_;
+  // Callbacks posted and not run yet. Producers only wake up the event loop when this goes from 0
+  // to 1, runPostCallbacks() keeps going until it drops back to 0.
+  std::atomic<uint64_t> post_queue_depth_{0};
+  // When the loop was last woken up for posted callbacks. Only this callback is timed, it is the
+  // oldest of its batch, so post() takes the time once per wakeup rather than per callback.
+  // runPostCallbacks() takes it back out, see there.
+  std::atomic<MonotonicTime> post_wakeup_time_{MonotonicTime::min()};
   bool deferred_deleting_{};
+  // Per iteration state while the loop is measured, see onEventCallback().
+  bool measuring_{};
+  uint64_t iteration_events_{};
+  MonotonicTime iteration_callbacks_start_;
+  // Loop iterations of the current utilization window. They are only added to the stats when the
+  // window ends, so that measuring an iteration does not touch any stat.
+  uint64_t window_iterations_{};
+  uint64_t window_events_{};
+  uint64_t window_max_events_{};
+  std::chrono::microseconds window_busy_{};
+  std::chrono::microseconds window_poll_wait_{};
+  std::chrono::microseconds window_max_busy_{};
+  uint64_t window_deferred_deleted_{};
+  uint64_t window_max_deferred_delete_batch_{};
 };
 
 } // namespace Event
@@ -27,7 +27,7 @@ private:
   void assignEvents(uint32_t events);
 
   FileReadyCb cb_;
-  event_base* base_;
+  DispatcherImpl& dispatcher_;
   int fd_;
   FileTriggerType trigger_;
 };
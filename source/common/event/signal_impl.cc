@@ -8,11 +8,14 @@ namespace Envoy {
 namespace Event {
 
 SignalEventImpl::SignalEventImpl(DispatcherImpl& dispatcher, int signal_num, SignalCb cb)
-    : cb_(cb) {
-  evsignal_assign(
-      &raw_event_, &dispatcher.base(), signal_num,
-      [](evutil_socket_t, short, void* arg) -> void { static_cast<SignalEventImpl*>(arg)->cb_(); },
-      this);
+    : dispatcher_(dispatcher), cb_(cb) {
+  evsignal_assign(&raw_event_, &dispatcher.base(), signal_num,
+                  [](evutil_socket_t, short, void* arg) -> void {
+                    SignalEventImpl* event = static_cast<SignalEventImpl*>(arg);
+                    event->dispatcher_.onEventCallback();
+                    event->cb_();
+                  },
+                  this);
   evsignal_add(&raw_event_, nullptr);
 }
 
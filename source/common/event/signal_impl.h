@@ -16,6 +16,7 @@ public:
   SignalEventImpl(DispatcherImpl& dispatcher, int signal_num, SignalCb cb);
 
 private:
+  DispatcherImpl& dispatcher_;
   SignalCb cb_;
 };
 
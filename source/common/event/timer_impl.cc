@@ -1,5 +1,6 @@
 #include "common/event/timer_impl.h"
 
+#include <algorithm>
 #include <chrono>
 
 #include "common/common/assert.h"
@@ -10,11 +11,15 @@
 namespace Envoy {
 namespace Event {
 
-TimerImpl::TimerImpl(DispatcherImpl& dispatcher, TimerCb cb) : cb_(cb) {
+TimerImpl::TimerImpl(DispatcherImpl& dispatcher, TimerCb cb) : dispatcher_(dispatcher), cb_(cb) {
   ASSERT(cb_);
-  evtimer_assign(
-      &raw_event_, &dispatcher.base(),
-      [](evutil_socket_t, short, void* arg) -> void { static_cast<TimerImpl*>(arg)->cb_(); }, this);
+  evtimer_assign(&raw_event_, &dispatcher.base(),
+                 [](evutil_socket_t, short, void* arg) -> void {
+                   TimerImpl* timer = static_cast<TimerImpl*>(arg);
+                   timer->dispatcher_.onEventCallback();
+                   timer->cb_();
+                 },
+                 this);
 }
 
 void TimerImpl::disableTimer() { event_del(&raw_event_); }
@@ -31,5 +36,98 @@ void TimerImpl::enableTimer(const std::chrono::milliseconds& d) {
   }
 }
 
+TimerWheelScheduler::TimerWheelScheduler(DispatcherImpl& dispatcher)
+    : dispatcher_(dispatcher), start_(std::chrono::steady_clock::now()) {
+  evtimer_assign(&raw_event_, &dispatcher.base(),
+                 [](evutil_socket_t, short, void* arg) -> void {
+                   static_cast<TimerWheelScheduler*>(arg)->onTimer();
+                 },
+                 this);
+}
+
+void TimerWheelScheduler::schedule(TimerWheel::Entry& entry, const std::chrono::milliseconds& d) {
+  ASSERT(d.count() > 0);
+  // Round the current time up so that the entry never expires early. The wheel itself only moves
+  // when the libevent timer fires, so it may be behind the current time.
+  const uint64_t expiry = std::max<uint64_t>((elapsed().count() + 999) / 1000 + d.count(),
+                                             wheel_.currentTick() + 1);
+  wheel_.schedule(entry, expiry);
+
+  // Expiries are almost always later than the current wakeup, in which case there is nothing to
+  // do. onTimer() re-arms once it is done, whatever callbacks schedule meanwhile.
+  if (!advancing_ && (!armed_ || expiry < armed_tick_)) {
+    arm();
+  }
+}
+
+void TimerWheelScheduler::onTimer() {
+  dispatcher_.onEventCallback();
+  armed_ = false;
+  advancing_ = true;
+  wheel_.advance(elapsed().count() / 1000);
+  advancing_ = false;
+  arm();
+}
+
+void TimerWheelScheduler::arm() {
+  Optional<uint64_t> wakeup = wheel_.nextWakeup();
+  if (!wakeup.valid()) {
+    // Timers have been cancelled, a stale wakeup is left to fire and find nothing to do.
+    return;
+  }
+
+  if (armed_ && armed_tick_ <= wakeup.value()) {
+    return;
+  }
+
+  const std::chrono::microseconds delay =
+      std::max<std::chrono::microseconds>(std::chrono::milliseconds(wakeup.value()) - elapsed(),
+                                          std::chrono::microseconds(0));
+  timeval tv;
+  tv.tv_sec = delay.count() / 1000000;
+  tv.tv_usec = delay.count() % 1000000;
+  event_add(&raw_event_, &tv);
+  armed_tick_ = wakeup.value();
+  armed_ = true;
+}
+
+WheelTimerImpl::WheelTimerImpl(DispatcherImpl& dispatcher, TimerWheelScheduler& scheduler,
+                               TimerCb cb)
+    : dispatcher_(dispatcher), scheduler_(scheduler), cb_(cb) {
+  ASSERT(cb_);
+  evtimer_assign(&raw_event_, &dispatcher.base(),
+                 [](evutil_socket_t, short, void* arg) -> void {
+                   WheelTimerImpl* timer = static_cast<WheelTimerImpl*>(arg);
+                   timer->activated_ = false;
+                   timer->dispatcher_.onEventCallback();
+                   timer->cb_();
+                 },
+                 this);
+}
+
+WheelTimerImpl::~WheelTimerImpl() { scheduler_.cancel(*this); }
+
+void WheelTimerImpl::disableTimer() {
+  scheduler_.cancel(*this);
+  if (activated_) {
+    event_del(&raw_event_);
+    activated_ = false;
+  }
+}
+
+void WheelTimerImpl::enableTimer(const std::chrono::milliseconds& d) {
+  if (d.count() == 0) {
+    scheduler_.cancel(*this);
+    event_active(&raw_event_, EV_TIMEOUT, 0);
+    activated_ = true;
+  } else {
+    if (activated_) {
+      event_del(&raw_event_);
+      activated_ = false;
+    }
+    scheduler_.schedule(*this, d);
+  }
+}
+
 } // namespace Event
 } // namespace Envoy
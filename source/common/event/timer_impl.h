@@ -1,11 +1,14 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 
+#include "envoy/common/time.h"
 #include "envoy/event/timer.h"
 
 #include "common/event/dispatcher_impl.h"
 #include "common/event/event_impl_base.h"
+#include "common/event/timer_wheel.h"
 
 namespace Envoy {
 namespace Event {
@@ -22,8 +25,72 @@ public:
   void enableTimer(const std::chrono::milliseconds& d) override;
 
 private:
+  DispatcherImpl& dispatcher_;
   TimerCb cb_;
 };
 
+/**
+ * Per dispatcher timer wheel with 1ms ticks, driven by a single libevent timer. Arming and
+ * disarming a timer is O(1) in the wheel, the libevent timer only gets re-armed when a timer is
+ * scheduled to expire before the current wakeup.
+ */
+class TimerWheelScheduler : ImplBase {
+public:
+  TimerWheelScheduler(DispatcherImpl& dispatcher);
+
+  /**
+   * Schedule an entry to expire after at least the given duration, rescheduling it if needed.
+   * @param entry supplies the entry.
+   * @param d supplies the duration. Must be greater than zero.
+   */
+  void schedule(TimerWheel::Entry& entry, const std::chrono::milliseconds& d);
+
+  /**
+   * Cancel an entry if it is scheduled.
+   * @param entry supplies the entry.
+   */
+  void cancel(TimerWheel::Entry& entry) { wheel_.cancel(entry); }
+
+private:
+  std::chrono::microseconds elapsed() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                 start_);
+  }
+  void onTimer();
+  void arm();
+
+  DispatcherImpl& dispatcher_;
+  TimerWheel wheel_;
+  const MonotonicTime start_;
+  // The tick the libevent timer fires at, if armed.
+  uint64_t armed_tick_{};
+  bool armed_{};
+  bool advancing_{};
+};
+
+/**
+ * Event::Timer implementation on top of the dispatcher's timer wheel. Timers armed with a zero
+ * duration are made active in libevent directly so that they run in the current loop iteration.
+ */
+class WheelTimerImpl : public Timer, TimerWheel::Entry, ImplBase {
+public:
+  WheelTimerImpl(DispatcherImpl& dispatcher, TimerWheelScheduler& scheduler, TimerCb cb);
+  ~WheelTimerImpl();
+
+  // Event::Timer
+  void disableTimer() override;
+  void enableTimer(const std::chrono::milliseconds& d) override;
+
+private:
+  // TimerWheel::Entry
+  void onExpired() override { cb_(); }
+
+  DispatcherImpl& dispatcher_;
+  TimerWheelScheduler& scheduler_;
+  TimerCb cb_;
+  // Whether raw_event_ has been made active and has not run yet.
+  bool activated_{};
+};
+
 } // namespace Event
 } // namespace Envoy
@@ -0,0 +1,203 @@
+#include "common/event/timer_wheel.h"
+
+#include <cstdint>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Event {
+
+TimerWheel::TimerWheel() {
+  for (Link& slot : slots_) {
+    slot.prev_ = &slot;
+    slot.next_ = &slot;
+  }
+}
+
+TimerWheel::~TimerWheel() {
+  // Leave remaining entries unscheduled so that they can be destroyed after the wheel.
+  for (Link& slot : slots_) {
+    Link* link = slot.next_;
+    while (link != &slot) {
+      Link* next = link->next_;
+      link->prev_ = nullptr;
+      link->next_ = nullptr;
+      link = next;
+    }
+  }
+}
+
+void TimerWheel::schedule(Entry& entry, uint64_t expiry) {
+  ASSERT(expiry > current_tick_);
+  if (entry.scheduled()) {
+    unlink(entry);
+  }
+  entry.expiry_ = expiry;
+  insert(entry);
+}
+
+void TimerWheel::cancel(Entry& entry) {
+  if (entry.scheduled()) {
+    unlink(entry);
+  }
+}
+
+void TimerWheel::insert(Entry& entry) {
+  // An entry goes in the lowest level at which its expiry and the current tick only differ in the
+  // bits that index that level. Entries in level 0 are then all due in the current 256 ticks
+  // block, and entries in any other level in a later slot of the current block of the level above.
+  uint32_t level = 0;
+  while (level < LEVELS - 1 &&
+         (entry.expiry_ >> levelShift(level + 1)) != (current_tick_ >> levelShift(level + 1))) {
+    level++;
+  }
+
+  const uint32_t mask = levelSlots(level) - 1;
+  uint32_t index;
+  if ((entry.expiry_ >> levelShift(LEVELS)) == (current_tick_ >> levelShift(LEVELS))) {
+    index = (entry.expiry_ >> levelShift(level)) & mask;
+  } else {
+    // Beyond the span of the wheel. Park the entry in the top level slot that cascades last before
+    // the span ends, or first after it if that slot is the current one. Either way this is before
+    // the entry is due, and the entry is placed again then.
+    index = ((current_tick_ >> levelShift(level)) & mask) == mask ? 0 : mask;
+  }
+
+  const uint32_t slot = levelOffset(level) + index;
+  Link& head = slots_[slot];
+  entry.slot_ = slot;
+  entry.prev_ = head.prev_;
+  entry.next_ = &head;
+  head.prev_->next_ = &entry;
+  head.prev_ = &entry;
+  occupied_[slot / 64] |= 1ULL << (slot % 64);
+}
+
+void TimerWheel::unlink(Entry& entry) {
+  entry.prev_->next_ = entry.next_;
+  entry.next_->prev_ = entry.prev_;
+  entry.prev_ = nullptr;
+  entry.next_ = nullptr;
+
+  // The entry may have been moved off its slot by advance() already, check the slot itself.
+  const uint32_t slot = entry.slot_;
+  if (slots_[slot].next_ == &slots_[slot]) {
+    occupied_[slot / 64] &= ~(1ULL << (slot % 64));
+  }
+}
+
+void TimerWheel::cascade(uint32_t level) {
+  Link list;
+  takeSlot(levelOffset(level) + ((current_tick_ >> levelShift(level)) & (levelSlots(level) - 1)),
+           list);
+
+  while (list.next_ != &list) {
+    Link* link = list.next_;
+    list.next_ = link->next_;
+    link->next_->prev_ = &list;
+    insert(entryFromLink(link));
+  }
+}
+
+void TimerWheel::expireCurrentSlot() {
+  // Callbacks may cancel or reschedule any entry, including those that are about to expire. Move
+  // the due entries to a local list so that such changes never touch the list being walked.
+  Link list;
+  takeSlot(current_tick_ & (FIRST_LEVEL_SLOTS - 1), list);
+
+  while (list.next_ != &list) {
+    Entry& entry = entryFromLink(list.next_);
+    unlink(entry);
+    entry.onExpired();
+  }
+}
+
+void TimerWheel::takeSlot(uint32_t slot, Link& list) {
+  Link& head = slots_[slot];
+  if (head.next_ == &head) {
+    list.next_ = &list;
+    list.prev_ = &list;
+    return;
+  }
+
+  list.next_ = head.next_;
+  list.prev_ = head.prev_;
+  list.next_->prev_ = &list;
+  list.prev_->next_ = &list;
+  head.next_ = &head;
+  head.prev_ = &head;
+  occupied_[slot / 64] &= ~(1ULL << (slot % 64));
+}
+
+void TimerWheel::advance(uint64_t tick) {
+  while (true) {
+    Optional<uint64_t> next = nextWakeup();
+    if (!next.valid() || next.value() > tick) {
+      break;
+    }
+
+    // Nothing is scheduled in between, so the ticks and cascade points in between can be skipped.
+    current_tick_ = next.value();
+    for (uint32_t level = LEVELS - 1; level > 0; level--) {
+      if ((current_tick_ & ((1ULL << levelShift(level)) - 1)) == 0) {
+        cascade(level);
+      }
+    }
+    expireCurrentSlot();
+  }
+
+  if (tick > current_tick_) {
+    current_tick_ = tick;
+  }
+}
+
+Optional<uint64_t> TimerWheel::nextWakeup() const {
+  // Every entry of a level is due before any slot of the levels above it cascades, so the first
+  // level that is not empty has the next wakeup.
+  for (uint32_t level = 0; level < LEVELS; level++) {
+    const uint32_t index = (current_tick_ >> levelShift(level)) & (levelSlots(level) - 1);
+    const int32_t distance = nextOccupied(level, index);
+    if (distance < 0) {
+      continue;
+    }
+
+    if (level == 0) {
+      return Optional<uint64_t>(current_tick_ + distance);
+    }
+
+    // The slot at the current index has cascaded already, anything else is at a later tick where
+    // all the lower bits are zero, possibly after wrapping around the level.
+    const uint64_t span = 1ULL << levelShift(level + 1);
+    const uint64_t base = current_tick_ & ~(span - 1);
+    uint64_t wakeup = base + (static_cast<uint64_t>((index + distance) & (levelSlots(level) - 1))
+                              << levelShift(level));
+    if (wakeup <= current_tick_) {
+      wakeup += span;
+    }
+    return Optional<uint64_t>(wakeup);
+  }
+
+  return Optional<uint64_t>();
+}
+
+int32_t TimerWheel::nextOccupied(uint32_t level, uint32_t index) const {
+  const uint32_t slots = levelSlots(level);
+  const uint32_t offset = levelOffset(level);
+  // Scan from index to the end of the level, then from the start of the level back to index.
+  for (uint32_t scanned = 0; scanned < slots;) {
+    const uint32_t i = (index + scanned) & (slots - 1);
+    const uint32_t slot = offset + i;
+    const uint64_t word = occupied_[slot / 64] >> (slot % 64);
+    if (word != 0) {
+      // Levels are a multiple of 64 slots, so the bit found is in this level. Past the wrap around
+      // it can only be before index, the rest was scanned already.
+      return scanned + __builtin_ctzll(word);
+    }
+    // Skip to the start of the next word, or to the start of the level.
+    scanned += 64 - (slot % 64);
+  }
+  return -1;
+}
+
+} // namespace Event
+} // namespace Envoy
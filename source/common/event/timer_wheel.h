@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "envoy/common/optional.h"
+#include "envoy/common/pure.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Event {
+
+/**
+ * Hierarchical timer wheel. Time is measured in ticks, and entries are kept in intrusive lists so
+ * that scheduling and cancelling an entry is O(1) no matter how many entries there are.
+ *
+ * The first level has one slot per tick for the next 256 ticks. Each further level has 64 slots
+ * covering 64 times the span of the level below. Entries further out sit in a coarse slot until
+ * the wheel gets there, at which point they are moved down to a finer level (cascading). Timeouts
+ * are usually cancelled or moved long before they expire, so most entries never cascade at all.
+ *
+ * The wheel is driven by calls to advance() and is not thread safe.
+ */
+class TimerWheel : NonCopyable {
+private:
+  // Intrusive circular list link. Each slot has a sentinel link.
+  struct Link {
+    Link* prev_{};
+    Link* next_{};
+  };
+
+public:
+  /**
+   * An entry in the wheel. The entry must not be destroyed while it is scheduled.
+   */
+  class Entry : Link {
+  public:
+    virtual ~Entry() {}
+
+    /**
+     * @return bool whether the entry is scheduled.
+     */
+    bool scheduled() const { return next_ != nullptr; }
+
+    /**
+     * @return uint64_t the tick the entry expires at, if scheduled.
+     */
+    uint64_t expiry() const { return expiry_; }
+
+  protected:
+    /**
+     * Called when the wheel reaches the entry's expiry tick. The entry is no longer scheduled when
+     * this is called, and may be rescheduled from within the callback.
+     */
+    virtual void onExpired() PURE;
+
+  private:
+    uint64_t expiry_{};
+    uint16_t slot_{};
+
+    friend class TimerWheel;
+  };
+
+  TimerWheel();
+  ~TimerWheel();
+
+  /**
+   * Schedule an entry, rescheduling it if it already is.
+   * @param entry supplies the entry.
+   * @param expiry supplies the tick to expire the entry at. Must be after the current tick.
+   */
+  void schedule(Entry& entry, uint64_t expiry);
+
+  /**
+   * Cancel an entry if it is scheduled.
+   * @param entry supplies the entry.
+   */
+  void cancel(Entry& entry);
+
+  /**
+   * Advance the wheel, expiring every entry scheduled up to and including the given tick in order
+   * of expiry.
+   * @param tick supplies the tick to advance to. Ticks never go backwards.
+   */
+  void advance(uint64_t tick);
+
+  /**
+   * @return Optional<uint64_t> the next tick at which advance() has work to do, if any. This is
+   *         the expiry of the next entry, or the earlier tick at which the wheel has to cascade
+   *         entries that may expire before it.
+   */
+  Optional<uint64_t> nextWakeup() const;
+
+  /**
+   * @return uint64_t the tick the wheel has advanced to.
+   */
+  uint64_t currentTick() const { return current_tick_; }
+
+private:
+  static const uint32_t LEVELS = 5;
+  static const uint32_t FIRST_LEVEL_BITS = 8;
+  static const uint32_t LEVEL_BITS = 6;
+  static const uint32_t FIRST_LEVEL_SLOTS = 1 << FIRST_LEVEL_BITS;
+  static const uint32_t LEVEL_SLOTS = 1 << LEVEL_BITS;
+  static const uint32_t SLOTS = FIRST_LEVEL_SLOTS + (LEVELS - 1) * LEVEL_SLOTS;
+
+  static uint32_t levelShift(uint32_t level) {
+    return level == 0 ? 0 : FIRST_LEVEL_BITS + (level - 1) * LEVEL_BITS;
+  }
+  static uint32_t levelSlots(uint32_t level) {
+    return level == 0 ? FIRST_LEVEL_SLOTS : LEVEL_SLOTS;
+  }
+  static uint32_t levelOffset(uint32_t level) {
+    return level == 0 ? 0 : FIRST_LEVEL_SLOTS + (level - 1) * LEVEL_SLOTS;
+  }
+
+  static Entry& entryFromLink(Link* link) { return *static_cast<Entry*>(link); }
+
+  void insert(Entry& entry);
+  void unlink(Entry& entry);
+  void cascade(uint32_t level);
+  void expireCurrentSlot();
+  // Move the list of a slot to the given sentinel, leaving the slot empty.
+  void takeSlot(uint32_t slot, Link& list);
+  // The first non-empty slot of the level at or after the given index, wrapping around, as a
+  // distance from that index. -1 if the level is empty.
+  int32_t nextOccupied(uint32_t level, uint32_t index) const;
+
+  uint64_t current_tick_{};
+  // Sentinels of the circular list of each slot, all levels back to back.
+  std::array<Link, SLOTS> slots_;
+  // One bit per slot, set when the slot is not empty.
+  std::array<uint64_t, SLOTS / 64> occupied_{};
+};
+
+} // namespace Event
+} // namespace Envoy
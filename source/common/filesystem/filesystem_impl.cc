@@ -1,7 +1,11 @@
 #include "common/filesystem/filesystem_impl.h"
 
 #include <dirent.h>
+#include <limits.h>
+#include <sys/uio.h>
 
+#include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <cstdint>
 #include <fstream>
@@ -16,7 +20,9 @@
 #include "envoy/stats/stats.h"
 
 #include "common/common/assert.h"
+#include "common/common/hash.h"
 #include "common/common/thread.h"
+#include "common/stats/stats_impl.h"
 
 #include "fmt/format.h"
 
@@ -52,17 +58,119 @@ std::string fileReadToEnd(const std::string& path) {
   return file_string.str();
 }
 
+std::string fileStatsPrefix(const std::string& path) {
+  std::string name = path;
+  std::replace_if(name.begin(), name.end(),
+                  [](char c) -> bool { return !isalnum(c) && c != '-' && c != '_'; }, '_');
+
+  // Different paths can look the same once characters are replaced, so the hash of the path makes
+  // the name unique. The name is cut from the front, where paths tend to share directories, so that
+  // the longest stat name of the file still fits.
+  static const std::string PREFIX = "filesystem.file.";
+  static const size_t LONGEST_STAT_LENGTH = sizeof("write_queue_bytes") - 1;
+  const std::string hash = fmt::format("{:016x}", HashUtil::xxHash64(path));
+  // The hash is joined to the name with '_' and followed by '.'.
+  const size_t fixed_length = PREFIX.size() + hash.size() + 2 + LONGEST_STAT_LENGTH;
+  const size_t max_length = Stats::RawStatData::maxNameLength();
+  const size_t max_name_length = max_length > fixed_length ? max_length - fixed_length : 0;
+  if (name.size() > max_name_length) {
+    name.erase(0, name.size() - max_name_length);
+  }
+  name.erase(0, name.find_first_not_of('_'));
+
+  return fmt::format("{}{}_{}.", PREFIX, name, hash);
+}
+
+FlushThread::~FlushThread() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    ASSERT(pending_.empty());
+    exit_ = true;
+    event_.notify_one();
+  }
+
+  if (thread_ != nullptr) {
+    thread_->join();
+  }
+}
+
+void FlushThread::add(FileImpl&) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (thread_ == nullptr) {
+    thread_.reset(new Thread::Thread([this]() -> void { threadFunc(); }));
+  }
+}
+
+void FlushThread::remove(FileImpl& file) {
+  std::unique_lock<std::mutex> lock(lock_);
+  cancelFlushWithLock(file);
+  while (flushing_ == &file) {
+    flush_done_.wait(lock);
+  }
+}
+
+void FlushThread::requestFlush(FileImpl& file) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!file.flush_pending_) {
+    file.flush_pending_ = true;
+    pending_.push_back(&file);
+    event_.notify_one();
+  }
+}
+
+void FlushThread::cancelFlush(FileImpl& file) {
+  std::lock_guard<std::mutex> lock(lock_);
+  cancelFlushWithLock(file);
+}
+
+void FlushThread::cancelFlushWithLock(FileImpl& file) {
+  if (file.flush_pending_) {
+    pending_.erase(std::find(pending_.begin(), pending_.end(), &file));
+    file.flush_pending_ = false;
+  }
+}
+
+void FlushThread::threadFunc() {
+  std::unique_lock<std::mutex> lock(lock_);
+  while (true) {
+    while (pending_.empty() && !exit_) {
+      event_.wait(lock);
+    }
+
+    if (exit_) {
+      return;
+    }
+
+    FileImpl* file = pending_.front();
+    pending_.pop_front();
+    file->flush_pending_ = false;
+    flushing_ = file;
+
+    // A slow disk only holds up the other files, never the file's writers or remove().
+    lock.unlock();
+    file->flushFromThread();
+    lock.lock();
+
+    flushing_ = nullptr;
+    flush_done_.notify_all();
+  }
+}
+
 FileImpl::FileImpl(const std::string& path, Event::Dispatcher& dispatcher,
                    Thread::BasicLockable& lock, Api::OsSysCalls& os_sys_calls,
-                   Stats::Store& stats_store, std::chrono::milliseconds flush_interval_msec)
-    : path_(path), file_lock_(lock), flush_timer_(dispatcher.createTimer([this]() -> void {
+                   Stats::Store& stats_store, std::chrono::milliseconds flush_interval_msec,
+                   FlushThreadSharedPtr flush_thread)
+    : path_(path), file_lock_(lock), flush_thread_(flush_thread),
+      flush_timer_(dispatcher.createTimer([this]() -> void {
         stats_.flushed_by_timer_.inc();
-        flush_event_.notify_one();
+        flush_thread_->requestFlush(*this);
         flush_timer_->enableTimer(flush_interval_msec_);
       })),
       os_sys_calls_(os_sys_calls), flush_interval_msec_(flush_interval_msec),
       stats_{FILESYSTEM_STATS(POOL_COUNTER_PREFIX(stats_store, "filesystem."),
-                              POOL_GAUGE_PREFIX(stats_store, "filesystem."))} {
+                              POOL_GAUGE_PREFIX(stats_store, "filesystem."))},
+      file_stats_{FILE_STATS(POOL_COUNTER_PREFIX(stats_store, fileStatsPrefix(path)),
+                             POOL_GAUGE_PREFIX(stats_store, fileStatsPrefix(path)))} {
   open();
 }
 
@@ -78,14 +186,14 @@ void FileImpl::open() {
 void FileImpl::reopen() { reopen_file_ = true; }
 
 FileImpl::~FileImpl() {
+  bool flush_thread_added;
   {
-    std::unique_lock<std::mutex> lock(write_lock_);
-    flush_thread_exit_ = true;
-    flush_event_.notify_one();
+    std::lock_guard<std::mutex> lock(write_lock_);
+    flush_thread_added = flush_thread_added_;
   }
 
-  if (flush_thread_ != nullptr) {
-    flush_thread_->join();
+  if (flush_thread_added) {
+    flush_thread_->remove(*this);
   }
 
   // Flush any remaining data. If file was not opened for some reason, skip flushing part.
@@ -103,6 +211,9 @@ void FileImpl::doWrite(Buffer::Instance& buffer) {
   Buffer::RawSlice slices[num_slices];
   buffer.getRawSlices(slices, num_slices);
 
+  iovec iov[std::min<uint64_t>(num_slices, IOV_MAX)];
+  const uint64_t length = buffer.length();
+
   // We must do the actual writes to disk under lock, so that we don't intermix chunks from
   // different FileImpl pointing to the same underlying file. This can happen either via hot
   // restart or if calling code opens the same underlying file into a different FileImpl in the
@@ -113,55 +224,62 @@ void FileImpl::doWrite(Buffer::Instance& buffer) {
   //            process lock or had multiple locks.
   {
     std::lock_guard<Thread::BasicLockable> lock(file_lock_);
-    for (Buffer::RawSlice& slice : slices) {
-      ssize_t rc = os_sys_calls_.write(fd_, slice.mem_, slice.len_);
-      ASSERT(rc == static_cast<ssize_t>(slice.len_));
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t first = 0; first < num_slices; first += IOV_MAX) {
+      const uint64_t count = std::min<uint64_t>(num_slices - first, IOV_MAX);
+      size_t bytes = 0;
+      for (uint64_t i = 0; i < count; i++) {
+        iov[i].iov_base = slices[first + i].mem_;
+        iov[i].iov_len = slices[first + i].len_;
+        bytes += slices[first + i].len_;
+      }
+
+      ssize_t rc = os_sys_calls_.writev(fd_, iov, count);
+      ASSERT(rc == static_cast<ssize_t>(bytes));
       UNREFERENCED_PARAMETER(rc);
+      UNREFERENCED_PARAMETER(bytes);
       stats_.write_completed_.inc();
+      file_stats_.writes_.inc();
     }
+    file_stats_.write_latency_us_.add(std::chrono::duration_cast<std::chrono::microseconds>(
+                                          std::chrono::steady_clock::now() - start)
+                                          .count());
   }
 
-  stats_.write_total_buffered_.sub(buffer.length());
-  buffer.drain(buffer.length());
+  stats_.write_total_buffered_.sub(length);
+  file_stats_.write_queue_bytes_.sub(length);
+  buffer.drain(length);
 }
 
-void FileImpl::flushThreadFunc() {
+void FileImpl::flushFromThread() {
+  std::unique_lock<std::mutex> flush_lock;
 
-  while (true) {
-    std::unique_lock<std::mutex> flush_lock;
+  {
+    std::unique_lock<std::mutex> write_lock(write_lock_);
 
-    {
-      std::unique_lock<std::mutex> write_lock(write_lock_);
+    // Flushes can be requested by the timer with nothing buffered, or the buffer may have been
+    // flushed by flush() since the request.
+    if (flush_buffer_.length() == 0) {
+      return;
+    }
 
-      // flush_event_ can be woken up either by large enough flush_buffer or by timer.
-      // In case it was timer, flush_buffer_ can be empty.
-      while (flush_buffer_.length() == 0 && !flush_thread_exit_) {
-        flush_event_.wait(write_lock);
-      }
+    flush_lock = std::unique_lock<std::mutex>(flush_lock_);
+    about_to_write_buffer_.move(flush_buffer_);
+    ASSERT(flush_buffer_.length() == 0);
+  }
 
-      if (flush_thread_exit_) {
-        return;
+  // if we failed to open file before (-1 == fd_), then simply ignore
+  if (fd_ != -1) {
+    try {
+      if (reopen_file_) {
+        reopen_file_ = false;
+        os_sys_calls_.close(fd_);
+        open();
       }
 
-      flush_lock = std::unique_lock<std::mutex>(flush_lock_);
-      ASSERT(flush_buffer_.length() > 0);
-      about_to_write_buffer_.move(flush_buffer_);
-      ASSERT(flush_buffer_.length() == 0);
-    }
-
-    // if we failed to open file before (-1 == fd_), then simply ignore
-    if (fd_ != -1) {
-      try {
-        if (reopen_file_) {
-          reopen_file_ = false;
-          os_sys_calls_.close(fd_);
-          open();
-        }
-
-        doWrite(about_to_write_buffer_);
-      } catch (const EnvoyException&) {
-        stats_.reopen_failed_.inc();
-      }
+      doWrite(about_to_write_buffer_);
+    } catch (const EnvoyException&) {
+      stats_.reopen_failed_.inc();
     }
   }
 }
@@ -173,7 +291,7 @@ void FileImpl::flush() {
     std::lock_guard<std::mutex> write_lock(write_lock_);
 
     // flush_lock_ must be held while checking this or else it is
-    // possible that flushThreadFunc() has already moved data from
+    // possible that flushFromThread() has already moved data from
     // flush_buffer_ to about_to_write_buffer_, has unlocked write_lock_,
     // but has not yet completed doWrite().  This would allow flush() to
     // return before the pending data has actually been written to disk.
@@ -185,6 +303,11 @@ void FileImpl::flush() {
 
     about_to_write_buffer_.move(flush_buffer_);
     ASSERT(flush_buffer_.length() == 0);
+
+    // Everything buffered is written below, so a flush the thread has not started is not needed.
+    if (flush_thread_added_) {
+      flush_thread_->cancelFlush(*this);
+    }
   }
 
   doWrite(about_to_write_buffer_);
@@ -193,20 +316,24 @@ void FileImpl::flush() {
 void FileImpl::write(const std::string& data) {
   std::lock_guard<std::mutex> lock(write_lock_);
 
-  if (flush_thread_ == nullptr) {
+  // The first write is flushed right away, like a dedicated flush thread starting up would.
+  const bool first_write = !flush_thread_added_;
+  if (first_write) {
     createFlushStructures();
   }
 
   stats_.write_buffered_.inc();
   stats_.write_total_buffered_.add(data.length());
+  file_stats_.write_queue_bytes_.add(data.length());
   flush_buffer_.add(data);
-  if (flush_buffer_.length() > MIN_FLUSH_SIZE) {
-    flush_event_.notify_one();
+  if (first_write || flush_buffer_.length() > MIN_FLUSH_SIZE) {
+    flush_thread_->requestFlush(*this);
   }
 }
 
 void FileImpl::createFlushStructures() {
-  flush_thread_.reset(new Thread::Thread([this]() -> void { flushThreadFunc(); }));
+  flush_thread_->add(*this);
+  flush_thread_added_ = true;
   flush_timer_->enableTimer(flush_interval_msec_);
 }
 
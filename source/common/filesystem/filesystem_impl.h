@@ -4,6 +4,8 @@
 #include <chrono>
 #include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <string>
 
@@ -29,6 +31,20 @@ struct FileSystemStats {
   FILESYSTEM_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
 };
 
+// clang-format off
+#define FILE_STATS(COUNTER, GAUGE)                                                                 \
+  COUNTER(writes)                                                                                  \
+  COUNTER(write_latency_us)                                                                        \
+  GAUGE  (write_queue_bytes)
+// clang-format on
+
+/**
+ * Stats for a single file, see FileImpl.
+ */
+struct FileStats {
+  FILE_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
 namespace Filesystem {
 
 /**
@@ -47,18 +63,70 @@ bool directoryExists(const std::string& path);
  */
 std::string fileReadToEnd(const std::string& path);
 
+/**
+ * @return std::string the prefix of the stats for a file, @see FileImpl. It is the path with
+ *         everything but letters, digits, '-' and '_' replaced by '_', followed by '_' and a hash
+ *         of the path. Long paths are cut from the front so that every stat name of the file fits.
+ */
+std::string fileStatsPrefix(const std::string& path);
+
+class FileImpl;
+
+/**
+ * Thread that writes out the buffered data of every FileImpl sharing it, so that the number of
+ * threads does not grow with the number of access log files. Files ask for a flush when their
+ * buffer is large enough or their flush timer fires, and the thread flushes them in that order.
+ */
+class FlushThread {
+public:
+  ~FlushThread();
+
+  /**
+   * Start flushing a file. The thread itself is started with the first file.
+   */
+  void add(FileImpl& file);
+
+  /**
+   * Stop flushing a file. Returns once the thread is no longer flushing it.
+   */
+  void remove(FileImpl& file);
+
+  /**
+   * Ask for a file to be flushed. Asking again before the thread gets to the file has no effect.
+   */
+  void requestFlush(FileImpl& file);
+
+  /**
+   * Drop a request to flush a file, if the thread has not gotten to it yet.
+   */
+  void cancelFlush(FileImpl& file);
+
+private:
+  void cancelFlushWithLock(FileImpl& file);
+  void threadFunc();
+
+  std::mutex lock_;
+  std::condition_variable event_;      // Signalled when a flush is requested or on exit.
+  std::condition_variable flush_done_; // Signalled when the thread finishes flushing a file.
+  std::deque<FileImpl*> pending_;      // Files to flush, each at most once.
+  FileImpl* flushing_{};               // The file being flushed, if any.
+  bool exit_{};
+  Thread::ThreadPtr thread_;
+};
+
+typedef std::shared_ptr<FlushThread> FlushThreadSharedPtr;
+
 /**
  * This is a file implementation geared for writing out access logs. It turn out that in certain
  * cases even if a standard file is opened with O_NONBLOCK, the kernel can still block when writing.
- * This implementation uses a flush thread per file, with the idea there there aren't that many
- * files. If this turns out to be a good implementation we can potentially have a single flush
- * thread that flushes all files, but we will start with this.
+ * Buffered data is written out by a FlushThread, which is shared by all the files an Api creates,
+ * with a single writev() per batch.
  */
 class FileImpl : public File {
 public:
   FileImpl(const std::string& path, Event::Dispatcher& dispatcher, Thread::BasicLockable& lock,
            Api::OsSysCalls& osSysCalls, Stats::Store& stats_store,
-           std::chrono::milliseconds flush_interval_msec);
+           std::chrono::milliseconds flush_interval_msec, FlushThreadSharedPtr flush_thread);
   ~FileImpl();
 
   // Filesystem::File
@@ -76,8 +144,10 @@ public:
   void flush() override;
 
 private:
+  friend class FlushThread;
+
   void doWrite(Buffer::Instance& buffer);
-  void flushThreadFunc();
+  void flushFromThread();
   void open();
   void createFlushStructures();
 
@@ -91,6 +161,8 @@ private:
   //    1) write_lock_
   //    2) flush_lock_
   //    3) file_lock_
+  // The FlushThread's lock may be taken while holding write_lock_ and flush_lock_, but never
+  // together with file_lock_.
   Thread::BasicLockable& file_lock_; // This lock is used only by the flush thread when writing
                                      // to disk. This is used to make sure that file blocks do
                                      // not get interleaved by multiple processes writing to
@@ -103,9 +175,9 @@ private:
   std::mutex write_lock_;            // The lock is used when filling the flush buffer. It allows
                                      // multiple threads to write to the same file at relatively
                                      // high performance.  It is always local to the process.
-  Thread::ThreadPtr flush_thread_;
-  std::condition_variable_any flush_event_;
-  std::atomic<bool> flush_thread_exit_{};
+  FlushThreadSharedPtr flush_thread_;
+  bool flush_thread_added_{}; // Set under write_lock_ by the first write.
+  bool flush_pending_{};      // Only used by flush_thread_, under its lock.
   std::atomic<bool> reopen_file_{};
   Buffer::OwnedImpl flush_buffer_; // This buffer is used by multiple threads. It gets filled and
                                    // then flushed either when max size is reached or when a timer
@@ -121,6 +193,7 @@ private:
                                                         // matter if it reached the MIN_FLUSH_SIZE
                                                         // or not.
   FileSystemStats stats_;
+  FileStats file_stats_;
 };
 
 } // namespace Filesystem
@@ -44,7 +44,8 @@ TcpProxyConfig::Route::Route(const Json::Object& config) {
 
 TcpProxyConfig::TcpProxyConfig(const Json::Object& config,
                                Upstream::ClusterManager& cluster_manager, Stats::Scope& scope)
-    : stats_(generateStats(config.getString("stat_prefix"), scope)) {
+    : stats_(generateStats(config.getString("stat_prefix"), scope)),
+      splice_(config.getBoolean("splice", false)) {
   config.validateSchema(Json::Schema::TCP_PROXY_NETWORK_FILTER_SCHEMA);
 
   for (const Json::ObjectSharedPtr& route_desc :
@@ -56,36 +57,24 @@ TcpProxyConfig::TcpProxyConfig(const Json::Object& config,
                                        route_desc->getString("cluster")));
     }
   }
+
+  std::vector<TcpProxyRouteIndex::RouteCriteria> criteria;
+  criteria.reserve(routes_.size());
+  for (const Route& route : routes_) {
+    criteria.push_back({route.source_ips_, route.source_port_ranges_, route.destination_ips_,
+                        route.destination_port_ranges_});
+  }
+  route_index_.reset(new TcpProxyRouteIndex(criteria));
 }
 
 const std::string& TcpProxyConfig::getRouteFromEntries(Network::Connection& connection) {
-  for (const TcpProxyConfig::Route& route : routes_) {
-    if (!route.source_port_ranges_.empty() &&
-        !Network::Utility::portInRangeList(connection.remoteAddress(), route.source_port_ranges_)) {
-      continue;
-    }
-
-    if (!route.source_ips_.empty() && !route.source_ips_.contains(connection.remoteAddress())) {
-      continue;
-    }
-
-    if (!route.destination_port_ranges_.empty() &&
-        !Network::Utility::portInRangeList(connection.localAddress(),
-                                           route.destination_port_ranges_)) {
-      continue;
-    }
-
-    if (!route.destination_ips_.empty() &&
-        !route.destination_ips_.contains(connection.localAddress())) {
-      continue;
-    }
-
-    // if we made it past all checks, the route matches
-    return route.cluster_name_;
+  Optional<uint32_t> route =
+      route_index_->firstMatch(connection.remoteAddress(), connection.localAddress());
+  if (!route.valid()) {
+    return EMPTY_STRING;
   }
 
-  // no match, no more routes to try
-  return EMPTY_STRING;
+  return routes_[route.value()].cluster_name_;
 }
 
 TcpProxy::TcpProxy(TcpProxyConfigSharedPtr config, Upstream::ClusterManager& cluster_manager)
@@ -269,6 +258,20 @@ void TcpProxy::onDownstreamEvent(Network::ConnectionEvent event) {
   }
 }
 
+void TcpProxy::spliceConnections() {
+  // Each direction is spliced independently. A direction that cannot be spliced (for example
+  // because the downstream connection has other filters installed) keeps going through onData()
+  // and onUpstreamData().
+  Network::Connection& downstream = read_callbacks_->connection();
+  const bool downstream_spliced = downstream.spliceTo(*upstream_connection_);
+  const bool upstream_spliced = upstream_connection_->spliceTo(downstream);
+  ENVOY_CONN_LOG(debug, "splice downstream={} upstream={}", downstream, downstream_spliced,
+                 upstream_spliced);
+  if (downstream_spliced || upstream_spliced) {
+    config_->stats().downstream_cx_spliced_.inc();
+  }
+}
+
 void TcpProxy::onUpstreamData(Buffer::Instance& data) {
   read_callbacks_->connection().write(data);
   ASSERT(0 == data.length());
@@ -293,6 +296,9 @@ void TcpProxy::onUpstreamEvent(Network::ConnectionEvent event) {
   } else if (event == Network::ConnectionEvent::Connected) {
     connect_timespan_->complete();
     onConnectionSuccess();
+    if (config_ && config_->splice()) {
+      spliceConnections();
+    }
   }
 
   if (connect_timeout_timer_) {
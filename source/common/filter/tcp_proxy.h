@@ -14,6 +14,7 @@
 #include "envoy/upstream/upstream.h"
 
 #include "common/common/logger.h"
+#include "common/filter/tcp_proxy_route_index.h"
 #include "common/json/json_loader.h"
 #include "common/network/cidr_range.h"
 #include "common/network/filter_impl.h"
@@ -33,6 +34,7 @@ namespace Filter {
   GAUGE  (downstream_cx_tx_bytes_buffered)                                                         \
   COUNTER(downstream_cx_total)                                                                     \
   COUNTER(downstream_cx_no_route)                                                                  \
+  COUNTER(downstream_cx_spliced)                                                                   \
   COUNTER(downstream_flow_control_paused_reading_total)                                            \
   COUNTER(downstream_flow_control_resumed_reading_total)
 // clang-format on
@@ -64,6 +66,12 @@ public:
 
   const TcpProxyStats& stats() { return stats_; }
 
+  /**
+   * @return bool whether data should be spliced between the downstream and upstream connections
+   *         inside the kernel when both connections allow it.
+   */
+  bool splice() const { return splice_; }
+
 private:
   struct Route {
     Route(const Json::Object& config);
@@ -78,7 +86,9 @@ private:
   static TcpProxyStats generateStats(const std::string& name, Stats::Scope& scope);
 
   std::vector<Route> routes_;
+  std::unique_ptr<TcpProxyRouteIndex> route_index_;
   const TcpProxyStats stats_;
+  const bool splice_;
 };
 
 typedef std::shared_ptr<TcpProxyConfig> TcpProxyConfigSharedPtr;
@@ -168,6 +178,7 @@ protected:
   void onDownstreamEvent(Network::ConnectionEvent event);
   void onUpstreamData(Buffer::Instance& data);
   void onUpstreamEvent(Network::ConnectionEvent event);
+  void spliceConnections();
 
   TcpProxyConfigSharedPtr config_;
   Upstream::ClusterManager& cluster_manager_;
@@ -0,0 +1,199 @@
+#include "common/filter/tcp_proxy_route_index.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Filter {
+
+TcpProxyRouteIndex::TcpProxyRouteIndex(const std::vector<RouteCriteria>& routes)
+    : words_((routes.size() + 63) / 64), source_ips_(words_), destination_ips_(words_),
+      source_ports_(words_), destination_ports_(words_) {
+  for (uint32_t i = 0; i < routes.size(); i++) {
+    source_ips_.addRoute(i, routes[i].source_ips_);
+    source_ports_.addRoute(i, routes[i].source_port_ranges_);
+    destination_ips_.addRoute(i, routes[i].destination_ips_);
+    destination_ports_.addRoute(i, routes[i].destination_port_ranges_);
+  }
+
+  source_ips_.finalize();
+  source_ports_.finalize();
+  destination_ips_.finalize();
+  destination_ports_.finalize();
+}
+
+Optional<uint32_t>
+TcpProxyRouteIndex::firstMatch(const Network::Address::Instance& remote_address,
+                               const Network::Address::Instance& local_address) const {
+  const RouteSet& source_ips = source_ips_.lookup(remote_address);
+  const RouteSet& source_ports = source_ports_.lookup(remote_address);
+  const RouteSet& destination_ips = destination_ips_.lookup(local_address);
+  const RouteSet& destination_ports = destination_ports_.lookup(local_address);
+
+  for (size_t i = 0; i < words_; i++) {
+    const uint64_t matches =
+        source_ips[i] & source_ports[i] & destination_ips[i] & destination_ports[i];
+    if (matches != 0) {
+      return Optional<uint32_t>(i * 64 + __builtin_ctzll(matches));
+    }
+  }
+
+  return Optional<uint32_t>();
+}
+
+void TcpProxyRouteIndex::IpIndex::addRoute(uint32_t route, const Network::Address::IpList& ips) {
+  if (ips.empty()) {
+    setRoute(any_, route);
+    return;
+  }
+
+  for (const Network::Address::CidrRange& range : ips.ranges()) {
+    if (range.version() == Network::Address::IpVersion::v4) {
+      // In network byte order, so the bytes are laid out most significant first.
+      const uint32_t address = range.ipv4()->address();
+      setRoute(v4_.insert(reinterpret_cast<const uint8_t*>(&address), range.length()), route);
+    } else {
+      const std::array<uint8_t, 16> address = range.ipv6()->address();
+      setRoute(v6_.insert(address.data(), range.length()), route);
+    }
+  }
+}
+
+void TcpProxyRouteIndex::IpIndex::finalize() {
+  v4_.propagate(0, any_);
+  v6_.propagate(0, any_);
+}
+
+const TcpProxyRouteIndex::RouteSet&
+TcpProxyRouteIndex::IpIndex::lookup(const Network::Address::Instance& address) const {
+  if (address.type() != Network::Address::Type::Ip) {
+    return any_;
+  }
+
+  if (address.ip()->version() == Network::Address::IpVersion::v4) {
+    const uint32_t ipv4 = address.ip()->ipv4()->address();
+    return v4_.lookup(reinterpret_cast<const uint8_t*>(&ipv4), 32);
+  }
+
+  const std::array<uint8_t, 16> ipv6 = address.ip()->ipv6()->address();
+  return v6_.lookup(ipv6.data(), 128);
+}
+
+TcpProxyRouteIndex::IpIndex::Trie::Trie(size_t words) : words_(words), nodes_(1) {
+  // The root always holds a set so that lookups have something to fall back to.
+  nodes_[0].set_ = 0;
+  sets_.emplace_back(words_);
+}
+
+TcpProxyRouteIndex::RouteSet& TcpProxyRouteIndex::IpIndex::Trie::insert(const uint8_t* address,
+                                                                        int length) {
+  uint32_t node = 0;
+  for (int i = 0; i < length; i++) {
+    const uint32_t bit = (address[i / 8] >> (7 - i % 8)) & 1;
+    if (nodes_[node].children_[bit] == 0) {
+      nodes_[node].children_[bit] = nodes_.size();
+      nodes_.emplace_back();
+    }
+    node = nodes_[node].children_[bit];
+  }
+
+  if (nodes_[node].set_ == -1) {
+    nodes_[node].set_ = sets_.size();
+    sets_.emplace_back(words_);
+  }
+  return sets_[nodes_[node].set_];
+}
+
+const TcpProxyRouteIndex::RouteSet&
+TcpProxyRouteIndex::IpIndex::Trie::lookup(const uint8_t* address, int bits) const {
+  uint32_t node = 0;
+  const RouteSet* longest_match = &sets_[nodes_[0].set_];
+  for (int i = 0; i < bits; i++) {
+    const uint32_t bit = (address[i / 8] >> (7 - i % 8)) & 1;
+    node = nodes_[node].children_[bit];
+    if (node == 0) {
+      break;
+    }
+    if (nodes_[node].set_ != -1) {
+      longest_match = &sets_[nodes_[node].set_];
+    }
+  }
+
+  return *longest_match;
+}
+
+void TcpProxyRouteIndex::IpIndex::Trie::propagate(uint32_t node, const RouteSet& inherited) {
+  // A range also admits every route of the ranges containing it, so after this each set holds all
+  // the routes matching an address whose longest match ends at its node.
+  const RouteSet* set = &inherited;
+  if (nodes_[node].set_ != -1) {
+    RouteSet& own_set = sets_[nodes_[node].set_];
+    for (size_t i = 0; i < words_; i++) {
+      own_set[i] |= inherited[i];
+    }
+    set = &own_set;
+  }
+
+  for (uint32_t child : nodes_[node].children_) {
+    if (child != 0) {
+      propagate(child, *set);
+    }
+  }
+}
+
+void TcpProxyRouteIndex::PortIndex::addRoute(uint32_t route, const Network::PortRangeList& ports) {
+  if (ports.empty()) {
+    setRoute(any_, route);
+    return;
+  }
+
+  for (const Network::PortRange& range : ports) {
+    if (range.min() <= range.max()) {
+      ranges_.push_back({route, range.min(), range.max()});
+    }
+  }
+}
+
+void TcpProxyRouteIndex::PortIndex::finalize() {
+  interval_starts_.push_back(0);
+  for (const Range& range : ranges_) {
+    interval_starts_.push_back(range.min_);
+    interval_starts_.push_back(range.max_ + 1);
+  }
+  std::sort(interval_starts_.begin(), interval_starts_.end());
+  interval_starts_.erase(std::unique(interval_starts_.begin(), interval_starts_.end()),
+                         interval_starts_.end());
+
+  sets_.assign(interval_starts_.size(), any_);
+  for (const Range& range : ranges_) {
+    const auto first =
+        std::lower_bound(interval_starts_.begin(), interval_starts_.end(), range.min_);
+    const auto last =
+        std::lower_bound(interval_starts_.begin(), interval_starts_.end(), range.max_ + 1);
+    for (auto it = first; it != last; ++it) {
+      setRoute(sets_[it - interval_starts_.begin()], range.route_);
+    }
+  }
+
+  ranges_.clear();
+  ranges_.shrink_to_fit();
+}
+
+const TcpProxyRouteIndex::RouteSet&
+TcpProxyRouteIndex::PortIndex::lookup(const Network::Address::Instance& address) const {
+  if (address.type() != Network::Address::Type::Ip) {
+    return any_;
+  }
+
+  const auto it =
+      std::upper_bound(interval_starts_.begin(), interval_starts_.end(), address.ip()->port());
+  ASSERT(it != interval_starts_.begin());
+  return sets_[it - interval_starts_.begin() - 1];
+}
+
+} // namespace Filter
+} // namespace Envoy
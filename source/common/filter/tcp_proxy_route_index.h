@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "envoy/common/optional.h"
+#include "envoy/network/address.h"
+
+#include "common/network/cidr_range.h"
+#include "common/network/utility.h"
+
+namespace Envoy {
+namespace Filter {
+
+/**
+ * Lookup index over the TCP proxy route table. A route matches a connection when all of the
+ * criteria it specifies are satisfied, and the first matching route wins. Instead of testing the
+ * routes one by one, each criteria is compiled into a structure that yields the set of routes it
+ * admits for a given address:
+ *  - Source and destination IPs use a binary trie over the configured CIDR ranges. The deepest
+ *    range containing the address (longest prefix match) holds every route matching it.
+ *  - Source and destination ports use the sorted, disjoint intervals formed by the configured
+ *    port ranges.
+ * The sets are bitsets in route order, so the first matching route is the lowest bit set in all
+ * four of them.
+ */
+class TcpProxyRouteIndex {
+public:
+  /**
+   * Criteria of a single route. Empty lists match any address.
+   */
+  struct RouteCriteria {
+    const Network::Address::IpList& source_ips_;
+    const Network::PortRangeList& source_port_ranges_;
+    const Network::Address::IpList& destination_ips_;
+    const Network::PortRangeList& destination_port_ranges_;
+  };
+
+  /**
+   * @param routes supplies the criteria of every route, in route table order.
+   */
+  TcpProxyRouteIndex(const std::vector<RouteCriteria>& routes);
+
+  /**
+   * @param remote_address supplies the remote (source) address of the downstream connection.
+   * @param local_address supplies the local (destination) address of the downstream connection.
+   * @return Optional<uint32_t> the position of the first matching route, if any.
+   */
+  Optional<uint32_t> firstMatch(const Network::Address::Instance& remote_address,
+                                const Network::Address::Instance& local_address) const;
+
+private:
+  // One bit per route, in route order.
+  typedef std::vector<uint64_t> RouteSet;
+
+  class IpIndex {
+  public:
+    IpIndex(size_t words) : any_(words), v4_(words), v6_(words) {}
+
+    void addRoute(uint32_t route, const Network::Address::IpList& ips);
+    void finalize();
+    const RouteSet& lookup(const Network::Address::Instance& address) const;
+
+  private:
+    struct Node {
+      uint32_t children_[2]{};
+      // Index into sets_ if a configured range ends at this node, -1 otherwise.
+      int32_t set_{-1};
+    };
+
+    // A binary trie for a single IP version. Node 0 is the root.
+    struct Trie {
+      Trie(size_t words);
+
+      RouteSet& insert(const uint8_t* address, int length);
+      const RouteSet& lookup(const uint8_t* address, int bits) const;
+      void propagate(uint32_t node, const RouteSet& inherited);
+
+      const size_t words_;
+      std::vector<Node> nodes_;
+      std::vector<RouteSet> sets_;
+    };
+
+    RouteSet any_;
+    Trie v4_;
+    Trie v6_;
+  };
+
+  class PortIndex {
+  public:
+    PortIndex(size_t words) : any_(words) {}
+
+    void addRoute(uint32_t route, const Network::PortRangeList& ports);
+    void finalize();
+    const RouteSet& lookup(const Network::Address::Instance& address) const;
+
+  private:
+    struct Range {
+      uint32_t route_;
+      uint32_t min_;
+      uint32_t max_;
+    };
+
+    RouteSet any_;
+    std::vector<Range> ranges_;
+    // The disjoint intervals formed by all configured ranges. interval_starts_[i] is the first port
+    // of the interval admitting the routes in sets_[i].
+    std::vector<uint32_t> interval_starts_;
+    std::vector<RouteSet> sets_;
+  };
+
+  static void setRoute(RouteSet& set, uint32_t route) { set[route / 64] |= 1ULL << (route % 64); }
+
+  const size_t words_;
+  IpIndex source_ips_;
+  IpIndex destination_ips_;
+  PortIndex source_ports_;
+  PortIndex destination_ports_;
+};
+
+} // namespace Filter
+} // namespace Envoy
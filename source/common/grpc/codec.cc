@@ -1,10 +1,12 @@
 #include "common/grpc/codec.h"
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <vector>
 
 #include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
 
 namespace Envoy {
 namespace Grpc {
@@ -22,79 +24,105 @@ void Encoder::newFrame(uint8_t flags, uint64_t length, std::array<uint8_t, 5>& o
 Decoder::Decoder() : state_(State::FH_FLAG) {}
 
 bool Decoder::decode(Buffer::Instance& input, std::vector<Frame>& output) {
-  uint64_t count = input.getRawSlices(nullptr, 0);
-  Buffer::RawSlice slices[count];
-  input.getRawSlices(slices, count);
-  for (Buffer::RawSlice& slice : slices) {
-    uint8_t* mem = reinterpret_cast<uint8_t*>(slice.mem_);
-    for (uint64_t j = 0; j < slice.len_;) {
-      uint8_t c = *mem;
-      switch (state_) {
-      case State::FH_FLAG:
-        if (c & ~GRPC_FH_COMPRESSED) {
-          // Unsupported flags.
-          return false;
-        }
-        frame_.flags_ = c;
-        state_ = State::FH_LEN_0;
-        mem++;
-        j++;
-        break;
-      case State::FH_LEN_0:
-        frame_.length_ = static_cast<uint32_t>(c) << 24;
-        state_ = State::FH_LEN_1;
-        mem++;
-        j++;
-        break;
-      case State::FH_LEN_1:
-        frame_.length_ |= static_cast<uint32_t>(c) << 16;
-        state_ = State::FH_LEN_2;
-        mem++;
-        j++;
-        break;
-      case State::FH_LEN_2:
-        frame_.length_ |= static_cast<uint32_t>(c) << 8;
-        state_ = State::FH_LEN_3;
-        mem++;
-        j++;
-        break;
-      case State::FH_LEN_3:
-        frame_.length_ |= static_cast<uint32_t>(c);
-        if (frame_.length_ == 0) {
-          output.push_back(std::move(frame_));
-          state_ = State::FH_FLAG;
-        } else {
-          frame_.data_.reset(new Buffer::OwnedImpl());
-          state_ = State::DATA;
-        }
-        mem++;
-        j++;
-        break;
-      case State::DATA:
-        uint64_t remain_in_buffer = slice.len_ - j;
-        uint64_t remain_in_frame = frame_.length_ - frame_.data_->length();
-        if (remain_in_buffer <= remain_in_frame) {
-          frame_.data_->add(mem, remain_in_buffer);
-          mem += remain_in_buffer;
-          j += remain_in_buffer;
-        } else {
-          frame_.data_->add(mem, remain_in_frame);
-          mem += remain_in_frame;
-          j += remain_in_frame;
-        }
-        if (frame_.length_ == frame_.data_->length()) {
-          output.push_back(std::move(frame_));
-          frame_.flags_ = 0;
-          frame_.length_ = 0;
-          state_ = State::FH_FLAG;
-        }
-        break;
+  FrameAccumulator accumulator(accumulated_frame_, output);
+  return decode(input, accumulator);
+}
+
+bool Decoder::decode(Buffer::Instance& input, FrameCallbacks& callbacks) {
+  while (input.length() > 0) {
+    if (state_ == State::DATA) {
+      // Move the message out of the input without copying, up to the end of the frame.
+      const uint64_t to_move = std::min<uint64_t>(remaining_, input.length());
+      Buffer::OwnedImpl data;
+      data.move(input, to_move);
+      remaining_ -= to_move;
+      callbacks.onFrameData(data);
+      if (remaining_ == 0) {
+        state_ = State::FH_FLAG;
+        callbacks.onFrameEnd();
       }
+      continue;
+    }
+
+    // The header is at most 5 bytes, so only look at the first slice and come back for the rest.
+    Buffer::RawSlice slice;
+    input.getRawSlices(&slice, 1);
+    uint64_t consumed;
+    const bool valid =
+        decodeHeader(reinterpret_cast<const uint8_t*>(slice.mem_), slice.len_, callbacks, consumed);
+    // Frames emitted before an invalid one are drained, so the input is left at its start.
+    input.drain(consumed);
+    if (!valid) {
+      return false;
     }
   }
-  input.drain(input.length());
+
   return true;
 }
 
+bool Decoder::decodeHeader(const uint8_t* data, uint64_t length, FrameCallbacks& callbacks,
+                           uint64_t& consumed) {
+  uint64_t j = 0;
+  for (; j < length && state_ != State::DATA; j++) {
+    const uint8_t c = data[j];
+    switch (state_) {
+    case State::FH_FLAG:
+      if (c & ~GRPC_FH_COMPRESSED) {
+        // Unsupported flags. The flag is the first byte of a frame, so everything before it
+        // belongs to frames that have been decoded.
+        consumed = j;
+        return false;
+      }
+      frame_.flags_ = c;
+      state_ = State::FH_LEN_0;
+      break;
+    case State::FH_LEN_0:
+      frame_.length_ = static_cast<uint32_t>(c) << 24;
+      state_ = State::FH_LEN_1;
+      break;
+    case State::FH_LEN_1:
+      frame_.length_ |= static_cast<uint32_t>(c) << 16;
+      state_ = State::FH_LEN_2;
+      break;
+    case State::FH_LEN_2:
+      frame_.length_ |= static_cast<uint32_t>(c) << 8;
+      state_ = State::FH_LEN_3;
+      break;
+    case State::FH_LEN_3:
+      frame_.length_ |= static_cast<uint32_t>(c);
+      callbacks.onFrameStart(frame_.flags_, frame_.length_);
+      if (frame_.length_ == 0) {
+        callbacks.onFrameEnd();
+        state_ = State::FH_FLAG;
+      } else {
+        remaining_ = frame_.length_;
+        state_ = State::DATA;
+      }
+      break;
+    case State::DATA:
+      NOT_REACHED;
+    }
+  }
+
+  consumed = j;
+  return true;
+}
+
+void Decoder::FrameAccumulator::onFrameStart(uint8_t flags, uint32_t length) {
+  frame_.flags_ = flags;
+  frame_.length_ = length;
+  if (length > 0) {
+    frame_.data_.reset(new Buffer::OwnedImpl());
+  }
+}
+
+void Decoder::FrameAccumulator::onFrameData(Buffer::Instance& data) { frame_.data_->move(data); }
+
+void Decoder::FrameAccumulator::onFrameEnd() {
+  output_.push_back(std::move(frame_));
+  frame_.flags_ = 0;
+  frame_.length_ = 0;
+}
+
 } // namespace Grpc
 } // namespace Envoy
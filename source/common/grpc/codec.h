@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "envoy/buffer/buffer.h"
+#include "envoy/common/pure.h"
 
 namespace Envoy {
 namespace Grpc {
@@ -32,6 +33,27 @@ public:
   void newFrame(uint8_t flags, uint64_t length, std::array<uint8_t, 5>& output);
 };
 
+// Callbacks for streaming decoding of GRPC data frames. The message of each frame is delivered
+// as it arrives, so large messages do not have to be accumulated by the decoder.
+class FrameCallbacks {
+public:
+  virtual ~FrameCallbacks() {}
+
+  // Called when the header of a new frame has been decoded.
+  // @param flags supplies the GRPC data frame flags.
+  // @param length supplies the length of the frame's message.
+  virtual void onFrameStart(uint8_t flags, uint32_t length) PURE;
+
+  // Called with the next part of the current frame's message. The data has been moved out of the
+  // input buffer and never spans more than the current frame. It is drained after the callback
+  // returns, so anything the callee wants to keep must be moved out of it.
+  // @param data supplies the message data.
+  virtual void onFrameData(Buffer::Instance& data) PURE;
+
+  // Called once the whole message of the current frame has been delivered.
+  virtual void onFrameEnd() PURE;
+};
+
 class Decoder {
 public:
   Decoder();
@@ -39,12 +61,22 @@ public:
   // Decodes the given buffer with GRPC data frame. Drains the input buffer when
   // decoding succeeded (returns true). If the input is not sufficient to make a
   // complete GRPC data frame, it will be buffered in the decoder. If a decoding
-  // error happened, the input buffer remains unchanged.
+  // error happened, the input buffer is left at the start of the invalid frame;
+  // any frames before it have been decoded.
+  // The message data is moved from the input buffer into the frames rather than copied.
   // @param input supplies the binary octets wrapped in a GRPC data frame.
   // @param output supplies the buffer to store the decoded data.
   // @return bool whether the decoding succeeded or not.
   bool decode(Buffer::Instance& input, std::vector<Frame>& output);
 
+  // Decodes the given buffer with GRPC data frame, delivering frame boundaries and message data
+  // through the callbacks as soon as they are available. Nothing is buffered in the decoder besides
+  // a partially received frame header. Error handling is the same as decode() above.
+  // @param input supplies the binary octets wrapped in a GRPC data frame.
+  // @param callbacks supplies the callbacks to receive the decoded frames.
+  // @return bool whether the decoding succeeded or not.
+  bool decode(Buffer::Instance& input, FrameCallbacks& callbacks);
+
   // Determine the length of the current frame being decoded. This is useful when supplying a
   // partial frame to decode() and wanting to know how many more bytes need to be read to complete
   // the frame.
@@ -83,8 +115,34 @@ private:
     DATA,
   };
 
+  // Accumulates the streamed frames into whole Frame instances for decode() into a vector.
+  class FrameAccumulator : public FrameCallbacks {
+  public:
+    FrameAccumulator(Frame& frame, std::vector<Frame>& output) : frame_(frame), output_(output) {}
+
+    // Grpc::FrameCallbacks
+    void onFrameStart(uint8_t flags, uint32_t length) override;
+    void onFrameData(Buffer::Instance& data) override;
+    void onFrameEnd() override;
+
+  private:
+    Frame& frame_;
+    std::vector<Frame>& output_;
+  };
+
+  // Decodes as many header bytes as are available from the given data.
+  // @param consumed is set to the number of bytes consumed. On an invalid frame, that is the
+  //        number of bytes before the start of the invalid frame.
+  // @return bool false on an invalid frame.
+  bool decodeHeader(const uint8_t* data, uint64_t length, FrameCallbacks& callbacks,
+                    uint64_t& consumed);
+
   State state_;
   Frame frame_;
+  // The partially received frame when decoding into a vector.
+  Frame accumulated_frame_;
+  // Message bytes of the current frame that have not been delivered yet.
+  uint32_t remaining_{0};
 };
 } // namespace Grpc
 } // namespace Envoy
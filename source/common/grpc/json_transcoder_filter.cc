@@ -1,5 +1,7 @@
 #include "common/grpc/json_transcoder_filter.h"
 
+#include <algorithm>
+
 #include "envoy/common/exception.h"
 #include "envoy/http/filter.h"
 
@@ -8,6 +10,7 @@
 #include "common/common/utility.h"
 #include "common/filesystem/filesystem_impl.h"
 #include "common/grpc/common.h"
+#include "common/http/codes.h"
 #include "common/http/headers.h"
 #include "common/http/utility.h"
 #include "common/protobuf/protobuf.h"
@@ -245,7 +248,20 @@ Http::FilterDataStatus JsonTranscoderFilter::decodeData(Buffer::Instance& data,
     request_in_.finish();
   }
 
+  // Each message is forwarded as soon as it has been translated, so only a partially received
+  // message is held here. Bound it like the connection manager bounds buffered bodies.
+  const int64_t request_read = request_in_.ByteCount();
   readToBuffer(*transcoder_->RequestOutput(), data);
+  if (!updatePendingBytes(request_in_, request_in_.ByteCount() - request_read,
+                          data.length(), request_bytes_held_,
+                          decoder_callbacks_->decoderBufferLimit())) {
+    ENVOY_LOG(debug, "Transcoding request exceeded buffer limit");
+    error_ = true;
+    Http::Utility::sendLocalReply(*decoder_callbacks_, stream_reset_,
+                                  Http::Code::PayloadTooLarge,
+                                  Http::CodeUtility::toString(Http::Code::PayloadTooLarge));
+    return Http::FilterDataStatus::StopIterationNoBuffer;
+  }
 
   const auto& request_status = transcoder_->RequestStatus();
 
@@ -308,7 +324,16 @@ Http::FilterDataStatus JsonTranscoderFilter::encodeData(Buffer::Instance& data,
     response_in_.finish();
   }
 
+  const int64_t response_read = response_in_.ByteCount();
   readToBuffer(*transcoder_->ResponseOutput(), data);
+  if (!updatePendingBytes(response_in_, response_in_.ByteCount() - response_read,
+                          data.length(), response_bytes_held_,
+                          encoder_callbacks_->encoderBufferLimit())) {
+    ENVOY_LOG(debug, "Transcoding response exceeded buffer limit");
+    error_ = true;
+    encoder_callbacks_->resetStream();
+    return Http::FilterDataStatus::StopIterationNoBuffer;
+  }
 
   if (!method_->server_streaming()) {
     // Buffer until the response is complete.
@@ -362,7 +387,24 @@ void JsonTranscoderFilter::setEncoderFilterCallbacks(
   encoder_callbacks_ = &callbacks;
 }
 
-// TODO(lizan): Incorporate watermarks to bound buffer sizes
+bool JsonTranscoderFilter::updatePendingBytes(const TranscoderInputStreamImpl& input,
+                                              int64_t bytes_read, uint64_t bytes_output,
+                                              uint64_t& bytes_held, uint32_t limit) {
+  // The transcoder may read the start of a message into its own buffers before it is complete,
+  // e.g. the JSON parser consumes all of its input. Which of the bytes read in a step went into the
+  // messages it translated isn't known, so the bytes handed downstream are taken off the bytes
+  // read instead. Messages are translated in order, so the bytes held before a step that produced
+  // output went into that output, and no more than the bytes read in the step can still be held.
+  // The latter bound keeps the count from growing over a stream of messages that get smaller when
+  // translated, as JSON messages do.
+  bytes_held += bytes_read;
+  if (bytes_output > 0) {
+    bytes_held -= std::min(bytes_held, bytes_output);
+    bytes_held = std::min<uint64_t>(bytes_held, bytes_read);
+  }
+  return limit == 0 || bytes_held + input.BytesAvailable() <= limit;
+}
+
 bool JsonTranscoderFilter::readToBuffer(Protobuf::io::ZeroCopyInputStream& stream,
                                         Buffer::Instance& data) {
   const void* out;
@@ -101,6 +101,21 @@ public:
 private:
   bool readToBuffer(Protobuf::io::ZeroCopyInputStream& stream, Buffer::Instance& data);
 
+  /**
+   * Account for the body data held by the transcoder after a translation step: the bytes it has
+   * read into its own buffers without producing a message, and the bytes it has not read yet.
+   * Data is held while a message is only partially received, since messages are translated as a
+   * whole.
+   * @param input supplies the transcoder input stream that data was moved into.
+   * @param bytes_read supplies the number of bytes the transcoder read from input in the step.
+   * @param bytes_output supplies the number of bytes the translation step handed downstream.
+   * @param bytes_held supplies the count of bytes read but not translated yet to update.
+   * @param limit supplies the buffer limit of the stream, 0 for no limit.
+   * @return bool whether the held data is within the limit.
+   */
+  static bool updatePendingBytes(const TranscoderInputStreamImpl& input, int64_t bytes_read,
+                                 uint64_t bytes_output, uint64_t& bytes_held, uint32_t limit);
+
   JsonTranscoderConfig& config_;
   std::unique_ptr<google::grpc::transcoding::Transcoder> transcoder_;
   TranscoderInputStreamImpl request_in_;
@@ -110,6 +125,10 @@ private:
   const Protobuf::MethodDescriptor* method_{nullptr};
   Http::HeaderMap* response_headers_{nullptr};
 
+  // Body bytes read by the transcoder that have not come out as a translated message yet.
+  uint64_t request_bytes_held_{0};
+  uint64_t response_bytes_held_{0};
+
   bool error_{false};
   bool stream_reset_{false};
 };
@@ -2,9 +2,11 @@
 
 #include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "common/common/assert.h"
+#include "common/common/empty_string.h"
 #include "common/common/utility.h"
 
 #include "fmt/format.h"
@@ -13,6 +15,117 @@ namespace Envoy {
 namespace Http {
 namespace AccessLog {
 
+namespace {
+
+/**
+ * The plain RequestInfo values, as captured at the start of a snapshot.
+ */
+struct CapturedRequestInfo {
+  int64_t start_time_;
+  int64_t request_received_duration_us_;
+  int64_t response_received_duration_us_;
+  int64_t duration_us_;
+  uint64_t bytes_received_;
+  uint64_t bytes_sent_;
+  uint64_t response_flags_;
+  uint32_t response_code_;
+  bool has_response_code_;
+  bool health_check_;
+  Protocol protocol_;
+};
+
+/**
+ * RequestInfo restored from a CapturedRequestInfo. There is no upstream host and no downstream
+ * address, and it can not be modified.
+ */
+class SnapshotRequestInfo : public RequestInfo {
+public:
+  SnapshotRequestInfo(const CapturedRequestInfo& captured) : captured_(captured) {
+    if (captured_.has_response_code_) {
+      response_code_.value(captured_.response_code_);
+    }
+  }
+
+  // Http::AccessLog::RequestInfo
+  void setResponseFlag(ResponseFlag) override { NOT_IMPLEMENTED; }
+  void onUpstreamHostSelected(Upstream::HostDescriptionConstSharedPtr) override { NOT_IMPLEMENTED; }
+  SystemTime startTime() const override {
+    return SystemTime(SystemTime::duration(captured_.start_time_));
+  }
+  std::chrono::microseconds requestReceivedDuration() const override {
+    return std::chrono::microseconds(captured_.request_received_duration_us_);
+  }
+  void requestReceivedDuration(MonotonicTime) override { NOT_IMPLEMENTED; }
+  std::chrono::microseconds responseReceivedDuration() const override {
+    return std::chrono::microseconds(captured_.response_received_duration_us_);
+  }
+  void responseReceivedDuration(MonotonicTime) override { NOT_IMPLEMENTED; }
+  uint64_t bytesReceived() const override { return captured_.bytes_received_; }
+  Protocol protocol() const override { return captured_.protocol_; }
+  void protocol(Protocol) override { NOT_IMPLEMENTED; }
+  const Optional<uint32_t>& responseCode() const override { return response_code_; }
+  uint64_t bytesSent() const override { return captured_.bytes_sent_; }
+  std::chrono::microseconds duration() const override {
+    return std::chrono::microseconds(captured_.duration_us_);
+  }
+  bool getResponseFlag(ResponseFlag response_flag) const override {
+    return captured_.response_flags_ & response_flag;
+  }
+  Upstream::HostDescriptionConstSharedPtr upstreamHost() const override { return nullptr; }
+  bool healthCheck() const override { return captured_.health_check_; }
+  void healthCheck(bool) override { NOT_IMPLEMENTED; }
+  const std::string& getDownstreamAddress() const override { return EMPTY_STRING; }
+
+private:
+  const CapturedRequestInfo& captured_;
+  Optional<uint32_t> response_code_;
+};
+
+void captureRequestInfo(const RequestInfo& request_info, SnapshotWriter& snapshot) {
+  // Zeroed so that no uninitialized padding ends up in the snapshot.
+  CapturedRequestInfo captured;
+  memset(&captured, 0, sizeof(captured));
+
+  captured.start_time_ = request_info.startTime().time_since_epoch().count();
+  captured.request_received_duration_us_ = request_info.requestReceivedDuration().count();
+  captured.response_received_duration_us_ = request_info.responseReceivedDuration().count();
+  captured.duration_us_ = request_info.duration().count();
+  captured.bytes_received_ = request_info.bytesReceived();
+  captured.bytes_sent_ = request_info.bytesSent();
+  // RateLimited is the highest flag.
+  for (uint64_t flag = ResponseFlag::FailedLocalHealthCheck; flag <= ResponseFlag::RateLimited;
+       flag <<= 1) {
+    if (request_info.getResponseFlag(static_cast<ResponseFlag>(flag))) {
+      captured.response_flags_ |= flag;
+    }
+  }
+  captured.has_response_code_ = request_info.responseCode().valid();
+  if (captured.has_response_code_) {
+    captured.response_code_ = request_info.responseCode().value();
+  }
+  captured.health_check_ = request_info.healthCheck();
+  captured.protocol_ = request_info.protocol();
+
+  snapshot.add(captured);
+}
+
+void appendInteger(uint64_t value, std::string& out) {
+  char buffer[32];
+  out.append(buffer, StringUtil::itoa(buffer, sizeof(buffer), value));
+}
+
+void appendMilliseconds(std::chrono::microseconds duration, std::string& out) {
+  const int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+  if (ms < 0) {
+    out += '-';
+    appendInteger(-ms, out);
+  } else {
+    appendInteger(ms, out);
+  }
+}
+
+} // namespace
+
 const std::string ResponseFlagUtils::NONE = "-";
 const std::string ResponseFlagUtils::FAILED_LOCAL_HEALTH_CHECK = "LH";
 const std::string ResponseFlagUtils::NO_HEALTHY_UPSTREAM = "UH";
@@ -27,66 +140,41 @@ const std::string ResponseFlagUtils::DELAY_INJECTED = "DI";
 const std::string ResponseFlagUtils::FAULT_INJECTED = "FI";
 const std::string ResponseFlagUtils::RATE_LIMITED = "RL";
 
-void ResponseFlagUtils::appendString(std::string& result, const std::string& append) {
-  if (result.empty()) {
-    result = append;
-  } else {
-    result += "," + append;
-  }
-}
-
 const std::string ResponseFlagUtils::toShortString(const RequestInfo& request_info) {
   std::string result;
+  appendShortString(request_info, result);
+  return result;
+}
 
-  if (request_info.getResponseFlag(ResponseFlag::FailedLocalHealthCheck)) {
-    appendString(result, FAILED_LOCAL_HEALTH_CHECK);
-  }
-
-  if (request_info.getResponseFlag(ResponseFlag::NoHealthyUpstream)) {
-    appendString(result, NO_HEALTHY_UPSTREAM);
-  }
-
-  if (request_info.getResponseFlag(ResponseFlag::UpstreamRequestTimeout)) {
-    appendString(result, UPSTREAM_REQUEST_TIMEOUT);
-  }
-
-  if (request_info.getResponseFlag(ResponseFlag::LocalReset)) {
-    appendString(result, LOCAL_RESET);
-  }
-
-  if (request_info.getResponseFlag(ResponseFlag::UpstreamRemoteReset)) {
-    appendString(result, UPSTREAM_REMOTE_RESET);
-  }
-
-  if (request_info.getResponseFlag(ResponseFlag::UpstreamConnectionFailure)) {
-    appendString(result, UPSTREAM_CONNECTION_FAILURE);
-  }
-
-  if (request_info.getResponseFlag(ResponseFlag::UpstreamConnectionTermination)) {
-    appendString(result, UPSTREAM_CONNECTION_TERMINATION);
-  }
-
-  if (request_info.getResponseFlag(ResponseFlag::UpstreamOverflow)) {
-    appendString(result, UPSTREAM_OVERFLOW);
-  }
-
-  if (request_info.getResponseFlag(ResponseFlag::NoRouteFound)) {
-    appendString(result, NO_ROUTE_FOUND);
-  }
-
-  if (request_info.getResponseFlag(ResponseFlag::DelayInjected)) {
-    appendString(result, DELAY_INJECTED);
-  }
-
-  if (request_info.getResponseFlag(ResponseFlag::FaultInjected)) {
-    appendString(result, FAULT_INJECTED);
+void ResponseFlagUtils::appendShortString(const RequestInfo& request_info, std::string& out) {
+  static const std::pair<ResponseFlag, const std::string&> flags[] = {
+      {ResponseFlag::FailedLocalHealthCheck, FAILED_LOCAL_HEALTH_CHECK},
+      {ResponseFlag::NoHealthyUpstream, NO_HEALTHY_UPSTREAM},
+      {ResponseFlag::UpstreamRequestTimeout, UPSTREAM_REQUEST_TIMEOUT},
+      {ResponseFlag::LocalReset, LOCAL_RESET},
+      {ResponseFlag::UpstreamRemoteReset, UPSTREAM_REMOTE_RESET},
+      {ResponseFlag::UpstreamConnectionFailure, UPSTREAM_CONNECTION_FAILURE},
+      {ResponseFlag::UpstreamConnectionTermination, UPSTREAM_CONNECTION_TERMINATION},
+      {ResponseFlag::UpstreamOverflow, UPSTREAM_OVERFLOW},
+      {ResponseFlag::NoRouteFound, NO_ROUTE_FOUND},
+      {ResponseFlag::DelayInjected, DELAY_INJECTED},
+      {ResponseFlag::FaultInjected, FAULT_INJECTED},
+      {ResponseFlag::RateLimited, RATE_LIMITED}};
+
+  bool first = true;
+  for (const auto& flag : flags) {
+    if (request_info.getResponseFlag(flag.first)) {
+      if (!first) {
+        out += ',';
+      }
+      out += flag.second;
+      first = false;
+    }
   }
 
-  if (request_info.getResponseFlag(ResponseFlag::RateLimited)) {
-    appendString(result, RATE_LIMITED);
+  if (first) {
+    out += NONE;
   }
-
-  return result.empty() ? NONE : result;
 }
 
 const std::string AccessLogFormatUtils::DEFAULT_FORMAT =
@@ -96,8 +184,8 @@ const std::string AccessLogFormatUtils::DEFAULT_FORMAT =
     "\"%REQ(X-FORWARDED-FOR)%\" \"%REQ(USER-AGENT)%\" \"%REQ(X-REQUEST-ID)%\" "
     "\"%REQ(:AUTHORITY)%\" \"%UPSTREAM_HOST%\"\n";
 
-FormatterPtr AccessLogFormatUtils::defaultAccessLogFormatter() {
-  return FormatterPtr{new FormatterImpl(DEFAULT_FORMAT)};
+FormatterImplPtr AccessLogFormatUtils::defaultAccessLogFormatter() {
+  return FormatterImplPtr{new FormatterImpl(DEFAULT_FORMAT)};
 }
 
 static const std::string Http10String = "HTTP/1.0";
@@ -117,21 +205,42 @@ const std::string& AccessLogFormatUtils::protocolToString(Protocol protocol) {
   NOT_REACHED;
 }
 
-FormatterImpl::FormatterImpl(const std::string& format) {
-  formatters_ = AccessLogFormatParser::parse(format);
-}
+FormatterImpl::FormatterImpl(const std::string& format)
+    : instructions_(AccessLogFormatParser::parse(format)) {}
 
 std::string FormatterImpl::format(const Http::HeaderMap& request_headers,
                                   const Http::HeaderMap& response_headers,
                                   const RequestInfo& request_info) const {
   std::string log_line;
   log_line.reserve(256);
+  format(request_headers, response_headers, request_info, log_line);
+  return log_line;
+}
 
-  for (const FormatterPtr& formatter : formatters_) {
-    log_line += formatter->format(request_headers, response_headers, request_info);
+void FormatterImpl::format(const HeaderMap& request_headers, const HeaderMap& response_headers,
+                           const RequestInfo& request_info, std::string& log_line) const {
+  for (const FormatInstruction& instruction : instructions_) {
+    instruction.format(request_headers, response_headers, request_info, log_line);
   }
+}
 
-  return log_line;
+void FormatterImpl::capture(const HeaderMap& request_headers, const HeaderMap& response_headers,
+                            const RequestInfo& request_info, std::string& snapshot) const {
+  SnapshotWriter writer(snapshot);
+  captureRequestInfo(request_info, writer);
+  for (const FormatInstruction& instruction : instructions_) {
+    instruction.capture(request_headers, response_headers, request_info, writer);
+  }
+}
+
+void FormatterImpl::format(const char* snapshot, size_t length, std::string& log_line) const {
+  SnapshotReader reader(snapshot, length);
+  const CapturedRequestInfo captured = reader.get<CapturedRequestInfo>();
+  const SnapshotRequestInfo request_info(captured);
+  for (const FormatInstruction& instruction : instructions_) {
+    instruction.format(reader, request_info, log_line);
+  }
+  ASSERT(reader.done());
 }
 
 void AccessLogFormatParser::parseCommand(const std::string& token, const size_t start,
@@ -172,14 +281,14 @@ void AccessLogFormatParser::parseCommand(const std::string& token, const size_t
   }
 }
 
-std::vector<FormatterPtr> AccessLogFormatParser::parse(const std::string& format) {
+std::vector<FormatInstruction> AccessLogFormatParser::parse(const std::string& format) {
   std::string current_token;
-  std::vector<FormatterPtr> formatters;
+  std::vector<FormatInstruction> instructions;
 
   for (size_t pos = 0; pos < format.length(); ++pos) {
     if (format[pos] == '%') {
       if (!current_token.empty()) {
-        formatters.emplace_back(FormatterPtr{new PlainStringFormatter(current_token)});
+        instructions.push_back(FormatInstruction::literal(current_token));
         current_token = "";
       }
 
@@ -198,8 +307,9 @@ std::vector<FormatterPtr> AccessLogFormatParser::parse(const std::string& format
 
         parseCommand(token, start, main_header, alternative_header, max_length);
 
-        formatters.emplace_back(
-            FormatterPtr(new RequestHeaderFormatter(main_header, alternative_header, max_length)));
+        instructions.push_back(FormatInstruction::header(FormatInstruction::Op::RequestHeader,
+                                                         main_header, alternative_header,
+                                                         max_length));
       } else if (token.find("RESP(") == 0) {
         std::string main_header, alternative_header;
         Optional<size_t> max_length;
@@ -207,10 +317,11 @@ std::vector<FormatterPtr> AccessLogFormatParser::parse(const std::string& format
 
         parseCommand(token, start, main_header, alternative_header, max_length);
 
-        formatters.emplace_back(
-            FormatterPtr(new ResponseHeaderFormatter(main_header, alternative_header, max_length)));
+        instructions.push_back(FormatInstruction::header(FormatInstruction::Op::ResponseHeader,
+                                                         main_header, alternative_header,
+                                                         max_length));
       } else {
-        formatters.emplace_back(FormatterPtr(new RequestInfoFormatter(token)));
+        instructions.push_back(FormatInstruction::requestInfoField(token));
       }
 
       pos = command_end_position;
@@ -220,136 +331,224 @@ std::vector<FormatterPtr> AccessLogFormatParser::parse(const std::string& format
   }
 
   if (!current_token.empty()) {
-    formatters.emplace_back(FormatterPtr{new PlainStringFormatter(current_token)});
+    instructions.push_back(FormatInstruction::literal(current_token));
   }
 
-  return formatters;
+  return instructions;
 }
 
-RequestInfoFormatter::RequestInfoFormatter(const std::string& field_name) {
-  if (field_name == "START_TIME") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return AccessLogDateTimeFormatter::fromTime(request_info.startTime());
-    };
-  } else if (field_name == "REQUEST_DURATION") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
-                                request_info.requestReceivedDuration())
-                                .count());
-    };
-  } else if (field_name == "RESPONSE_DURATION") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
-                                request_info.responseReceivedDuration())
-                                .count());
-    };
-  } else if (field_name == "BYTES_RECEIVED") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return std::to_string(request_info.bytesReceived());
-    };
-  } else if (field_name == "PROTOCOL") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return AccessLogFormatUtils::protocolToString(request_info.protocol());
-    };
-  } else if (field_name == "RESPONSE_CODE") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return request_info.responseCode().valid()
-                 ? std::to_string(request_info.responseCode().value())
-                 : "0";
-    };
-  } else if (field_name == "BYTES_SENT") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return std::to_string(request_info.bytesSent());
-    };
-  } else if (field_name == "DURATION") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return std::to_string(
-          std::chrono::duration_cast<std::chrono::milliseconds>(request_info.duration()).count());
-    };
-  } else if (field_name == "RESPONSE_FLAGS") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      return ResponseFlagUtils::toShortString(request_info);
-    };
-  } else if (field_name == "UPSTREAM_HOST") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      if (request_info.upstreamHost()) {
-        return request_info.upstreamHost()->address()->asString();
-      } else {
-        return std::string("-");
-      }
-    };
-  } else if (field_name == "UPSTREAM_CLUSTER") {
-    field_extractor_ = [](const RequestInfo& request_info) {
-      std::string upstream_cluster_name;
-      if (nullptr != request_info.upstreamHost()) {
-        upstream_cluster_name = request_info.upstreamHost()->cluster().name();
-      }
+FormatInstruction FormatInstruction::literal(const std::string& text) {
+  return FormatInstruction(Op::Literal, text, "", "", Optional<size_t>());
+}
 
-      return upstream_cluster_name.empty() ? "-" : upstream_cluster_name;
-    };
-  } else {
-    throw EnvoyException(fmt::format("Not supported field in RequestInfo: {}", field_name));
-  }
+FormatInstruction FormatInstruction::header(Op op, const std::string& main_header,
+                                            const std::string& alternative_header,
+                                            const Optional<size_t>& max_length) {
+  ASSERT(op == Op::RequestHeader || op == Op::ResponseHeader);
+  return FormatInstruction(op, "", main_header, alternative_header, max_length);
 }
 
-std::string RequestInfoFormatter::format(const HeaderMap&, const HeaderMap&,
-                                         const RequestInfo& request_info) const {
-  return field_extractor_(request_info);
+FormatInstruction FormatInstruction::requestInfoField(const std::string& field_name) {
+  static const std::pair<const char*, Op> fields[] = {
+      {"START_TIME", Op::StartTime},
+      {"REQUEST_DURATION", Op::RequestDuration},
+      {"RESPONSE_DURATION", Op::ResponseDuration},
+      {"BYTES_RECEIVED", Op::BytesReceived},
+      {"PROTOCOL", Op::Protocol},
+      {"RESPONSE_CODE", Op::ResponseCode},
+      {"BYTES_SENT", Op::BytesSent},
+      {"DURATION", Op::Duration},
+      {"RESPONSE_FLAGS", Op::ResponseFlags},
+      {"UPSTREAM_HOST", Op::UpstreamHost},
+      {"UPSTREAM_CLUSTER", Op::UpstreamCluster}};
+
+  for (const auto& field : fields) {
+    if (field_name == field.first) {
+      return FormatInstruction(field.second, "", "", "", Optional<size_t>());
+    }
+  }
+
+  throw EnvoyException(fmt::format("Not supported field in RequestInfo: {}", field_name));
 }
 
-PlainStringFormatter::PlainStringFormatter(const std::string& str) : str_(str) {}
+void FormatInstruction::format(const HeaderMap& request_headers,
+                               const HeaderMap& response_headers, const RequestInfo& request_info,
+                               std::string& log_line) const {
+  switch (op_) {
+  case Op::Literal:
+    log_line += literal_;
+    break;
+  case Op::RequestHeader:
+    appendHeader(request_headers, log_line);
+    break;
+  case Op::ResponseHeader:
+    appendHeader(response_headers, log_line);
+    break;
+  default:
+    appendRequestInfoField(request_info, log_line);
+    break;
+  }
+}
 
-std::string PlainStringFormatter::format(const Http::HeaderMap&, const Http::HeaderMap&,
-                                         const RequestInfo&) const {
-  return str_;
+void FormatInstruction::capture(const HeaderMap& request_headers,
+                                const HeaderMap& response_headers, const RequestInfo& request_info,
+                                SnapshotWriter& snapshot) const {
+  // Only the values that are not part of the CapturedRequestInfo FormatterImpl writes first are
+  // captured, as the text they format to.
+  switch (op_) {
+  case Op::RequestHeader:
+  case Op::ResponseHeader: {
+    const char* value;
+    size_t length;
+    headerValue(op_ == Op::RequestHeader ? request_headers : response_headers, value, length);
+    snapshot.addString(value, length);
+    break;
+  }
+  case Op::UpstreamHost:
+  case Op::UpstreamCluster: {
+    const std::string& value = upstreamValue(request_info);
+    snapshot.addString(value.c_str(), value.size());
+    break;
+  }
+  default:
+    break;
+  }
 }
 
-HeaderFormatter::HeaderFormatter(const std::string& main_header,
-                                 const std::string& alternative_header,
-                                 const Optional<size_t>& max_length)
-    : main_header_(main_header), alternative_header_(alternative_header), max_length_(max_length) {}
+void FormatInstruction::format(SnapshotReader& snapshot, const RequestInfo& request_info,
+                               std::string& log_line) const {
+  switch (op_) {
+  case Op::Literal:
+    log_line += literal_;
+    break;
+  case Op::RequestHeader:
+  case Op::ResponseHeader:
+  case Op::UpstreamHost:
+  case Op::UpstreamCluster:
+    snapshot.appendString(log_line);
+    break;
+  default:
+    appendRequestInfoField(request_info, log_line);
+    break;
+  }
+}
 
-std::string HeaderFormatter::format(const HeaderMap& headers) const {
+const HeaderEntry* FormatInstruction::findHeader(const HeaderMap& headers) const {
   const HeaderEntry* header = headers.get(main_header_);
 
   if (!header && !alternative_header_.get().empty()) {
     header = headers.get(alternative_header_);
   }
 
-  std::string header_value_string;
-  if (!header) {
-    header_value_string = "-";
-  } else {
-    header_value_string = header->value().c_str();
+  return header;
+}
+
+void FormatInstruction::headerValue(const HeaderMap& headers, const char*& value,
+                                    size_t& length) const {
+  const HeaderEntry* header = findHeader(headers);
+  value = "-";
+  length = 1;
+  if (header) {
+    value = header->value().c_str();
+    length = header->value().size();
   }
 
-  if (max_length_.valid() && header_value_string.length() > max_length_.value()) {
-    return header_value_string.substr(0, max_length_.value());
+  if (max_length_.valid() && length > max_length_.value()) {
+    length = max_length_.value();
   }
+}
 
-  return header_value_string;
+void FormatInstruction::appendHeader(const HeaderMap& headers, std::string& log_line) const {
+  const char* value;
+  size_t length;
+  headerValue(headers, value, length);
+  log_line.append(value, length);
 }
 
-ResponseHeaderFormatter::ResponseHeaderFormatter(const std::string& main_header,
-                                                 const std::string& alternative_header,
-                                                 const Optional<size_t>& max_length)
-    : HeaderFormatter(main_header, alternative_header, max_length) {}
+const std::string& FormatInstruction::upstreamValue(const RequestInfo& request_info) const {
+  static const std::string none = "-";
+  if (nullptr == request_info.upstreamHost()) {
+    return none;
+  }
+
+  if (op_ == Op::UpstreamHost) {
+    return request_info.upstreamHost()->address()->asString();
+  }
 
-std::string ResponseHeaderFormatter::format(const Http::HeaderMap&,
-                                            const Http::HeaderMap& response_headers,
-                                            const RequestInfo&) const {
-  return HeaderFormatter::format(response_headers);
+  ASSERT(op_ == Op::UpstreamCluster);
+  const std::string& name = request_info.upstreamHost()->cluster().name();
+  return name.empty() ? none : name;
 }
 
+void FormatInstruction::appendRequestInfoField(const RequestInfo& request_info,
+                                               std::string& log_line) const {
+  switch (op_) {
+  case Op::StartTime:
+    AccessLogDateTimeFormatter::appendTime(request_info.startTime(), log_line);
+    break;
+  case Op::RequestDuration:
+    appendMilliseconds(request_info.requestReceivedDuration(), log_line);
+    break;
+  case Op::ResponseDuration:
+    appendMilliseconds(request_info.responseReceivedDuration(), log_line);
+    break;
+  case Op::BytesReceived:
+    appendInteger(request_info.bytesReceived(), log_line);
+    break;
+  case Op::Protocol:
+    log_line += AccessLogFormatUtils::protocolToString(request_info.protocol());
+    break;
+  case Op::ResponseCode:
+    appendInteger(request_info.responseCode().valid() ? request_info.responseCode().value() : 0,
+                  log_line);
+    break;
+  case Op::BytesSent:
+    appendInteger(request_info.bytesSent(), log_line);
+    break;
+  case Op::Duration:
+    appendMilliseconds(request_info.duration(), log_line);
+    break;
+  case Op::ResponseFlags:
+    ResponseFlagUtils::appendShortString(request_info, log_line);
+    break;
+  case Op::UpstreamHost:
+  case Op::UpstreamCluster:
+    log_line += upstreamValue(request_info);
+    break;
+  case Op::Literal:
+  case Op::RequestHeader:
+  case Op::ResponseHeader:
+    NOT_REACHED;
+  }
+}
+
+std::string InstructionFormatter::format(const HeaderMap& request_headers,
+                                         const HeaderMap& response_headers,
+                                         const RequestInfo& request_info) const {
+  std::string value;
+  instruction_.format(request_headers, response_headers, request_info, value);
+  return value;
+}
+
+PlainStringFormatter::PlainStringFormatter(const std::string& str)
+    : InstructionFormatter(FormatInstruction::literal(str)) {}
+
 RequestHeaderFormatter::RequestHeaderFormatter(const std::string& main_header,
                                                const std::string& alternative_header,
                                                const Optional<size_t>& max_length)
-    : HeaderFormatter(main_header, alternative_header, max_length) {}
+    : InstructionFormatter(FormatInstruction::header(FormatInstruction::Op::RequestHeader,
+                                                     main_header, alternative_header,
+                                                     max_length)) {}
 
-std::string RequestHeaderFormatter::format(const Http::HeaderMap& request_headers,
-                                           const Http::HeaderMap&, const RequestInfo&) const {
-  return HeaderFormatter::format(request_headers);
-}
+ResponseHeaderFormatter::ResponseHeaderFormatter(const std::string& main_header,
+                                                 const std::string& alternative_header,
+                                                 const Optional<size_t>& max_length)
+    : InstructionFormatter(FormatInstruction::header(FormatInstruction::Op::ResponseHeader,
+                                                     main_header, alternative_header,
+                                                     max_length)) {}
+
+RequestInfoFormatter::RequestInfoFormatter(const std::string& field_name)
+    : InstructionFormatter(FormatInstruction::requestInfoField(field_name)) {}
 
 } // namespace AccessLog
 } // namespace Http
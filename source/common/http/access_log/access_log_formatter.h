@@ -1,11 +1,15 @@
 #pragma once
 
-#include <functional>
+#include <string.h>
+
+#include <cstdint>
 #include <string>
 #include <vector>
 
 #include "envoy/http/access_log.h"
 
+#include "common/common/assert.h"
+
 namespace Envoy {
 namespace Http {
 namespace AccessLog {
@@ -17,9 +21,13 @@ class ResponseFlagUtils {
 public:
   static const std::string toShortString(const RequestInfo& request_info);
 
+  /**
+   * Append the same text toShortString() returns to a string.
+   */
+  static void appendShortString(const RequestInfo& request_info, std::string& out);
+
 private:
   ResponseFlagUtils();
-  static void appendString(std::string& result, const std::string& append);
 
   const static std::string NONE;
   const static std::string FAILED_LOCAL_HEALTH_CHECK;
@@ -36,24 +44,174 @@ private:
   const static std::string RATE_LIMITED;
 };
 
+/**
+ * Appends the values an access log line is formatted from to a binary snapshot.
+ */
+class SnapshotWriter {
+public:
+  SnapshotWriter(std::string& snapshot) : snapshot_(snapshot) {}
+
+  /**
+   * Append a trivially copyable value.
+   */
+  template <class T> void add(const T& value) {
+    snapshot_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  /**
+   * Append a length prefixed string.
+   */
+  void addString(const char* value, size_t length) {
+    add(static_cast<uint32_t>(length));
+    snapshot_.append(value, length);
+  }
+
+private:
+  std::string& snapshot_;
+};
+
+/**
+ * Reads the values written by SnapshotWriter back, in the same order.
+ */
+class SnapshotReader {
+public:
+  SnapshotReader(const char* data, size_t length) : pos_(data), end_(data + length) {}
+
+  template <class T> T get() {
+    ASSERT(pos_ + sizeof(T) <= end_);
+    T value;
+    memcpy(&value, pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return value;
+  }
+
+  /**
+   * Read a string written by addString() and append it to out.
+   */
+  void appendString(std::string& out) {
+    const uint32_t length = get<uint32_t>();
+    ASSERT(pos_ + length <= end_);
+    out.append(pos_, length);
+    pos_ += length;
+  }
+
+  bool done() const { return pos_ == end_; }
+
+private:
+  const char* pos_;
+  const char* end_;
+};
+
+/**
+ * One step of a compiled access log format. A format is compiled into a flat list of these, and
+ * formatting a line runs the list, appending each value to the output without intermediate strings.
+ *
+ * The work can also be split in two: capture() copies the values an instruction uses into a binary
+ * snapshot, and the snapshot format() turns them into the text the instruction would have produced
+ * for the original request. The capture is cheap enough to run on the worker that logs the request,
+ * while the string formatting can happen later on another thread.
+ */
+class FormatInstruction {
+public:
+  enum class Op {
+    Literal,
+    RequestHeader,
+    ResponseHeader,
+    StartTime,
+    RequestDuration,
+    ResponseDuration,
+    BytesReceived,
+    Protocol,
+    ResponseCode,
+    BytesSent,
+    Duration,
+    ResponseFlags,
+    UpstreamHost,
+    UpstreamCluster
+  };
+
+  /**
+   * @return FormatInstruction that appends a fixed string.
+   */
+  static FormatInstruction literal(const std::string& text);
+
+  /**
+   * @return FormatInstruction that appends the value of a header, or of the alternative header if
+   *         the main header is not there, or "-" if neither is.
+   * @param op supplies Op::RequestHeader or Op::ResponseHeader.
+   */
+  static FormatInstruction header(Op op, const std::string& main_header,
+                                  const std::string& alternative_header,
+                                  const Optional<size_t>& max_length);
+
+  /**
+   * @return FormatInstruction that appends a RequestInfo field. Throws EnvoyException if there is
+   *         no field by that name.
+   */
+  static FormatInstruction requestInfoField(const std::string& field_name);
+
+  /**
+   * Append the formatted value to a log line.
+   */
+  void format(const HeaderMap& request_headers, const HeaderMap& response_headers,
+              const RequestInfo& request_info, std::string& log_line) const;
+
+  /**
+   * Append the values the instruction uses that are not part of the captured RequestInfo to a
+   * snapshot.
+   */
+  void capture(const HeaderMap& request_headers, const HeaderMap& response_headers,
+               const RequestInfo& request_info, SnapshotWriter& snapshot) const;
+
+  /**
+   * Append the formatted value to a log line.
+   * @param snapshot supplies the snapshot, positioned at the values written by capture().
+   * @param request_info supplies the request info restored from the snapshot. Only the plain
+   *        values are restored, the upstream host is not.
+   * @param log_line supplies the line to append to.
+   */
+  void format(SnapshotReader& snapshot, const RequestInfo& request_info,
+              std::string& log_line) const;
+
+private:
+  FormatInstruction(Op op, const std::string& literal, const std::string& main_header,
+                    const std::string& alternative_header, const Optional<size_t>& max_length)
+      : op_(op), literal_(literal), main_header_(main_header),
+        alternative_header_(alternative_header), max_length_(max_length) {}
+
+  void appendHeader(const HeaderMap& headers, std::string& log_line) const;
+  void appendRequestInfoField(const RequestInfo& request_info, std::string& log_line) const;
+  const HeaderEntry* findHeader(const HeaderMap& headers) const;
+  void headerValue(const HeaderMap& headers, const char*& value, size_t& length) const;
+  const std::string& upstreamValue(const RequestInfo& request_info) const;
+
+  const Op op_;
+  const std::string literal_;
+  const LowerCaseString main_header_;
+  const LowerCaseString alternative_header_;
+  const Optional<size_t> max_length_;
+};
+
 /**
  * Access log format parser.
  */
 class AccessLogFormatParser {
 public:
-  static std::vector<FormatterPtr> parse(const std::string& format);
+  static std::vector<FormatInstruction> parse(const std::string& format);
 
 private:
   static void parseCommand(const std::string& token, const size_t start, std::string& main_header,
                            std::string& alternative_header, Optional<size_t>& max_length);
 };
 
+class FormatterImpl;
+
 /**
  * Util class for access log format.
  */
 class AccessLogFormatUtils {
 public:
-  static FormatterPtr defaultAccessLogFormatter();
+  static std::unique_ptr<FormatterImpl> defaultAccessLogFormatter();
   static const std::string& protocolToString(Protocol protocol);
 
 private:
@@ -73,77 +231,82 @@ public:
   std::string format(const HeaderMap& request_headers, const HeaderMap& response_headers,
                      const RequestInfo& request_info) const override;
 
+  /**
+   * Same as format() above, appending to a caller owned string. Formatting into a string that is
+   * reused across log lines does not allocate once the string has grown to the line length.
+   * @param log_line supplies the string the formatted line is appended to.
+   */
+  void format(const HeaderMap& request_headers, const HeaderMap& response_headers,
+              const RequestInfo& request_info, std::string& log_line) const;
+
+  /**
+   * Capture everything the format uses into a snapshot, see FormatInstruction.
+   * @param snapshot supplies the string the snapshot is appended to.
+   */
+  void capture(const HeaderMap& request_headers, const HeaderMap& response_headers,
+               const RequestInfo& request_info, std::string& snapshot) const;
+
+  /**
+   * Format a snapshot taken by capture(). The result is the same as format() would have returned
+   * for the captured request.
+   * @param log_line supplies the string the formatted line is appended to.
+   */
+  void format(const char* snapshot, size_t length, std::string& log_line) const;
+
 private:
-  std::vector<FormatterPtr> formatters_;
+  std::vector<FormatInstruction> instructions_;
 };
 
+typedef std::unique_ptr<FormatterImpl> FormatterImplPtr;
+
 /**
- * Formatter for string literal. It ignores headers and request info and returns string by which it
- * was initialized.
+ * Formatter that runs a single instruction.
  */
-class PlainStringFormatter : public Formatter {
+class InstructionFormatter : public Formatter {
 public:
-  PlainStringFormatter(const std::string& str);
+  InstructionFormatter(FormatInstruction&& instruction) : instruction_(std::move(instruction)) {}
 
   // Formatter::format
-  std::string format(const HeaderMap&, const HeaderMap&, const RequestInfo&) const override;
+  std::string format(const HeaderMap& request_headers, const HeaderMap& response_headers,
+                     const RequestInfo& request_info) const override;
 
 private:
-  std::string str_;
+  const FormatInstruction instruction_;
 };
 
-class HeaderFormatter {
+/**
+ * Formatter for string literal. It ignores headers and request info and returns string by which it
+ * was initialized.
+ */
+class PlainStringFormatter : public InstructionFormatter {
 public:
-  HeaderFormatter(const std::string& main_header, const std::string& alternative_header,
-                  const Optional<size_t>& max_length);
-
-  std::string format(const HeaderMap& headers) const;
-
-private:
-  LowerCaseString main_header_;
-  LowerCaseString alternative_header_;
-  Optional<size_t> max_length_;
+  PlainStringFormatter(const std::string& str);
 };
 
 /**
  * Formatter based on request header.
  */
-class RequestHeaderFormatter : public Formatter, HeaderFormatter {
+class RequestHeaderFormatter : public InstructionFormatter {
 public:
   RequestHeaderFormatter(const std::string& main_header, const std::string& alternative_header,
                          const Optional<size_t>& max_length);
-
-  // Formatter::format
-  std::string format(const HeaderMap& request_headers, const HeaderMap&,
-                     const RequestInfo&) const override;
 };
 
 /**
  * Formatter based on the response header.
  */
-class ResponseHeaderFormatter : public Formatter, HeaderFormatter {
+class ResponseHeaderFormatter : public InstructionFormatter {
 public:
   ResponseHeaderFormatter(const std::string& main_header, const std::string& alternative_header,
                           const Optional<size_t>& max_length);
-
-  // Formatter::format
-  std::string format(const HeaderMap&, const HeaderMap& response_headers,
-                     const RequestInfo&) const override;
 };
 
 /**
  * Formatter based on the RequestInfo field.
  */
-class RequestInfoFormatter : public Formatter {
+class RequestInfoFormatter : public InstructionFormatter {
 public:
   RequestInfoFormatter(const std::string& field_name);
-
-  // Formatter::format
-  std::string format(const HeaderMap&, const HeaderMap&,
-                     const RequestInfo& request_info) const override;
-
-private:
-  std::function<std::string(const RequestInfo&)> field_extractor_;
 };
 
 } // namespace AccessLog
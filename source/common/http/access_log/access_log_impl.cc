@@ -1,5 +1,8 @@
 #include "common/http/access_log/access_log_impl.h"
 
+#include <string.h>
+
+#include <algorithm>
 #include <cstdint>
 #include <string>
 
@@ -91,7 +94,8 @@ RuntimeFilter::RuntimeFilter(const envoy::api::v2::filter::RuntimeFilter& config
 bool RuntimeFilter::evaluate(const RequestInfo&, const HeaderMap& request_header) {
   const HeaderEntry* uuid = request_header.RequestId();
   uint16_t sampled_value;
-  if (uuid && UuidUtils::uuidModBy(uuid->value().c_str(), sampled_value, 100)) {
+  if (uuid &&
+      UuidUtils::uuidModBy(uuid->value().c_str(), uuid->value().size(), sampled_value, 100)) {
     uint64_t runtime_value =
         std::min<uint64_t>(runtime_.snapshot().getInteger(runtime_key_, 0), 100);
 
@@ -161,7 +165,7 @@ InstanceSharedPtr AccessLogFactory::fromProto(const envoy::api::v2::filter::Acce
 }
 
 FileAccessLog::FileAccessLog(const std::string& access_log_path, FilterPtr&& filter,
-                             FormatterPtr&& formatter,
+                             FormatterImplPtr&& formatter,
                              Envoy::AccessLog::AccessLogManager& log_manager)
     : filter_(std::move(filter)), formatter_(std::move(formatter)) {
   log_file_ = log_manager.createAccessLog(access_log_path);
@@ -183,11 +187,231 @@ void FileAccessLog::log(const HeaderMap* request_headers, const HeaderMap* respo
     }
   }
 
-  std::string access_log_line =
-      formatter_->format(*request_headers, *response_headers, request_info);
+  formatAndWrite(*request_headers, *response_headers, request_info);
+}
+
+void FileAccessLog::formatAndWrite(const HeaderMap& request_headers,
+                                   const HeaderMap& response_headers,
+                                   const RequestInfo& request_info) {
+  // Lines are formatted into a buffer that is reused by every log on the thread, so once it has
+  // grown to the longest line formatting does not allocate.
+  static thread_local std::string access_log_line;
+  access_log_line.clear();
+  formatter_->format(request_headers, response_headers, request_info, access_log_line);
   log_file_->write(access_log_line);
 }
 
+SnapshotRing::SnapshotRing(uint64_t capacity) : capacity_(capacity), data_(new char[capacity]) {
+  ASSERT((capacity_ & (capacity_ - 1)) == 0);
+}
+
+bool SnapshotRing::push(const std::string& record) {
+  const uint32_t length = record.size();
+  const uint64_t size = sizeof(length) + length;
+  const uint64_t tail = tail_.load(std::memory_order_relaxed);
+  if (size > capacity_ - (tail - head_.load(std::memory_order_acquire))) {
+    return false;
+  }
+
+  copyIn(tail, reinterpret_cast<const char*>(&length), sizeof(length));
+  copyIn(tail + sizeof(length), record.data(), length);
+  // Sequentially consistent, see BackgroundFormatThread::notify().
+  tail_.store(tail + size);
+  return true;
+}
+
+bool SnapshotRing::pop(std::string& record) {
+  const uint64_t head = head_.load(std::memory_order_relaxed);
+  if (head == tail_.load()) {
+    return false;
+  }
+
+  uint32_t length;
+  copyOut(head, reinterpret_cast<char*>(&length), sizeof(length));
+  record.resize(length);
+  copyOut(head + sizeof(length), &record[0], length);
+  head_.store(head + sizeof(length) + length, std::memory_order_release);
+  return true;
+}
+
+void SnapshotRing::copyIn(uint64_t position, const char* data, uint64_t length) {
+  const uint64_t offset = position & (capacity_ - 1);
+  const uint64_t first = std::min(length, capacity_ - offset);
+  memcpy(&data_[offset], data, first);
+  memcpy(&data_[0], data + first, length - first);
+}
+
+void SnapshotRing::copyOut(uint64_t position, char* data, uint64_t length) const {
+  const uint64_t offset = position & (capacity_ - 1);
+  const uint64_t first = std::min(length, capacity_ - offset);
+  memcpy(data, &data_[offset], first);
+  memcpy(data + first, &data_[0], length - first);
+}
+
+const uint64_t BackgroundFileAccessLog::RING_CAPACITY;
+
+BackgroundFormatThread::~BackgroundFormatThread() {
+  ASSERT(logs_.empty());
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    exit_ = true;
+    wakeup_.notify_one();
+  }
+
+  if (thread_) {
+    thread_->join();
+  }
+}
+
+void BackgroundFormatThread::add(BackgroundFileAccessLog& log) {
+  std::lock_guard<std::mutex> lock(lock_);
+  logs_.push_back(&log);
+}
+
+void BackgroundFormatThread::remove(BackgroundFileAccessLog& log) {
+  std::unique_lock<std::mutex> lock(lock_);
+  logs_.remove(&log);
+  drain_done_.wait(lock, [this, &log]() -> bool { return draining_ != &log; });
+}
+
+void BackgroundFormatThread::notify() {
+  // The thread clears pending_ before it drains the logs. Both that and the push of the record are
+  // sequentially consistent, so either the drain sees the record or this sees pending_ cleared
+  // and wakes the thread up. Only the first record after a drain takes the lock.
+  if (!pending_) {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!thread_) {
+      thread_.reset(new Thread::Thread([this]() -> void { threadFunc(); }));
+    }
+    pending_ = true;
+    wakeup_.notify_one();
+  }
+}
+
+void BackgroundFormatThread::threadFunc() {
+  std::string record;
+  std::string lines;
+  std::vector<BackgroundFileAccessLog*> logs;
+  std::unique_lock<std::mutex> lock(lock_);
+  while (true) {
+    wakeup_.wait(lock, [this]() -> bool { return pending_ || exit_; });
+    if (exit_) {
+      return;
+    }
+    pending_ = false;
+
+    // The lock is not held while a log is drained, so a log that is removed in the meantime is
+    // skipped. A removed log drains itself.
+    logs.assign(logs_.begin(), logs_.end());
+    for (BackgroundFileAccessLog* log : logs) {
+      if (std::find(logs_.begin(), logs_.end(), log) == logs_.end()) {
+        continue;
+      }
+      draining_ = log;
+      lock.unlock();
+      log->drain(record, lines);
+      lock.lock();
+      draining_ = nullptr;
+      drain_done_.notify_all();
+    }
+  }
+}
+
+BackgroundFileAccessLog::BackgroundFileAccessLog(const std::string& access_log_path,
+                                                 FilterPtr&& filter, FormatterImplPtr&& formatter,
+                                                 Envoy::AccessLog::AccessLogManager& log_manager,
+                                                 ThreadLocal::SlotAllocator& tls,
+                                                 Runtime::Loader& runtime, Stats::Scope& scope,
+                                                 BackgroundFormatThreadSharedPtr format_thread)
+    : FileAccessLog(access_log_path, std::move(filter), std::move(formatter), log_manager),
+      runtime_(runtime),
+      stats_{BACKGROUND_ACCESS_LOG_STATS(POOL_COUNTER_PREFIX(scope, "access_log."))},
+      format_thread_(format_thread), tls_slot_(tls.allocateSlot()) {
+  tls_slot_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalRing>();
+  });
+
+  format_thread_->add(*this);
+}
+
+BackgroundFileAccessLog::~BackgroundFileAccessLog() {
+  // Once the format thread is done with this log, the records it has not gotten to are written
+  // here.
+  format_thread_->remove(*this);
+  std::string record;
+  std::string lines;
+  drain(record, lines);
+}
+
+void BackgroundFileAccessLog::log(const HeaderMap* request_headers,
+                                  const HeaderMap* response_headers,
+                                  const RequestInfo& request_info) {
+  static HeaderMapImpl empty_headers;
+  if (!request_headers) {
+    request_headers = &empty_headers;
+  }
+  if (!response_headers) {
+    response_headers = &empty_headers;
+  }
+
+  if (filter_) {
+    if (!filter_->evaluate(request_info, *request_headers)) {
+      return;
+    }
+  }
+
+  // The runtime key is read for every line, so that background formatting can be turned off
+  // without recreating the log. Records already captured are still written by the format thread.
+  if (runtime_.snapshot().getInteger("access_log.background_formatting", 0) == 0) {
+    formatAndWrite(*request_headers, *response_headers, request_info);
+    return;
+  }
+
+  ThreadLocalRing& local = tls_slot_->getTyped<ThreadLocalRing>();
+  if (!local.ring_) {
+    local.ring_ = std::make_shared<SnapshotRing>(RING_CAPACITY);
+    std::lock_guard<std::mutex> lock(lock_);
+    rings_.push_back(local.ring_);
+  }
+
+  local.snapshot_.clear();
+  formatter_->capture(*request_headers, *response_headers, request_info, local.snapshot_);
+  if (!local.ring_->push(local.snapshot_)) {
+    stats_.background_ring_full_.inc();
+    formatAndWrite(*request_headers, *response_headers, request_info);
+    return;
+  }
+  stats_.background_captured_.inc();
+  format_thread_->notify();
+}
+
+void BackgroundFileAccessLog::drain(std::string& record, std::string& lines) {
+  // A ring is added before its first record is pushed, so a copy of the list is good enough.
+  std::vector<SnapshotRingSharedPtr> rings;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    rings = rings_;
+  }
+
+  // Lines are handed to the file in batches, which keeps the file's write lock mostly out of the
+  // way of workers that fall back to writing themselves.
+  static const uint64_t MAX_BATCH_SIZE = 64 * 1024;
+  for (const SnapshotRingSharedPtr& ring : rings) {
+    while (ring->pop(record)) {
+      formatter_->format(record.data(), record.size(), lines);
+      if (lines.size() >= MAX_BATCH_SIZE) {
+        log_file_->write(lines);
+        lines.clear();
+      }
+    }
+  }
+
+  if (!lines.empty()) {
+    log_file_->write(lines);
+    lines.clear();
+  }
+}
+
 } // namespace AccessLog
 } // namespace Http
 } // namespace Envoy
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -8,7 +13,12 @@
 #include "envoy/http/access_log.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/server/access_log_config.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
 
+#include "common/common/thread.h"
+#include "common/http/access_log/access_log_formatter.h"
 #include "common/protobuf/protobuf.h"
 
 #include "api/filter/http_connection_manager.pb.h"
@@ -157,17 +167,163 @@ public:
  */
 class FileAccessLog : public Instance {
 public:
-  FileAccessLog(const std::string& access_log_path, FilterPtr&& filter, FormatterPtr&& formatter,
-                Envoy::AccessLog::AccessLogManager& log_manager);
+  FileAccessLog(const std::string& access_log_path, FilterPtr&& filter,
+                FormatterImplPtr&& formatter, Envoy::AccessLog::AccessLogManager& log_manager);
 
   // Http::AccessLog::Instance
   void log(const HeaderMap* request_headers, const HeaderMap* response_headers,
            const RequestInfo& request_info) override;
 
-private:
+protected:
+  /**
+   * Format a line for a request that passed the filter and write it to the file.
+   */
+  void formatAndWrite(const HeaderMap& request_headers, const HeaderMap& response_headers,
+                      const RequestInfo& request_info);
+
   Filesystem::FileSharedPtr log_file_;
   FilterPtr filter_;
-  FormatterPtr formatter_;
+  FormatterImplPtr formatter_;
+};
+
+/**
+ * Single producer, single consumer ring of variable length records. The producer and the consumer
+ * may run on different threads without locking.
+ */
+class SnapshotRing {
+public:
+  /**
+   * @param capacity supplies the size of the ring in bytes. Must be a power of 2.
+   */
+  SnapshotRing(uint64_t capacity);
+
+  /**
+   * Append a record. Only called by the producer.
+   * @return bool false if there is not enough room for the record, in which case nothing is
+   *         written.
+   */
+  bool push(const std::string& record);
+
+  /**
+   * Remove the oldest record. Only called by the consumer.
+   * @param record supplies the string the record is copied to. It is overwritten.
+   * @return bool false if the ring is empty.
+   */
+  bool pop(std::string& record);
+
+private:
+  void copyIn(uint64_t position, const char* data, uint64_t length);
+  void copyOut(uint64_t position, char* data, uint64_t length) const;
+
+  const uint64_t capacity_;
+  std::unique_ptr<char[]> data_;
+  // Written by the producer only. Positions grow without wrapping and are masked on access.
+  std::atomic<uint64_t> tail_{};
+  char padding_[64];
+  // Written by the consumer only.
+  std::atomic<uint64_t> head_{};
+};
+
+typedef std::shared_ptr<SnapshotRing> SnapshotRingSharedPtr;
+
+// clang-format off
+#define BACKGROUND_ACCESS_LOG_STATS(COUNTER)                                                       \
+  COUNTER(background_captured)                                                                     \
+  COUNTER(background_ring_full)
+// clang-format on
+
+struct BackgroundAccessLogStats {
+  BACKGROUND_ACCESS_LOG_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+class BackgroundFileAccessLog;
+
+/**
+ * Thread that formats and writes the records captured by every BackgroundFileAccessLog sharing
+ * it, so that the number of threads does not grow with the number of access logs. It is shared
+ * through the singleton manager and started when the first record is captured.
+ */
+class BackgroundFormatThread : public Singleton::Instance {
+public:
+  ~BackgroundFormatThread();
+
+  /**
+   * Start draining a log's rings.
+   */
+  void add(BackgroundFileAccessLog& log);
+
+  /**
+   * Stop draining a log's rings. Returns once the thread is no longer draining them.
+   */
+  void remove(BackgroundFileAccessLog& log);
+
+  /**
+   * Wake the thread up after a record has been captured. Called on the workers.
+   */
+  void notify();
+
+private:
+  void threadFunc();
+
+  std::mutex lock_;
+  std::condition_variable wakeup_;
+  std::condition_variable drain_done_;       // Signalled when the thread finishes a log.
+  std::list<BackgroundFileAccessLog*> logs_; // Protected by lock_.
+  BackgroundFileAccessLog* draining_{};      // Protected by lock_.
+  std::atomic<bool> pending_{};
+  bool exit_{};              // Protected by lock_.
+  Thread::ThreadPtr thread_; // Protected by lock_.
+};
+
+typedef std::shared_ptr<BackgroundFormatThread> BackgroundFormatThreadSharedPtr;
+
+/**
+ * FileAccessLog that can move the string formatting off the workers, while the runtime key
+ * access_log.background_formatting is set. A worker then only captures the values the format uses
+ * (see FormatterImpl::capture()) into a ring of its own, which is allocated when it first does.
+ * A BackgroundFormatThread shared by all such logs formats the captured records and writes the
+ * lines to the file. If a worker's ring is full, that worker formats and writes the line itself.
+ *
+ * Lines from different workers can be written in a different order than the requests completed
+ * in, as with the file itself.
+ */
+class BackgroundFileAccessLog : public FileAccessLog {
+public:
+  BackgroundFileAccessLog(const std::string& access_log_path, FilterPtr&& filter,
+                          FormatterImplPtr&& formatter,
+                          Envoy::AccessLog::AccessLogManager& log_manager,
+                          ThreadLocal::SlotAllocator& tls, Runtime::Loader& runtime,
+                          Stats::Scope& scope, BackgroundFormatThreadSharedPtr format_thread);
+  ~BackgroundFileAccessLog();
+
+  // Http::AccessLog::Instance
+  void log(const HeaderMap* request_headers, const HeaderMap* response_headers,
+           const RequestInfo& request_info) override;
+
+  /**
+   * Format and write the records captured so far. Only called by one thread at a time.
+   * @param record supplies a string that is reused for each record.
+   * @param lines supplies a string that is reused for the formatted lines.
+   */
+  void drain(std::string& record, std::string& lines);
+
+  // Size of each worker's ring.
+  static const uint64_t RING_CAPACITY = 256 * 1024;
+
+private:
+  struct ThreadLocalRing : public ThreadLocal::ThreadLocalObject {
+    // Null until the thread captures its first record.
+    SnapshotRingSharedPtr ring_;
+    // Reused for every record captured on the thread.
+    std::string snapshot_;
+  };
+
+  Runtime::Loader& runtime_;
+  BackgroundAccessLogStats stats_;
+  std::mutex lock_;
+  std::vector<SnapshotRingSharedPtr> rings_; // Protected by lock_.
+  BackgroundFormatThreadSharedPtr format_thread_;
+  ThreadLocal::SlotPtr tls_slot_;
 };
 
 } // namespace AccessLog
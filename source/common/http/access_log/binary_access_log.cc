@@ -0,0 +1,320 @@
+#include "common/http/access_log/binary_access_log.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "envoy/common/exception.h"
+#include "envoy/upstream/upstream.h"
+
+#include "common/common/assert.h"
+#include "common/common/utility.h"
+#include "common/http/header_map_impl.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Http {
+namespace AccessLog {
+namespace Binary {
+
+namespace {
+
+void writeVarint(uint64_t value, std::string& output) {
+  while (value >= 0x80) {
+    output.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  output.push_back(static_cast<char>(value));
+}
+
+void writeString(const char* data, size_t size, std::string& output) {
+  writeVarint(size, output);
+  output.append(data, size);
+}
+
+bool readVarint(const uint8_t* data, size_t size, size_t& pos, uint64_t& value) {
+  value = 0;
+  for (uint32_t shift = 0; shift < 64 && pos < size; shift += 7) {
+    const uint8_t byte = data[pos++];
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool readString(const uint8_t* data, size_t size, size_t& pos, std::string& value) {
+  uint64_t length;
+  if (!readVarint(data, size, pos, length) || length > size - pos) {
+    return false;
+  }
+  value.assign(reinterpret_cast<const char*>(data + pos), length);
+  pos += length;
+  return true;
+}
+
+const ResponseFlag ALL_RESPONSE_FLAGS[] = {ResponseFlag::FailedLocalHealthCheck,
+                                           ResponseFlag::NoHealthyUpstream,
+                                           ResponseFlag::UpstreamRequestTimeout,
+                                           ResponseFlag::LocalReset,
+                                           ResponseFlag::UpstreamRemoteReset,
+                                           ResponseFlag::UpstreamConnectionFailure,
+                                           ResponseFlag::UpstreamConnectionTermination,
+                                           ResponseFlag::UpstreamOverflow,
+                                           ResponseFlag::NoRouteFound,
+                                           ResponseFlag::DelayInjected,
+                                           ResponseFlag::FaultInjected,
+                                           ResponseFlag::RateLimited};
+
+} // namespace
+
+const uint8_t RecordEncoder::VERSION;
+const size_t RecordEncoder::HEADER_SIZE;
+
+void RecordEncoder::encode(const HeaderMap& request_headers, const HeaderMap& response_headers,
+                           const RequestInfo& request_info, std::string& output) const {
+  const size_t start = output.size();
+  // The length is filled in once the record is complete.
+  output.append(HEADER_SIZE - 1, '\0');
+  output.push_back(static_cast<char>(VERSION));
+
+  writeVarint(std::chrono::duration_cast<std::chrono::microseconds>(
+                  request_info.startTime().time_since_epoch())
+                  .count(),
+              output);
+  writeVarint(request_info.requestReceivedDuration().count(), output);
+  writeVarint(request_info.responseReceivedDuration().count(), output);
+  writeVarint(request_info.duration().count(), output);
+  writeVarint(request_info.bytesReceived(), output);
+  writeVarint(request_info.bytesSent(), output);
+  writeVarint(request_info.responseCode().valid() ? request_info.responseCode().value() : 0,
+              output);
+
+  uint64_t response_flags = 0;
+  for (ResponseFlag flag : ALL_RESPONSE_FLAGS) {
+    if (request_info.getResponseFlag(flag)) {
+      response_flags |= flag;
+    }
+  }
+  writeVarint(response_flags, output);
+
+  output.push_back(static_cast<char>(request_info.protocol()));
+  output.push_back(request_info.healthCheck() ? 1 : 0);
+
+  if (request_info.upstreamHost()) {
+    const std::string& host = request_info.upstreamHost()->address()->asString();
+    const std::string& cluster = request_info.upstreamHost()->cluster().name();
+    writeString(host.data(), host.size(), output);
+    writeString(cluster.data(), cluster.size(), output);
+  } else {
+    writeVarint(0, output);
+    writeVarint(0, output);
+  }
+  const std::string& downstream_address = request_info.getDownstreamAddress();
+  writeString(downstream_address.data(), downstream_address.size(), output);
+
+  // The count is not known until the maps have been looked up, and the position of everything
+  // after it depends on its size, so the present headers are looked up twice.
+  uint64_t header_count = 0;
+  for (const SelectedHeader& header : headers_) {
+    const HeaderMap& map = header.type_ == HeaderType::Request ? request_headers : response_headers;
+    if (map.get(header.name_) != nullptr) {
+      header_count++;
+    }
+  }
+  writeVarint(header_count, output);
+  for (const SelectedHeader& header : headers_) {
+    const HeaderMap& map = header.type_ == HeaderType::Request ? request_headers : response_headers;
+    const HeaderEntry* entry = map.get(header.name_);
+    if (entry != nullptr) {
+      output.push_back(static_cast<char>(header.type_));
+      writeString(header.name_.get().data(), header.name_.get().size(), output);
+      writeString(entry->value().c_str(), entry->value().size(), output);
+    }
+  }
+
+  const size_t size = output.size() - start;
+  output[start] = static_cast<char>(size >> 24);
+  output[start + 1] = static_cast<char>(size >> 16);
+  output[start + 2] = static_cast<char>(size >> 8);
+  output[start + 3] = static_cast<char>(size);
+}
+
+SelectedHeaders RecordEncoder::parseHeaders(const std::string& format) {
+  SelectedHeaders headers;
+  for (std::string entry : StringUtil::split(format, ',')) {
+    const size_t begin = entry.find_first_not_of(" \t");
+    const size_t end = entry.find_last_not_of(" \t");
+    entry = begin == std::string::npos ? "" : entry.substr(begin, end - begin + 1);
+
+    HeaderType type;
+    size_t name_start;
+    if (entry.find("REQ(") == 0) {
+      type = HeaderType::Request;
+      name_start = 4;
+    } else if (entry.find("RESP(") == 0) {
+      type = HeaderType::Response;
+      name_start = 5;
+    } else {
+      throw EnvoyException(
+          fmt::format("Binary access log header '{}' is not REQ(name) or RESP(name)", entry));
+    }
+
+    if (entry.back() != ')' || entry.size() == name_start + 1) {
+      throw EnvoyException(
+          fmt::format("Binary access log header '{}' is not REQ(name) or RESP(name)", entry));
+    }
+    headers.push_back(
+        {type, LowerCaseString(entry.substr(name_start, entry.size() - name_start - 1))});
+  }
+  return headers;
+}
+
+SelectedHeaders RecordEncoder::defaultHeaders() {
+  return {{HeaderType::Request, LowerCaseString(":method")},
+          {HeaderType::Request, LowerCaseString("x-envoy-original-path")},
+          {HeaderType::Request, LowerCaseString(":path")},
+          {HeaderType::Request, LowerCaseString(":authority")},
+          {HeaderType::Request, LowerCaseString("user-agent")},
+          {HeaderType::Request, LowerCaseString("x-request-id")},
+          {HeaderType::Request, LowerCaseString("x-forwarded-for")},
+          {HeaderType::Response, LowerCaseString("x-envoy-upstream-service-time")}};
+}
+
+uint32_t RecordDecoder::recordLength(const uint8_t* data) {
+  return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+         (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+bool RecordDecoder::decode(const uint8_t* data, size_t size, Record& record) {
+  if (size < RecordEncoder::HEADER_SIZE || recordLength(data) != size ||
+      data[4] != RecordEncoder::VERSION) {
+    return false;
+  }
+
+  size_t pos = RecordEncoder::HEADER_SIZE;
+  uint64_t response_code;
+  if (!readVarint(data, size, pos, record.start_time_us_) ||
+      !readVarint(data, size, pos, record.request_received_duration_us_) ||
+      !readVarint(data, size, pos, record.response_received_duration_us_) ||
+      !readVarint(data, size, pos, record.duration_us_) ||
+      !readVarint(data, size, pos, record.bytes_received_) ||
+      !readVarint(data, size, pos, record.bytes_sent_) ||
+      !readVarint(data, size, pos, response_code) ||
+      !readVarint(data, size, pos, record.response_flags_) || size - pos < 2 ||
+      data[pos] > static_cast<uint8_t>(Protocol::Http2)) {
+    return false;
+  }
+  record.response_code_ = response_code;
+  record.protocol_ = static_cast<Protocol>(data[pos++]);
+  record.health_check_ = data[pos++] != 0;
+
+  uint64_t header_count;
+  if (!readString(data, size, pos, record.upstream_host_) ||
+      !readString(data, size, pos, record.upstream_cluster_) ||
+      !readString(data, size, pos, record.downstream_address_) ||
+      !readVarint(data, size, pos, header_count)) {
+    return false;
+  }
+
+  record.request_headers_.clear();
+  record.response_headers_.clear();
+  for (uint64_t i = 0; i < header_count; i++) {
+    if (pos == size || data[pos] > static_cast<uint8_t>(HeaderType::Response)) {
+      return false;
+    }
+    auto& headers = static_cast<HeaderType>(data[pos++]) == HeaderType::Request
+                        ? record.request_headers_
+                        : record.response_headers_;
+    headers.emplace_back();
+    if (!readString(data, size, pos, headers.back().first) ||
+        !readString(data, size, pos, headers.back().second)) {
+      return false;
+    }
+  }
+
+  return pos == size;
+}
+
+const std::string BinaryAccessLog::UNIX_SOCKET_PREFIX = "unix://";
+
+BinaryAccessLog::BinaryAccessLog(const std::string& path, FilterPtr&& filter,
+                                 const SelectedHeaders& headers,
+                                 Envoy::AccessLog::AccessLogManager& log_manager,
+                                 Api::OsSysCalls& os_sys_calls, Stats::Scope& scope)
+    : filter_(std::move(filter)), encoder_(headers), os_sys_calls_(os_sys_calls),
+      stats_{BINARY_ACCESS_LOG_STATS(POOL_COUNTER_PREFIX(scope, "access_log."))} {
+  if (!StringUtil::startsWith(path.c_str(), UNIX_SOCKET_PREFIX)) {
+    log_file_ = log_manager.createAccessLog(path);
+    return;
+  }
+
+  // Records are sent with sendto() rather than on a connected socket, so the receiver can start
+  // after Envoy and be restarted without the log having to reconnect.
+  const std::string socket_path = path.substr(UNIX_SOCKET_PREFIX.size());
+  memset(&address_, 0, sizeof(address_));
+  if (socket_path.empty() || socket_path.size() >= sizeof(address_.sun_path)) {
+    throw EnvoyException(fmt::format("Invalid binary access log socket path '{}'", socket_path));
+  }
+  address_.sun_family = AF_UNIX;
+  StringUtil::strlcpy(&address_.sun_path[0], socket_path.c_str(), sizeof(address_.sun_path));
+
+  fd_ = os_sys_calls_.socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (fd_ == -1) {
+    throw EnvoyException(fmt::format("Unable to create binary access log socket for '{}': {}",
+                                     socket_path, strerror(errno)));
+  }
+}
+
+BinaryAccessLog::~BinaryAccessLog() {
+  if (fd_ != -1) {
+    RELEASE_ASSERT(os_sys_calls_.close(fd_) == 0);
+  }
+}
+
+void BinaryAccessLog::log(const HeaderMap* request_headers, const HeaderMap* response_headers,
+                          const RequestInfo& request_info) {
+  static HeaderMapImpl empty_headers;
+  if (!request_headers) {
+    request_headers = &empty_headers;
+  }
+  if (!response_headers) {
+    response_headers = &empty_headers;
+  }
+
+  if (filter_) {
+    if (!filter_->evaluate(request_info, *request_headers)) {
+      return;
+    }
+  }
+
+  // As with FileAccessLog, records are encoded into a buffer that is reused on the thread.
+  static thread_local std::string record;
+  record.clear();
+  encoder_.encode(*request_headers, *response_headers, request_info, record);
+
+  if (log_file_) {
+    log_file_->write(record);
+    stats_.binary_records_.inc();
+    return;
+  }
+
+  const ssize_t rc =
+      os_sys_calls_.sendto(fd_, record.data(), record.size(), MSG_DONTWAIT,
+                           reinterpret_cast<const sockaddr*>(&address_), sizeof(address_));
+  if (rc == static_cast<ssize_t>(record.size())) {
+    stats_.binary_records_.inc();
+  } else {
+    stats_.binary_dropped_.inc();
+  }
+}
+
+} // namespace Binary
+} // namespace AccessLog
+} // namespace Http
+} // namespace Envoy
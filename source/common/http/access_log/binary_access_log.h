@@ -0,0 +1,160 @@
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/access_log/access_log.h"
+#include "envoy/api/os_sys_calls.h"
+#include "envoy/http/access_log.h"
+#include "envoy/http/header_map.h"
+#include "envoy/http/protocol.h"
+#include "envoy/stats/stats_macros.h"
+
+namespace Envoy {
+namespace Http {
+namespace AccessLog {
+namespace Binary {
+
+/**
+ * Which header map a logged header comes from.
+ */
+enum class HeaderType : uint8_t { Request = 0, Response = 1 };
+
+/**
+ * A header that is copied into every record when it is present.
+ */
+struct SelectedHeader {
+  HeaderType type_;
+  LowerCaseString name_;
+};
+
+typedef std::vector<SelectedHeader> SelectedHeaders;
+
+/**
+ * Encodes one access log record per request. A record is:
+ *
+ *   length:uint32 (big endian, the size of the whole record) version:uint8
+ *   start_time_us request_received_duration_us response_received_duration_us duration_us
+ *   bytes_received bytes_sent response_code response_flags
+ *   protocol:uint8 health_check:uint8
+ *   upstream_host:string upstream_cluster:string downstream_address:string
+ *   header_count (header_type:uint8 name:string value:string)*
+ *
+ * Integers without a size are varints and strings are a varint length followed by the bytes.
+ * Durations that are not known yet are encoded as 0, as is the response code of a request that got
+ * no response. Headers that are not present are left out.
+ */
+class RecordEncoder {
+public:
+  RecordEncoder(const SelectedHeaders& headers) : headers_(headers) {}
+
+  /**
+   * Append the record for a request to a buffer.
+   */
+  void encode(const HeaderMap& request_headers, const HeaderMap& response_headers,
+              const RequestInfo& request_info, std::string& output) const;
+
+  /**
+   * Parse a comma separated list of REQ(name) and RESP(name) entries. Throws EnvoyException on
+   * anything else.
+   */
+  static SelectedHeaders parseHeaders(const std::string& format);
+
+  /**
+   * @return the headers that the default text format logs.
+   */
+  static SelectedHeaders defaultHeaders();
+
+  static const uint8_t VERSION = 1;
+  static const size_t HEADER_SIZE = 5;
+
+private:
+  const SelectedHeaders headers_;
+};
+
+/**
+ * A decoded record. @see RecordEncoder for the meaning of the fields.
+ */
+struct Record {
+  uint64_t start_time_us_;
+  uint64_t request_received_duration_us_;
+  uint64_t response_received_duration_us_;
+  uint64_t duration_us_;
+  uint64_t bytes_received_;
+  uint64_t bytes_sent_;
+  uint32_t response_code_;
+  uint64_t response_flags_;
+  Protocol protocol_;
+  bool health_check_;
+  std::string upstream_host_;
+  std::string upstream_cluster_;
+  std::string downstream_address_;
+  std::vector<std::pair<std::string, std::string>> request_headers_;
+  std::vector<std::pair<std::string, std::string>> response_headers_;
+};
+
+class RecordDecoder {
+public:
+  /**
+   * @param data supplies at least RecordEncoder::HEADER_SIZE bytes of the start of a record.
+   * @return uint32_t the size of the whole record.
+   */
+  static uint32_t recordLength(const uint8_t* data);
+
+  /**
+   * Decode exactly one record.
+   * @return bool false if the data is not a well formed record.
+   */
+  static bool decode(const uint8_t* data, size_t size, Record& record);
+};
+
+// clang-format off
+#define BINARY_ACCESS_LOG_STATS(COUNTER)                                                           \
+  COUNTER(binary_records)                                                                          \
+  COUNTER(binary_dropped)
+// clang-format on
+
+struct BinaryAccessLogStats {
+  BINARY_ACCESS_LOG_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Access log Instance that writes binary records (@see RecordEncoder) to a file, or sends them as
+ * one datagram each to a unix socket when the path starts with unix://. Nothing is formatted as
+ * text on the request path.
+ *
+ * Datagrams are sent without blocking. A record that can't be sent, because nothing is bound to
+ * the socket or the receiver is behind, is dropped and counted.
+ */
+class BinaryAccessLog : public Instance {
+public:
+  BinaryAccessLog(const std::string& path, FilterPtr&& filter, const SelectedHeaders& headers,
+                  Envoy::AccessLog::AccessLogManager& log_manager, Api::OsSysCalls& os_sys_calls,
+                  Stats::Scope& scope);
+  ~BinaryAccessLog();
+
+  // Http::AccessLog::Instance
+  void log(const HeaderMap* request_headers, const HeaderMap* response_headers,
+           const RequestInfo& request_info) override;
+
+  static const std::string UNIX_SOCKET_PREFIX;
+
+private:
+  FilterPtr filter_;
+  RecordEncoder encoder_;
+  Api::OsSysCalls& os_sys_calls_;
+  BinaryAccessLogStats stats_;
+  Filesystem::FileSharedPtr log_file_;
+  int fd_{-1};
+  sockaddr_un address_;
+};
+
+} // namespace Binary
+} // namespace AccessLog
+} // namespace Http
+} // namespace Envoy
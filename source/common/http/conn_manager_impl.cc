@@ -1,6 +1,8 @@
 #include "common/http/conn_manager_impl.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <list>
 #include <string>
@@ -145,9 +147,16 @@ void ConnectionManagerImpl::doEndStream(ActiveStream& stream) {
 
   // Reading may have been disabled for the non-multiplexing case, so enable it again.
   // Also be sure to unwind any read-disable done by the prior downstream
-  // connection.
+  // connection. Pipelined requests that are still active may have disabled reading themselves,
+  // so only the read-disable done for a full pipeline is undone while they are around.
   if (drain_state_ != DrainState::Closing && codec_->protocol() != Protocol::Http2) {
-    while (!read_callbacks_->connection().readEnabled()) {
+    if (streams_.empty()) {
+      pipeline_read_disabled_ = false;
+      while (!read_callbacks_->connection().readEnabled()) {
+        read_callbacks_->connection().readDisable(false);
+      }
+    } else if (pipeline_read_disabled_) {
+      pipeline_read_disabled_ = false;
       read_callbacks_->connection().readDisable(false);
     }
   }
@@ -179,13 +188,21 @@ StreamDecoder& ConnectionManagerImpl::newStream(StreamEncoder& response_encoder)
   }
 
   ENVOY_CONN_LOG(debug, "new stream", read_callbacks_->connection());
+  if (codec_->protocol() != Protocol::Http2 && !streams_.empty()) {
+    stats_.named_.downstream_rq_pipelined_.inc();
+    stats_.named_.downstream_rq_pipeline_depth_.recordValue(streams_.size() + 1);
+  }
+
   ActiveStreamPtr new_stream(new ActiveStream(*this));
+  new_stream->stream_number_ = ++streams_created_;
   new_stream->response_encoder_ = &response_encoder;
   new_stream->response_encoder_->getStream().addCallbacks(*new_stream);
   new_stream->buffer_limit_ = new_stream->response_encoder_->getStream().bufferLimit();
   config_.filterFactory().createFilterChain(*new_stream);
-  // Make sure new streams are apprised that the underlying connection is blocked.
-  if (read_callbacks_->connection().aboveHighWatermark()) {
+  // Make sure new streams are apprised that the underlying connection is blocked. The HTTP/1.1
+  // codec does this for a pipelined request once its response starts writing to the connection.
+  if (read_callbacks_->connection().aboveHighWatermark() &&
+      (codec_->protocol() == Protocol::Http2 || streams_.empty())) {
     new_stream->callHighWatermarkCallbacks();
   }
   new_stream->moveIntoList(std::move(new_stream), streams_);
@@ -204,6 +221,7 @@ Network::FilterStatus ConnectionManagerImpl::onData(Buffer::Instance& data) {
 
   if (!codec_) {
     codec_ = config_.createCodec(read_callbacks_->connection(), data, *this);
+    max_pipeline_depth_ = config_.maxPipelineDepth();
     if (codec_->protocol() == Protocol::Http2) {
       stats_.named_.downstream_cx_http2_total_.inc();
       stats_.named_.downstream_cx_http2_active_.inc();
@@ -217,6 +235,19 @@ Network::FilterStatus ConnectionManagerImpl::onData(Buffer::Instance& data) {
   do {
     redispatch = false;
 
+    // The HTTP/1 codec starts decoding the next request as soon as it is given data past the last
+    // complete one. A request that can't be processed alongside the outstanding ones is left in the
+    // buffer, and reading stops below until they are done.
+    if (codec_->protocol() != Protocol::Http2 && data.length() > 0 && !streams_.empty() &&
+        streams_.front()->state_.remote_complete_ && !isWebSocketConnection() &&
+        !acceptsPipelinedRequest(data)) {
+      if (!pipeline_read_disabled_) {
+        pipeline_read_disabled_ = true;
+        read_callbacks_->connection().readDisable(true);
+      }
+      break;
+    }
+
     try {
       codec_->dispatch(data);
     } catch (const CodecProtocolException& e) {
@@ -238,17 +269,18 @@ Network::FilterStatus ConnectionManagerImpl::onData(Buffer::Instance& data) {
     checkForDeferredClose();
 
     // The HTTP/1 codec will pause dispatch after a single message is complete. We want to
-    // either redispatch if there are no streams and we have more data. If we have a single
-    // complete non-WebSocket stream but have not responded yet we will pause socket reads
-    // to apply back pressure.
+    // redispatch if we have more data and room in the pipeline for another request that may run
+    // alongside the outstanding ones. Otherwise, if the pipeline holds complete non-WebSocket
+    // streams that we have not responded to yet we will pause socket reads to apply back pressure.
     if (codec_->protocol() != Protocol::Http2) {
       if (read_callbacks_->connection().state() == Network::Connection::State::Open &&
-          data.length() > 0 && streams_.empty()) {
+          data.length() > 0 && acceptsPipelinedRequest(data)) {
         redispatch = true;
       }
 
       if (!streams_.empty() && streams_.front()->state_.remote_complete_ &&
-          !isWebSocketConnection()) {
+          !isWebSocketConnection() && !acceptsPipelinedRequest(data) && !pipeline_read_disabled_) {
+        pipeline_read_disabled_ = true;
         read_callbacks_->connection().readDisable(true);
       }
     }
@@ -257,6 +289,46 @@ Network::FilterStatus ConnectionManagerImpl::onData(Buffer::Instance& data) {
   return Network::FilterStatus::StopIteration;
 }
 
+bool ConnectionManagerImpl::acceptsPipelinedRequest(Buffer::Instance& data) {
+  // streams_ is newest first. A request can only follow one that has been fully received, and
+  // none are started once the connection is going to be closed.
+  if (streams_.empty()) {
+    return true;
+  }
+  if (streams_.size() >= max_pipeline_depth_ || !streams_.front()->state_.remote_complete_ ||
+      drain_state_ == DrainState::Closing) {
+    return false;
+  }
+
+  // Per RFC 7230 section 6.3.2 pipelined requests may only be processed in parallel if they all
+  // use safe methods. A request that does not waits until the ones ahead of it have completed.
+  for (const ActiveStreamPtr& stream : streams_) {
+    if (!stream->request_headers_ || !stream->request_headers_->Method() ||
+        !isSafeMethod(stream->request_headers_->Method()->value().c_str(),
+                      stream->request_headers_->Method()->value().size())) {
+      return false;
+    }
+  }
+
+  // The next request has not been decoded yet, so its method is taken from the start of its
+  // request line. Until the whole method has been received it is not known to be safe.
+  if (data.length() == 0) {
+    return true;
+  }
+  const uint32_t length = std::min<uint64_t>(data.length(), MaxSafeMethodLength + 1);
+  const char* request_line = static_cast<const char*>(data.linearize(length));
+  const char* method_end = static_cast<const char*>(memchr(request_line, ' ', length));
+  return method_end != nullptr && isSafeMethod(request_line, method_end - request_line);
+}
+
+bool ConnectionManagerImpl::isSafeMethod(const char* method, size_t length) {
+  const auto& methods = Headers::get().MethodValues;
+  return (length == methods.Get.size() && 0 == memcmp(method, methods.Get.c_str(), length)) ||
+         (length == methods.Head.size() && 0 == memcmp(method, methods.Head.c_str(), length)) ||
+         (length == methods.Options.size() &&
+          0 == memcmp(method, methods.Options.c_str(), length));
+}
+
 void ConnectionManagerImpl::resetAllStreams() {
   while (!streams_.empty()) {
     // Mimic a downstream reset in this case.
@@ -517,7 +589,13 @@ void ConnectionManagerImpl::ActiveStream::decodeHeaders(HeaderMapPtr&& headers,
     const bool websocket_allowed = (route_entry != nullptr) && route_entry->useWebSocket();
     const bool websocket_requested = Utility::isWebSocketUpgradeRequest(*request_headers_);
 
-    if (websocket_requested && websocket_allowed) {
+    if (websocket_requested && connection_manager_.streams_.size() > 1) {
+      // The WebSocket would take over the connection while responses to earlier pipelined
+      // requests are still outstanding.
+      HeaderMapImpl headers{{Headers::get().Status, std::to_string(enumToInt(Code::BadRequest))}};
+      encodeHeaders(nullptr, headers, true);
+      return;
+    } else if (websocket_requested && websocket_allowed) {
       ENVOY_STREAM_LOG(debug, "found websocket connection. (end_stream={}):", *this, end_stream);
 
       connection_manager_.ws_connection_.reset(new WebSocket::WsHandlerImpl(
@@ -780,8 +858,11 @@ void ConnectionManagerImpl::ActiveStream::encodeHeaders(ActiveStreamEncoderFilte
     connection_manager_.stats_.named_.downstream_rq_response_before_rq_complete_.inc();
   }
 
+  // Requests pipelined behind this one are still answered before the connection is closed, so
+  // only the response to the last request received says that it will be.
   if (connection_manager_.drain_state_ == DrainState::Closing &&
-      connection_manager_.codec_->protocol() != Protocol::Http2) {
+      connection_manager_.codec_->protocol() != Protocol::Http2 &&
+      stream_number_ == connection_manager_.streams_created_) {
     headers.insertConnection().value().setReference(Headers::get().ConnectionValues.Close);
   }
 
@@ -73,6 +73,8 @@ namespace Http {
   COUNTER  (downstream_rq_rx_reset)                                                                \
   COUNTER  (downstream_rq_tx_reset)                                                                \
   COUNTER  (downstream_rq_non_relative_path)                                                       \
+  COUNTER  (downstream_rq_pipelined)                                                               \
+  HISTOGRAM(downstream_rq_pipeline_depth)                                                          \
   COUNTER  (downstream_rq_ws_on_non_ws_route)                                                      \
   COUNTER  (downstream_rq_too_large)                                                               \
   COUNTER  (downstream_rq_2xx)                                                                     \
@@ -215,6 +217,14 @@ public:
    */
   virtual const Optional<std::chrono::milliseconds>& idleTimeout() PURE;
 
+  /**
+   * @return uint32_t the maximum number of HTTP/1.1 requests on a connection that are processed
+   *         at the same time. Requests beyond the first are pipelined: they are decoded and
+   *         forwarded while earlier requests are outstanding, and their responses are held until
+   *         the earlier responses have been written. Called once for each new connection.
+   */
+  virtual uint32_t maxPipelineDepth() PURE;
+
   /**
    * @return Router::RouteConfigProvider& the configuration provider used to acquire a route
    *         config for each request flow.
@@ -562,6 +572,8 @@ private:
     Router::ConfigConstSharedPtr snapped_route_config_;
     Tracing::SpanPtr active_span_{new Tracing::NullSpan()};
     const uint64_t stream_id_;
+    // The order in which the stream was created on the connection, starting at 1.
+    uint64_t stream_number_{};
     StreamEncoder* response_encoder_{};
     HeaderMapPtr response_headers_;
     Buffer::WatermarkBufferPtr buffered_response_data_;
@@ -600,6 +612,21 @@ private:
    */
   void doEndStream(ActiveStream& stream);
 
+  /**
+   * @param data supplies the buffered data that the next request would be decoded from.
+   * @return bool whether the HTTP/1.1 codec may decode another request on the connection.
+   */
+  bool acceptsPipelinedRequest(Buffer::Instance& data);
+
+  /**
+   * @return bool whether a method is safe (GET, HEAD or OPTIONS), so that a pipelined request
+   *         using it may be processed in parallel with other such requests.
+   */
+  static bool isSafeMethod(const char* method, size_t length);
+
+  // The length of the longest safe method, OPTIONS.
+  static constexpr uint32_t MaxSafeMethodLength = 7;
+
   void resetAllStreams();
   void onIdleTimeout();
   void onDrainTimeout();
@@ -617,6 +644,12 @@ private:
   Stats::TimespanPtr conn_length_;
   const Network::DrainDecision& drain_close_;
   DrainState drain_state_{DrainState::NotDraining};
+  // The pipeline depth of the connection, read when its codec is created.
+  uint32_t max_pipeline_depth_{1};
+  // Whether reading has been disabled because the pipeline is full.
+  bool pipeline_read_disabled_{};
+  // The number of streams created on the connection.
+  uint64_t streams_created_{};
   UserAgent user_agent_;
   Event::TimerPtr idle_timer_;
   Event::TimerPtr drain_timer_;
@@ -122,10 +122,9 @@ void ConnectionManagerUtility::mutateRequestHeaders(
 
   // Generate x-request-id for all edge requests, or if there is none.
   if (config.generateRequestId() && (edge_request || !request_headers.RequestId())) {
-    // TODO(PiotrSikora) PERF: Write UUID directly to the header map.
-    const std::string uuid = random.uuid();
-    ASSERT(!uuid.empty());
-    request_headers.insertRequestId().value(uuid);
+    char uuid[Runtime::RandomGenerator::UUID_LENGTH];
+    random.fastUuid(uuid);
+    request_headers.insertRequestId().value().setCopy(uuid, sizeof(uuid));
   }
 
   if (config.tracingConfig()) {
@@ -0,0 +1,532 @@
+#include "common/http/filter/cache_filter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+#include "envoy/stats/stats.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/common/hash.h"
+#include "common/common/utility.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/headers.h"
+#include "common/http/utility.h"
+#include "common/json/config_schemas.h"
+
+namespace Envoy {
+namespace Http {
+
+namespace {
+
+bool isSpace(char c) { return c == ' ' || c == '\t'; }
+
+// Calls cb with each element of a comma separated header value, trimmed.
+template <class Callback> void forEachElement(const char* value, Callback cb) {
+  while (*value != '\0') {
+    const char* end = value + strcspn(value, ",");
+    const char* begin = value;
+    const char* last = end;
+    while (begin != last && isSpace(*begin)) {
+      begin++;
+    }
+    while (last != begin && isSpace(*(last - 1))) {
+      last--;
+    }
+    if (begin != last) {
+      cb(begin, last);
+    }
+    value = *end == ',' ? end + 1 : end;
+  }
+}
+
+bool equalsIgnoreCase(const char* begin, const char* end, const char* token) {
+  const size_t length = strlen(token);
+  return static_cast<size_t>(end - begin) == length && strncasecmp(begin, token, length) == 0;
+}
+
+int64_t parseSeconds(const char* begin, const char* end) {
+  if (begin != end && *begin == '"' && *(end - 1) == '"' && end - begin >= 2) {
+    begin++;
+    end--;
+  }
+  uint64_t seconds;
+  if (!StringUtil::atoul(std::string(begin, end).c_str(), seconds)) {
+    return -1;
+  }
+  return std::min<uint64_t>(seconds, INT32_MAX);
+}
+
+} // namespace
+
+CacheControl CacheControl::parse(const HeaderEntry* header) {
+  CacheControl cache_control;
+  if (header == nullptr) {
+    return cache_control;
+  }
+
+  forEachElement(header->value().c_str(), [&cache_control](const char* begin, const char* end) {
+    const char* name_end = std::find(begin, end, '=');
+    const char* value = name_end == end ? end : name_end + 1;
+    while (name_end != begin && isSpace(*(name_end - 1))) {
+      name_end--;
+    }
+    while (value != end && isSpace(*value)) {
+      value++;
+    }
+
+    if (equalsIgnoreCase(begin, name_end, "no-cache")) {
+      cache_control.no_cache_ = true;
+    } else if (equalsIgnoreCase(begin, name_end, "no-store")) {
+      cache_control.no_store_ = true;
+    } else if (equalsIgnoreCase(begin, name_end, "private")) {
+      cache_control.private_ = true;
+    } else if (equalsIgnoreCase(begin, name_end, "public")) {
+      cache_control.public_ = true;
+    } else if (equalsIgnoreCase(begin, name_end, "must-revalidate")) {
+      cache_control.must_revalidate_ = true;
+    } else if (equalsIgnoreCase(begin, name_end, "max-age")) {
+      cache_control.max_age_ = parseSeconds(value, end);
+    } else if (equalsIgnoreCase(begin, name_end, "s-maxage")) {
+      cache_control.s_maxage_ = parseSeconds(value, end);
+    }
+  });
+  return cache_control;
+}
+
+const uint32_t FrequencySketch::DEPTH;
+const uint8_t FrequencySketch::MAX_COUNT;
+
+FrequencySketch::FrequencySketch(uint64_t expected_entries) {
+  uint64_t width = 64;
+  while (width < expected_entries && width < (1 << 20)) {
+    width <<= 1;
+  }
+  mask_ = width - 1;
+  counters_.resize(width * DEPTH);
+  reset_threshold_ = width * 10;
+}
+
+size_t FrequencySketch::index(uint64_t hash, uint32_t row) const {
+  static const uint64_t SEEDS[DEPTH] = {0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL,
+                                        0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL};
+  const uint64_t mixed = (hash ^ SEEDS[row]) * 0x9e3779b97f4a7c15ULL;
+  return row * (mask_ + 1) + ((mixed >> 32) & mask_);
+}
+
+void FrequencySketch::record(uint64_t hash) {
+  for (uint32_t row = 0; row < DEPTH; row++) {
+    uint8_t& counter = counters_[index(hash, row)];
+    if (counter < MAX_COUNT) {
+      counter++;
+    }
+  }
+
+  if (++additions_ == reset_threshold_) {
+    for (uint8_t& counter : counters_) {
+      counter >>= 1;
+    }
+    additions_ /= 2;
+  }
+}
+
+uint32_t FrequencySketch::estimate(uint64_t hash) const {
+  uint32_t estimate = MAX_COUNT;
+  for (uint32_t row = 0; row < DEPTH; row++) {
+    estimate = std::min<uint32_t>(estimate, counters_[index(hash, row)]);
+  }
+  return estimate;
+}
+
+ResponseLru::ResponseLru(uint64_t max_bytes, bool tiny_lfu) : max_bytes_(max_bytes) {
+  if (tiny_lfu) {
+    // Assume responses of a few KB when sizing the sketch.
+    sketch_.reset(new FrequencySketch(max_bytes / 4096));
+  }
+}
+
+CachedResponseConstSharedPtr ResponseLru::lookup(const std::string& key, uint64_t hash) {
+  if (sketch_) {
+    sketch_->record(hash);
+  }
+
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return it->second->response_;
+}
+
+bool ResponseLru::insert(const std::string& key, uint64_t hash,
+                         CachedResponseConstSharedPtr response, uint64_t& evicted) {
+  remove(key);
+  if (response->size_ > max_bytes_) {
+    return false;
+  }
+
+  // Decide on admission against all the entries that would have to make room before evicting
+  // any of them, so that a rejected response leaves the cache as it was.
+  uint64_t freed = 0;
+  uint64_t victims = 0;
+  for (auto it = lru_.rbegin(); bytes_ - freed + response->size_ > max_bytes_; ++it) {
+    if (sketch_ && sketch_->estimate(hash) <= sketch_->estimate(it->hash_)) {
+      return false;
+    }
+    freed += it->response_->size_;
+    victims++;
+  }
+
+  for (; victims > 0; victims--) {
+    const Entry& victim = lru_.back();
+    bytes_ -= victim.response_->size_;
+    index_.erase(victim.key_);
+    lru_.pop_back();
+    evicted++;
+  }
+
+  bytes_ += response->size_;
+  lru_.push_front({key, hash, std::move(response)});
+  index_[key] = lru_.begin();
+  return true;
+}
+
+void ResponseLru::remove(const std::string& key) {
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    bytes_ -= it->second->response_->size_;
+    lru_.erase(it->second);
+    index_.erase(it);
+  }
+}
+
+const size_t SharedResponseCache::NUM_SHARDS;
+
+SharedResponseCache::SharedResponseCache(uint64_t max_bytes, bool tiny_lfu,
+                                         CacheFilterStats& stats)
+    : stats_(stats) {
+  for (size_t i = 0; i < NUM_SHARDS; i++) {
+    shards_.emplace_back(new Shard(max_bytes / NUM_SHARDS, tiny_lfu));
+  }
+}
+
+CachedResponseConstSharedPtr SharedResponseCache::lookup(const std::string& key, uint64_t hash) {
+  Shard& shard = this->shard(hash);
+  std::lock_guard<std::mutex> guard(shard.lock_);
+  return shard.lru_.lookup(key, hash);
+}
+
+void SharedResponseCache::insert(const std::string& key, uint64_t hash,
+                                 CachedResponseConstSharedPtr response) {
+  Shard& shard = this->shard(hash);
+  uint64_t evicted = 0;
+  bool inserted;
+  uint64_t bytes_before;
+  uint64_t bytes_after;
+  {
+    std::lock_guard<std::mutex> guard(shard.lock_);
+    bytes_before = shard.lru_.bytes();
+    inserted = shard.lru_.insert(key, hash, std::move(response), evicted);
+    bytes_after = shard.lru_.bytes();
+  }
+
+  if (bytes_after > bytes_before) {
+    stats_.shared_bytes_.add(bytes_after - bytes_before);
+  } else {
+    stats_.shared_bytes_.sub(bytes_before - bytes_after);
+  }
+  stats_.evict_.add(evicted);
+  if (!inserted) {
+    stats_.admission_rejected_.inc();
+  }
+}
+
+void SharedResponseCache::remove(const std::string& key, uint64_t hash) {
+  Shard& shard = this->shard(hash);
+  uint64_t removed;
+  {
+    std::lock_guard<std::mutex> guard(shard.lock_);
+    removed = shard.lru_.bytes();
+    shard.lru_.remove(key);
+    removed -= shard.lru_.bytes();
+  }
+  stats_.shared_bytes_.sub(removed);
+}
+
+CacheFilterConfig::CacheFilterConfig(const Json::Object& json_config,
+                                     const std::string& stats_prefix, Stats::Scope& scope,
+                                     ThreadLocal::SlotAllocator& tls,
+                                     MonotonicTimeSource& time_source)
+    : Json::Validator(json_config, Json::Schema::CACHE_HTTP_FILTER_SCHEMA),
+      stats_(generateStats(stats_prefix, scope)),
+      max_entry_bytes_(json_config.getInteger("max_entry_bytes", 1024 * 1024)),
+      time_source_(time_source), tls_(tls.allocateSlot()) {
+  const bool tiny_lfu = json_config.getString("eviction", "lru") == "tinylfu";
+  const uint64_t max_worker_bytes = json_config.getInteger("max_worker_bytes", 16 * 1024 * 1024);
+  tls_->set([max_worker_bytes,
+             tiny_lfu](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<WorkerResponseCache>(max_worker_bytes, tiny_lfu);
+  });
+
+  const uint64_t max_shared_bytes = json_config.getInteger("max_shared_bytes", 0);
+  if (max_shared_bytes > 0) {
+    shared_cache_.reset(new SharedResponseCache(max_shared_bytes, tiny_lfu, stats_));
+  }
+}
+
+CacheFilterStats CacheFilterConfig::generateStats(const std::string& prefix,
+                                                  Stats::Scope& scope) {
+  std::string final_prefix = prefix + "cache.";
+  return {ALL_CACHE_FILTER_STATS(POOL_COUNTER_PREFIX(scope, final_prefix),
+                                 POOL_GAUGE_PREFIX(scope, final_prefix))};
+}
+
+bool CacheFilter::varyMatches(const CachedResponse& response, const HeaderMap& request_headers) {
+  for (const auto& vary : response.vary_) {
+    const HeaderEntry* header = request_headers.get(vary.first);
+    if (vary.second != (header != nullptr ? header->value().c_str() : "")) {
+      return false;
+    }
+  }
+  return true;
+}
+
+FilterHeadersStatus CacheFilter::decodeHeaders(HeaderMap& headers, bool end_stream) {
+  const CacheControl cache_control = CacheControl::parse(headers.CacheControl());
+  if (!end_stream || headers.Method() == nullptr ||
+      headers.Method()->value() != Headers::get().MethodValues.Get.c_str() ||
+      headers.Host() == nullptr || headers.Path() == nullptr || cache_control.no_store_) {
+    config_->stats().bypass_.inc();
+    return FilterHeadersStatus::Continue;
+  }
+
+  request_headers_ = &headers;
+  authorized_ = headers.Authorization() != nullptr;
+  key_ = std::string(headers.Host()->value().c_str()) + headers.Path()->value().c_str();
+  hash_ = HashUtil::xxHash64(key_);
+  if (cache_control.no_cache_) {
+    // The request has to go upstream, but its response can still be stored.
+    config_->stats().bypass_.inc();
+    return FilterHeadersStatus::Continue;
+  }
+
+  const MonotonicTime now = config_->timeSource().currentTime();
+  CachedResponseConstSharedPtr response = lookup(now);
+  if (response) {
+    config_->stats().hit_.inc();
+    serve(*response, now);
+    return FilterHeadersStatus::StopIteration;
+  }
+
+  WorkerResponseCache& cache = config_->workerCache();
+  auto pending = cache.pending_.find(key_);
+  if (pending != cache.pending_.end()) {
+    config_->stats().coalesced_.inc();
+    pending->second.push_back(this);
+    waiting_ = true;
+    return FilterHeadersStatus::StopIteration;
+  }
+
+  config_->stats().miss_.inc();
+  cache.pending_.emplace(key_, std::list<CacheFilter*>{});
+  leader_ = true;
+  return FilterHeadersStatus::Continue;
+}
+
+CachedResponseConstSharedPtr CacheFilter::lookup(MonotonicTime now) {
+  WorkerResponseCache& cache = config_->workerCache();
+  CachedResponseConstSharedPtr response = cache.lru_.lookup(key_, hash_);
+  if (response && response->expires_at_ <= now) {
+    cache.lru_.remove(key_);
+    response = nullptr;
+  }
+
+  SharedResponseCache* shared_cache = config_->sharedCache();
+  if (!response && shared_cache != nullptr) {
+    response = shared_cache->lookup(key_, hash_);
+    if (response && response->expires_at_ <= now) {
+      shared_cache->remove(key_, hash_);
+      response = nullptr;
+    } else if (response && varyMatches(*response, *request_headers_)) {
+      config_->stats().shared_hit_.inc();
+      uint64_t evicted = 0;
+      cache.lru_.insert(key_, hash_, response, evicted);
+      config_->stats().evict_.add(evicted);
+    }
+  }
+
+  if (response && !varyMatches(*response, *request_headers_)) {
+    return nullptr;
+  }
+  return response;
+}
+
+void CacheFilter::serve(const CachedResponse& response, MonotonicTime now) {
+  // The response served here passes through encodeHeaders() of this filter as well, and must not
+  // be stored again.
+  key_.clear();
+
+  HeaderMapPtr headers{new HeaderMapImpl(*response.headers_)};
+  headers->addReferenceKey(
+      Headers::get().Age,
+      std::chrono::duration_cast<std::chrono::seconds>(now - response.stored_at_).count());
+  decoder_callbacks_->encodeHeaders(std::move(headers), response.body_.empty());
+  if (!response.body_.empty()) {
+    Buffer::OwnedImpl body(response.body_);
+    decoder_callbacks_->encodeData(body, true);
+  }
+}
+
+FilterHeadersStatus CacheFilter::encodeHeaders(HeaderMap& headers, bool end_stream) {
+  if (key_.empty()) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  const CacheControl cache_control = CacheControl::parse(headers.CacheControl());
+  const int64_t lifetime =
+      cache_control.s_maxage_ >= 0 ? cache_control.s_maxage_ : cache_control.max_age_;
+  uint64_t age = 0;
+  const HeaderEntry* age_header = headers.get(Headers::get().Age);
+  if (age_header != nullptr) {
+    StringUtil::atoul(age_header->value().c_str(), age);
+  }
+  // Like any shared cache, only store a response to a request with credentials when it is
+  // explicitly allowed to (RFC 7234 section 3.2).
+  const bool shareable = !authorized_ || cache_control.public_ || cache_control.s_maxage_ >= 0 ||
+                         cache_control.must_revalidate_;
+  uint64_t content_length = 0;
+  const bool cacheable =
+      Utility::getResponseStatus(headers) == 200 && !cache_control.no_store_ &&
+      !cache_control.no_cache_ && !cache_control.private_ && shareable && lifetime > 0 &&
+      age < static_cast<uint64_t>(lifetime) && headers.get(Headers::get().SetCookie) == nullptr &&
+      (headers.Vary() == nullptr || !headers.Vary()->value().find("*")) &&
+      (headers.ContentLength() == nullptr ||
+       (StringUtil::atoul(headers.ContentLength()->value().c_str(), content_length) &&
+        content_length <= config_->maxEntryBytes()));
+  if (!cacheable) {
+    config_->stats().not_cacheable_.inc();
+    completePending(nullptr);
+    return FilterHeadersStatus::Continue;
+  }
+
+  const MonotonicTime now = config_->timeSource().currentTime();
+  response_.reset(new CachedResponse());
+  response_->headers_.reset(new HeaderMapImpl(headers));
+  response_->headers_->remove(Headers::get().Age);
+  response_->stored_at_ = now - std::chrono::seconds(age);
+  response_->expires_at_ = response_->stored_at_ + std::chrono::seconds(lifetime);
+  if (headers.Vary() != nullptr) {
+    forEachElement(headers.Vary()->value().c_str(), [this](const char* begin, const char* end) {
+      LowerCaseString name(std::string(begin, end));
+      const HeaderEntry* header = request_headers_->get(name);
+      response_->vary_.emplace_back(name, header != nullptr ? header->value().c_str() : "");
+    });
+  }
+
+  if (end_stream) {
+    store();
+  }
+  return FilterHeadersStatus::Continue;
+}
+
+FilterDataStatus CacheFilter::encodeData(Buffer::Instance& data, bool end_stream) {
+  if (!response_) {
+    return FilterDataStatus::Continue;
+  }
+
+  if (response_->body_.size() + data.length() > config_->maxEntryBytes()) {
+    config_->stats().not_cacheable_.inc();
+    response_.reset();
+    completePending(nullptr);
+    return FilterDataStatus::Continue;
+  }
+
+  // The body streams through, a copy is kept for the cache.
+  const uint64_t num_slices = data.getRawSlices(nullptr, 0);
+  if (num_slices > 0) {
+    Buffer::RawSlice slices[num_slices];
+    data.getRawSlices(slices, num_slices);
+    for (const Buffer::RawSlice& slice : slices) {
+      response_->body_.append(static_cast<const char*>(slice.mem_), slice.len_);
+    }
+  }
+
+  if (end_stream) {
+    store();
+  }
+  return FilterDataStatus::Continue;
+}
+
+FilterTrailersStatus CacheFilter::encodeTrailers(HeaderMap&) {
+  // Responses with trailers are not stored.
+  if (response_) {
+    config_->stats().not_cacheable_.inc();
+    response_.reset();
+    completePending(nullptr);
+  }
+  return FilterTrailersStatus::Continue;
+}
+
+void CacheFilter::store() {
+  response_->size_ = sizeof(CachedResponse) + key_.size() + response_->headers_->byteSize() +
+                     response_->body_.size();
+  CachedResponseConstSharedPtr response(std::move(response_));
+
+  uint64_t evicted = 0;
+  if (config_->workerCache().lru_.insert(key_, hash_, response, evicted)) {
+    config_->stats().insert_.inc();
+  } else {
+    config_->stats().admission_rejected_.inc();
+  }
+  config_->stats().evict_.add(evicted);
+  if (config_->sharedCache() != nullptr) {
+    config_->sharedCache()->insert(key_, hash_, response);
+  }
+
+  completePending(response.get());
+}
+
+void CacheFilter::completePending(const CachedResponse* response) {
+  if (!leader_) {
+    return;
+  }
+
+  leader_ = false;
+  WorkerResponseCache& cache = config_->workerCache();
+  auto pending = cache.pending_.find(key_);
+  ASSERT(pending != cache.pending_.end());
+  const std::list<CacheFilter*> waiting = std::move(pending->second);
+  cache.pending_.erase(pending);
+  for (CacheFilter* filter : waiting) {
+    filter->onPendingComplete(response);
+  }
+}
+
+void CacheFilter::onPendingComplete(const CachedResponse* response) {
+  waiting_ = false;
+  if (response != nullptr && varyMatches(*response, *request_headers_)) {
+    serve(*response, config_->timeSource().currentTime());
+  } else {
+    // There is nothing to share, so the request goes upstream itself.
+    decoder_callbacks_->continueDecoding();
+  }
+}
+
+void CacheFilter::onDestroy() {
+  if (waiting_) {
+    WorkerResponseCache& cache = config_->workerCache();
+    auto pending = cache.pending_.find(key_);
+    ASSERT(pending != cache.pending_.end());
+    pending->second.remove(this);
+    waiting_ = false;
+  }
+  // A request reset before its response was complete can't share it.
+  completePending(nullptr);
+  response_.reset();
+}
+
+} // namespace Http
+} // namespace Envoy
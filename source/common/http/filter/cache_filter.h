@@ -0,0 +1,284 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/http/filter.h"
+#include "envoy/json/json_object.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/json/json_validator.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * All stats for the cache filter. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_CACHE_FILTER_STATS(COUNTER, GAUGE)                                                     \
+  COUNTER(hit)                                                                                     \
+  COUNTER(shared_hit)                                                                              \
+  COUNTER(miss)                                                                                    \
+  COUNTER(coalesced)                                                                               \
+  COUNTER(bypass)                                                                                  \
+  COUNTER(insert)                                                                                  \
+  COUNTER(not_cacheable)                                                                           \
+  COUNTER(evict)                                                                                   \
+  COUNTER(admission_rejected)                                                                      \
+  GAUGE  (shared_bytes)
+// clang-format on
+
+/**
+ * Wrapper struct for cache filter stats. @see stats_macros.h
+ */
+struct CacheFilterStats {
+  ALL_CACHE_FILTER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * The Cache-Control directives the cache acts on.
+ */
+struct CacheControl {
+  /**
+   * Parse a Cache-Control header. Unknown directives are ignored.
+   * @param header supplies the header, which may be nullptr.
+   */
+  static CacheControl parse(const HeaderEntry* header);
+
+  bool no_cache_{};
+  bool no_store_{};
+  bool private_{};
+  bool public_{};
+  bool must_revalidate_{};
+  // -1 when not present.
+  int64_t max_age_{-1};
+  int64_t s_maxage_{-1};
+};
+
+/**
+ * A stored response. Immutable once built, so it can be shared between workers.
+ */
+struct CachedResponse {
+  HeaderMapPtr headers_;
+  std::string body_;
+  MonotonicTime stored_at_;
+  MonotonicTime expires_at_;
+  // Names of the request headers listed in Vary and the values they had in the request the
+  // response was stored for. A header that was not present has an empty value.
+  std::vector<std::pair<LowerCaseString, std::string>> vary_;
+  // Approximate memory used by the entry, charged against the cache size.
+  uint64_t size_{};
+};
+
+typedef std::shared_ptr<const CachedResponse> CachedResponseConstSharedPtr;
+
+/**
+ * Approximate access frequency of keys, for TinyLFU admission. This is a count-min sketch of 4 bit
+ * counters that are all halved once the number of recorded accesses reaches 10 times the number of
+ * counters per row, so that the frequencies follow recent traffic.
+ */
+class FrequencySketch {
+public:
+  FrequencySketch(uint64_t expected_entries);
+
+  void record(uint64_t hash);
+  uint32_t estimate(uint64_t hash) const;
+
+private:
+  static const uint32_t DEPTH = 4;
+  static const uint8_t MAX_COUNT = 15;
+
+  size_t index(uint64_t hash, uint32_t row) const;
+
+  uint64_t mask_;
+  std::vector<uint8_t> counters_;
+  uint64_t additions_{};
+  uint64_t reset_threshold_;
+};
+
+/**
+ * A byte bounded LRU map of responses. Not thread safe.
+ *
+ * With TinyLFU admission, a new entry that would evict others is only stored if its key has been
+ * accessed more often than the keys of all the least recently used entries it would evict. This keeps one off responses
+ * from flushing popular ones out of a full cache.
+ */
+class ResponseLru {
+public:
+  ResponseLru(uint64_t max_bytes, bool tiny_lfu);
+
+  /**
+   * @return the response stored for a key, nullptr if none.
+   */
+  CachedResponseConstSharedPtr lookup(const std::string& key, uint64_t hash);
+
+  /**
+   * Store a response, replacing any response stored for the key and evicting least recently used
+   * entries as needed. A response that is not admitted evicts nothing.
+   * @param evicted is incremented with the number of entries evicted.
+   * @return bool whether the response was stored.
+   */
+  bool insert(const std::string& key, uint64_t hash, CachedResponseConstSharedPtr response,
+              uint64_t& evicted);
+
+  void remove(const std::string& key);
+  uint64_t bytes() const { return bytes_; }
+
+private:
+  struct Entry {
+    std::string key_;
+    uint64_t hash_;
+    CachedResponseConstSharedPtr response_;
+  };
+  typedef std::list<Entry> EntryList;
+
+  const uint64_t max_bytes_;
+  EntryList lru_;
+  std::unordered_map<std::string, EntryList::iterator> index_;
+  uint64_t bytes_{};
+  std::unique_ptr<FrequencySketch> sketch_;
+};
+
+/**
+ * Cache of responses shared by all workers, split into independently locked shards.
+ */
+class SharedResponseCache {
+public:
+  SharedResponseCache(uint64_t max_bytes, bool tiny_lfu, CacheFilterStats& stats);
+
+  CachedResponseConstSharedPtr lookup(const std::string& key, uint64_t hash);
+  void insert(const std::string& key, uint64_t hash, CachedResponseConstSharedPtr response);
+  void remove(const std::string& key, uint64_t hash);
+
+private:
+  static const size_t NUM_SHARDS = 16;
+
+  struct Shard {
+    Shard(uint64_t max_bytes, bool tiny_lfu) : lru_(max_bytes, tiny_lfu) {}
+
+    std::mutex lock_;
+    ResponseLru lru_;
+  };
+
+  Shard& shard(uint64_t hash) { return *shards_[hash % NUM_SHARDS]; }
+
+  CacheFilterStats& stats_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+class CacheFilter;
+
+/**
+ * Per worker cache state: the worker's own LRU and the requests waiting for a response being
+ * fetched by another request on the same worker.
+ */
+struct WorkerResponseCache : public ThreadLocal::ThreadLocalObject {
+  WorkerResponseCache(uint64_t max_bytes, bool tiny_lfu) : lru_(max_bytes, tiny_lfu) {}
+
+  ResponseLru lru_;
+  // Keys with a request in flight upstream, and the requests waiting for it.
+  std::unordered_map<std::string, std::list<CacheFilter*>> pending_;
+};
+
+/**
+ * Configuration for the cache filter.
+ */
+class CacheFilterConfig : Json::Validator {
+public:
+  CacheFilterConfig(const Json::Object& json_config, const std::string& stats_prefix,
+                    Stats::Scope& scope, ThreadLocal::SlotAllocator& tls,
+                    MonotonicTimeSource& time_source);
+
+  CacheFilterStats& stats() { return stats_; }
+  uint64_t maxEntryBytes() const { return max_entry_bytes_; }
+  MonotonicTimeSource& timeSource() { return time_source_; }
+  WorkerResponseCache& workerCache() { return tls_->getTyped<WorkerResponseCache>(); }
+  // nullptr unless a shared cache is configured.
+  SharedResponseCache* sharedCache() { return shared_cache_.get(); }
+
+private:
+  static CacheFilterStats generateStats(const std::string& prefix, Stats::Scope& scope);
+
+  CacheFilterStats stats_;
+  const uint64_t max_entry_bytes_;
+  MonotonicTimeSource& time_source_;
+  ThreadLocal::SlotPtr tls_;
+  std::unique_ptr<SharedResponseCache> shared_cache_;
+};
+
+typedef std::shared_ptr<CacheFilterConfig> CacheFilterConfigSharedPtr;
+
+/**
+ * A filter that serves GET requests from an in memory cache of responses, honoring Cache-Control
+ * and Vary. Responses are looked up in the worker's cache, then in the shared cache if there is
+ * one. Concurrent misses for the same key on a worker are collapsed into a single upstream request
+ * whose response is used for all of them.
+ */
+class CacheFilter : public StreamFilter {
+public:
+  CacheFilter(CacheFilterConfigSharedPtr config) : config_(config) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return FilterDataStatus::Continue;
+  }
+  FilterTrailersStatus decodeTrailers(HeaderMap&) override {
+    return FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) override {
+    decoder_callbacks_ = &callbacks;
+  }
+
+  // Http::StreamEncoderFilter
+  FilterHeadersStatus encodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  FilterTrailersStatus encodeTrailers(HeaderMap& trailers) override;
+  void setEncoderFilterCallbacks(StreamEncoderFilterCallbacks&) override {}
+
+  /**
+   * @return whether a response stored for the given request headers can be used for a request.
+   */
+  static bool varyMatches(const CachedResponse& response, const HeaderMap& request_headers);
+
+private:
+  CachedResponseConstSharedPtr lookup(MonotonicTime now);
+  void serve(const CachedResponse& response, MonotonicTime now);
+  void store();
+  // Hand the outcome of this request to the requests waiting for it, if this request is the one
+  // fetching the response.
+  void completePending(const CachedResponse* response);
+  // Called on a waiting request once the response it waits for is in, or nullptr if there is no
+  // usable response.
+  void onPendingComplete(const CachedResponse* response);
+
+  CacheFilterConfigSharedPtr config_;
+  StreamDecoderFilterCallbacks* decoder_callbacks_{};
+  const HeaderMap* request_headers_{};
+  std::string key_;
+  uint64_t hash_{};
+  // Whether this request fetches the response for the requests waiting on key_.
+  bool leader_{};
+  // Whether this request waits for another request's response.
+  bool waiting_{};
+  // Whether the request has an Authorization header.
+  bool authorized_{};
+  // The response being stored, if it is cacheable so far.
+  std::unique_ptr<CachedResponse> response_;
+};
+
+} // namespace Http
+} // namespace Envoy
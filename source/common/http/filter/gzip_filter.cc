@@ -0,0 +1,350 @@
+#include "common/http/filter/gzip_filter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+#include "envoy/stats/stats.h"
+
+#include "common/common/assert.h"
+#include "common/common/utility.h"
+#include "common/http/headers.h"
+#include "common/json/config_schemas.h"
+
+namespace Envoy {
+namespace Http {
+
+namespace {
+
+// Output is produced in chunks of this size, which is what zlib itself uses.
+const uint64_t CHUNK_SIZE = 16384;
+
+const char* const DEFAULT_CONTENT_TYPES[] = {
+    "application/javascript", "application/json", "application/xhtml+xml", "application/xml",
+    "image/svg+xml",          "text/css",         "text/html",             "text/javascript",
+    "text/plain",             "text/xml"};
+
+bool isSpace(char c) { return c == ' ' || c == '\t'; }
+
+// Whether a q-value ("0", "0.5", "1.000", ...) is zero, i.e. the coding is not acceptable.
+bool isZeroQuality(const char* begin, const char* end) {
+  if (begin == end || *begin != '0') {
+    return false;
+  }
+  for (++begin; begin != end; ++begin) {
+    if (*begin != '.' && *begin != '0') {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool equalsIgnoreCase(const char* begin, const char* end, const char* token) {
+  const size_t length = strlen(token);
+  return static_cast<size_t>(end - begin) == length && strncasecmp(begin, token, length) == 0;
+}
+
+} // namespace
+
+const size_t ZlibStreamPool::MAX_IDLE_STREAMS;
+
+ZlibDeflateStream::ZlibDeflateStream(GzipEncoding encoding, int compression_level) {
+  ASSERT(encoding != GzipEncoding::None);
+  zstream_.zalloc = Z_NULL;
+  zstream_.zfree = Z_NULL;
+  zstream_.opaque = Z_NULL;
+  // Adding 16 to the window bits selects the gzip wrapper instead of the zlib one.
+  const int window_bits = encoding == GzipEncoding::Gzip ? MAX_WBITS + 16 : MAX_WBITS;
+  const int rc = deflateInit2(&zstream_, compression_level, Z_DEFLATED, window_bits, 8,
+                              Z_DEFAULT_STRATEGY);
+  RELEASE_ASSERT(rc == Z_OK);
+  UNREFERENCED_PARAMETER(rc);
+}
+
+ZlibDeflateStream::~ZlibDeflateStream() { deflateEnd(&zstream_); }
+
+ZlibDeflateStreamPtr ZlibStreamPool::acquire(GzipEncoding encoding, bool& reused) {
+  std::vector<ZlibDeflateStreamPtr>& streams = idle(encoding);
+  reused = !streams.empty();
+  if (!reused) {
+    return ZlibDeflateStreamPtr{new ZlibDeflateStream(encoding, compression_level_)};
+  }
+
+  ZlibDeflateStreamPtr stream = std::move(streams.back());
+  streams.pop_back();
+  return stream;
+}
+
+void ZlibStreamPool::release(GzipEncoding encoding, ZlibDeflateStreamPtr&& stream) {
+  std::vector<ZlibDeflateStreamPtr>& streams = idle(encoding);
+  if (streams.size() < MAX_IDLE_STREAMS) {
+    // Resetting keeps the allocated state, which is the whole point of pooling.
+    deflateReset(&stream->zstream());
+    streams.push_back(std::move(stream));
+  }
+}
+
+GzipFilterConfig::GzipFilterConfig(const Json::Object& json_config,
+                                   const std::string& stats_prefix, Stats::Scope& scope,
+                                   ThreadLocal::SlotAllocator& tls)
+    : Json::Validator(json_config, Json::Schema::GZIP_HTTP_FILTER_SCHEMA),
+      stats_(generateStats(stats_prefix, scope)),
+      min_content_length_(json_config.getInteger("min_content_length", 30)),
+      tls_(tls.allocateSlot()) {
+  if (json_config.hasObject("content_types")) {
+    for (std::string content_type : json_config.getStringArray("content_types")) {
+      std::transform(content_type.begin(), content_type.end(), content_type.begin(), tolower);
+      content_types_.insert(content_type);
+    }
+  } else {
+    content_types_.insert(std::begin(DEFAULT_CONTENT_TYPES), std::end(DEFAULT_CONTENT_TYPES));
+  }
+
+  const int compression_level = json_config.getInteger("compression_level", Z_DEFAULT_COMPRESSION);
+  tls_->set([compression_level](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ZlibStreamPool>(compression_level);
+  });
+}
+
+GzipFilterStats GzipFilterConfig::generateStats(const std::string& prefix, Stats::Scope& scope) {
+  std::string final_prefix = prefix + "gzip.";
+  return {ALL_GZIP_FILTER_STATS(POOL_COUNTER_PREFIX(scope, final_prefix),
+                                POOL_HISTOGRAM_PREFIX(scope, final_prefix))};
+}
+
+bool GzipFilterConfig::isCompressibleContentType(const HeaderEntry* content_type) const {
+  if (content_type == nullptr) {
+    return false;
+  }
+
+  // Drop parameters such as "; charset=utf-8".
+  const char* begin = content_type->value().c_str();
+  const char* end = begin + strcspn(begin, ";");
+  while (begin != end && isSpace(*begin)) {
+    begin++;
+  }
+  while (end != begin && isSpace(*(end - 1))) {
+    end--;
+  }
+  std::string type(begin, end);
+  std::transform(type.begin(), type.end(), type.begin(), tolower);
+  return content_types_.count(type) > 0;
+}
+
+GzipEncoding GzipFilterConfig::negotiate(const HeaderEntry* accept_encoding) {
+  if (accept_encoding == nullptr) {
+    return GzipEncoding::None;
+  }
+
+  // Accept-Encoding is a list of codings, each optionally followed by parameters, e.g.
+  // "gzip;q=1.0, deflate;q=0.5, *;q=0". Codings with a zero q-value are not acceptable, other
+  // q-values are not used for ranking.
+  bool gzip = false;
+  bool deflate = false;
+  bool gzip_refused = false;
+  bool wildcard = false;
+  const char* position = accept_encoding->value().c_str();
+  while (*position != '\0') {
+    while (isSpace(*position) || *position == ',') {
+      position++;
+    }
+    const char* coding = position;
+    position += strcspn(position, ";, \t");
+    const char* coding_end = position;
+
+    bool acceptable = true;
+    const char* element_end = position + strcspn(position, ",");
+    while (position != element_end) {
+      // Parameters.
+      position++;
+      while (position != element_end && isSpace(*position)) {
+        position++;
+      }
+      const char* parameter_end = position + strcspn(position, ";,");
+      if (parameter_end - position >= 2 && (position[0] == 'q' || position[0] == 'Q') &&
+          position[1] == '=') {
+        const char* value_end = parameter_end;
+        while (value_end != position + 2 && isSpace(*(value_end - 1))) {
+          value_end--;
+        }
+        acceptable = !isZeroQuality(position + 2, value_end);
+      }
+      position = parameter_end;
+    }
+
+    if (equalsIgnoreCase(coding, coding_end, "gzip")) {
+      gzip = acceptable;
+      gzip_refused = !acceptable;
+    } else if (equalsIgnoreCase(coding, coding_end, "deflate")) {
+      deflate = acceptable;
+    } else if (equalsIgnoreCase(coding, coding_end, "*")) {
+      wildcard = acceptable;
+    }
+  }
+
+  if (gzip || (wildcard && !gzip_refused)) {
+    return GzipEncoding::Gzip;
+  }
+  return deflate ? GzipEncoding::Deflate : GzipEncoding::None;
+}
+
+FilterHeadersStatus GzipFilter::decodeHeaders(HeaderMap& headers, bool) {
+  encoding_ = GzipFilterConfig::negotiate(headers.AcceptEncoding());
+  return FilterHeadersStatus::Continue;
+}
+
+bool GzipFilter::shouldCompress(const HeaderMap& headers) const {
+  if (headers.ContentEncoding() != nullptr && headers.ContentEncoding()->value() != "identity") {
+    return false;
+  }
+
+  if (headers.CacheControl() != nullptr &&
+      headers.CacheControl()->value().find(Headers::get().CacheControlValues.NoTransform.c_str())) {
+    return false;
+  }
+
+  uint64_t content_length;
+  if (headers.ContentLength() != nullptr &&
+      StringUtil::atoul(headers.ContentLength()->value().c_str(), content_length) &&
+      content_length < config_->minContentLength()) {
+    return false;
+  }
+
+  return config_->isCompressibleContentType(headers.ContentType());
+}
+
+FilterHeadersStatus GzipFilter::encodeHeaders(HeaderMap& headers, bool end_stream) {
+  if (end_stream) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  if (!shouldCompress(headers)) {
+    config_->stats().not_compressed_.inc();
+    encoding_ = GzipEncoding::None;
+    return FilterHeadersStatus::Continue;
+  }
+
+  // The response depends on Accept-Encoding from here on, whether it gets compressed or not.
+  const std::string& accept_encoding = Headers::get().VaryValues.AcceptEncoding;
+  if (headers.Vary() == nullptr) {
+    headers.insertVary().value(accept_encoding);
+  } else if (strcasestr(headers.Vary()->value().c_str(), accept_encoding.c_str()) == nullptr) {
+    headers.Vary()->value(std::string(headers.Vary()->value().c_str()) + ", " + accept_encoding);
+  }
+
+  if (encoding_ == GzipEncoding::None) {
+    config_->stats().not_accepted_.inc();
+    return FilterHeadersStatus::Continue;
+  }
+
+  config_->stats().compressed_.inc();
+  headers.removeContentLength();
+  headers.insertContentEncoding().value(encoding_ == GzipEncoding::Gzip
+                                            ? Headers::get().ContentEncodingValues.Gzip
+                                            : Headers::get().ContentEncodingValues.Deflate);
+
+  bool reused;
+  stream_ = config_->streamPool().acquire(encoding_, reused);
+  if (reused) {
+    config_->stats().zlib_stream_reused_.inc();
+  } else {
+    config_->stats().zlib_stream_created_.inc();
+  }
+  return FilterHeadersStatus::Continue;
+}
+
+FilterDataStatus GzipFilter::encodeData(Buffer::Instance& data, bool end_stream) {
+  if (stream_ == nullptr) {
+    return FilterDataStatus::Continue;
+  }
+
+  compress(data, end_stream);
+  data.drain(data.length());
+  data.move(output_);
+  if (end_stream) {
+    finish();
+  }
+  return FilterDataStatus::Continue;
+}
+
+FilterTrailersStatus GzipFilter::encodeTrailers(HeaderMap&) {
+  if (stream_ != nullptr) {
+    // The compressed body has to be completed before the trailers go out.
+    compress(Buffer::OwnedImpl(), true);
+    encoder_callbacks_->addEncodedData(output_, true);
+    finish();
+  }
+  return FilterTrailersStatus::Continue;
+}
+
+void GzipFilter::onDestroy() {
+  // A stream reset in the middle of a response leaves a stream in use.
+  if (stream_ != nullptr) {
+    releaseStream();
+  }
+}
+
+void GzipFilter::compress(const Buffer::Instance& data, bool finish) {
+  const auto start = std::chrono::steady_clock::now();
+  const uint64_t num_slices = data.getRawSlices(nullptr, 0);
+  if (num_slices > 0) {
+    Buffer::RawSlice slices[num_slices];
+    data.getRawSlices(slices, num_slices);
+    for (const Buffer::RawSlice& slice : slices) {
+      deflateSlice(slice.mem_, slice.len_, Z_NO_FLUSH);
+    }
+  }
+  // Each chunk is flushed to a byte boundary, so a streamed response reaches the client as it is
+  // produced instead of when zlib's window fills up or the stream ends.
+  if (finish) {
+    deflateSlice(nullptr, 0, Z_FINISH);
+  } else if (num_slices > 0) {
+    deflateSlice(nullptr, 0, Z_SYNC_FLUSH);
+  }
+
+  compression_time_ += std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+}
+
+void GzipFilter::deflateSlice(void* mem, uint64_t length, int flush) {
+  z_stream& zstream = stream_->zstream();
+  zstream.next_in = static_cast<Bytef*>(mem);
+  zstream.avail_in = length;
+  uncompressed_bytes_ += length;
+
+  // Output goes straight into space reserved in output_, so the compressed data is not copied
+  // again.
+  int rc;
+  do {
+    Buffer::RawSlice out;
+    output_.reserve(CHUNK_SIZE, &out, 1);
+    zstream.next_out = static_cast<Bytef*>(out.mem_);
+    zstream.avail_out = out.len_;
+    rc = deflate(&zstream, flush);
+    ASSERT(rc != Z_STREAM_ERROR);
+    out.len_ -= zstream.avail_out;
+    compressed_bytes_ += out.len_;
+    output_.commit(&out, 1);
+  } while (flush == Z_FINISH ? rc != Z_STREAM_END : zstream.avail_out == 0);
+  ASSERT(zstream.avail_in == 0);
+}
+
+void GzipFilter::finish() {
+  GzipFilterStats& stats = config_->stats();
+  stats.total_uncompressed_bytes_.add(uncompressed_bytes_);
+  stats.total_compressed_bytes_.add(compressed_bytes_);
+  if (uncompressed_bytes_ > 0) {
+    stats.compression_ratio_percent_.recordValue(compressed_bytes_ * 100 / uncompressed_bytes_);
+  }
+  stats.compression_time_us_.recordValue(compression_time_.count());
+  releaseStream();
+}
+
+void GzipFilter::releaseStream() {
+  config_->streamPool().release(encoding_, std::move(stream_));
+  stream_.reset();
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "envoy/http/filter.h"
+#include "envoy/json/json_object.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/json/json_validator.h"
+
+#include "zlib.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * All stats for the gzip filter. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_GZIP_FILTER_STATS(COUNTER, HISTOGRAM)                                                  \
+  COUNTER(compressed)                                                                              \
+  COUNTER(not_compressed)                                                                          \
+  COUNTER(not_accepted)                                                                            \
+  COUNTER(total_uncompressed_bytes)                                                                \
+  COUNTER(total_compressed_bytes)                                                                  \
+  COUNTER(zlib_stream_reused)                                                                      \
+  COUNTER(zlib_stream_created)                                                                     \
+  HISTOGRAM(compression_ratio_percent)                                                             \
+  HISTOGRAM(compression_time_us)
+// clang-format on
+
+/**
+ * Wrapper struct for gzip filter stats. @see stats_macros.h
+ */
+struct GzipFilterStats {
+  ALL_GZIP_FILTER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_HISTOGRAM_STRUCT)
+};
+
+/**
+ * Content codings the filter can produce.
+ */
+enum class GzipEncoding { None, Gzip, Deflate };
+
+/**
+ * A zlib deflate stream. The stream state is a few hundred KB, so streams are reset and reused
+ * rather than destroyed. @see ZlibStreamPool.
+ */
+class ZlibDeflateStream {
+public:
+  ZlibDeflateStream(GzipEncoding encoding, int compression_level);
+  ~ZlibDeflateStream();
+
+  z_stream& zstream() { return zstream_; }
+
+private:
+  z_stream zstream_;
+};
+
+typedef std::unique_ptr<ZlibDeflateStream> ZlibDeflateStreamPtr;
+
+/**
+ * Per worker pool of idle deflate streams, one list per encoding.
+ */
+class ZlibStreamPool : public ThreadLocal::ThreadLocalObject {
+public:
+  // Idle streams kept per encoding. Concurrent responses beyond this allocate and free streams.
+  static const size_t MAX_IDLE_STREAMS = 16;
+
+  ZlibStreamPool(int compression_level) : compression_level_(compression_level) {}
+
+  /**
+   * @return a reset stream for the given encoding.
+   * @param reused is set to whether the stream came from the pool.
+   */
+  ZlibDeflateStreamPtr acquire(GzipEncoding encoding, bool& reused);
+
+  /**
+   * Return a stream to the pool.
+   */
+  void release(GzipEncoding encoding, ZlibDeflateStreamPtr&& stream);
+
+private:
+  std::vector<ZlibDeflateStreamPtr>& idle(GzipEncoding encoding) {
+    return encoding == GzipEncoding::Gzip ? idle_gzip_ : idle_deflate_;
+  }
+
+  const int compression_level_;
+  std::vector<ZlibDeflateStreamPtr> idle_gzip_;
+  std::vector<ZlibDeflateStreamPtr> idle_deflate_;
+};
+
+/**
+ * Configuration for the gzip filter.
+ */
+class GzipFilterConfig : Json::Validator {
+public:
+  GzipFilterConfig(const Json::Object& json_config, const std::string& stats_prefix,
+                   Stats::Scope& scope, ThreadLocal::SlotAllocator& tls);
+
+  GzipFilterStats& stats() { return stats_; }
+  uint64_t minContentLength() const { return min_content_length_; }
+  ZlibStreamPool& streamPool() { return tls_->getTyped<ZlibStreamPool>(); }
+
+  /**
+   * @return whether a response with the given content type should be compressed.
+   */
+  bool isCompressibleContentType(const HeaderEntry* content_type) const;
+
+  /**
+   * @return the coding to use for a request's Accept-Encoding header, preferring gzip over
+   *         deflate.
+   */
+  static GzipEncoding negotiate(const HeaderEntry* accept_encoding);
+
+private:
+  static GzipFilterStats generateStats(const std::string& prefix, Stats::Scope& scope);
+
+  GzipFilterStats stats_;
+  const uint64_t min_content_length_;
+  std::unordered_set<std::string> content_types_;
+  ThreadLocal::SlotPtr tls_;
+};
+
+typedef std::shared_ptr<GzipFilterConfig> GzipFilterConfigSharedPtr;
+
+/**
+ * A filter that compresses response bodies with gzip or deflate, as negotiated through the
+ * request's Accept-Encoding header. Bodies are compressed chunk by chunk as they are encoded, they
+ * are never buffered in full.
+ */
+class GzipFilter : public StreamFilter {
+public:
+  GzipFilter(GzipFilterConfigSharedPtr config) : config_(config) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return FilterDataStatus::Continue;
+  }
+  FilterTrailersStatus decodeTrailers(HeaderMap&) override {
+    return FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks&) override {}
+
+  // Http::StreamEncoderFilter
+  FilterHeadersStatus encodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  FilterTrailersStatus encodeTrailers(HeaderMap& trailers) override;
+  void setEncoderFilterCallbacks(StreamEncoderFilterCallbacks& callbacks) override {
+    encoder_callbacks_ = &callbacks;
+  }
+
+private:
+  bool shouldCompress(const HeaderMap& headers) const;
+  // Deflate data into output_, finishing the stream if requested.
+  void compress(const Buffer::Instance& data, bool finish);
+  void deflateSlice(void* mem, uint64_t length, int flush);
+  void finish();
+  void releaseStream();
+
+  GzipFilterConfigSharedPtr config_;
+  StreamEncoderFilterCallbacks* encoder_callbacks_{};
+  GzipEncoding encoding_{GzipEncoding::None};
+  ZlibDeflateStreamPtr stream_;
+  Buffer::OwnedImpl output_;
+  uint64_t uncompressed_bytes_{};
+  uint64_t compressed_bytes_{};
+  std::chrono::microseconds compression_time_{};
+};
+
+} // namespace Http
+} // namespace Envoy
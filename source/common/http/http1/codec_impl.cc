@@ -1,5 +1,6 @@
 #include "common/http/http1/codec_impl.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
 
@@ -11,6 +12,7 @@
 #include "common/common/utility.h"
 #include "common/http/exception.h"
 #include "common/http/headers.h"
+#include "common/http/http1/request_head_parser.h"
 #include "common/http/utility.h"
 
 #include "fmt/format.h"
@@ -90,7 +92,7 @@ void StreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end_stream)
   if (end_stream) {
     endEncode();
   } else {
-    connection_.flushOutput();
+    flushOutput();
   }
 }
 
@@ -112,7 +114,7 @@ void StreamEncoderImpl::encodeData(Buffer::Instance& data, bool end_stream) {
   if (end_stream) {
     endEncode();
   } else {
-    connection_.flushOutput();
+    flushOutput();
   }
 }
 
@@ -123,17 +125,23 @@ void StreamEncoderImpl::endEncode() {
     connection_.buffer().add(LAST_CHUNK);
   }
 
-  connection_.flushOutput();
+  flushOutput();
+  encode_complete_ = true;
   connection_.onEncodeComplete();
 }
 
-void ConnectionImpl::flushOutput() {
+void StreamEncoderImpl::flushOutput() { connection_.flushOutput(); }
+
+void ConnectionImpl::commitOutput() {
   if (reserved_current_) {
     reserved_iovec_.len_ = reserved_current_ - static_cast<char*>(reserved_iovec_.mem_);
     output_buffer_.commit(&reserved_iovec_, 1);
     reserved_current_ = nullptr;
   }
+}
 
+void ConnectionImpl::flushOutput() {
+  commitOutput();
   connection().write(output_buffer_);
   ASSERT(0UL == output_buffer_.length());
 }
@@ -182,6 +190,69 @@ void StreamEncoderImpl::readDisable(bool disable) { connection_.readDisable(disa
 uint32_t StreamEncoderImpl::bufferLimit() { return connection_.bufferLimit(); }
 
 static const char RESPONSE_PREFIX[] = "HTTP/1.1 ";
+static const char CONTINUE_RESPONSE[] = "HTTP/1.1 100 Continue\r\n\r\n";
+
+void ResponseStreamEncoderImpl::encode100Continue() {
+  connection_.buffer().add(CONTINUE_RESPONSE, sizeof(CONTINUE_RESPONSE) - 1);
+  flushOutput();
+}
+
+void ResponseStreamEncoderImpl::holdOutput() {
+  ASSERT(!held_output_);
+  held_output_.reset(new Buffer::WatermarkBuffer(
+      [this]() -> void {
+        // Nothing refers to a complete response by the time its held output is released.
+        if (!encodeComplete()) {
+          runLowWatermarkCallbacks();
+        }
+      },
+      [this]() -> void { runHighWatermarkCallbacks(); }));
+  held_output_->setWatermarks(connection_.bufferLimit());
+}
+
+void ResponseStreamEncoderImpl::releaseOutput() {
+  if (held_output_) {
+    connection_.buffer().move(*held_output_);
+    held_output_.reset();
+    connection_.flushOutput();
+  }
+}
+
+void ResponseStreamEncoderImpl::holdProtocolError(Buffer::Instance& response) {
+  ASSERT(held_output_);
+  started_response_ = true;
+  held_output_->move(response);
+}
+
+void ResponseStreamEncoderImpl::resetStream(StreamResetReason reason) {
+  ASSERT(!reset_called_);
+  reset_called_ = true;
+  StreamEncoderImpl::resetStream(reason);
+}
+
+void ResponseStreamEncoderImpl::unwindReadDisable() {
+  while (read_disable_calls_ > 0) {
+    readDisable(false);
+  }
+}
+
+void ResponseStreamEncoderImpl::readDisable(bool disable) {
+  if (disable) {
+    read_disable_calls_++;
+  } else if (read_disable_calls_ > 0) {
+    read_disable_calls_--;
+  }
+  StreamEncoderImpl::readDisable(disable);
+}
+
+void ResponseStreamEncoderImpl::flushOutput() {
+  if (held_output_) {
+    connection_.commitOutput();
+    held_output_->move(connection_.buffer());
+  } else {
+    StreamEncoderImpl::flushOutput();
+  }
+}
 
 void ResponseStreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end_stream) {
   started_response_ = true;
@@ -363,7 +434,8 @@ void ConnectionImpl::onMessageBeginBase() {
 }
 
 void ConnectionImpl::onResetStreamBase(StreamResetReason reason) {
-  ASSERT(!reset_stream_called_);
+  // A server connection may still reset the responses to requests pipelined ahead of one that has
+  // been reset.
   reset_stream_called_ = true;
   onResetStream(reason);
 }
@@ -374,12 +446,33 @@ ServerConnectionImpl::ServerConnectionImpl(Network::Connection& connection,
     : ConnectionImpl(connection, HTTP_REQUEST), callbacks_(callbacks), codec_settings_(settings) {}
 
 void ServerConnectionImpl::onEncodeComplete() {
-  ASSERT(active_request_);
-  if (active_request_->remote_complete_) {
+  ASSERT(!active_requests_.empty());
+  releaseCompletedRequests();
+}
+
+void ServerConnectionImpl::releaseCompletedRequests() {
+  while (!active_requests_.empty()) {
+    ActiveRequest& request = *active_requests_.front();
     // Only do this if remote is complete. If we are replying before the request is complete the
     // only logical thing to do is for higher level code to reset() / close the connection so we
     // leave the request around so that it can fire reset callbacks.
-    active_request_.reset();
+    if (!request.complete()) {
+      return;
+    }
+
+    request.response_encoder_.unwindReadDisable();
+    active_requests_.pop_front();
+    if (!active_requests_.empty()) {
+      // The next response writes to the connection from now on, so the connection's back pressure
+      // moves to it.
+      ResponseStreamEncoderImpl& response_encoder = active_requests_.front()->response_encoder_;
+      if (!response_encoder.encodeComplete()) {
+        for (uint32_t i = 0; i < high_watermark_calls_; i++) {
+          response_encoder.runHighWatermarkCallbacks();
+        }
+      }
+      response_encoder.releaseOutput();
+    }
   }
 }
 
@@ -389,28 +482,28 @@ void ServerConnectionImpl::handlePath(HeaderMapImpl& headers, unsigned int metho
   bool is_connect = (method == HTTP_CONNECT);
 
   // The url is relative or a wildcard when the method is OPTIONS. Nothing to do here.
-  if (active_request_->request_url_.c_str()[0] == '/' ||
-      ((method == HTTP_OPTIONS) && active_request_->request_url_.c_str()[0] == '*')) {
-    headers.addViaMove(std::move(path), std::move(active_request_->request_url_));
+  if (decoding_request_->request_url_.c_str()[0] == '/' ||
+      ((method == HTTP_OPTIONS) && decoding_request_->request_url_.c_str()[0] == '*')) {
+    headers.addViaMove(std::move(path), std::move(decoding_request_->request_url_));
     return;
   }
 
   // If absolute_urls and/or connect are not going be handled, copy the url and return.
   // This forces the behavior to be backwards compatible with the old codec behavior.
   if (!codec_settings_.allow_absolute_url_) {
-    headers.addViaMove(std::move(path), std::move(active_request_->request_url_));
+    headers.addViaMove(std::move(path), std::move(decoding_request_->request_url_));
     return;
   }
 
   if (is_connect) {
-    headers.addViaMove(std::move(path), std::move(active_request_->request_url_));
+    headers.addViaMove(std::move(path), std::move(decoding_request_->request_url_));
     return;
   }
 
   struct http_parser_url u;
   http_parser_url_init(&u);
-  int result = http_parser_parse_url(active_request_->request_url_.buffer(),
-                                     active_request_->request_url_.size(), is_connect, &u);
+  int result = http_parser_parse_url(decoding_request_->request_url_.buffer(),
+                                     decoding_request_->request_url_.size(), is_connect, &u);
 
   if (result != 0) {
     sendProtocolError();
@@ -434,7 +527,7 @@ void ServerConnectionImpl::handlePath(HeaderMapImpl& headers, unsigned int metho
       }
 
       // Insert the host header, this will later be converted to :authority
-      std::string new_host(active_request_->request_url_.c_str() + u.field_data[UF_HOST].off,
+      std::string new_host(decoding_request_->request_url_.c_str() + u.field_data[UF_HOST].off,
                            authority_len);
 
       headers.insertHost().value(new_host);
@@ -443,8 +536,8 @@ void ServerConnectionImpl::handlePath(HeaderMapImpl& headers, unsigned int metho
       // must start with /
       if ((u.field_set & (1 << UF_PATH)) == (1 << UF_PATH) && u.field_data[UF_PATH].len > 0) {
         HeaderString new_path;
-        new_path.setCopy(active_request_->request_url_.c_str() + u.field_data[UF_PATH].off,
-                         active_request_->request_url_.size() - u.field_data[UF_PATH].off);
+        new_path.setCopy(decoding_request_->request_url_.c_str() + u.field_data[UF_PATH].off,
+                         decoding_request_->request_url_.size() - u.field_data[UF_PATH].off);
         headers.addViaMove(std::move(path), std::move(new_path));
       } else {
         HeaderString new_path;
@@ -452,7 +545,7 @@ void ServerConnectionImpl::handlePath(HeaderMapImpl& headers, unsigned int metho
         headers.addViaMove(std::move(path), std::move(new_path));
       }
 
-      active_request_->request_url_.clear();
+      decoding_request_->request_url_.clear();
       return;
     }
     sendProtocolError();
@@ -460,90 +553,188 @@ void ServerConnectionImpl::handlePath(HeaderMapImpl& headers, unsigned int metho
   }
 }
 
+void ServerConnectionImpl::decodeRequestHeaders(HeaderMapImplPtr&& headers, unsigned int method,
+                                                bool has_body) {
+  const char* method_string = http_method_str(static_cast<http_method>(method));
+
+  // Currently, CONNECT is not supported, however; http_parser_parse_url needs to know about
+  // CONNECT
+  handlePath(*headers, method);
+  ASSERT(decoding_request_->request_url_.empty());
+
+  headers->insertMethod().value(method_string, strlen(method_string));
+
+  // Deal with expect: 100-continue here since higher layers are never going to do anything other
+  // than say to continue so that we can respond before request complete if necessary.
+  if (headers->Expect() &&
+      0 == StringUtil::caseInsensitiveCompare(headers->Expect()->value().c_str(),
+                                              Headers::get().ExpectValues._100Continue.c_str())) {
+    decoding_request_->response_encoder_.encode100Continue();
+    headers->removeExpect();
+  }
+
+  // If there is no body, we defer raising decodeHeaders() until the request is complete. This
+  // allows upper layers to behave like HTTP/2 and prevents a proxy scenario where the higher layers
+  // stream through and implicitly switch to chunked transfer encoding because end stream with zero
+  // body length has not yet been indicated.
+  if (has_body) {
+    decoding_request_->request_decoder_->decodeHeaders(std::move(headers), false);
+  } else {
+    deferred_end_stream_headers_ = std::move(headers);
+  }
+}
+
 int ServerConnectionImpl::onHeadersComplete(HeaderMapImplPtr&& headers) {
   // Handle the case where response happens prior to request complete. It's up to upper layer code
   // to disconnect the connection but we shouldn't fire any more events since it doesn't make
   // sense.
-  if (active_request_) {
-    const char* method_string = http_method_str(static_cast<http_method>(parser_.method));
-
-    // Currently, CONNECT is not supported, however; http_parser_parse_url needs to know about
-    // CONNECT
-    handlePath(*headers, parser_.method);
-    ASSERT(active_request_->request_url_.empty());
-
-    headers->insertMethod().value(method_string, strlen(method_string));
-
-    // Deal with expect: 100-continue here since higher layers are never going to do anything other
-    // than say to continue so that we can respond before request complete if necessary.
-    if (headers->Expect() &&
-        0 == StringUtil::caseInsensitiveCompare(headers->Expect()->value().c_str(),
-                                                Headers::get().ExpectValues._100Continue.c_str())) {
-      Buffer::OwnedImpl continue_response("HTTP/1.1 100 Continue\r\n\r\n");
-      connection_.write(continue_response);
-      headers->removeExpect();
-    }
-
+  if (decoding_request_) {
     // Determine here whether we have a body or not. This uses the new RFC semantics where the
     // presence of content-length or chunked transfer-encoding indicates a body vs. a particular
-    // method. If there is no body, we defer raising decodeHeaders() until the parser is flushed
-    // with message complete. This allows upper layers to behave like HTTP/2 and prevents a proxy
-    // scenario where the higher layers stream through and implicitly switch to chunked transfer
-    // encoding because end stream with zero body length has not yet been indicated.
-    if (parser_.flags & F_CHUNKED ||
-        (parser_.content_length > 0 && parser_.content_length != ULLONG_MAX)) {
-      active_request_->request_decoder_->decodeHeaders(std::move(headers), false);
-
-      // If the connection has been closed (or is closing) after decoding headers, pause the parser
-      // so we return control to the caller.
-      if (connection_.state() != Network::Connection::State::Open) {
-        http_parser_pause(&parser_, 1);
-      }
+    // method.
+    const bool has_body = parser_.flags & F_CHUNKED ||
+                          (parser_.content_length > 0 && parser_.content_length != ULLONG_MAX);
+    decodeRequestHeaders(std::move(headers), parser_.method, has_body);
+
+    // If the connection has been closed (or is closing) after decoding headers, pause the parser
+    // so we return control to the caller.
+    if (has_body && connection_.state() != Network::Connection::State::Open) {
+      http_parser_pause(&parser_, 1);
+    }
+  }
+
+  return 0;
+}
+
+void ServerConnectionImpl::dispatch(Buffer::Instance& data) {
+  if (!codec_settings_.fast_request_parser_ || fast_parser_disabled_ || parser_request_) {
+    ConnectionImpl::dispatch(data);
+    return;
+  }
+
+  if (fast_request_) {
+    if (data.length() == 0) {
+      // The connection was closed before the end of the body.
+      sendProtocolError();
+      throw CodecProtocolException("http/1.1 protocol error: HPE_INVALID_EOF_STATE");
+    }
+    dispatchFastBody(data);
+    return;
+  }
+
+  // A request head that is split across slices, or that the fast parser does not handle, goes to
+  // http_parser, which then parses the whole request.
+  RequestHeadParser::RequestHead head;
+  Buffer::RawSlice slice;
+  if (data.getRawSlices(&slice, 1) == 0 ||
+      RequestHeadParser::parse(static_cast<const char*>(slice.mem_), slice.len_, head) !=
+          RequestHeadParser::Result::Complete) {
+    ConnectionImpl::dispatch(data);
+    return;
+  }
+
+  ENVOY_CONN_LOG(trace, "parsed request head of {} bytes", connection_, head.length_);
+  fast_request_ = true;
+  onMessageBegin();
+  fast_body_remaining_ = head.content_length_;
+  if (decoding_request_) {
+    decoding_request_->request_url_.setCopy(head.url_, head.url_length_);
+  }
+  data.drain(head.length_);
+
+  if (decoding_request_) {
+    decodeRequestHeaders(std::move(head.headers_), head.method_, fast_body_remaining_ > 0);
+
+    // As with http_parser, return control to the caller if the connection has been closed (or is
+    // closing) after decoding headers.
+    if (fast_body_remaining_ > 0 && connection_.state() != Network::Connection::State::Open) {
+      return;
+    }
+  }
+
+  dispatchFastBody(data);
+}
+
+void ServerConnectionImpl::dispatchFastBody(Buffer::Instance& data) {
+  if (fast_body_remaining_ > 0) {
+    if (data.length() == 0) {
+      return;
+    }
 
+    const uint64_t length = std::min(fast_body_remaining_, data.length());
+    fast_body_remaining_ -= length;
+    if (decoding_request_) {
+      ENVOY_CONN_LOG(trace, "body size={}", connection_, length);
+      Buffer::OwnedImpl buffer;
+      buffer.move(data, length);
+      decoding_request_->request_decoder_->decodeData(buffer, false);
     } else {
-      deferred_end_stream_headers_ = std::move(headers);
+      data.drain(length);
+    }
+
+    if (fast_body_remaining_ > 0) {
+      return;
     }
   }
 
-  return 0;
+  fast_request_ = false;
+  onMessageComplete();
 }
 
 void ServerConnectionImpl::onMessageBegin() {
+  parser_request_ = !fast_request_;
   if (!resetStreamCalled()) {
-    ASSERT(!active_request_);
-    active_request_.reset(new ActiveRequest(*this));
-    active_request_->request_decoder_ = &callbacks_.newStream(active_request_->response_encoder_);
+    ASSERT(!decoding_request_);
+    active_requests_.emplace_back(new ActiveRequest(*this));
+    decoding_request_ = active_requests_.back().get();
+    if (active_requests_.size() > 1) {
+      decoding_request_->response_encoder_.holdOutput();
+    }
+    decoding_request_->request_decoder_ =
+        &callbacks_.newStream(decoding_request_->response_encoder_);
   }
 }
 
 void ServerConnectionImpl::onUrl(const char* data, size_t length) {
-  if (active_request_) {
-    active_request_->request_url_.append(data, length);
+  if (decoding_request_) {
+    decoding_request_->request_url_.append(data, length);
   }
 }
 
 void ServerConnectionImpl::onBody(const char* data, size_t length) {
   ASSERT(!deferred_end_stream_headers_);
-  if (active_request_) {
+  if (decoding_request_) {
     ENVOY_CONN_LOG(trace, "body size={}", connection_, length);
     Buffer::OwnedImpl buffer(data, length);
-    active_request_->request_decoder_->decodeData(buffer, false);
+    decoding_request_->request_decoder_->decodeData(buffer, false);
   }
 }
 
 void ServerConnectionImpl::onMessageComplete() {
-  if (active_request_) {
+  if (parser_request_) {
+    parser_request_ = false;
+    if (!http_should_keep_alive(&parser_)) {
+      fast_parser_disabled_ = true;
+    }
+  }
+
+  if (decoding_request_) {
     ENVOY_CONN_LOG(trace, "message complete", connection_);
-    Buffer::OwnedImpl buffer;
-    active_request_->remote_complete_ = true;
+    // The request may be destroyed by the decoder if it responds right away.
+    StreamDecoder& request_decoder = *decoding_request_->request_decoder_;
+    decoding_request_->remote_complete_ = true;
+    decoding_request_ = nullptr;
 
     if (deferred_end_stream_headers_) {
-      active_request_->request_decoder_->decodeHeaders(std::move(deferred_end_stream_headers_),
-                                                       true);
+      request_decoder.decodeHeaders(std::move(deferred_end_stream_headers_), true);
       deferred_end_stream_headers_.reset();
     } else {
-      active_request_->request_decoder_->decodeData(buffer, true);
+      Buffer::OwnedImpl buffer;
+      request_decoder.decodeData(buffer, true);
     }
+
+    // The response may have been completed before the request.
+    releaseCompletedRequests();
   }
 
   // Always pause the parser so that the calling code can process 1 request at a time and apply
@@ -553,9 +744,23 @@ void ServerConnectionImpl::onMessageComplete() {
 }
 
 void ServerConnectionImpl::onResetStream(StreamResetReason reason) {
-  ASSERT(active_request_);
-  active_request_->response_encoder_.runResetCallbacks(reason);
-  active_request_.reset();
+  // There is no way to reset a single request in HTTP/1.1, so the connection is going to be closed.
+  // The responses to the requests ahead of the reset one are still written first. The reset
+  // request and the ones pipelined behind it can't be answered, so they are all reset.
+  auto reset_request = std::find_if(active_requests_.begin(), active_requests_.end(),
+                                    [](const ActiveRequestPtr& request) -> bool {
+                                      return request->response_encoder_.resetCalled();
+                                    });
+  ASSERT(reset_request != active_requests_.end());
+  std::list<ActiveRequestPtr> requests;
+  requests.splice(requests.end(), active_requests_, reset_request, active_requests_.end());
+  decoding_request_ = nullptr;
+  for (const ActiveRequestPtr& request : requests) {
+    // A complete request is only waiting to write its response, and nothing refers to it any more.
+    if (request->response_encoder_.resetCalled() || !request->complete()) {
+      request->response_encoder_.runResetCallbacks(reason);
+    }
+  }
 }
 
 void ServerConnectionImpl::sendProtocolError() {
@@ -563,23 +768,39 @@ void ServerConnectionImpl::sendProtocolError() {
   // layers can only operate on streams, so there is no coherent way to allow them to send an error
   // "out of band." On one hand this is kind of a hack but on the other hand it normalizes HTTP/1.1
   // to look more like HTTP/2 to higher layers.
-  if (!active_request_ || !active_request_->response_encoder_.startedResponse()) {
-    Buffer::OwnedImpl bad_request_response(
-        fmt::format("HTTP/1.1 {} {}\r\ncontent-length: 0\r\nconnection: close\r\n\r\n",
-                    std::to_string(enumToInt(error_code_)), CodeUtility::toString(error_code_)));
-
-    connection_.write(bad_request_response);
+  Buffer::OwnedImpl bad_request_response(
+      fmt::format("HTTP/1.1 {} {}\r\ncontent-length: 0\r\nconnection: close\r\n\r\n",
+                  std::to_string(enumToInt(error_code_)), CodeUtility::toString(error_code_)));
+
+  // The client would take an error written while an earlier request is still waiting for its
+  // response as the response to that request. So it only goes straight to the connection when the
+  // failing request, if it got far enough to exist, is the only one left and has not started a
+  // response of its own. Otherwise the failing request holds it until the earlier responses have
+  // been written, and without a failing request the connection is closed without an error.
+  if (active_requests_.empty() ||
+      (active_requests_.size() == 1 && active_requests_.front().get() == decoding_request_)) {
+    if (active_requests_.empty() ||
+        !active_requests_.front()->response_encoder_.startedResponse()) {
+      connection_.write(bad_request_response);
+    }
+  } else if (decoding_request_ && !decoding_request_->response_encoder_.startedResponse()) {
+    decoding_request_->response_encoder_.holdProtocolError(bad_request_response);
   }
 }
 
 void ServerConnectionImpl::onAboveHighWatermark() {
-  if (active_request_) {
-    active_request_->response_encoder_.runHighWatermarkCallbacks();
+  // Only the response to the oldest request writes to the connection. Held responses apply back
+  // pressure through their own buffers.
+  high_watermark_calls_++;
+  if (!active_requests_.empty() && !active_requests_.front()->response_encoder_.encodeComplete()) {
+    active_requests_.front()->response_encoder_.runHighWatermarkCallbacks();
   }
 }
 void ServerConnectionImpl::onBelowLowWatermark() {
-  if (active_request_) {
-    active_request_->response_encoder_.runLowWatermarkCallbacks();
+  ASSERT(high_watermark_calls_ > 0);
+  high_watermark_calls_--;
+  if (!active_requests_.empty() && !active_requests_.front()->response_encoder_.encodeComplete()) {
+    active_requests_.front()->response_encoder_.runLowWatermarkCallbacks();
   }
 }
 
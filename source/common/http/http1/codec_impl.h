@@ -38,6 +38,11 @@ public:
   void encodeTrailers(const HeaderMap& trailers) override;
   Stream& getStream() override { return *this; }
 
+  /**
+   * @return bool whether the stream has been fully encoded.
+   */
+  bool encodeComplete() { return encode_complete_; }
+
   // Http::Stream
   void addCallbacks(StreamCallbacks& callbacks) override { addCallbacks_(callbacks); }
   void removeCallbacks(StreamCallbacks& callbacks) override { removeCallbacks_(callbacks); }
@@ -48,6 +53,11 @@ public:
 protected:
   StreamEncoderImpl(ConnectionImpl& connection) : connection_(connection) {}
 
+  /**
+   * Called to send everything encoded so far.
+   */
+  virtual void flushOutput();
+
   static const std::string CRLF;
   static const std::string LAST_CHUNK;
 
@@ -69,6 +79,7 @@ private:
   void endEncode();
 
   bool chunk_encoding_{true};
+  bool encode_complete_{};
 };
 
 /**
@@ -80,11 +91,55 @@ public:
 
   bool startedResponse() { return started_response_; }
 
+  /**
+   * Send a 100 Continue response ahead of the final response.
+   */
+  void encode100Continue();
+
+  /**
+   * Hold all output in the encoder instead of writing it to the connection. This is used for
+   * responses to pipelined requests, which must not be written before the responses to earlier
+   * requests on the connection.
+   */
+  void holdOutput();
+
+  /**
+   * Write any held output to the connection and stop holding output.
+   */
+  void releaseOutput();
+
+  /**
+   * Add the error response to a request that could not be parsed to the held output, in place of
+   * any other response to the request.
+   * @param response supplies the complete response, which is drained.
+   */
+  void holdProtocolError(Buffer::Instance& response);
+
+  /**
+   * Undo any readDisable(true) calls the stream has not undone itself.
+   */
+  void unwindReadDisable();
+
   // Http::StreamEncoder
   void encodeHeaders(const HeaderMap& headers, bool end_stream) override;
 
+  /**
+   * @return bool whether resetStream() has been called.
+   */
+  bool resetCalled() { return reset_called_; }
+
+  // Http::Stream
+  void readDisable(bool disable) override;
+  void resetStream(StreamResetReason reason) override;
+
 private:
+  // StreamEncoderImpl
+  void flushOutput() override;
+
   bool started_response_{};
+  Buffer::WatermarkBufferPtr held_output_;
+  uint32_t read_disable_calls_{};
+  bool reset_called_{};
 };
 
 /**
@@ -125,6 +180,11 @@ public:
    */
   void onResetStreamBase(StreamResetReason reason);
 
+  /**
+   * Commit the data written into the current buffer reservation to buffer().
+   */
+  void commitOutput();
+
   /**
    * Flush all pending output from encoding.
    */
@@ -266,6 +326,9 @@ public:
   ServerConnectionImpl(Network::Connection& connection, ServerConnectionCallbacks& callbacks,
                        Http1Settings settings);
 
+  // Http::Connection
+  void dispatch(Buffer::Instance& data) override;
+
 private:
   /**
    * An active HTTP/1.1 request.
@@ -273,12 +336,20 @@ private:
   struct ActiveRequest {
     ActiveRequest(ConnectionImpl& connection) : response_encoder_(connection) {}
 
+    /**
+     * @return bool whether the request has been received and answered in full. Nothing above the
+     *         codec refers to a complete request any more.
+     */
+    bool complete() { return remote_complete_ && response_encoder_.encodeComplete(); }
+
     HeaderString request_url_;
     StreamDecoder* request_decoder_{};
     ResponseStreamEncoderImpl response_encoder_;
     bool remote_complete_{};
   };
 
+  typedef std::unique_ptr<ActiveRequest> ActiveRequestPtr;
+
   /**
    * Manipulate the request's first line, parsing the url and converting to a relative path if
    * neccessary. Compute Host / :authority headers based on 7230#5.7 and 7230#6
@@ -289,6 +360,27 @@ private:
    */
   void handlePath(HeaderMapImpl& headers, unsigned int method);
 
+  /**
+   * Raise the headers of the active request, or defer them until the request is complete if it
+   * has no body.
+   * @param headers supplies the request's headers.
+   * @param method supplies the request's method.
+   * @param has_body supplies whether the request has a body.
+   */
+  void decodeRequestHeaders(HeaderMapImplPtr&& headers, unsigned int method, bool has_body);
+
+  /**
+   * Hand the body of a request parsed by RequestHeadParser to the decoder, completing the request
+   * once all of it has been received.
+   */
+  void dispatchFastBody(Buffer::Instance& data);
+
+  /**
+   * Destroy the requests at the front of the pipeline that are done in both directions, and let
+   * the next response write to the connection.
+   */
+  void releaseCompletedRequests();
+
   // ConnectionImpl
   void onEncodeComplete() override;
   void onMessageBegin() override;
@@ -302,8 +394,24 @@ private:
   void onBelowLowWatermark() override;
 
   ServerConnectionCallbacks& callbacks_;
-  std::unique_ptr<ActiveRequest> active_request_;
+  // Requests that have not completed in both directions, oldest first. Only the response to the
+  // oldest request writes to the connection; later responses are held until it completes.
+  std::list<ActiveRequestPtr> active_requests_;
+  // The request that is being received, if any.
+  ActiveRequest* decoding_request_{};
+  // The number of high watermark calls for the connection that have not been followed by a low
+  // watermark call yet. A held response inherits them when it starts writing to the connection.
+  uint32_t high_watermark_calls_{};
   Http1Settings codec_settings_;
+  // Whether http_parser is in the middle of a request, in which case it keeps parsing until the
+  // request is complete.
+  bool parser_request_{};
+  // Whether the current request was parsed by RequestHeadParser and its body is incomplete.
+  bool fast_request_{};
+  uint64_t fast_body_remaining_{};
+  // Set once http_parser completes a request that does not keep the connection alive, after which
+  // http_parser rejects any further data.
+  bool fast_parser_disabled_{};
 };
 
 /**
@@ -0,0 +1,282 @@
+#include "common/http/http1/request_head_parser.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <array>
+#include <string>
+
+#include "common/common/utility.h"
+#include "common/http/headers.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+namespace {
+
+/**
+ * Maps the characters allowed in header names (tchar in RFC 7230 section 3.2.6) to their lower
+ * case form, and everything else to 0.
+ */
+class TokenTable {
+public:
+  TokenTable() {
+    table_.fill(0);
+    for (char c : std::string("!#$%&'*+-.^_`|~0123456789abcdefghijklmnopqrstuvwxyz")) {
+      table_[static_cast<uint8_t>(c)] = c;
+    }
+    for (char c = 'A'; c <= 'Z'; c++) {
+      table_[static_cast<uint8_t>(c)] = c | 0x20;
+    }
+  }
+
+  char operator[](char c) const { return table_[static_cast<uint8_t>(c)]; }
+
+private:
+  std::array<char, 256> table_;
+};
+
+const TokenTable& tokenTable() {
+  static TokenTable* table = new TokenTable();
+  return *table;
+}
+
+// The request target is visible ASCII, ended by a space.
+bool isUrlChar(char c) { return c > 0x20 && c < 0x7f; }
+
+// Header values are anything but control characters and DEL. Tab is allowed, but treated as a
+// delimiter by the scan below so the common case only looks for one set of bytes.
+bool isValueChar(char c) { return static_cast<uint8_t>(c) >= 0x20 && c != 0x7f; }
+
+/**
+ * @return the first character in [p, end) that can not be part of a request target, or end.
+ */
+const char* findUrlEnd(const char* p, const char* end) {
+  // The compares are signed, so bytes with the high bit set are below the space.
+#if defined(__AVX2__)
+  const __m256i space = _mm256_set1_epi8(0x20);
+  const __m256i del = _mm256_set1_epi8(0x7f);
+  for (; end - p >= 32; p += 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i valid =
+        _mm256_and_si256(_mm256_cmpgt_epi8(v, space), _mm256_cmpgt_epi8(del, v));
+    const uint32_t invalid = ~static_cast<uint32_t>(_mm256_movemask_epi8(valid));
+    if (invalid != 0) {
+      return p + __builtin_ctz(invalid);
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i space16 = _mm_set1_epi8(0x20);
+  const __m128i del16 = _mm_set1_epi8(0x7f);
+  for (; end - p >= 16; p += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i valid = _mm_and_si128(_mm_cmpgt_epi8(v, space16), _mm_cmplt_epi8(v, del16));
+    const uint32_t invalid = ~static_cast<uint32_t>(_mm_movemask_epi8(valid)) & 0xffff;
+    if (invalid != 0) {
+      return p + __builtin_ctz(invalid);
+    }
+  }
+#endif
+  while (p < end && isUrlChar(*p)) {
+    p++;
+  }
+  return p;
+}
+
+/**
+ * @return the first control character or DEL in [p, end), or end.
+ */
+const char* findValueEnd(const char* p, const char* end) {
+  // A byte is a control character if it is signed non negative and below the space.
+#if defined(__AVX2__)
+  const __m256i minus_one = _mm256_set1_epi8(-1);
+  const __m256i space = _mm256_set1_epi8(0x20);
+  const __m256i del = _mm256_set1_epi8(0x7f);
+  for (; end - p >= 32; p += 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i control =
+        _mm256_and_si256(_mm256_cmpgt_epi8(v, minus_one), _mm256_cmpgt_epi8(space, v));
+    const uint32_t invalid = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_or_si256(control, _mm256_cmpeq_epi8(v, del))));
+    if (invalid != 0) {
+      return p + __builtin_ctz(invalid);
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i minus_one16 = _mm_set1_epi8(-1);
+  const __m128i space16 = _mm_set1_epi8(0x20);
+  const __m128i del16 = _mm_set1_epi8(0x7f);
+  for (; end - p >= 16; p += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i control =
+        _mm_and_si128(_mm_cmpgt_epi8(v, minus_one16), _mm_cmplt_epi8(v, space16));
+    const uint32_t invalid = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_or_si128(control, _mm_cmpeq_epi8(v, del16))));
+    if (invalid != 0) {
+      return p + __builtin_ctz(invalid);
+    }
+  }
+#endif
+  while (p < end && isValueChar(*p)) {
+    p++;
+  }
+  return p;
+}
+
+struct Method {
+  const char* name_;
+  size_t length_;
+  http_method method_;
+};
+
+// CONNECT is left out since its target is not in origin form, as are the WebDAV and other rarely
+// used methods http_parser knows about.
+const Method METHODS[] = {{"GET", 3, HTTP_GET},         {"POST", 4, HTTP_POST},
+                          {"PUT", 3, HTTP_PUT},         {"HEAD", 4, HTTP_HEAD},
+                          {"DELETE", 6, HTTP_DELETE},   {"OPTIONS", 7, HTTP_OPTIONS},
+                          {"PATCH", 5, HTTP_PATCH}};
+
+bool parseMethod(const char*& p, const char* end, http_method& method) {
+  for (const Method& candidate : METHODS) {
+    if (static_cast<size_t>(end - p) > candidate.length_ &&
+        memcmp(p, candidate.name_, candidate.length_) == 0 && p[candidate.length_] == ' ') {
+      method = candidate.method_;
+      p += candidate.length_ + 1;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool isHeader(const HeaderString& key, const LowerCaseString& name) {
+  return key.size() == name.get().size() && key == name.get().c_str();
+}
+
+bool parseContentLength(const HeaderString& value, uint64_t& length) {
+  // Longer values are left to http_parser's overflow checks.
+  if (value.empty() || value.size() > 18) {
+    return false;
+  }
+
+  length = 0;
+  for (const char* p = value.c_str(); *p != 0; p++) {
+    if (*p < '0' || *p > '9') {
+      return false;
+    }
+    length = length * 10 + (*p - '0');
+  }
+  return true;
+}
+
+} // namespace
+
+const size_t RequestHeadParser::MAX_HEAD_SIZE;
+
+RequestHeadParser::Result RequestHeadParser::parse(const char* data, size_t length,
+                                                   RequestHead& head) {
+  const char* head_end =
+      static_cast<const char*>(memmem(data, std::min(length, MAX_HEAD_SIZE), "\r\n\r\n", 4));
+  if (head_end == nullptr) {
+    return length < MAX_HEAD_SIZE ? Result::Incomplete : Result::Unsupported;
+  }
+
+  // From here on every scan is bounded by the CRLF CRLF that ends the head, so running into a CR
+  // is the only way a scan stops before end.
+  const char* end = head_end + 4;
+  const char* p = data;
+
+  if (!parseMethod(p, end, head.method_) || *p != '/') {
+    return Result::Unsupported;
+  }
+  head.url_ = p;
+  p = findUrlEnd(p, end);
+  head.url_length_ = p - head.url_;
+
+  static const char VERSION[] = " HTTP/1.1\r\n";
+  static const size_t VERSION_LENGTH = sizeof(VERSION) - 1;
+  if (static_cast<size_t>(end - p) < VERSION_LENGTH || memcmp(p, VERSION, VERSION_LENGTH) != 0) {
+    return Result::Unsupported;
+  }
+  p += VERSION_LENGTH;
+
+  const TokenTable& tokens = tokenTable();
+  HeaderMapImplPtr headers(new HeaderMapImpl());
+  bool has_content_length = false;
+  head.content_length_ = 0;
+  while (*p != '\r') {
+    const char* colon = static_cast<const char*>(memchr(p, ':', end - p));
+    if (colon == nullptr || colon == p) {
+      return Result::Unsupported;
+    }
+
+    // Validate and lower case the name in the copy.
+    HeaderString key;
+    key.setCopy(p, colon - p);
+    char* name = key.buffer();
+    for (uint32_t i = 0; i < key.size(); i++) {
+      const char c = tokens[name[i]];
+      if (c == 0) {
+        return Result::Unsupported;
+      }
+      name[i] = c;
+    }
+
+    p = colon + 1;
+    while (*p == ' ' || *p == '\t') {
+      p++;
+    }
+    const char* value_end = findValueEnd(p, end);
+    while (*value_end == '\t') {
+      value_end = findValueEnd(value_end + 1, end);
+    }
+    if (value_end[0] != '\r' || value_end[1] != '\n') {
+      return Result::Unsupported;
+    }
+
+    // Like http_parser, trailing whitespace is kept.
+    HeaderString value;
+    value.setCopy(p, value_end - p);
+    p = value_end + 2;
+
+    // Headers that change the framing of the message or the connection are left to http_parser.
+    if (isHeader(key, Headers::get().ContentLength)) {
+      if (has_content_length || !parseContentLength(value, head.content_length_)) {
+        return Result::Unsupported;
+      }
+      has_content_length = true;
+    } else if (isHeader(key, Headers::get().Connection) ||
+               isHeader(key, Headers::get().ProxyConnection)) {
+      if (0 != StringUtil::caseInsensitiveCompare(
+                   value.c_str(), Headers::get().ConnectionValues.KeepAlive.c_str())) {
+        return Result::Unsupported;
+      }
+    } else if (isHeader(key, Headers::get().TransferEncoding) ||
+               isHeader(key, Headers::get().Upgrade)) {
+      return Result::Unsupported;
+    }
+
+    headers->addViaMove(std::move(key), std::move(value));
+  }
+
+  // A CR that is not followed by LF at the start of a line stops the loop early.
+  if (p != end - 2) {
+    return Result::Unsupported;
+  }
+
+  head.headers_ = std::move(headers);
+  head.length_ = end - data;
+  return Result::Complete;
+}
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/http/header_map_impl.h"
+
+#include "http_parser.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+/**
+ * Parser for the head (request line and headers) of an HTTP/1.1 request held in contiguous
+ * memory. The request target and header values are scanned for delimiters 16 or 32 bytes at a time
+ * with SSE2 or AVX2 when the build targets them, and a byte at a time otherwise. Header names are
+ * validated and lower cased in the same pass, and headers are added to the map as they are parsed.
+ *
+ * The parser only accepts a strict subset of what http_parser accepts: origin form requests with
+ * one of the common methods, HTTP/1.1, token header names, no control characters, and no
+ * Transfer-Encoding, Upgrade or non keep-alive Connection headers. Requests it does not support
+ * are not necessarily invalid; the caller is expected to hand them to http_parser, which then
+ * either parses or rejects them. This keeps everything http_parser's framing and error handling
+ * deals with in one place.
+ */
+class RequestHeadParser {
+public:
+  enum class Result {
+    // The head was parsed.
+    Complete,
+    // The data does not hold a full head yet.
+    Incomplete,
+    // The request is not one the parser handles.
+    Unsupported
+  };
+
+  struct RequestHead {
+    http_method method_;
+    // The request target, pointing into the parsed data.
+    const char* url_;
+    size_t url_length_;
+    HeaderMapImplPtr headers_;
+    // 0 if there is no Content-Length header.
+    uint64_t content_length_;
+    // The size of the head, including the empty line that ends it.
+    size_t length_;
+  };
+
+  /**
+   * Largest head the parser accepts. Requests with larger heads are left to http_parser, which
+   * allows up to HTTP_MAX_HEADER_SIZE.
+   */
+  static const size_t MAX_HEAD_SIZE = 64 * 1024;
+
+  /**
+   * Parse a request head.
+   * @param data supplies the start of the request.
+   * @param length supplies the number of bytes available.
+   * @param head is filled in if the result is Complete.
+   * @return Result whether the head was parsed.
+   */
+  static Result parse(const char* data, size_t length, RequestHead& head);
+};
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
@@ -62,46 +62,82 @@ ConnectionImpl::StreamImpl::StreamImpl(ConnectionImpl& parent, uint32_t buffer_l
   }
 }
 
-static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& header) {
+/**
+ * @return whether a header must never enter the HPACK dynamic table. Per RFC 7541 section 7.1.3,
+ * values such as credentials and cookies could otherwise be guessed by an attacker who can inject
+ * headers on the same connection and observe the compressed size.
+ */
+static bool isSensitiveHeader(const HeaderString& key) {
+  static const LowerCaseString* sensitive_headers[] = {
+      &Headers::get().Authorization, &Headers::get().Cookie, &Headers::get().ProxyAuthorization,
+      &Headers::get().SetCookie};
+  for (const LowerCaseString* header : sensitive_headers) {
+    if (key.size() == header->get().size() && key == header->get().c_str()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& header,
+                         bool no_copy) {
   uint8_t flags = 0;
-  if (header.key().type() == HeaderString::Type::Reference) {
+  if (no_copy || header.key().type() == HeaderString::Type::Reference) {
     flags |= NGHTTP2_NV_FLAG_NO_COPY_NAME;
   }
-  if (header.value().type() == HeaderString::Type::Reference) {
+  if (no_copy || header.value().type() == HeaderString::Type::Reference) {
     flags |= NGHTTP2_NV_FLAG_NO_COPY_VALUE;
   }
+  if (isSensitiveHeader(header.key())) {
+    flags |= NGHTTP2_NV_FLAG_NO_INDEX;
+  }
   headers.push_back({remove_const<uint8_t>(header.key().c_str()),
                      remove_const<uint8_t>(header.value().c_str()), header.key().size(),
                      header.value().size(), flags});
 }
 
-void ConnectionImpl::StreamImpl::buildHeaders(std::vector<nghttp2_nv>& final_headers,
-                                              const HeaderMap& headers) {
+void ConnectionImpl::buildHeaders(const HeaderMap& headers, bool no_copy) {
+  // nghttp2 copies the nv array itself when a frame is submitted, so the same vector is reused
+  // for every frame on the connection.
+  nv_scratch_.clear();
+  nv_scratch_.reserve(headers.size());
+
   // nghttp2 requires that all ':' headers come before all other headers. To avoid making higher
   // layers understand that we do two passes here to build the final header list to encode.
-  final_headers.reserve(headers.size());
+  struct Context {
+    std::vector<nghttp2_nv>& final_headers_;
+    bool no_copy_;
+  } context{nv_scratch_, no_copy};
   headers.iterate(
       [](const HeaderEntry& header, void* context) -> void {
-        std::vector<nghttp2_nv>* final_headers = static_cast<std::vector<nghttp2_nv>*>(context);
+        Context* ctx = static_cast<Context*>(context);
         if (header.key().c_str()[0] == ':') {
-          insertHeader(*final_headers, header);
+          insertHeader(ctx->final_headers_, header, ctx->no_copy_);
         }
       },
-      &final_headers);
+      &context);
 
   headers.iterate(
       [](const HeaderEntry& header, void* context) -> void {
-        std::vector<nghttp2_nv>* final_headers = static_cast<std::vector<nghttp2_nv>*>(context);
+        Context* ctx = static_cast<Context*>(context);
         if (header.key().c_str()[0] != ':') {
-          insertHeader(*final_headers, header);
+          insertHeader(ctx->final_headers_, header, ctx->no_copy_);
         }
       },
-      &final_headers);
+      &context);
+}
+
+bool ConnectionImpl::sendsHeadersImmediately() {
+  // With NO_COPY flags nghttp2 reads the header storage when it serializes the frame rather than
+  // when it is submitted. That happens in the sendPendingFrames() call that follows the submit,
+  // before the header map can be changed or destroyed, unless we are dispatching (frames are sent
+  // once dispatch completes) or this is a client, whose request HEADERS nghttp2 holds back while
+  // the peer's concurrent stream limit is reached.
+  return !dispatching_ && nghttp2_session_check_server_session(session_);
 }
 
 void ConnectionImpl::StreamImpl::encodeHeaders(const HeaderMap& headers, bool end_stream) {
-  std::vector<nghttp2_nv> final_headers;
-  buildHeaders(final_headers, headers);
+  parent_.buildHeaders(headers, parent_.sendsHeadersImmediately());
 
   nghttp2_data_provider provider;
   if (!end_stream) {
@@ -114,7 +150,7 @@ void ConnectionImpl::StreamImpl::encodeHeaders(const HeaderMap& headers, bool en
   }
 
   local_end_stream_ = end_stream;
-  submitHeaders(final_headers, end_stream ? nullptr : &provider);
+  submitHeaders(parent_.nv_scratch_, end_stream ? nullptr : &provider);
   parent_.sendPendingFrames();
 }
 
@@ -127,7 +163,7 @@ void ConnectionImpl::StreamImpl::encodeTrailers(const HeaderMap& trailers) {
     ASSERT(!pending_trailers_);
     pending_trailers_.reset(new HeaderMapImpl(trailers));
   } else {
-    submitTrailers(trailers);
+    submitTrailers(trailers, parent_.sendsHeadersImmediately());
     parent_.sendPendingFrames();
   }
 }
@@ -182,11 +218,10 @@ void ConnectionImpl::StreamImpl::saveHeader(HeaderString&& name, HeaderString&&
   }
 }
 
-void ConnectionImpl::StreamImpl::submitTrailers(const HeaderMap& trailers) {
-  std::vector<nghttp2_nv> final_headers;
-  buildHeaders(final_headers, trailers);
-  int rc =
-      nghttp2_submit_trailer(parent_.session_, stream_id_, &final_headers[0], final_headers.size());
+void ConnectionImpl::StreamImpl::submitTrailers(const HeaderMap& trailers, bool no_copy) {
+  parent_.buildHeaders(trailers, no_copy);
+  int rc = nghttp2_submit_trailer(parent_.session_, stream_id_, &parent_.nv_scratch_[0],
+                                  parent_.nv_scratch_.size());
   ASSERT(rc == 0);
   UNREFERENCED_PARAMETER(rc);
 }
@@ -202,8 +237,9 @@ ssize_t ConnectionImpl::StreamImpl::onDataSourceRead(uint64_t length, uint32_t*
       *data_flags |= NGHTTP2_DATA_FLAG_EOF;
       if (pending_trailers_) {
         // We need to tell the library to not set end stream so that we can emit the trailers.
+        // The saved trailers are released right away, so nghttp2 must copy them.
         *data_flags |= NGHTTP2_DATA_FLAG_NO_END_STREAM;
-        submitTrailers(*pending_trailers_);
+        submitTrailers(*pending_trailers_, false);
         pending_trailers_.reset();
       }
     }
@@ -378,10 +414,10 @@ int ConnectionImpl::onFrameReceived(const nghttp2_frame* frame) {
                                                 Headers::get().ExpectValues._100Continue.c_str())) {
       // Deal with expect: 100-continue here since higher layers are never going to do anything
       // other than say to continue so that we can respond before request complete if necessary.
-      std::vector<nghttp2_nv> final_headers;
-      StreamImpl::buildHeaders(final_headers, *CONTINUE_HEADER);
-      int rc = nghttp2_submit_headers(session_, 0, stream->stream_id_, nullptr, &final_headers[0],
-                                      final_headers.size(), nullptr);
+      // CONTINUE_HEADER is static and never changes, so it never needs to be copied.
+      buildHeaders(*CONTINUE_HEADER, true);
+      int rc = nghttp2_submit_headers(session_, 0, stream->stream_id_, nullptr, &nv_scratch_[0],
+                                      nv_scratch_.size(), nullptr);
       ASSERT(rc == 0);
       UNREFERENCED_PARAMETER(rc);
 
@@ -477,7 +513,20 @@ int ConnectionImpl::onFrameSend(const nghttp2_frame* frame) {
     break;
   }
 
-  case NGHTTP2_HEADERS:
+  case NGHTTP2_HEADERS: {
+    // The frame length is the size of the HPACK encoded header block, to compare against the size
+    // of the header fields it encodes.
+    stats_.tx_headers_encoded_bytes_.add(frame->hd.length);
+    for (size_t i = 0; i < frame->headers.nvlen; i++) {
+      const nghttp2_nv& nv = frame->headers.nva[i];
+      stats_.tx_headers_raw_bytes_.add(nv.namelen + nv.valuelen);
+      if (nv.flags & NGHTTP2_NV_FLAG_NO_INDEX) {
+        stats_.tx_headers_never_indexed_.inc();
+      }
+    }
+    FALLTHRU;
+  }
+
   case NGHTTP2_DATA: {
     StreamImpl* stream = getStream(frame->hd.stream_id);
     stream->local_end_stream_sent_ = frame->hd.flags & NGHTTP2_FLAG_END_STREAM;
@@ -41,7 +41,10 @@ const std::string CLIENT_MAGIC_PREFIX = "PRI * HTTP/2";
   COUNTER(tx_reset)                                                                                \
   COUNTER(header_overflow)                                                                         \
   COUNTER(trailers)                                                                                \
-  COUNTER(headers_cb_no_stream)
+  COUNTER(headers_cb_no_stream)                                                                    \
+  COUNTER(tx_headers_raw_bytes)                                                                    \
+  COUNTER(tx_headers_encoded_bytes)                                                                \
+  COUNTER(tx_headers_never_indexed)
 // clang-format on
 
 /**
@@ -140,11 +143,10 @@ protected:
     ssize_t onDataSourceRead(uint64_t length, uint32_t* data_flags);
     int onDataSourceSend(const uint8_t* framehd, size_t length);
     void resetStreamWorker(StreamResetReason reason);
-    static void buildHeaders(std::vector<nghttp2_nv>& final_headers, const HeaderMap& headers);
     void saveHeader(HeaderString&& name, HeaderString&& value);
     virtual void submitHeaders(const std::vector<nghttp2_nv>& final_headers,
                                nghttp2_data_provider* provider) PURE;
-    void submitTrailers(const HeaderMap& trailers);
+    void submitTrailers(const HeaderMap& trailers, bool no_copy);
 
     // Http::StreamEncoder
     void encodeHeaders(const HeaderMap& headers, bool end_stream) override;
@@ -229,6 +231,18 @@ protected:
 
   ConnectionImpl* base() { return this; }
   StreamImpl* getStream(int32_t stream_id);
+  /**
+   * Fill nv_scratch_ with the headers of a frame about to be submitted.
+   * @param headers supplies the headers to encode.
+   * @param no_copy supplies whether all of the header storage stays valid and unchanged until the
+   *        frame is serialized, so that nghttp2 need not copy any name or value.
+   */
+  void buildHeaders(const HeaderMap& headers, bool no_copy);
+  /**
+   * @return whether a HEADERS frame submitted now is serialized by the sendPendingFrames() call
+   *         that follows it.
+   */
+  bool sendsHeadersImmediately();
   int saveHeader(const nghttp2_frame* frame, HeaderString&& name, HeaderString&& value);
   void sendPendingFrames();
   void sendSettings(const Http2Settings& http2_settings, bool disable_push);
@@ -238,6 +252,8 @@ protected:
 
   std::list<StreamImplPtr> active_streams_;
   nghttp2_session* session_{};
+  // Reused for the nv array of every HEADERS frame submitted on the connection.
+  std::vector<nghttp2_nv> nv_scratch_;
   CodecStats stats_;
   Network::Connection& connection_;
   uint32_t per_stream_buffer_limit_;
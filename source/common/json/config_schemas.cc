@@ -460,6 +460,7 @@ const std::string Json::Schema::TCP_PROXY_NETWORK_FILTER_SCHEMA(R"EOF(
       "type" : "object",
       "properties": {
         "stat_prefix": {"type" : "string"},
+        "splice": {"type" : "boolean"},
         "route_config": {
           "type": "object",
           "properties": {
@@ -906,6 +907,32 @@ const std::string Json::Schema::BUFFER_HTTP_FILTER_SCHEMA(R"EOF(
   }
   )EOF");
 
+const std::string Json::Schema::CACHE_HTTP_FILTER_SCHEMA(R"EOF(
+  {
+    "$schema": "http://json-schema.org/schema#",
+    "type" : "object",
+    "properties" : {
+      "max_worker_bytes" : {
+        "type" : "integer",
+        "minimum" : 0
+      },
+      "max_shared_bytes" : {
+        "type" : "integer",
+        "minimum" : 0
+      },
+      "max_entry_bytes" : {
+        "type" : "integer",
+        "minimum" : 0
+      },
+      "eviction" : {
+        "type" : "string",
+        "enum" : ["lru", "tinylfu"]
+      }
+    },
+    "additionalProperties" : false
+  }
+  )EOF");
+
 const std::string Json::Schema::FAULT_HTTP_FILTER_SCHEMA(R"EOF(
   {
     "$schema": "http://json-schema.org/schema#",
@@ -997,6 +1024,30 @@ const std::string Json::Schema::GRPC_JSON_TRANSCODER_FILTER_SCHEMA(R"EOF(
   }
   )EOF");
 
+const std::string Json::Schema::GZIP_HTTP_FILTER_SCHEMA(R"EOF(
+  {
+    "$schema": "http://json-schema.org/schema#",
+    "type" : "object",
+    "properties" : {
+      "compression_level" : {
+        "type" : "integer",
+        "minimum" : 1,
+        "maximum" : 9
+      },
+      "min_content_length" : {
+        "type" : "integer",
+        "minimum" : 0
+      },
+      "content_types" : {
+        "type" : "array",
+        "uniqueItems" : true,
+        "items" : { "type" : "string" }
+      }
+    },
+    "additionalProperties" : false
+  }
+  )EOF");
+
 const std::string Json::Schema::IP_TAGGING_HTTP_FILTER_SCHEMA(R"EOF(
   {
     "$schema": "http://json-schema.org/schema#",
@@ -1253,6 +1304,7 @@ const std::string Json::Schema::TOP_LEVEL_CONFIG_SCHEMA(R"EOF(
       "flags_path" : {"type" : "string"},
       "statsd_udp_ip_address" : {"type" : "string"},
       "statsd_tcp_cluster_name" : {"type" : "string"},
+      "binary_stats_udp_ip_address" : {"type" : "string"},
       "stats_flush_interval_ms" : {"type" : "integer"},
       "watchdog_miss_timeout_ms" : {"type" : "integer"},
       "watchdog_megamiss_timeout_ms" : {"type" : "integer"},
@@ -131,6 +131,7 @@ public:
 
   bool contains(const Instance& address) const;
   bool empty() const { return ip_list_.empty(); }
+  const std::vector<CidrRange>& ranges() const { return ip_list_; }
 
 private:
   std::vector<CidrRange> ip_list_;
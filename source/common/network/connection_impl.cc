@@ -1,5 +1,6 @@
 #include "common/network/connection_impl.h"
 
+#include <fcntl.h>
 #include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -12,6 +13,7 @@
 #include "envoy/event/timer.h"
 #include "envoy/network/filter.h"
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
 #include "common/common/empty_string.h"
 #include "common/common/enum_to_int.h"
@@ -105,13 +107,28 @@ ConnectionImpl::~ConnectionImpl() {
   close(ConnectionCloseType::NoFlush);
 }
 
+ConnectionImpl::SplicePipe::~SplicePipe() {
+  ::close(read_fd_);
+  ::close(write_fd_);
+}
+
 void ConnectionImpl::addWriteFilter(WriteFilterSharedPtr filter) {
+  if (splice_source_ != nullptr) {
+    splice_source_->stopSplicing();
+  }
   filter_manager_.addWriteFilter(filter);
 }
 
-void ConnectionImpl::addFilter(FilterSharedPtr filter) { filter_manager_.addFilter(filter); }
+void ConnectionImpl::addFilter(FilterSharedPtr filter) {
+  if (splice_source_ != nullptr) {
+    splice_source_->stopSplicing();
+  }
+  stopSplicing();
+  filter_manager_.addFilter(filter);
+}
 
 void ConnectionImpl::addReadFilter(ReadFilterSharedPtr filter) {
+  stopSplicing();
   filter_manager_.addReadFilter(filter);
 }
 
@@ -122,6 +139,13 @@ void ConnectionImpl::close(ConnectionCloseType type) {
     return;
   }
 
+  // Anything in flight through a splice pipe towards this connection is moved to the write buffer
+  // so that it can be flushed like any other pending data.
+  if (splice_source_ != nullptr) {
+    splice_source_->stopSplicing();
+  }
+  stopSplicing();
+
   uint64_t data_to_write = write_buffer_->length();
   ENVOY_CONN_LOG(debug, "closing data_to_write={} type={}", *this, data_to_write, enumToInt(type));
   if (data_to_write == 0 || type == ConnectionCloseType::NoFlush) {
@@ -158,6 +182,14 @@ void ConnectionImpl::closeSocket(ConnectionEvent close_type) {
 
   ENVOY_CONN_LOG(debug, "closing socket: {}", *this, static_cast<uint32_t>(close_type));
 
+  // Data spliced towards this connection is dropped along with the write buffer. Data spliced from
+  // this connection is handed to the peer which remains open.
+  if (splice_source_ != nullptr) {
+    splice_source_->splice_pipe_->size_ = 0;
+    splice_source_->stopSplicing();
+  }
+  stopSplicing();
+
   // Drain input and output buffers.
   updateReadBufferStats(0, 0);
   updateWriteBufferStats(0, 0);
@@ -282,6 +314,11 @@ bool ConnectionImpl::readEnabled() const { return state_ & InternalState::ReadEn
 void ConnectionImpl::addConnectionCallbacks(ConnectionCallbacks& cb) { callbacks_.push_back(&cb); }
 
 void ConnectionImpl::write(Buffer::Instance& data) {
+  // Data written from user space must not overtake data that is still in the splice pipe.
+  if (splice_source_ != nullptr && data.length() > 0) {
+    splice_source_->stopSplicing();
+  }
+
   // NOTE: This is kind of a hack, but currently we don't support restart/continue on the write
   //       path, so we just pass around the buffer passed to us in this function. If we ever support
   //       buffer/restart/continue on the write path this needs to get more complicated.
@@ -437,6 +474,16 @@ ConnectionImpl::IoResult ConnectionImpl::doReadFromSocket() {
 void ConnectionImpl::onReadReady() {
   ASSERT(!(state_ & InternalState::Connecting));
 
+  if (splice_peer_ != nullptr) {
+    IoResult result = doSpliceFromSocket();
+    updateReadBufferStats(result.bytes_processed_, 0);
+    if (result.action_ == PostIoAction::Close) {
+      ENVOY_CONN_LOG(debug, "remote close", *this);
+      closeSocket(ConnectionEvent::RemoteClose);
+    }
+    return;
+  }
+
   IoResult result = doReadFromSocket();
   uint64_t new_buffer_size = read_buffer_.length();
   updateReadBufferStats(result.bytes_processed_, new_buffer_size);
@@ -506,6 +553,18 @@ void ConnectionImpl::onWriteReady() {
 
   IoResult result = doWriteToSocket();
   uint64_t new_buffer_size = write_buffer_->length();
+  if (splice_source_ != nullptr && result.action_ == PostIoAction::KeepOpen) {
+    IoResult splice_result = doSpliceToSocket();
+    result.action_ = splice_result.action_;
+    result.bytes_processed_ += splice_result.bytes_processed_;
+    new_buffer_size += splice_source_->splice_pipe_->size_;
+
+    // The source stops reading when the pipe is full. Now that there is room again, have it pick
+    // up whatever is waiting in its socket.
+    if (splice_result.bytes_processed_ > 0 && splice_source_->readEnabled()) {
+      splice_source_->setReadBufferReady();
+    }
+  }
   updateWriteBufferStats(result.bytes_processed_, new_buffer_size);
 
   if (result.action_ == PostIoAction::Close) {
@@ -519,6 +578,148 @@ void ConnectionImpl::onWriteReady() {
   }
 }
 
+bool ConnectionImpl::spliceTo(Connection& peer) {
+#ifdef __linux__
+  ConnectionImpl* peer_impl = dynamic_cast<ConnectionImpl*>(&peer);
+  const uint32_t not_ready = InternalState::Connecting | InternalState::CloseWithFlush;
+  if (peer_impl == nullptr || peer_impl == this || fd_ == -1 || peer_impl->fd_ == -1 ||
+      (state_ & not_ready) || (peer_impl->state_ & not_ready) || ssl() != nullptr ||
+      peer.ssl() != nullptr || &peer_impl->dispatcher_ != &dispatcher_ ||
+      splice_peer_ != nullptr || peer_impl->splice_source_ != nullptr ||
+      filter_manager_.numReadFilters() > 1 || peer_impl->filter_manager_.hasWriteFilters() ||
+      read_buffer_.length() > 0) {
+    return false;
+  }
+
+  int fds[2];
+  if (::pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+    ENVOY_CONN_LOG(debug, "unable to create splice pipe: {}", *this, errno);
+    return false;
+  }
+
+  splice_pipe_.reset(new SplicePipe());
+  splice_pipe_->read_fd_ = fds[0];
+  splice_pipe_->write_fd_ = fds[1];
+  int capacity = ::fcntl(fds[1], F_GETPIPE_SZ);
+  // 64K is the default pipe capacity on Linux.
+  splice_pipe_->capacity_ = capacity > 0 ? capacity : 65536;
+  splice_peer_ = peer_impl;
+  peer_impl->splice_source_ = this;
+  ENVOY_CONN_LOG(debug, "splicing to [C{}] pipe_capacity={}", *this, peer.id(),
+                 splice_pipe_->capacity_);
+
+  // Reads are edge triggered, so make sure anything that arrived before splicing was enabled is
+  // picked up.
+  if (state_ & InternalState::ReadEnabled) {
+    setReadBufferReady();
+  }
+  return true;
+#else
+  UNREFERENCED_PARAMETER(peer);
+  return false;
+#endif
+}
+
+ConnectionImpl::IoResult ConnectionImpl::doSpliceFromSocket() {
+  PostIoAction action = PostIoAction::KeepOpen;
+  uint64_t bytes_read = 0;
+#ifdef __linux__
+  while ((state_ & InternalState::ReadEnabled) && splice_pipe_->size_ < splice_pipe_->capacity_) {
+    ssize_t rc = ::splice(fd_, nullptr, splice_pipe_->write_fd_, nullptr,
+                          splice_pipe_->capacity_ - splice_pipe_->size_,
+                          SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    ENVOY_CONN_LOG(trace, "splice from socket returns: {}", *this, rc);
+
+    if (rc == 0) {
+      action = PostIoAction::Close;
+      break;
+    } else if (rc == -1) {
+      // EAGAIN means either that there is no data or that the pipe is full. In the latter case the
+      // peer resumes reading once it has drained the pipe.
+      ENVOY_CONN_LOG(trace, "splice error: {}", *this, errno);
+      if (errno != EAGAIN) {
+        action = PostIoAction::Close;
+      }
+      break;
+    }
+
+    bytes_read += rc;
+    splice_pipe_->size_ += rc;
+
+    // Push the data to the peer right away so that the pipe does not fill up. Errors writing to
+    // the peer are raised from its own write event rather than from underneath this loop.
+    ConnectionImpl& peer = *splice_peer_;
+    IoResult result = peer.doSpliceToSocket();
+    peer.updateWriteBufferStats(result.bytes_processed_,
+                                peer.write_buffer_->length() + splice_pipe_->size_);
+    if (result.action_ == PostIoAction::Close) {
+      peer.file_event_->activate(Event::FileReadyType::Write);
+      break;
+    }
+  }
+#endif
+  return {action, bytes_read};
+}
+
+ConnectionImpl::IoResult ConnectionImpl::doSpliceToSocket() {
+  PostIoAction action = PostIoAction::KeepOpen;
+  uint64_t bytes_written = 0;
+#ifdef __linux__
+  SplicePipe& pipe = *splice_source_->splice_pipe_;
+  // Anything in the write buffer was read by the source before the data in the pipe, so it has to
+  // be written first.
+  if (write_buffer_->length() > 0 || (state_ & InternalState::Connecting)) {
+    return {action, bytes_written};
+  }
+
+  while (pipe.size_ > 0) {
+    ssize_t rc = ::splice(pipe.read_fd_, nullptr, fd_, nullptr, pipe.size_,
+                          SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    ENVOY_CONN_LOG(trace, "splice to socket returns: {}", *this, rc);
+    if (rc == -1) {
+      ENVOY_CONN_LOG(trace, "splice error: {}", *this, errno);
+      if (errno != EAGAIN) {
+        action = PostIoAction::Close;
+      }
+      break;
+    }
+
+    bytes_written += rc;
+    pipe.size_ -= rc;
+  }
+#endif
+  return {action, bytes_written};
+}
+
+void ConnectionImpl::stopSplicing() {
+  if (splice_peer_ == nullptr) {
+    return;
+  }
+
+  ENVOY_CONN_LOG(debug, "stop splicing to [C{}] pending={}", *this, splice_peer_->id(),
+                 splice_pipe_->size_);
+  ConnectionImpl& peer = *splice_peer_;
+  splice_peer_ = nullptr;
+  peer.splice_source_ = nullptr;
+
+  // Hand whatever is still in the pipe to the peer. It goes after anything already in the peer's
+  // write buffer, which is where it would have ended up without splicing.
+  Buffer::OwnedImpl pending;
+  while (splice_pipe_->size_ > 0) {
+    int rc = pending.read(splice_pipe_->read_fd_, splice_pipe_->size_);
+    if (rc <= 0) {
+      break;
+    }
+    splice_pipe_->size_ -= rc;
+  }
+  splice_pipe_.reset();
+
+  if (pending.length() > 0) {
+    peer.write_buffer_->move(pending);
+    peer.file_event_->activate(Event::FileReadyType::Write);
+  }
+}
+
 void ConnectionImpl::doConnect() {
   ENVOY_CONN_LOG(debug, "connecting to {}", *this, remote_address_->asString());
   int rc = remote_address_->connect(fd_);
@@ -79,6 +79,7 @@ public:
   uint32_t bufferLimit() const override { return read_buffer_limit_; }
   bool usingOriginalDst() const override { return using_original_dst_; }
   bool aboveHighWatermark() const override { return above_high_watermark_; }
+  bool spliceTo(Connection& peer) override;
 
   // Network::BufferSource
   Buffer::Instance& getReadBuffer() override { return read_buffer_; }
@@ -129,6 +130,22 @@ private:
   };
   // clang-format on
 
+  /**
+   * A non-blocking pipe used to move data from a socket to another socket with splice(). The pipe
+   * is owned by the connection that data is read from.
+   */
+  struct SplicePipe {
+    ~SplicePipe();
+
+    int read_fd_{-1};
+    int write_fd_{-1};
+    // Number of bytes currently sitting in the pipe.
+    uint64_t size_{};
+    uint64_t capacity_{};
+  };
+
+  typedef std::unique_ptr<SplicePipe> SplicePipePtr;
+
   virtual IoResult doReadFromSocket();
   virtual IoResult doWriteToSocket();
   virtual void onConnected();
@@ -136,6 +153,10 @@ private:
   void onRead(uint64_t read_buffer_size);
   void onReadReady();
   void onWriteReady();
+  IoResult doSpliceFromSocket();
+  IoResult doSpliceToSocket();
+  // Stop splicing data read from this connection. Data still in the pipe is handed to the peer.
+  void stopSplicing();
   void updateReadBufferStats(uint64_t num_read, uint64_t new_size);
   void updateWriteBufferStats(uint64_t num_written, uint64_t new_size);
 
@@ -158,6 +179,12 @@ private:
   const bool using_original_dst_;
   bool above_high_watermark_{false};
   bool detect_early_close_{true};
+  // Set on the connection data is spliced from. Data read from fd_ goes through splice_pipe_ to
+  // splice_peer_ without being copied into user space.
+  SplicePipePtr splice_pipe_;
+  ConnectionImpl* splice_peer_{};
+  // Set on the connection data is spliced to.
+  ConnectionImpl* splice_source_{};
 };
 
 /**
@@ -1,11 +1,20 @@
 #include "common/network/listener_impl.h"
 
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
 #include <sys/un.h>
+#include <unistd.h>
+
+#include <memory>
 
 #include "envoy/common/exception.h"
 #include "envoy/network/connection_handler.h"
 
+#include "common/common/assert.h"
 #include "common/common/empty_string.h"
+#include "common/common/logger.h"
 #include "common/event/dispatcher_impl.h"
 #include "common/event/file_event_impl.h"
 #include "common/network/address_impl.h"
@@ -13,7 +22,6 @@
 #include "common/network/utility.h"
 #include "common/ssl/connection_impl.h"
 
-#include "event2/listener.h"
 #include "fmt/format.h"
 
 namespace Envoy {
@@ -27,21 +35,71 @@ Address::InstanceConstSharedPtr ListenerImpl::getOriginalDst(int fd) {
   return Utility::getOriginalDst(fd);
 }
 
-void ListenerImpl::listenCallback(evconnlistener*, evutil_socket_t fd, sockaddr* remote_addr,
-                                  int remote_addr_len, void* arg) {
-  ListenerImpl* listener = static_cast<ListenerImpl*>(arg);
-  Address::InstanceConstSharedPtr final_local_address = listener->socket_.localAddress();
+void ListenerImpl::onSocketEvent() {
+  const uint32_t max_accepts =
+      options_.max_accepts_per_wakeup_ ? options_.max_accepts_per_wakeup_() : 0;
+  uint32_t accepted = 0;
+  while (max_accepts == 0 || accepted < max_accepts) {
+    sockaddr_storage remote_addr;
+    socklen_t remote_addr_len = sizeof(remote_addr);
+    const int fd = ::accept4(socket_.fd(), reinterpret_cast<sockaddr*>(&remote_addr),
+                             &remote_addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNABORTED) {
+        // The socket is level triggered, anything left is accepted in the next iteration.
+        break;
+      }
+
+      // Any other error means we ran out of FDs or memory, or the socket is gone. In those cases
+      // just crash.
+      PANIC(fmt::format("listener accept failure: {}", strerror(errno)));
+    }
+
+    accepted++;
+    onAccept(fd, remote_addr, remote_addr_len);
+  }
+
+  // Level triggered wakeups can find the queue empty, e.g. when another worker accepted first.
+  // Those are not recorded, they would swamp the distribution with zeroes.
+  if (accepted > 0) {
+    stats_.downstream_cx_accepts_per_wakeup_.recordValue(accepted);
+  }
+  if (max_accepts > 0 && accepted == max_accepts) {
+    checkAcceptQueue();
+  }
+}
+
+void ListenerImpl::checkAcceptQueue() {
+  // For a listen socket, the kernel reports the length of the accept queue in tcpi_unacked and
+  // its limit in tcpi_sacked. Past the limit new connection attempts are dropped. This only tells
+  // whether the queue is full right now, the number of drops is in TcpExtListenOverflows.
+  if (socket_.localAddress()->type() != Address::Type::Ip) {
+    return;
+  }
+
+  tcp_info info;
+  socklen_t info_len = sizeof(info);
+  if (::getsockopt(socket_.fd(), IPPROTO_TCP, TCP_INFO, &info, &info_len) == 0 &&
+      info.tcpi_unacked >= info.tcpi_sacked) {
+    stats_.downstream_cx_accept_queue_full_.inc();
+  }
+}
+
+void ListenerImpl::onAccept(int fd, const sockaddr_storage& remote_addr,
+                            socklen_t remote_addr_len) {
+  ListenerImpl* listener = this;
+  Address::InstanceConstSharedPtr final_local_address = socket_.localAddress();
   bool using_original_dst = false;
 
   // Get the local address from the new socket if the listener is listening on the all hosts
   // address (e.g., 0.0.0.0 for IPv4).
   auto ip = final_local_address->ip();
   if (ip && ip->isAnyAddress()) {
-    final_local_address = listener->getLocalAddress(fd);
+    final_local_address = getLocalAddress(fd);
   }
 
-  if (listener->options_.use_original_dst_ && final_local_address->type() == Address::Type::Ip) {
-    Address::InstanceConstSharedPtr original_local_address = listener->getOriginalDst(fd);
+  if (options_.use_original_dst_ && final_local_address->type() == Address::Type::Ip) {
+    Address::InstanceConstSharedPtr original_local_address = getOriginalDst(fd);
 
     // A listener that has the use_original_dst flag set to true can still receive
     // connections that are NOT redirected using iptables. If a connection was not redirected,
@@ -55,7 +113,7 @@ void ListenerImpl::listenCallback(evconnlistener*, evutil_socket_t fd, sockaddr*
       // original destination address. If there is no listener associated with the original
       // destination address, the connection is handled by the listener that receives it.
       ListenerImpl* new_listener = dynamic_cast<ListenerImpl*>(
-          listener->connection_handler_.findListenerByAddress(*original_local_address));
+          connection_handler_.findListenerByAddress(*original_local_address));
 
       if (new_listener != nullptr) {
         listener = new_listener;
@@ -67,15 +125,14 @@ void ListenerImpl::listenCallback(evconnlistener*, evutil_socket_t fd, sockaddr*
     listener->proxy_protocol_.newConnection(listener->dispatcher_, fd, *listener);
   } else {
     Address::InstanceConstSharedPtr final_remote_address;
-    if (remote_addr->sa_family == AF_UNIX) {
+    if (remote_addr.ss_family == AF_UNIX) {
       // The accept() call that filled in remote_addr doesn't fill in more than the sa_family field
       // for Unix domain sockets; apparently there isn't a mechanism in the kernel to get the
       // sockaddr_un associated with the client socket when starting from the server socket.
       // We work around this by using our own name for the socket in this case.
       final_remote_address = Address::peerAddressFromFd(fd);
     } else {
-      final_remote_address = Address::addressFromSockAddr(
-          *reinterpret_cast<const sockaddr_storage*>(remote_addr), remote_addr_len);
+      final_remote_address = Address::addressFromSockAddr(remote_addr, remote_addr_len);
     }
     // TODO(jamessynge): We need to keep per-family stats. BUT, should it be based on the original
     // family or the local family? Probably local family, as the original proxy can take care of
@@ -89,30 +146,96 @@ ListenerImpl::ListenerImpl(Network::ConnectionHandler& conn_handler,
                            ListenerCallbacks& cb, Stats::Scope& scope,
                            const Network::ListenerOptions& listener_options)
     : connection_handler_(conn_handler), dispatcher_(dispatcher), socket_(socket), cb_(cb),
-      proxy_protocol_(scope), options_(listener_options), listener_(nullptr) {
+      proxy_protocol_(scope), options_(listener_options),
+      stats_({ALL_LISTENER_ACCEPT_STATS(POOL_COUNTER(scope), POOL_HISTOGRAM(scope))}),
+      self_(new ListenerImpl*(this)) {
 
   if (options_.bind_to_port_) {
-    listener_.reset(
-        evconnlistener_new(&dispatcher_.base(), listenCallback, this, 0, -1, socket.fd()));
-
-    if (!listener_) {
+    // Every worker's listener does this on the shared listen socket, which is harmless.
+    const int flags = ::fcntl(socket.fd(), F_GETFL, 0);
+    if (flags == -1 || ::fcntl(socket.fd(), F_SETFL, flags | O_NONBLOCK) == -1 ||
+        ::listen(socket.fd(), LISTEN_BACKLOG) == -1) {
       throw CreateListenerException(
           fmt::format("cannot listen on socket: {}", socket.localAddress()->asString()));
     }
 
-    evconnlistener_set_error_cb(listener_.get(), errorCallback);
+    if (options_.tcp_defer_accept_seconds_ > 0 &&
+        socket.localAddress()->type() == Address::Type::Ip) {
+      const int seconds = options_.tcp_defer_accept_seconds_;
+      if (::setsockopt(socket.fd(), IPPROTO_TCP, TCP_DEFER_ACCEPT, &seconds, sizeof(seconds)) ==
+          -1) {
+        throw CreateListenerException(fmt::format("cannot set TCP_DEFER_ACCEPT on socket: {}",
+                                                  socket.localAddress()->asString()));
+      }
+    }
+
+    file_event_ = dispatcher_.createFileEvent(socket.fd(),
+                                              [this](uint32_t events) -> void {
+                                                ASSERT(events == Event::FileReadyType::Read);
+                                                UNREFERENCED_PARAMETER(events);
+                                                onSocketEvent();
+                                              },
+                                              Event::FileTriggerType::Level,
+                                              Event::FileReadyType::Read);
+  }
+
+  if (options_.connection_balancer_) {
+    options_.connection_balancer_->registerHandler(*this);
   }
 }
 
-void ListenerImpl::errorCallback(evconnlistener*, void*) {
-  // We should never get an error callback. This can happen if we run out of FDs or memory. In those
-  // cases just crash.
-  PANIC(fmt::format("listener accept failure: {}", strerror(errno)));
+ListenerImpl::~ListenerImpl() {
+  // Once this returns no other worker can hand off a connection to this listener anymore.
+  if (options_.connection_balancer_) {
+    options_.connection_balancer_->unregisterHandler(*this);
+  }
 }
 
 void ListenerImpl::newConnection(int fd, Address::InstanceConstSharedPtr remote_address,
                                  Address::InstanceConstSharedPtr local_address,
                                  bool using_original_dst) {
+  if (options_.connection_balancer_ &&
+      options_.connection_balancer_->rebalance(*this, fd, remote_address, local_address,
+                                               using_original_dst)) {
+    return;
+  }
+
+  createConnection(fd, remote_address, local_address, using_original_dst);
+}
+
+void ListenerImpl::post(int fd, Address::InstanceConstSharedPtr remote_address,
+                        Address::InstanceConstSharedPtr local_address, bool using_original_dst) {
+  // The balancer only calls this while the listener is registered, so self_ is still there.
+  pending_handoffs_++;
+  std::weak_ptr<ListenerImpl*> weak_self = self_;
+  // std::function needs a copyable callback, so the fd holder is shared.
+  std::shared_ptr<HandoffFd> handoff_fd(new HandoffFd(fd));
+  dispatcher_.post([weak_self, handoff_fd, remote_address, local_address,
+                    using_original_dst]() -> void {
+    // The listener can only go away on this thread, so it is either gone already or here to stay
+    // until the connection has been created.
+    std::shared_ptr<ListenerImpl*> self = weak_self.lock();
+    if (!self) {
+      ENVOY_LOG_MISC(debug, "closing handed off connection: listener is gone");
+      return;
+    }
+
+    ListenerImpl& listener = **self;
+    listener.pending_handoffs_--;
+    listener.createConnection(handoff_fd->release(), remote_address, local_address,
+                              using_original_dst);
+  });
+}
+
+ListenerImpl::HandoffFd::~HandoffFd() {
+  if (fd_ != -1) {
+    ::close(fd_);
+  }
+}
+
+void ListenerImpl::createConnection(int fd, Address::InstanceConstSharedPtr remote_address,
+                                    Address::InstanceConstSharedPtr local_address,
+                                    bool using_original_dst) {
   ConnectionPtr new_connection(new ConnectionImpl(dispatcher_, fd, remote_address, local_address,
                                                   Network::Address::InstanceConstSharedPtr(),
                                                   using_original_dst, true));
@@ -120,9 +243,9 @@ void ListenerImpl::newConnection(int fd, Address::InstanceConstSharedPtr remote_
   cb_.onNewConnection(std::move(new_connection));
 }
 
-void SslListenerImpl::newConnection(int fd, Address::InstanceConstSharedPtr remote_address,
-                                    Address::InstanceConstSharedPtr local_address,
-                                    bool using_original_dst) {
+void SslListenerImpl::createConnection(int fd, Address::InstanceConstSharedPtr remote_address,
+                                       Address::InstanceConstSharedPtr local_address,
+                                       bool using_original_dst) {
   ConnectionPtr new_connection(new Ssl::ConnectionImpl(
       dispatcher_, fd, remote_address, local_address, Network::Address::InstanceConstSharedPtr(),
       using_original_dst, true, ssl_ctx_, Ssl::ConnectionImpl::InitialState::Server));
@@ -1,29 +1,54 @@
 #pragma once
 
+#include <sys/socket.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "envoy/event/file_event.h"
+#include "envoy/network/connection_balancer.h"
 #include "envoy/network/connection_handler.h"
 #include "envoy/network/listener.h"
+#include "envoy/stats/stats_macros.h"
 
 #include "common/event/dispatcher_impl.h"
-#include "common/event/libevent.h"
 #include "common/network/listen_socket_impl.h"
 #include "common/network/proxy_protocol.h"
 
-#include "event2/event.h"
-
 namespace Envoy {
 namespace Network {
 
 /**
- * libevent implementation of Network::Listener.
+ * All listener accept stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_LISTENER_ACCEPT_STATS(COUNTER, HISTOGRAM)                                              \
+  COUNTER(downstream_cx_accept_queue_full)                                                     \
+  HISTOGRAM(downstream_cx_accepts_per_wakeup)
+// clang-format on
+
+/**
+ * Definition of all listener accept stats. @see stats_macros.h
+ */
+struct ListenerAcceptStats {
+  ALL_LISTENER_ACCEPT_STATS(GENERATE_COUNTER_STRUCT, GENERATE_HISTOGRAM_STRUCT)
+};
+
+/**
+ * libevent implementation of Network::Listener. Connections are accepted with accept4() straight
+ * off the listen socket, up to max_accepts_per_wakeup_ at a time.
  */
-class ListenerImpl : public Listener {
+class ListenerImpl : public Listener, public BalancedConnectionHandler {
 public:
   ListenerImpl(Network::ConnectionHandler& conn_handler, Event::DispatcherImpl& dispatcher,
                ListenSocket& socket, ListenerCallbacks& cb, Stats::Scope& scope,
                const ListenerOptions& listener_options);
+  ~ListenerImpl();
 
   /**
-   * Accept/process a new connection.
+   * Accept/process a new connection. The connection may be handed off to another worker's
+   * listener if the listener has a connection balancer.
    * @param fd supplies the new connection's fd.
    * @param remote_address supplies the remote address for the new connection.
    * @param local_address supplies the local address for the new connection.
@@ -37,7 +62,20 @@ public:
    */
   ListenSocket& socket() { return socket_; }
 
+  // Network::BalancedConnectionHandler
+  uint64_t numConnections() override {
+    return connection_handler_.numConnections() + pending_handoffs_.load();
+  }
+  void post(int fd, Address::InstanceConstSharedPtr remote_address,
+            Address::InstanceConstSharedPtr local_address, bool using_original_dst) override;
+
 protected:
+  /**
+   * Create the connection for an accepted fd on this listener's dispatcher.
+   */
+  virtual void createConnection(int fd, Address::InstanceConstSharedPtr remote_address,
+                                Address::InstanceConstSharedPtr local_address,
+                                bool using_original_dst);
   virtual Address::InstanceConstSharedPtr getLocalAddress(int fd);
   virtual Address::InstanceConstSharedPtr getOriginalDst(int fd);
 
@@ -49,11 +87,43 @@ protected:
   const ListenerOptions options_;
 
 private:
-  static void errorCallback(evconnlistener* listener, void* context);
-  static void listenCallback(evconnlistener*, evutil_socket_t fd, sockaddr* remote_addr,
-                             int remote_addr_len, void* arg);
+  // The kernel caps this at net.core.somaxconn.
+  static const int LISTEN_BACKLOG = SOMAXCONN;
+
+  /**
+   * Owns an accepted fd on its way to another worker, so that the fd is closed if the handoff
+   * never creates a connection. Besides the target listener going away, the target dispatcher can
+   * exit with the handoff still posted, which destroys the callback without running it.
+   */
+  class HandoffFd {
+  public:
+    HandoffFd(int fd) : fd_(fd) {}
+    ~HandoffFd();
+
+    /**
+     * @return int the fd, which the caller owns from now on.
+     */
+    int release() {
+      const int fd = fd_;
+      fd_ = -1;
+      return fd;
+    }
+
+  private:
+    int fd_;
+  };
 
-  Event::Libevent::ListenerPtr listener_;
+  void onSocketEvent();
+  void onAccept(int fd, const sockaddr_storage& remote_addr, socklen_t remote_addr_len);
+  void checkAcceptQueue();
+
+  ListenerAcceptStats stats_;
+  Event::FileEventPtr file_event_;
+  // Connections handed off to this listener that have not been created yet.
+  std::atomic<uint64_t> pending_handoffs_{};
+  // Handoffs posted to the dispatcher only hold a weak reference to this, so that they can tell
+  // whether the listener is still there when they run.
+  std::shared_ptr<ListenerImpl*> self_;
 };
 
 class SslListenerImpl : public ListenerImpl {
@@ -64,10 +134,11 @@ public:
       : ListenerImpl(conn_handler, dispatcher, socket, cb, scope, listener_options),
         ssl_ctx_(ssl_ctx) {}
 
+protected:
   // ListenerImpl
-  void newConnection(int fd, Address::InstanceConstSharedPtr remote_address,
-                     Address::InstanceConstSharedPtr local_address,
-                     bool using_original_dst) override;
+  void createConnection(int fd, Address::InstanceConstSharedPtr remote_address,
+                        Address::InstanceConstSharedPtr local_address,
+                        bool using_original_dst) override;
 
 private:
   Ssl::Context& ssl_ctx_;
@@ -20,6 +20,8 @@ public:
   PortRange(uint32_t min, uint32_t max) : min_(min), max_(max) {}
 
   bool contains(uint32_t port) const { return (port >= min_ && port <= max_); }
+  uint32_t min() const { return min_; }
+  uint32_t max() const { return max_; }
 
 private:
   const uint32_t min_;
@@ -31,8 +31,7 @@ public:
   // Runtime::RandomGenerator
   uint64_t random() override;
   std::string uuid() override;
-
-  static const size_t UUID_LENGTH;
+  void fastUuid(char* out) override;
 };
 
 /**
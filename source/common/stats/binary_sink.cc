@@ -0,0 +1,238 @@
+#include "common/stats/binary_sink.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "common/common/assert.h"
+#include "common/common/macros.h"
+
+namespace Envoy {
+namespace Stats {
+namespace Binary {
+
+namespace {
+
+size_t varintSize(uint64_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+bool readVarint(const uint8_t* data, size_t size, size_t& pos, uint64_t& value) {
+  value = 0;
+  for (uint32_t shift = 0; shift < 64 && pos < size; shift += 7) {
+    const uint8_t byte = data[pos++];
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+const uint8_t FrameEncoder::VERSION;
+const size_t FrameEncoder::HEADER_SIZE;
+
+void FrameEncoder::add(MetricType type, const std::string& name, uint64_t value) {
+  size_t shared = 0;
+  if (frame_open_) {
+    const size_t limit = std::min(name.size(), previous_name_.size());
+    while (shared < limit && name[shared] == previous_name_[shared]) {
+      shared++;
+    }
+
+    const size_t suffix_length = name.size() - shared;
+    const size_t entry_size = 1 + varintSize(shared) + varintSize(suffix_length) + suffix_length +
+                              varintSize(value);
+    if (buffer_.size() - frame_start_ + entry_size > max_frame_size_) {
+      finish();
+      shared = 0;
+    }
+  }
+
+  if (!frame_open_) {
+    startFrame();
+  }
+
+  buffer_.push_back(static_cast<uint8_t>(type));
+  writeVarint(shared);
+  writeVarint(name.size() - shared);
+  buffer_.insert(buffer_.end(), name.begin() + shared, name.end());
+  writeVarint(value);
+  previous_name_ = name;
+}
+
+void FrameEncoder::finish() {
+  if (!frame_open_) {
+    return;
+  }
+
+  const size_t size = buffer_.size() - frame_start_;
+  buffer_[frame_start_] = size >> 24;
+  buffer_[frame_start_ + 1] = size >> 16;
+  buffer_[frame_start_ + 2] = size >> 8;
+  buffer_[frame_start_ + 3] = size;
+  frames_.emplace_back(frame_start_, size);
+  frame_open_ = false;
+}
+
+void FrameEncoder::clear() {
+  buffer_.clear();
+  frames_.clear();
+  frame_open_ = false;
+}
+
+void FrameEncoder::startFrame() {
+  frame_start_ = buffer_.size();
+  // The length is filled in by finish().
+  buffer_.insert(buffer_.end(), HEADER_SIZE - 1, 0);
+  buffer_.push_back(VERSION);
+  previous_name_.clear();
+  frame_open_ = true;
+}
+
+void FrameEncoder::writeVarint(uint64_t value) {
+  while (value >= 0x80) {
+    buffer_.push_back(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  buffer_.push_back(static_cast<uint8_t>(value));
+}
+
+bool FrameDecoder::decode(const uint8_t* data, size_t size, const MetricCb& cb) {
+  if (size < FrameEncoder::HEADER_SIZE) {
+    return false;
+  }
+
+  const uint32_t length = (static_cast<uint32_t>(data[0]) << 24) |
+                          (static_cast<uint32_t>(data[1]) << 16) |
+                          (static_cast<uint32_t>(data[2]) << 8) | data[3];
+  if (length != size || data[4] != FrameEncoder::VERSION) {
+    return false;
+  }
+
+  std::string name;
+  size_t pos = FrameEncoder::HEADER_SIZE;
+  while (pos < size) {
+    const uint8_t type = data[pos++];
+    uint64_t shared;
+    uint64_t suffix_length;
+    if (type > static_cast<uint8_t>(MetricType::Timer) || !readVarint(data, size, pos, shared) ||
+        !readVarint(data, size, pos, suffix_length) || shared > name.size() ||
+        suffix_length > size - pos) {
+      return false;
+    }
+
+    name.resize(shared);
+    name.append(reinterpret_cast<const char*>(data + pos), suffix_length);
+    pos += suffix_length;
+
+    uint64_t value;
+    if (!readVarint(data, size, pos, value)) {
+      return false;
+    }
+    cb(static_cast<MetricType>(type), name, value);
+  }
+
+  return true;
+}
+
+const size_t UdpBinarySink::MAX_DATAGRAM_SIZE;
+const size_t UdpBinarySink::MAX_DATAGRAMS_PER_SEND;
+const std::chrono::milliseconds UdpBinarySink::TIMER_FLUSH_INTERVAL(1000);
+
+UdpBinarySink::Writer::Writer(Network::Address::InstanceConstSharedPtr address,
+                              Event::Dispatcher& dispatcher) {
+  fd_ = address->socket(Network::Address::SocketType::Datagram);
+  ASSERT(fd_ != -1);
+
+  int rc = address->connect(fd_);
+  ASSERT(rc != -1);
+  UNREFERENCED_PARAMETER(rc);
+
+  timers_flush_timer_ = dispatcher.createTimer([this]() -> void { flushTimers(); });
+}
+
+UdpBinarySink::Writer::~Writer() {
+  if (fd_ != -1) {
+    RELEASE_ASSERT(close(fd_) == 0);
+  }
+}
+
+void UdpBinarySink::Writer::send(FrameEncoder& encoder) {
+  encoder.finish();
+  const auto& frames = encoder.frames();
+  iovecs_.resize(frames.size());
+  headers_.resize(frames.size());
+  for (size_t i = 0; i < frames.size(); i++) {
+    iovecs_[i].iov_base = const_cast<uint8_t*>(encoder.data() + frames[i].first);
+    iovecs_[i].iov_len = frames[i].second;
+    headers_[i] = mmsghdr();
+    headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+    headers_[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  size_t sent = 0;
+  while (sent < frames.size()) {
+    const size_t batch = std::min(frames.size() - sent, MAX_DATAGRAMS_PER_SEND);
+    const int rc = ::sendmmsg(fd_, &headers_[sent], batch, MSG_DONTWAIT);
+    // Sending is best effort, as with statsd. A datagram that can't be sent is dropped rather than
+    // retried.
+    sent += rc > 0 ? rc : 1;
+  }
+
+  encoder.clear();
+}
+
+void UdpBinarySink::Writer::flushTimers() {
+  if (timers_.pendingBytes() > 0) {
+    send(timers_);
+  }
+}
+
+UdpBinarySink::UdpBinarySink(ThreadLocal::SlotAllocator& tls,
+                             Network::Address::InstanceConstSharedPtr address)
+    : tls_(tls.allocateSlot()), server_address_(address) {
+  tls_->set([this](Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<Writer>(this->server_address_, dispatcher);
+  });
+}
+
+void UdpBinarySink::flush(const FlushSnapshot& snapshot) {
+  Writer& writer = tls_->getTyped<Writer>();
+  for (const auto& counter : snapshot.counters_) {
+    writer.metrics_.add(MetricType::Counter, counter.first->name(), counter.second);
+  }
+
+  for (const auto& gauge : snapshot.gauges_) {
+    writer.metrics_.add(MetricType::Gauge, gauge.first->name(), gauge.second);
+  }
+
+  writer.send(writer.metrics_);
+}
+
+void UdpBinarySink::onHistogramComplete(const Histogram& histogram, uint64_t value) {
+  Writer& writer = tls_->getTyped<Writer>();
+  const bool first = writer.timers_.pendingBytes() == 0;
+  writer.timers_.add(MetricType::Timer, histogram.name(), value);
+  if (!writer.timers_.frames().empty()) {
+    // A frame is full, send everything now.
+    writer.timers_flush_timer_->disableTimer();
+    writer.send(writer.timers_);
+  } else if (first) {
+    writer.timers_flush_timer_->enableTimer(TIMER_FLUSH_INTERVAL);
+  }
+}
+
+} // namespace Binary
+} // namespace Stats
+} // namespace Envoy
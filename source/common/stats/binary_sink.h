@@ -0,0 +1,157 @@
+#pragma once
+
+#include <sys/socket.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/network/address.h"
+#include "envoy/stats/stats.h"
+#include "envoy/thread_local/thread_local.h"
+
+namespace Envoy {
+namespace Stats {
+namespace Binary {
+
+/**
+ * Types of metrics in a frame.
+ */
+enum class MetricType : uint8_t { Counter = 0, Gauge = 1, Timer = 2 };
+
+/**
+ * Packs metrics into self contained binary frames of a bounded size, so that each frame can be
+ * sent as a single datagram and decoded on its own. Integers are unsigned LEB128 varints unless
+ * noted otherwise.
+ *
+ *   frame  := length:uint32 (big endian, whole frame) version:uint8 entry*
+ *   entry  := type:uint8 shared:varint suffix_length:varint suffix:byte* value:varint
+ *
+ * A name is encoded as the number of leading bytes it shares with the name of the previous entry
+ * of the frame, followed by the rest of the name. Stats are mostly created and flushed in groups
+ * with a common prefix, e.g. "cluster.foo.upstream_rq_2xx" next to "cluster.foo.upstream_rq_5xx",
+ * so this takes most of the name out of most entries.
+ *
+ * The encoder's buffers are reused after clear(), so steady state encoding does not allocate.
+ */
+class FrameEncoder {
+public:
+  static const uint8_t VERSION = 1;
+  static const size_t HEADER_SIZE = 5;
+
+  /**
+   * @param max_frame_size supplies the maximum size of a frame. An entry that does not fit in an
+   *        empty frame of this size is put in a frame of its own.
+   */
+  FrameEncoder(size_t max_frame_size) : max_frame_size_(max_frame_size) {}
+
+  /**
+   * Add a metric, starting a new frame if it does not fit in the current one.
+   */
+  void add(MetricType type, const std::string& name, uint64_t value);
+
+  /**
+   * Complete the current frame, if any. Must be called before the frames are read.
+   */
+  void finish();
+
+  /**
+   * Drop all frames, keeping the buffers.
+   */
+  void clear();
+
+  /**
+   * @return const uint8_t* the encoded frames, back to back.
+   */
+  const uint8_t* data() const { return buffer_.data(); }
+
+  /**
+   * @return the offset and size in data() of each complete frame.
+   */
+  const std::vector<std::pair<size_t, size_t>>& frames() const { return frames_; }
+
+  /**
+   * @return the number of bytes of an incomplete frame, 0 if there is none.
+   */
+  size_t pendingBytes() const { return frame_open_ ? buffer_.size() - frame_start_ : 0; }
+
+private:
+  void startFrame();
+  void writeVarint(uint64_t value);
+
+  const size_t max_frame_size_;
+  std::vector<uint8_t> buffer_;
+  std::vector<std::pair<size_t, size_t>> frames_;
+  size_t frame_start_{};
+  bool frame_open_{};
+  std::string previous_name_;
+};
+
+/**
+ * Decodes frames written by FrameEncoder.
+ */
+class FrameDecoder {
+public:
+  typedef std::function<void(MetricType type, const std::string& name, uint64_t value)> MetricCb;
+
+  /**
+   * Decode a single frame.
+   * @param data supplies the frame.
+   * @param size supplies the size of the frame, which must match its length field.
+   * @param cb supplies the callback invoked for each entry.
+   * @return bool whether the frame is well formed. Entries before a malformed one have been passed
+   *         to the callback already.
+   */
+  static bool decode(const uint8_t* data, size_t size, const MetricCb& cb);
+};
+
+/**
+ * Implementation of Sink that writes binary frames to a UDP address. All counters and gauges of a
+ * flush are packed into as few datagrams as possible, which are then sent with batched
+ * sendmmsg() calls. Histogram values are buffered per thread and sent when a frame is full or
+ * TIMER_FLUSH_INTERVAL after the first buffered value.
+ */
+class UdpBinarySink : public Sink {
+public:
+  // Datagrams that fit the typical 1500 byte MTU after IPv6 and UDP headers.
+  static const size_t MAX_DATAGRAM_SIZE = 1432;
+  static const size_t MAX_DATAGRAMS_PER_SEND = 256;
+  static const std::chrono::milliseconds TIMER_FLUSH_INTERVAL;
+
+  UdpBinarySink(ThreadLocal::SlotAllocator& tls, Network::Address::InstanceConstSharedPtr address);
+
+  // Stats::Sink
+  void flush(const FlushSnapshot& snapshot) override;
+  void onHistogramComplete(const Histogram& histogram, uint64_t value) override;
+
+  // Called in unit test to validate writer construction and address.
+  int getFdForTests() { return tls_->getTyped<Writer>().fd_; }
+
+private:
+  struct Writer : public ThreadLocal::ThreadLocalObject {
+    Writer(Network::Address::InstanceConstSharedPtr address, Event::Dispatcher& dispatcher);
+    ~Writer();
+
+    void send(FrameEncoder& encoder);
+    void flushTimers();
+
+    int fd_;
+    FrameEncoder metrics_{MAX_DATAGRAM_SIZE};
+    FrameEncoder timers_{MAX_DATAGRAM_SIZE};
+    Event::TimerPtr timers_flush_timer_;
+    std::vector<iovec> iovecs_;
+    std::vector<mmsghdr> headers_;
+  };
+
+  ThreadLocal::SlotPtr tls_;
+  Network::Address::InstanceConstSharedPtr server_address_;
+};
+
+} // namespace Binary
+} // namespace Stats
+} // namespace Envoy
@@ -2,7 +2,9 @@
 
 #include <string.h>
 
+#include <algorithm>
 #include <chrono>
+#include <new>
 #include <string>
 
 #include "common/common/utility.h"
@@ -70,6 +72,39 @@ void HeapRawStatDataAllocator::free(RawStatData& data) {
   ::free(&data);
 }
 
+std::atomic<uint32_t> CounterShards::next_thread_index_;
+
+CounterShards::CounterShards(uint32_t num_shards)
+    : mask_((1U << (32 - __builtin_clz(std::max(num_shards, 2U) - 1))) - 1),
+      storage_(new uint8_t[(mask_ + 2) * CACHE_LINE_SIZE]) {
+  // operator new doesn't guarantee more than the natural alignment, so allocate an extra line and
+  // start at the first line boundary.
+  const uintptr_t address = reinterpret_cast<uintptr_t>(storage_.get());
+  shards_ = storage_.get() + (CACHE_LINE_SIZE - address % CACHE_LINE_SIZE) % CACHE_LINE_SIZE;
+  for (uint32_t i = 0; i <= mask_; i++) {
+    new (&shard(i)) std::atomic<uint64_t>(0);
+  }
+}
+
+uint64_t CounterShards::value() const {
+  uint64_t value = 0;
+  for (uint32_t i = 0; i <= mask_; i++) {
+    value += shard(i).load(std::memory_order_relaxed);
+  }
+  return value;
+}
+
+uint64_t CounterShards::latch() {
+  uint64_t latched = 0;
+  for (uint32_t i = 0; i <= mask_; i++) {
+    std::atomic<uint64_t>& shard = this->shard(i);
+    if (shard.load(std::memory_order_relaxed) != 0) {
+      latched += shard.exchange(0, std::memory_order_relaxed);
+    }
+  }
+  return latched;
+}
+
 void RawStatData::initialize(const std::string& name) {
   ASSERT(!initialized());
   ASSERT(name.size() <= maxNameLength());
@@ -83,5 +118,21 @@ bool RawStatData::matches(const std::string& name) {
   return 0 == strcmp(name.substr(0, maxNameLength()).c_str(), name_);
 }
 
+void IsolatedStoreImpl::latch(FlushSnapshot& snapshot) {
+  snapshot.clear();
+  for (auto& counter : counters_.stats()) {
+    const uint64_t delta = counter.second->latch();
+    if (delta > 0) {
+      snapshot.counters_.emplace_back(counter.second, delta);
+    }
+  }
+
+  for (auto& gauge : gauges_.stats()) {
+    if (gauge.second->used()) {
+      snapshot.gauges_.emplace_back(gauge.second, gauge.second->value());
+    }
+  }
+}
+
 } // namespace Stats
 } // namespace Envoy
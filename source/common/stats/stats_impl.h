@@ -14,6 +14,7 @@
 #include "envoy/stats/stats.h"
 
 #include "common/common/assert.h"
+#include "common/common/non_copyable.h"
 
 namespace Envoy {
 namespace Stats {
@@ -144,36 +145,134 @@ private:
 };
 
 /**
- * Counter implementation that wraps a RawStatData.
+ * Per thread increments of a counter that many threads update. Each shard is on its own cache
+ * line, so that threads incrementing the counter do not contend with each other. Threads are
+ * assigned shards round robin the first time they increment any sharded counter, so threads only
+ * share a shard when there are more threads than shards.
  */
-class CounterImpl : public Counter, public MetricImpl {
+class CounterShards : NonCopyable {
 public:
-  CounterImpl(RawStatData& data, RawStatDataAllocator& alloc)
-      : MetricImpl(data.name_), data_(data), alloc_(alloc) {}
+  /**
+   * @param num_shards supplies the minimum number of shards. Rounded up to a power of 2.
+   */
+  CounterShards(uint32_t num_shards);
+
+  void add(uint64_t amount) {
+    shard(threadIndex() & mask_).fetch_add(amount, std::memory_order_relaxed);
+  }
+
+  /**
+   * @return the sum of the increments that have not been latched yet.
+   */
+  uint64_t value() const;
+
+  /**
+   * Reset all shards to zero.
+   * @return the sum of the increments since the previous call.
+   */
+  uint64_t latch();
+
+  /**
+   * @return the number of shards.
+   */
+  uint32_t size() const { return mask_ + 1; }
+
+private:
+  static const size_t CACHE_LINE_SIZE = 64;
+
+  static uint32_t threadIndex() {
+    static thread_local const uint32_t index = next_thread_index_++;
+    return index;
+  }
+
+  std::atomic<uint64_t>& shard(uint32_t index) const {
+    return *reinterpret_cast<std::atomic<uint64_t>*>(shards_ + index * CACHE_LINE_SIZE);
+  }
+
+  static std::atomic<uint32_t> next_thread_index_;
+  const uint32_t mask_;
+  std::unique_ptr<uint8_t[]> storage_;
+  uint8_t* shards_;
+};
+
+/**
+ * Counter implementation that wraps a RawStatData. Final so that stores that keep track of their
+ * CounterImpls can latch them without virtual calls.
+ *
+ * A counter can optionally be sharded per thread, in which case increments only go to the
+ * thread's shard and are folded into the RawStatData when the counter is latched. The RawStatData
+ * then lags behind by one flush interval, but stays the one value shared with another process
+ * across a hot restart.
+ */
+class CounterImpl final : public Counter, public MetricImpl {
+public:
+  /**
+   * @param num_shards supplies the number of per thread shards, or 0 to increment the RawStatData
+   *        directly.
+   */
+  CounterImpl(RawStatData& data, RawStatDataAllocator& alloc, uint32_t num_shards = 0)
+      : MetricImpl(data.name_), data_(data), alloc_(alloc),
+        shards_(num_shards > 0 ? new CounterShards(num_shards) : nullptr) {}
   ~CounterImpl() { alloc_.free(data_); }
 
   // Stats::Counter
   void add(uint64_t amount) override {
+    if (shards_) {
+      shards_->add(amount);
+      // Only the first increment writes to the shared cache line.
+      if (!used()) {
+        data_.flags_ |= RawStatData::Flags::Used;
+      }
+      return;
+    }
+
     data_.value_ += amount;
     data_.pending_increment_ += amount;
     data_.flags_ |= RawStatData::Flags::Used;
   }
 
   void inc() override { add(1); }
-  uint64_t latch() override { return data_.pending_increment_.exchange(0); }
-  void reset() override { data_.value_ = 0; }
+  uint64_t latch() override {
+    uint64_t latched = 0;
+    if (shards_) {
+      // Readers may briefly see a value that is missing the increments being moved here.
+      latched = shards_->latch();
+      if (latched > 0) {
+        data_.value_ += latched;
+      }
+    }
+
+    // Most counters do not change in a flush interval, leave their cache line alone. A sharded
+    // counter can still have a pending increment from another process during a hot restart.
+    if (data_.pending_increment_.load() == 0) {
+      return latched;
+    }
+    return latched + data_.pending_increment_.exchange(0);
+  }
+  void reset() override {
+    if (shards_) {
+      shards_->latch();
+    }
+    data_.value_ = 0;
+  }
   bool used() const override { return data_.flags_ & RawStatData::Flags::Used; }
-  uint64_t value() const override { return data_.value_; }
+  uint64_t value() const override { return data_.value_ + (shards_ ? shards_->value() : 0); }
+
+  /**
+   * @return the number of per thread shards, 0 if the counter is not sharded.
+   */
+  uint32_t shards() const { return shards_ ? shards_->size() : 0; }
 
 private:
   RawStatData& data_;
   RawStatDataAllocator& alloc_;
+  const std::unique_ptr<CounterShards> shards_;
 };
 
 /**
  * Gauge implementation that wraps a RawStatData.
  */
-class GaugeImpl : public Gauge, public MetricImpl {
+class GaugeImpl final : public Gauge, public MetricImpl {
 public:
   GaugeImpl(RawStatData& data, RawStatDataAllocator& alloc)
       : MetricImpl(data.name_), data_(data), alloc_(alloc) {}
@@ -256,6 +355,8 @@ public:
     return list;
   }
 
+  const std::unordered_map<std::string, std::shared_ptr<Impl>>& stats() const { return stats_; }
+
 private:
   std::unordered_map<std::string, std::shared_ptr<Impl>> stats_;
   Allocator alloc_;
@@ -292,6 +393,7 @@ public:
   // Stats::Store
   std::list<CounterSharedPtr> counters() const override { return counters_.toList(); }
   std::list<GaugeSharedPtr> gauges() const override { return gauges_.toList(); }
+  void latch(FlushSnapshot& snapshot) override;
 
 private:
   struct ScopeImpl : public Scope {
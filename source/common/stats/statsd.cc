@@ -60,12 +60,15 @@ UdpStatsdSink::UdpStatsdSink(ThreadLocal::SlotAllocator& tls,
   });
 }
 
-void UdpStatsdSink::flushCounter(const Counter& counter, uint64_t delta) {
-  tls_->getTyped<Writer>().writeCounter(counter.name(), delta);
-}
+void UdpStatsdSink::flush(const FlushSnapshot& snapshot) {
+  Writer& writer = tls_->getTyped<Writer>();
+  for (const auto& counter : snapshot.counters_) {
+    writer.writeCounter(counter.first->name(), counter.second);
+  }
 
-void UdpStatsdSink::flushGauge(const Gauge& gauge, uint64_t value) {
-  tls_->getTyped<Writer>().writeGauge(gauge.name(), value);
+  for (const auto& gauge : snapshot.gauges_) {
+    writer.writeGauge(gauge.first->name(), gauge.second);
+  }
 }
 
 void UdpStatsdSink::onHistogramComplete(const Histogram& histogram, uint64_t value) {
@@ -89,6 +92,19 @@ TcpStatsdSink::TcpStatsdSink(const LocalInfo::LocalInfo& local_info,
   });
 }
 
+void TcpStatsdSink::flush(const FlushSnapshot& snapshot) {
+  TlsSink& tls_sink = tls_->getTyped<TlsSink>();
+  tls_sink.beginFlush(true);
+  for (const auto& counter : snapshot.counters_) {
+    tls_sink.flushCounter(counter.first->name(), counter.second);
+  }
+
+  for (const auto& gauge : snapshot.gauges_) {
+    tls_sink.flushGauge(gauge.first->name(), gauge.second);
+  }
+  tls_sink.endFlush(true);
+}
+
 TcpStatsdSink::TlsSink::TlsSink(TcpStatsdSink& parent, Event::Dispatcher& dispatcher)
     : parent_(parent), dispatcher_(dispatcher) {}
 
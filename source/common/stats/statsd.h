@@ -45,10 +45,7 @@ public:
   UdpStatsdSink(ThreadLocal::SlotAllocator& tls, Network::Address::InstanceConstSharedPtr address);
 
   // Stats::Sink
-  void beginFlush() override {}
-  void flushCounter(const Counter& counter, uint64_t delta) override;
-  void flushGauge(const Gauge& gauge, uint64_t value) override;
-  void endFlush() override {}
+  void flush(const FlushSnapshot& snapshot) override;
   void onHistogramComplete(const Histogram& histogram, uint64_t value) override;
 
   // Called in unit test to validate writer construction and address.
@@ -69,17 +66,7 @@ public:
                 Stats::Scope& scope);
 
   // Stats::Sink
-  void beginFlush() override { tls_->getTyped<TlsSink>().beginFlush(true); }
-
-  void flushCounter(const Counter& counter, uint64_t delta) override {
-    tls_->getTyped<TlsSink>().flushCounter(counter.name(), delta);
-  }
-
-  void flushGauge(const Gauge& gauge, uint64_t value) override {
-    tls_->getTyped<TlsSink>().flushGauge(gauge.name(), value);
-  }
-
-  void endFlush() override { tls_->getTyped<TlsSink>().endFlush(true); }
+  void flush(const FlushSnapshot& snapshot) override;
 
   void onHistogramComplete(const Histogram& histogram, uint64_t value) override {
     // For statsd histograms are all timers.
@@ -8,6 +8,8 @@
 #include <string>
 #include <unordered_set>
 
+#include "common/common/utility.h"
+
 namespace Envoy {
 namespace Stats {
 
@@ -37,6 +39,25 @@ std::list<CounterSharedPtr> ThreadLocalStoreImpl::counters() const {
   return ret;
 }
 
+void ThreadLocalStoreImpl::latch(FlushSnapshot& snapshot) {
+  snapshot.clear();
+  std::unique_lock<std::mutex> lock(lock_);
+  for (const auto& entry : counter_registry_.entries()) {
+    // The implementations are final, so this does not go through virtual calls.
+    const uint64_t delta = static_cast<CounterImpl&>(**entry.stat_).latch();
+    if (delta > 0) {
+      snapshot.counters_.emplace_back(*entry.stat_, delta);
+    }
+  }
+
+  for (const auto& entry : gauge_registry_.entries()) {
+    const GaugeImpl& gauge = static_cast<const GaugeImpl&>(**entry.stat_);
+    if (gauge.used()) {
+      snapshot.gauges_.emplace_back(*entry.stat_, gauge.value());
+    }
+  }
+}
+
 ScopePtr ThreadLocalStoreImpl::createScope(const std::string& name) {
   std::unique_ptr<ScopeImpl> new_scope(new ScopeImpl(*this, name));
   std::unique_lock<std::mutex> lock(lock_);
@@ -79,6 +100,33 @@ void ThreadLocalStoreImpl::releaseScopeCrossThread(ScopeImpl* scope) {
   ASSERT(scopes_.count(scope) == 1);
   scopes_.erase(scope);
 
+  // If an overlapping scope still has a stat, the registry needs to list that scope's stat. This
+  // is only looked up when the stat being removed is the one listed.
+  for (const auto& counter : scope->central_cache_.counters_) {
+    counter_registry_.remove(counter.first, counter.second,
+                             [this, &counter]() -> const CounterSharedPtr& {
+                               for (ScopeImpl* other : scopes_) {
+                                 auto it = other->central_cache_.counters_.find(counter.first);
+                                 if (it != other->central_cache_.counters_.end()) {
+                                   return it->second;
+                                 }
+                               }
+                               NOT_REACHED;
+                             });
+  }
+
+  for (const auto& gauge : scope->central_cache_.gauges_) {
+    gauge_registry_.remove(gauge.first, gauge.second, [this, &gauge]() -> const GaugeSharedPtr& {
+      for (ScopeImpl* other : scopes_) {
+        auto it = other->central_cache_.gauges_.find(gauge.first);
+        if (it != other->central_cache_.gauges_.end()) {
+          return it->second;
+        }
+      }
+      NOT_REACHED;
+    });
+  }
+
   // This can happen from any thread. We post() back to the main thread which will initiate the
   // cache flush operation.
   if (!shutting_down_ && main_thread_dispatcher_) {
@@ -96,6 +144,22 @@ void ThreadLocalStoreImpl::clearScopeFromCaches(ScopeImpl* scope) {
   }
 }
 
+void ThreadLocalStoreImpl::shardCounters(const std::vector<std::string>& suffixes,
+                                         uint32_t num_shards) {
+  sharded_counter_suffixes_ = suffixes;
+  counter_shards_ = num_shards;
+}
+
+uint32_t ThreadLocalStoreImpl::counterShards(const std::string& name) const {
+  for (const std::string& suffix : sharded_counter_suffixes_) {
+    if (StringUtil::endsWith(name, suffix) &&
+        (name.size() == suffix.size() || name[name.size() - suffix.size() - 1] == '.')) {
+      return counter_shards_;
+    }
+  }
+  return 0;
+}
+
 ThreadLocalStoreImpl::SafeAllocData ThreadLocalStoreImpl::safeAlloc(const std::string& name) {
   RawStatData* data = alloc_.alloc(name);
   if (!data) {
@@ -134,7 +198,9 @@ Counter& ThreadLocalStoreImpl::ScopeImpl::counter(const std::string& name) {
   CounterSharedPtr& central_ref = central_cache_.counters_[final_name];
   if (!central_ref) {
     SafeAllocData alloc = parent_.safeAlloc(final_name);
-    central_ref.reset(new CounterImpl(alloc.data_, alloc.free_));
+    central_ref.reset(
+        new CounterImpl(alloc.data_, alloc.free_, parent_.counterShards(final_name)));
+    parent_.counter_registry_.add(final_name, central_ref);
   }
 
   // If we have a TLS location to store or allocation into, do it.
@@ -180,6 +246,7 @@ Gauge& ThreadLocalStoreImpl::ScopeImpl::gauge(const std::string& name) {
   if (!central_ref) {
     SafeAllocData alloc = parent_.safeAlloc(final_name);
     central_ref.reset(new GaugeImpl(alloc.data_, alloc.free_));
+    parent_.gauge_registry_.add(final_name, central_ref);
   }
 
   if (tls_ref) {
@@ -215,5 +282,41 @@ Histogram& ThreadLocalStoreImpl::ScopeImpl::histogram(const std::string& name) {
   return *central_ref;
 }
 
+template <class StatSharedPtr>
+void ThreadLocalStoreImpl::StatRegistry<StatSharedPtr>::add(const std::string& name,
+                                                            const StatSharedPtr& stat) {
+  auto it = index_.find(name);
+  if (it != index_.end()) {
+    it->second.ref_count_++;
+    return;
+  }
+
+  it = index_.emplace(name, IndexEntry{entries_.size(), 1}).first;
+  entries_.push_back({&stat, &it->first});
+}
+
+template <class StatSharedPtr>
+void ThreadLocalStoreImpl::StatRegistry<StatSharedPtr>::remove(
+    const std::string& name, const StatSharedPtr& stat,
+    std::function<const StatSharedPtr&()> find_other) {
+  auto it = index_.find(name);
+  ASSERT(it != index_.end());
+  const size_t index = it->second.index_;
+  if (--it->second.ref_count_ > 0) {
+    if (entries_[index].stat_ == &stat) {
+      entries_[index].stat_ = &find_other();
+    }
+    return;
+  }
+
+  // Keep the list dense by moving the last entry into the hole.
+  if (index != entries_.size() - 1) {
+    entries_[index] = std::move(entries_.back());
+    index_[*entries_[index].name_].index_ = index;
+  }
+  entries_.pop_back();
+  index_.erase(it);
+}
+
 } // namespace Stats
 } // namespace Envoy
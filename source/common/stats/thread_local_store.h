@@ -3,11 +3,13 @@
 #include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "envoy/thread_local/thread_local.h"
 
@@ -40,6 +42,11 @@ namespace Stats {
  *         repopulated on the next access.
  * - Since it's possible to have overlapping scopes, we de-dup stats when counters() or gauges() is
  *   called since these are very uncommon operations.
+ * - Flushing is not uncommon, so the store also keeps a flat registry of all counters and gauges,
+ *   de-duped by name. It is updated as stats are allocated in and released from central caches,
+ *   and lets latch() visit each stat once without walking the scopes or allocating.
+ * - Counters that every worker increments can be sharded per thread, see shardCounters(). This
+ *   trades memory for not bouncing the counter's cache line between cores.
  * - Though this implementation is designed to work with a fixed shared memory space, it will fall
  *   back to heap allocated stats if needed. NOTE: In this case, overlapping scopes will not share
  *   the same backing store. This is to keep things simple, it could be done in the future if
@@ -64,6 +71,7 @@ public:
   // Stats::Store
   std::list<CounterSharedPtr> counters() const override;
   std::list<GaugeSharedPtr> gauges() const override;
+  void latch(FlushSnapshot& snapshot) override;
 
   // Stats::StoreRoot
   void addSink(Sink& sink) override { timer_sinks_.push_back(sink); }
@@ -71,6 +79,17 @@ public:
                            ThreadLocal::Instance& tls) override;
   void shutdownThreading() override;
 
+  /**
+   * Shard counters per thread. Only affects counters created after the call, so this should be
+   * called before the store is used.
+   * @param suffixes supplies the names of the counters to shard, matched against the end of full
+   *        counter names at a '.' boundary. E.g. "downstream_rq_total" matches the counter of
+   *        every HTTP connection manager.
+   * @param num_shards supplies the number of shards of each counter, usually the number of
+   *        threads incrementing the counters.
+   */
+  void shardCounters(const std::vector<std::string>& suffixes, uint32_t num_shards);
+
 private:
   struct TlsCacheEntry {
     std::unordered_map<std::string, CounterSharedPtr> counters_;
@@ -106,15 +125,60 @@ private:
     RawStatDataAllocator& free_;
   };
 
+  /**
+   * Dense list of the counters or gauges of all scopes, one per name. Overlapping scopes share
+   * the entry for a name, which is reference counted. Entries point at the stat in a scope's
+   * central cache rather than owning a reference, so stats are still freed along with scopes.
+   */
+  template <class StatSharedPtr> class StatRegistry {
+  public:
+    struct Entry {
+      // Points to the value in the central cache, which is stable.
+      const StatSharedPtr* stat_;
+      // Points to the key in index_, which is stable.
+      const std::string* name_;
+    };
+
+    /**
+     * Add a stat that was just allocated in a scope's central cache.
+     */
+    void add(const std::string& name, const StatSharedPtr& stat);
+
+    /**
+     * Remove a stat of a scope that is being released.
+     * @param find_other supplies a function returning the stat with the same name in another
+     *        scope. Only called if other scopes still have the name and the stat being removed is
+     *        the one listed.
+     */
+    void remove(const std::string& name, const StatSharedPtr& stat,
+                std::function<const StatSharedPtr&()> find_other);
+
+    const std::vector<Entry>& entries() const { return entries_; }
+
+  private:
+    struct IndexEntry {
+      size_t index_;
+      uint32_t ref_count_;
+    };
+
+    std::unordered_map<std::string, IndexEntry> index_;
+    std::vector<Entry> entries_;
+  };
+
   void clearScopeFromCaches(ScopeImpl* scope);
   void releaseScopeCrossThread(ScopeImpl* scope);
   SafeAllocData safeAlloc(const std::string& name);
+  uint32_t counterShards(const std::string& name) const;
 
   RawStatDataAllocator& alloc_;
   Event::Dispatcher* main_thread_dispatcher_{};
   ThreadLocal::SlotPtr tls_;
   mutable std::mutex lock_;
   std::unordered_set<ScopeImpl*> scopes_;
+  StatRegistry<CounterSharedPtr> counter_registry_;
+  StatRegistry<GaugeSharedPtr> gauge_registry_;
+  std::vector<std::string> sharded_counter_suffixes_;
+  uint32_t counter_shards_{};
   ScopePtr default_scope_;
   std::list<std::reference_wrapper<Sink>> timer_sinks_;
   std::atomic<bool> shutting_down_{};
@@ -44,32 +44,36 @@ void HttpTracerUtility::mutateHeaders(Http::HeaderMap& request_headers, Runtime:
     return;
   }
 
-  // TODO PERF: Avoid copy.
-  std::string x_request_id = request_headers.RequestId()->value().c_str();
+  // The trace status is written into the header value in place.
+  Http::HeaderString& x_request_id = request_headers.RequestId()->value();
 
   uint16_t result;
   // Skip if x-request-id is corrupted.
-  if (!UuidUtils::uuidModBy(x_request_id, result, 10000)) {
+  if (!UuidUtils::uuidModBy(x_request_id.c_str(), x_request_id.size(), result, 10000)) {
     return;
   }
 
+  if (x_request_id.type() == Http::HeaderString::Type::Reference) {
+    x_request_id.setCopy(x_request_id.c_str(), x_request_id.size());
+  }
+  char* uuid = x_request_id.buffer();
+  const size_t uuid_length = x_request_id.size();
+
   // Do not apply tracing transformations if we are currently tracing.
-  if (UuidTraceStatus::NoTrace == UuidUtils::isTraceableUuid(x_request_id)) {
+  if (UuidTraceStatus::NoTrace == UuidUtils::isTraceableUuid(uuid, uuid_length)) {
     if (request_headers.ClientTraceId() &&
         runtime.snapshot().featureEnabled("tracing.client_enabled", 100)) {
-      UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::Client);
+      UuidUtils::setTraceableUuid(uuid, uuid_length, UuidTraceStatus::Client);
     } else if (request_headers.EnvoyForceTrace()) {
-      UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::Forced);
+      UuidUtils::setTraceableUuid(uuid, uuid_length, UuidTraceStatus::Forced);
     } else if (runtime.snapshot().featureEnabled("tracing.random_sampling", 10000, result, 10000)) {
-      UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::Sampled);
+      UuidUtils::setTraceableUuid(uuid, uuid_length, UuidTraceStatus::Sampled);
     }
   }
 
   if (!runtime.snapshot().featureEnabled("tracing.global_enabled", 100, result)) {
-    UuidUtils::setTraceableUuid(x_request_id, UuidTraceStatus::NoTrace);
+    UuidUtils::setTraceableUuid(uuid, uuid_length, UuidTraceStatus::NoTrace);
   }
-
-  request_headers.RequestId()->value(x_request_id);
 }
 
 const std::string HttpTracerUtility::INGRESS_OPERATION = "ingress";
@@ -97,9 +101,9 @@ Decision HttpTracerUtility::isTracing(const Http::AccessLog::RequestInfo& reques
     return {Reason::NotTraceableRequestId, false};
   }
 
-  // TODO PERF: Avoid copy.
+  const Http::HeaderString& x_request_id = request_headers.RequestId()->value();
   UuidTraceStatus trace_status =
-      UuidUtils::isTraceableUuid(request_headers.RequestId()->value().c_str());
+      UuidUtils::isTraceableUuid(x_request_id.c_str(), x_request_id.size());
 
   switch (trace_status) {
   case UuidTraceStatus::Client:
@@ -81,6 +81,8 @@ int main_common(OptionsImpl& options) {
   DefaultTestHooks default_test_hooks;
   ThreadLocal::InstanceImpl tls;
   Stats::ThreadLocalStoreImpl stats_store(stats_allocator);
+  // Workers and the main thread.
+  stats_store.shardCounters(options.shardedCounters(), options.concurrency() + 1);
   Server::InstanceImpl server(options, local_address, default_test_hooks, *restarter, stats_store,
                               access_log_lock, component_factory, tls);
   server.run();
@@ -0,0 +1,42 @@
+#include "server/config/http/binary_access_log.h"
+
+#include "envoy/registry/registry.h"
+#include "envoy/server/filter_config.h"
+
+#include "common/config/well_known_names.h"
+#include "common/http/access_log/binary_access_log.h"
+#include "common/protobuf/protobuf.h"
+
+#include "api/filter/http_connection_manager.pb.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+Http::AccessLog::InstanceSharedPtr BinaryAccessLogFactory::createAccessLogInstance(
+    const Protobuf::Message& config, Http::AccessLog::FilterPtr&& filter, FactoryContext& context) {
+  const auto& fal_config = dynamic_cast<const envoy::api::v2::filter::FileAccessLog&>(config);
+  const Http::AccessLog::Binary::SelectedHeaders headers =
+      fal_config.format().empty()
+          ? Http::AccessLog::Binary::RecordEncoder::defaultHeaders()
+          : Http::AccessLog::Binary::RecordEncoder::parseHeaders(fal_config.format());
+
+  return Http::AccessLog::InstanceSharedPtr{new Http::AccessLog::Binary::BinaryAccessLog(
+      fal_config.path(), std::move(filter), headers, context.accessLogManager(), os_sys_calls_,
+      context.scope())};
+}
+
+ProtobufTypes::MessagePtr BinaryAccessLogFactory::createEmptyConfigProto() {
+  return ProtobufTypes::MessagePtr{new envoy::api::v2::filter::FileAccessLog()};
+}
+
+std::string BinaryAccessLogFactory::name() const { return Config::AccessLogNames::get().BINARY; }
+
+/**
+ * Static registration for the binary access log. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<BinaryAccessLogFactory, AccessLogInstanceFactory> register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
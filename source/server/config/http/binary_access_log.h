@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+#include "envoy/server/access_log_config.h"
+
+#include "common/api/os_sys_calls_impl.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+/**
+ * Config registration for the binary access log. It takes the file access log config, where path
+ * is a file or a unix://<path> socket and format is an optional comma separated list of REQ(name)
+ * and RESP(name) headers to include in every record. @see AccessLogInstanceFactory.
+ */
+class BinaryAccessLogFactory : public AccessLogInstanceFactory {
+public:
+  Http::AccessLog::InstanceSharedPtr createAccessLogInstance(const Protobuf::Message& config,
+                                                             Http::AccessLog::FilterPtr&& filter,
+                                                             FactoryContext& context) override;
+
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override;
+
+  std::string name() const override;
+
+private:
+  // The factory is registered statically, so it outlives every log it creates.
+  Api::OsSysCallsImpl os_sys_calls_;
+};
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
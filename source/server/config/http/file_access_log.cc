@@ -2,6 +2,7 @@
 
 #include "envoy/registry/registry.h"
 #include "envoy/server/filter_config.h"
+#include "envoy/singleton/manager.h"
 
 #include "common/common/macros.h"
 #include "common/config/well_known_names.h"
@@ -15,17 +16,28 @@ namespace Envoy {
 namespace Server {
 namespace Configuration {
 
+// Singleton registration via macro defined in envoy/singleton/manager.h
+SINGLETON_MANAGER_REGISTRATION(access_log_format_thread);
+
 Http::AccessLog::InstanceSharedPtr FileAccessLogFactory::createAccessLogInstance(
     const Protobuf::Message& config, Http::AccessLog::FilterPtr&& filter, FactoryContext& context) {
   const auto& fal_config = dynamic_cast<const envoy::api::v2::filter::FileAccessLog&>(config);
-  Http::AccessLog::FormatterPtr formatter;
+  Http::AccessLog::FormatterImplPtr formatter;
   if (fal_config.format().empty()) {
     formatter = Http::AccessLog::AccessLogFormatUtils::defaultAccessLogFormatter();
   } else {
     formatter.reset(new Http::AccessLog::FormatterImpl(fal_config.format()));
   }
-  return Http::AccessLog::InstanceSharedPtr{new Http::AccessLog::FileAccessLog(
-      fal_config.path(), std::move(filter), std::move(formatter), context.accessLogManager())};
+
+  // Whether lines are formatted in the background is up to the runtime key at the time of each
+  // line, see BackgroundFileAccessLog.
+  Http::AccessLog::BackgroundFormatThreadSharedPtr format_thread =
+      context.singletonManager().getTyped<Http::AccessLog::BackgroundFormatThread>(
+          SINGLETON_MANAGER_REGISTERED_NAME(access_log_format_thread),
+          [] { return std::make_shared<Http::AccessLog::BackgroundFormatThread>(); });
+  return Http::AccessLog::InstanceSharedPtr{new Http::AccessLog::BackgroundFileAccessLog(
+      fal_config.path(), std::move(filter), std::move(formatter), context.accessLogManager(),
+      context.threadLocal(), context.runtime(), context.scope(), format_thread)};
 }
 
 ProtobufTypes::MessagePtr FileAccessLogFactory::createEmptyConfigProto() {
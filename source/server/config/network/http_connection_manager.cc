@@ -1,5 +1,6 @@
 #include "server/config/network/http_connection_manager.h"
 
+#include <algorithm>
 #include <chrono>
 #include <memory>
 #include <string>
@@ -122,6 +123,8 @@ HttpConnectionManagerConfig::HttpConnectionManagerConfig(
       route_config_provider_manager_(route_config_provider_manager),
       http2_settings_(Http::Utility::parseHttp2Settings(config.http2_protocol_options())),
       http1_settings_(Http::Utility::parseHttp1Settings(config.http_protocol_options())),
+      fast_request_parser_key_(fmt::format("{}http1.fast_request_parser", stats_prefix_)),
+      max_pipeline_depth_key_(fmt::format("{}http1.max_pipeline_depth", stats_prefix_)),
       drain_timeout_(PROTOBUF_GET_MS_OR_DEFAULT(config, drain_timeout, 5000)),
       generate_request_id_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, generate_request_id, true)),
       date_provider_(date_provider),
@@ -252,7 +255,7 @@ HttpConnectionManagerConfig::createCodec(Network::Connection& connection,
   switch (codec_type_) {
   case CodecType::HTTP1:
     return Http::ServerConnectionPtr{
-        new Http::Http1::ServerConnectionImpl(connection, callbacks, http1_settings_)};
+        new Http::Http1::ServerConnectionImpl(connection, callbacks, http1Settings())};
   case CodecType::HTTP2:
     return Http::ServerConnectionPtr{new Http::Http2::ServerConnectionImpl(
         connection, callbacks, context_.scope(), http2_settings_)};
@@ -263,13 +266,29 @@ HttpConnectionManagerConfig::createCodec(Network::Connection& connection,
           connection, callbacks, context_.scope(), http2_settings_)};
     } else {
       return Http::ServerConnectionPtr{
-          new Http::Http1::ServerConnectionImpl(connection, callbacks, http1_settings_)};
+          new Http::Http1::ServerConnectionImpl(connection, callbacks, http1Settings())};
     }
   }
 
   NOT_REACHED;
 }
 
+Http::Http1Settings HttpConnectionManagerConfig::http1Settings() {
+  // The HTTP/1 protocol options live in the v2 API, so this is a runtime setting for now. It is
+  // read for every connection so that it can be turned off without a config reload.
+  Http::Http1Settings settings = http1_settings_;
+  settings.fast_request_parser_ =
+      context_.runtime().snapshot().getInteger(fast_request_parser_key_, 0) != 0;
+  return settings;
+}
+
+uint32_t HttpConnectionManagerConfig::maxPipelineDepth() {
+  // Like the HTTP/1 settings above, this is read for every connection so that pipelining can be
+  // turned off without a config reload.
+  return std::max<uint64_t>(1,
+                            context_.runtime().snapshot().getInteger(max_pipeline_depth_key_, 1));
+}
+
 void HttpConnectionManagerConfig::createFilterChain(Http::FilterChainFactoryCallbacks& callbacks) {
   for (const HttpFilterFactoryCb& factory : filter_factories_) {
     factory(callbacks);
@@ -78,6 +78,7 @@ public:
   FilterChainFactory& filterFactory() override { return *this; }
   bool generateRequestId() override { return generate_request_id_; }
   const Optional<std::chrono::milliseconds>& idleTimeout() override { return idle_timeout_; }
+  uint32_t maxPipelineDepth() override;
   Router::RouteConfigProvider& routeConfigProvider() override { return *route_config_provider_; }
   const std::string& serverName() override { return server_name_; }
   Http::ConnectionManagerStats& stats() override { return stats_; }
@@ -99,6 +100,11 @@ public:
 private:
   enum class CodecType { HTTP1, HTTP2, AUTO };
 
+  /**
+   * @return the HTTP/1 settings for a new connection, with the runtime settings applied.
+   */
+  Http::Http1Settings http1Settings();
+
   FactoryContext& context_;
   std::list<HttpFilterFactoryCb> filter_factories_;
   std::list<Http::AccessLog::InstanceSharedPtr> access_logs_;
@@ -112,6 +118,8 @@ private:
   CodecType codec_type_;
   const Http::Http2Settings http2_settings_;
   const Http::Http1Settings http1_settings_;
+  const std::string fast_request_parser_key_;
+  const std::string max_pipeline_depth_key_;
   std::string server_name_;
   Http::TracingConnectionManagerConfigPtr tracing_config_;
   Optional<std::string> user_agent_;
@@ -0,0 +1,44 @@
+#include "server/config/stats/binary.h"
+
+#include <string>
+
+#include "envoy/registry/registry.h"
+
+#include "common/config/well_known_names.h"
+#include "common/network/utility.h"
+#include "common/stats/binary_sink.h"
+
+#include "api/bootstrap.pb.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+Stats::SinkPtr BinaryStatsSinkFactory::createStatsSink(const Protobuf::Message& config,
+                                                       Server::Instance& server) {
+  const auto& sink_config = dynamic_cast<const envoy::api::v2::StatsdSink&>(config);
+  if (sink_config.statsd_specifier_case() != envoy::api::v2::StatsdSink::kAddress) {
+    throw EnvoyException(fmt::format("No address provided for {} Stats::Sink config", name()));
+  }
+
+  Network::Address::InstanceConstSharedPtr address =
+      Network::Utility::fromProtoAddress(sink_config.address());
+  ENVOY_LOG(info, "binary stats UDP ip address: {}", address->asString());
+  return Stats::SinkPtr(
+      new Stats::Binary::UdpBinarySink(server.threadLocal(), std::move(address)));
+}
+
+ProtobufTypes::MessagePtr BinaryStatsSinkFactory::createEmptyConfigProto() {
+  return std::unique_ptr<envoy::api::v2::StatsdSink>(new envoy::api::v2::StatsdSink());
+}
+
+std::string BinaryStatsSinkFactory::name() { return Config::StatsSinkNames::get().BINARY; }
+
+/**
+ * Static registration for the binary stats sink factory. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<BinaryStatsSinkFactory, StatsSinkFactory> register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
@@ -0,0 +1,58 @@
+#include "server/connection_balancer_impl.h"
+
+#include <algorithm>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Server {
+
+ConnectionBalancerImpl::ConnectionBalancerImpl(Runtime::Loader& runtime,
+                                               const std::string& runtime_key,
+                                               Stats::Scope& scope)
+    : runtime_(runtime), runtime_key_(runtime_key),
+      stats_({ALL_CONNECTION_BALANCER_STATS(POOL_COUNTER(scope))}) {}
+
+void ConnectionBalancerImpl::registerHandler(Network::BalancedConnectionHandler& handler) {
+  std::lock_guard<std::mutex> guard(lock_);
+  handlers_.push_back(&handler);
+}
+
+void ConnectionBalancerImpl::unregisterHandler(Network::BalancedConnectionHandler& handler) {
+  std::lock_guard<std::mutex> guard(lock_);
+  auto it = std::find(handlers_.begin(), handlers_.end(), &handler);
+  ASSERT(it != handlers_.end());
+  handlers_.erase(it);
+}
+
+bool ConnectionBalancerImpl::rebalance(Network::BalancedConnectionHandler& current_handler, int fd,
+                                       Network::Address::InstanceConstSharedPtr remote_address,
+                                       Network::Address::InstanceConstSharedPtr local_address,
+                                       bool using_original_dst) {
+  if (!runtime_.snapshot().featureEnabled(runtime_key_, 0)) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> guard(lock_);
+  // Ties stay with the accepting worker, a handoff costs a trip through another event loop.
+  Network::BalancedConnectionHandler* target = &current_handler;
+  uint64_t target_connections = current_handler.numConnections();
+  for (Network::BalancedConnectionHandler* handler : handlers_) {
+    const uint64_t connections = handler->numConnections();
+    if (connections < target_connections) {
+      target = handler;
+      target_connections = connections;
+    }
+  }
+
+  if (target == &current_handler) {
+    return false;
+  }
+
+  target->post(fd, remote_address, local_address, using_original_dst);
+  stats_.downstream_cx_handoff_.inc();
+  return true;
+}
+
+} // namespace Server
+} // namespace Envoy
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "envoy/network/connection_balancer.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/stats.h"
+#include "envoy/stats/stats_macros.h"
+
+namespace Envoy {
+namespace Server {
+
+/**
+ * All connection balancer stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_CONNECTION_BALANCER_STATS(COUNTER)                                                     \
+  COUNTER(downstream_cx_handoff)
+// clang-format on
+
+/**
+ * Struct definition for all connection balancer stats. @see stats_macros.h
+ */
+struct ConnectionBalancerStats {
+  ALL_CONNECTION_BALANCER_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Balancer that hands each new connection to the listener of the worker with the fewest
+ * connections, if that is not the worker that accepted it. Balancing is enabled by a runtime
+ * feature key, as the percentage of new connections that are balanced.
+ */
+class ConnectionBalancerImpl : public Network::ConnectionBalancer {
+public:
+  ConnectionBalancerImpl(Runtime::Loader& runtime, const std::string& runtime_key,
+                         Stats::Scope& scope);
+
+  // Network::ConnectionBalancer
+  void registerHandler(Network::BalancedConnectionHandler& handler) override;
+  void unregisterHandler(Network::BalancedConnectionHandler& handler) override;
+  bool rebalance(Network::BalancedConnectionHandler& current_handler, int fd,
+                 Network::Address::InstanceConstSharedPtr remote_address,
+                 Network::Address::InstanceConstSharedPtr local_address,
+                 bool using_original_dst) override;
+
+private:
+  Runtime::Loader& runtime_;
+  const std::string runtime_key_;
+  ConnectionBalancerStats stats_;
+  // Held while handing off a connection, so that handlers cannot go away meanwhile.
+  std::mutex lock_;
+  std::vector<Network::BalancedConnectionHandler*> handlers_;
+};
+
+} // namespace Server
+} // namespace Envoy
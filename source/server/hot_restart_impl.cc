@@ -13,6 +13,7 @@
 #include "envoy/server/instance.h"
 #include "envoy/server/options.h"
 
+#include "common/common/hash.h"
 #include "common/common/utility.h"
 #include "common/network/utility.h"
 
@@ -23,11 +24,15 @@ namespace Server {
 
 // Increment this whenever there is a shared memory / RPC change that will prevent a hot restart
 // from working. Operations code can then cope with this and do a full restart.
-const uint64_t SharedMemory::VERSION = 9;
+const uint64_t SharedMemory::VERSION = 11;
+const uint64_t SharedMemory::MAX_STAT_SEGMENTS;
 
 SharedMemory& SharedMemory::initialize(Options& options, Api::OsSysCalls& os_sys_calls) {
   const uint64_t entry_size = Stats::RawStatData::size();
-  const uint64_t total_size = sizeof(SharedMemory) + (entry_size * options.maxStats());
+  const uint64_t total_size =
+      sizeof(SharedMemory) + StatSegment::size(options.maxStats(), entry_size);
+  // Slots are referenced by 32 bit indexes, with 0 meaning an empty index bucket.
+  RELEASE_ASSERT(statSegmentSize(options.maxStats(), MAX_STAT_SEGMENTS - 1) < UINT32_MAX);
 
   int flags = O_RDWR;
   const std::string shmem_name = fmt::format("/envoy_shared_memory_{}", options.baseId());
@@ -60,6 +65,8 @@ SharedMemory& SharedMemory::initialize(Options& options, Api::OsSysCalls& os_sys
     shmem->version_ = VERSION;
     shmem->num_stats_ = options.maxStats();
     shmem->entry_size_ = entry_size;
+    shmem->num_stat_segments_ = 1;
+    shmem->stats().initialize(options.maxStats(), entry_size);
     shmem->initializeMutex(shmem->log_lock_);
     shmem->initializeMutex(shmem->access_log_lock_);
     shmem->initializeMutex(shmem->stat_lock_);
@@ -72,8 +79,7 @@ SharedMemory& SharedMemory::initialize(Options& options, Api::OsSysCalls& os_sys
   }
 
   // Stats::RawStatData must be naturally aligned for atomics to work properly.
-  RELEASE_ASSERT((reinterpret_cast<uintptr_t>(shmem->stats_slots_) % alignof(Stats::RawStatData)) ==
-                 0);
+  RELEASE_ASSERT((reinterpret_cast<uintptr_t>(shmem->stats_) % alignof(Stats::RawStatData)) == 0);
 
   // Here we catch the case where a new Envoy starts up when the current Envoy has not yet fully
   // initialized. The startup logic is quite complicated, and it's not worth trying to handle this
@@ -105,8 +111,86 @@ std::string SharedMemory::version() {
   return version(num_stats_, Stats::RawStatData::maxNameLength());
 }
 
+uint64_t StatSegment::indexSize(uint64_t num_stats) {
+  uint64_t size = 1;
+  while (size < num_stats * 2) {
+    size <<= 1;
+  }
+  return size;
+}
+
+uint64_t StatSegment::size(uint64_t num_stats, uint64_t entry_size) {
+  return sizeof(StatSegment) + entry_size * num_stats + sizeof(uint32_t) * indexSize(num_stats) +
+         sizeof(uint32_t) * num_stats;
+}
+
+void StatSegment::initialize(uint64_t num_stats, uint64_t entry_size) {
+  num_stats_ = num_stats;
+  entry_size_ = entry_size;
+  index_size_ = indexSize(num_stats);
+  memset(index(), 0, sizeof(uint32_t) * index_size_);
+  // Hand out slots in increasing order.
+  num_free_slots_ = num_stats;
+  for (uint64_t i = 0; i < num_free_slots_; i++) {
+    freeSlots()[i] = num_free_slots_ - 1 - i;
+  }
+}
+
+uint64_t StatSegment::findBucket(const char* name, uint64_t hash) {
+  // Linear probing. The index is at most half full so there always is an empty bucket.
+  const uint64_t mask = index_size_ - 1;
+  const uint32_t* buckets = index();
+  for (uint64_t bucket = hash & mask;; bucket = (bucket + 1) & mask) {
+    if (buckets[bucket] == 0 || 0 == strcmp(name, slot(buckets[bucket] - 1).name_)) {
+      return bucket;
+    }
+  }
+}
+
+Stats::RawStatData* StatSegment::find(const std::string& name, uint64_t hash) {
+  const uint32_t entry = index()[findBucket(name.c_str(), hash)];
+  return entry == 0 ? nullptr : &slot(entry - 1);
+}
+
+Stats::RawStatData* StatSegment::alloc(const std::string& name, uint64_t hash) {
+  if (num_free_slots_ == 0) {
+    return nullptr;
+  }
+
+  const uint64_t bucket = findBucket(name.c_str(), hash);
+  ASSERT(index()[bucket] == 0);
+  const uint32_t i = freeSlots()[--num_free_slots_];
+  Stats::RawStatData& data = slot(i);
+  data.initialize(name);
+  index()[bucket] = i + 1;
+  return &data;
+}
+
+void StatSegment::free(Stats::RawStatData& data) {
+  const uint64_t i = (reinterpret_cast<const uint8_t*>(&data) - slots_) / entry_size_;
+  const uint64_t mask = index_size_ - 1;
+  uint32_t* buckets = index();
+  uint64_t hole = findBucket(data.name_, HashUtil::xxHash64(data.name_));
+  ASSERT(buckets[hole] == i + 1);
+
+  // Backward shift deletion: move following entries of the probe sequence into the hole, unless
+  // that would put them before their home bucket. Lookups then never need tombstones.
+  for (uint64_t bucket = (hole + 1) & mask; buckets[bucket] != 0; bucket = (bucket + 1) & mask) {
+    const uint64_t home = HashUtil::xxHash64(slot(buckets[bucket] - 1).name_) & mask;
+    if (((bucket - home) & mask) >= ((bucket - hole) & mask)) {
+      buckets[hole] = buckets[bucket];
+      hole = bucket;
+    }
+  }
+  buckets[hole] = 0;
+
+  memset(&data, 0, entry_size_);
+  freeSlots()[num_free_slots_++] = i;
+}
+
 HotRestartImpl::HotRestartImpl(Options& options, Api::OsSysCalls& os_sys_calls)
-    : options_(options), shmem_(SharedMemory::initialize(options, os_sys_calls)),
+    : options_(options), os_sys_calls_(os_sys_calls),
+      shmem_(SharedMemory::initialize(options, os_sys_calls)),
       log_lock_(shmem_.log_lock_), access_log_lock_(shmem_.access_log_lock_),
       stat_lock_(shmem_.stat_lock_), init_lock_(shmem_.init_lock_) {
 
@@ -116,6 +200,12 @@ HotRestartImpl::HotRestartImpl(Options& options, Api::OsSysCalls& os_sys_calls)
     parent_address_ = createDomainSocketAddress((options.restartEpoch() + -1));
   }
 
+  {
+    // Map the stat segments added by the parent, ones added later are mapped as they show up.
+    std::unique_lock<Thread::BasicLockable> lock(stat_lock_);
+    mapStatSegments();
+  }
+
   // If our parent ever goes away just terminate us so that we don't have to rely on ops/launching
   // logic killing the entire process tree. We should never exist without our parent.
   int rc = prctl(PR_SET_PDEATHSIG, SIGTERM);
@@ -124,26 +214,29 @@ HotRestartImpl::HotRestartImpl(Options& options, Api::OsSysCalls& os_sys_calls)
 }
 
 Stats::RawStatData* HotRestartImpl::alloc(const std::string& name) {
-  // Try to find the existing slot in shared memory, otherwise allocate a new one.
-  Stats::RawStatData* unused = nullptr;
+  // Try to find the existing slot in shared memory, otherwise allocate a new one. In case a stat
+  // got truncated, match on the truncated name.
+  const std::string truncated = name.substr(0, Stats::RawStatData::maxNameLength());
+  const uint64_t hash = HashUtil::xxHash64(truncated);
   std::unique_lock<Thread::BasicLockable> lock(stat_lock_);
-  for (uint64_t i = 0; i < shmem_.num_stats_; i++) {
-    const size_t offset = shmem_.entry_size_ * i;
-    Stats::RawStatData* data = reinterpret_cast<Stats::RawStatData*>(shmem_.stats_slots_ + offset);
-    if (!data->initialized()) {
-      unused = data;
-    } else if (data->matches(name)) {
+  mapStatSegments();
+  for (StatSegment* segment : stat_segments_) {
+    Stats::RawStatData* data = segment->find(truncated, hash);
+    if (data != nullptr) {
       data->ref_count_++;
       return data;
     }
   }
 
-  if (unused != nullptr) {
-    unused->initialize(name);
-    return unused;
+  for (StatSegment* segment : stat_segments_) {
+    Stats::RawStatData* data = segment->alloc(truncated, hash);
+    if (data != nullptr) {
+      return data;
+    }
   }
 
-  return nullptr;
+  StatSegment* segment = addStatSegment();
+  return segment != nullptr ? segment->alloc(truncated, hash) : nullptr;
 }
 
 void HotRestartImpl::free(Stats::RawStatData& data) {
@@ -154,7 +247,77 @@ void HotRestartImpl::free(Stats::RawStatData& data) {
     return;
   }
 
-  memset(&data, 0, Stats::RawStatData::size());
+  for (StatSegment* segment : stat_segments_) {
+    if (segment->contains(data)) {
+      segment->free(data);
+      return;
+    }
+  }
+  NOT_REACHED;
+}
+
+std::string HotRestartImpl::statSegmentName(uint64_t segment) {
+  return fmt::format("/envoy_shared_memory_{}_stats_{}", options_.baseId(), segment);
+}
+
+void HotRestartImpl::mapStatSegments() {
+  while (stat_segments_.size() < shmem_.num_stat_segments_) {
+    const uint64_t segment = stat_segments_.size();
+    if (segment == 0) {
+      stat_segments_.push_back(&shmem_.stats());
+      continue;
+    }
+
+    const std::string name = statSegmentName(segment);
+    const uint64_t size = StatSegment::size(
+        SharedMemory::statSegmentSize(shmem_.num_stats_, segment), shmem_.entry_size_);
+    int fd = os_sys_calls_.shmOpen(name.c_str(), O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+      PANIC(fmt::format("cannot open shared memory region {}", name));
+    }
+    void* address = os_sys_calls_.mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    RELEASE_ASSERT(address != MAP_FAILED);
+    os_sys_calls_.close(fd);
+    stat_segments_.push_back(static_cast<StatSegment*>(address));
+  }
+}
+
+StatSegment* HotRestartImpl::addStatSegment() {
+  const uint64_t segment = shmem_.num_stat_segments_;
+  if (segment == SharedMemory::MAX_STAT_SEGMENTS) {
+    return nullptr;
+  }
+
+  // A region left behind by a previous set of processes is stale, the stat lock makes sure that
+  // no running process is creating this one.
+  const std::string name = statSegmentName(segment);
+  os_sys_calls_.shmUnlink(name.c_str());
+  int fd = os_sys_calls_.shmOpen(name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    ENVOY_LOG(warn, "cannot create shared memory region {} for stats", name);
+    return nullptr;
+  }
+
+  const uint64_t num_stats = SharedMemory::statSegmentSize(shmem_.num_stats_, segment);
+  const uint64_t size = StatSegment::size(num_stats, shmem_.entry_size_);
+  void* address = MAP_FAILED;
+  if (os_sys_calls_.ftruncate(fd, size) != -1) {
+    address = os_sys_calls_.mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  os_sys_calls_.close(fd);
+  if (address == MAP_FAILED) {
+    ENVOY_LOG(warn, "cannot allocate {} bytes of shared memory for stats", size);
+    os_sys_calls_.shmUnlink(name.c_str());
+    return nullptr;
+  }
+
+  StatSegment* stats = static_cast<StatSegment*>(address);
+  stats->initialize(num_stats, shmem_.entry_size_);
+  stat_segments_.push_back(stats);
+  // Published last so that other processes only map complete segments.
+  shmem_.num_stat_segments_++;
+  ENVOY_LOG(info, "added shared memory for {} stats", num_stats);
+  return stats;
 }
 
 int HotRestartImpl::bindDomainSocket(uint64_t id, Api::OsSysCalls& os_sys_calls) {
@@ -7,6 +7,7 @@
 #include <atomic>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/api/os_sys_calls.h"
 #include "envoy/server/hot_restart.h"
@@ -18,9 +19,95 @@
 namespace Envoy {
 namespace Server {
 
+/**
+ * A table of stats laid directly into shared memory: the stat slots, followed by an open
+ * addressing hash index from stat name to slot and by a stack of free slots, so that finding or
+ * allocating a stat does not depend on the number of stats. All methods must be called with the
+ * stat lock held.
+ */
+class StatSegment {
+public:
+  /**
+   * @return the size of a segment holding a number of stats.
+   */
+  static uint64_t size(uint64_t num_stats, uint64_t entry_size);
+
+  /**
+   * Initialize a zero filled segment.
+   */
+  void initialize(uint64_t num_stats, uint64_t entry_size);
+
+  /**
+   * @return the stat with the given name, nullptr if it is not in this segment.
+   * @param name supplies the name, truncated to Stats::RawStatData::maxNameLength().
+   * @param hash supplies the hash of the name.
+   */
+  Stats::RawStatData* find(const std::string& name, uint64_t hash);
+
+  /**
+   * Allocate a stat that is not in the segment yet.
+   * @return the stat, nullptr if the segment is full.
+   */
+  Stats::RawStatData* alloc(const std::string& name, uint64_t hash);
+
+  /**
+   * Release the slot of a stat whose reference count dropped to 0.
+   */
+  void free(Stats::RawStatData& data);
+
+  /**
+   * @return whether a stat lives in this segment.
+   */
+  bool contains(const Stats::RawStatData& data) const {
+    const uint8_t* address = reinterpret_cast<const uint8_t*>(&data);
+    return address >= slots_ && address < slots_ + entry_size_ * num_stats_;
+  }
+
+private:
+  // Due to the flexible-array-length of slots_, c-style allocation and initialization are
+  // neccessary.
+  StatSegment() = delete;
+  ~StatSegment() = delete;
+
+  /**
+   * @return the number of hash index buckets for a number of stats. This is a power of 2 that
+   *         keeps the index at most half full.
+   */
+  static uint64_t indexSize(uint64_t num_stats);
+
+  /**
+   * @return the bucket holding the stat with the given name, or the empty bucket where it should
+   *         be inserted.
+   */
+  uint64_t findBucket(const char* name, uint64_t hash);
+
+  Stats::RawStatData& slot(uint64_t i) {
+    return *reinterpret_cast<Stats::RawStatData*>(slots_ + entry_size_ * i);
+  }
+
+  // Buckets of the hash index, each holding 0 when empty or the slot index + 1.
+  uint32_t* index() { return reinterpret_cast<uint32_t*>(slots_ + entry_size_ * num_stats_); }
+
+  // Stack of unused slot indexes, num_free_slots_ long.
+  uint32_t* freeSlots() { return index() + index_size_; }
+
+  uint64_t num_stats_;
+  uint64_t entry_size_;
+  uint64_t index_size_;
+  uint64_t num_free_slots_;
+  alignas(Stats::RawStatData) uint8_t
+      slots_[]; // array of Stats::RawStatData, which has a flexible-array-length member
+                // so non-fixed size
+};
+
 /**
  * Shared memory segment. This structure is laid directly into shared memory and is used amongst
  * all running envoy processes.
+ *
+ * It ends with a StatSegment sized for --max-stats. When that is full, further StatSegments are
+ * created in shared memory regions of their own, each twice the size of the previous one, up to
+ * MAX_STAT_SEGMENTS in total. num_stat_segments_ tells the other processes which extra regions to
+ * map.
  */
 class SharedMemory {
 public:
@@ -28,12 +115,23 @@ public:
   static std::string version(uint64_t max_num_stats, uint64_t max_stat_name_len);
   std::string version();
 
+  static const uint64_t MAX_STAT_SEGMENTS = 8;
+
+  /**
+   * @return the number of stats of a stat segment.
+   * @param max_num_stats supplies the configured maximum number of stats.
+   * @param segment supplies the index of the segment, 0 being the one in this region.
+   */
+  static uint64_t statSegmentSize(uint64_t max_num_stats, uint64_t segment) {
+    return segment == 0 ? max_num_stats : max_num_stats << (segment - 1);
+  }
+
 private:
   struct Flags {
     static const uint64_t INITIALIZING = 0x1;
   };
 
-  // Due to the flexible-array-length of stats_slots_, c-style allocation
+  // Due to the flexible-array-length of stats_, c-style allocation
   // and initialization are neccessary.
   SharedMemory() = delete;
   ~SharedMemory() = delete;
@@ -49,20 +147,22 @@ private:
    */
   void initializeMutex(pthread_mutex_t& mutex);
 
+  StatSegment& stats() { return *reinterpret_cast<StatSegment*>(stats_); }
+
   static const uint64_t VERSION;
 
   uint64_t size_;
   uint64_t version_;
   uint64_t num_stats_;
   uint64_t entry_size_;
+  uint64_t num_stat_segments_;
   std::atomic<uint64_t> flags_;
   pthread_mutex_t log_lock_;
   pthread_mutex_t access_log_lock_;
   pthread_mutex_t stat_lock_;
   pthread_mutex_t init_lock_;
-  alignas(Stats::RawStatData) uint8_t
-      stats_slots_[]; // array of Stats::RawStatData, which has a flexible-array-length member
-                      // so non-fixed size
+  alignas(Stats::RawStatData) uint8_t stats_[]; // StatSegment, which has a flexible-array-length
+                                                // member so non-fixed size
 
   friend class HotRestartImpl;
 };
@@ -193,11 +293,21 @@ private:
   sockaddr_un createDomainSocketAddress(uint64_t id);
   void onGetListenSocket(RpcGetListenSocketRequest& rpc);
   void onSocketEvent();
+  // Map the stat segments other processes added since the last call. Must be called with
+  // stat_lock_ held.
+  void mapStatSegments();
+  // Create and map a new stat segment, returns nullptr on failure. Must be called with stat_lock_
+  // held.
+  StatSegment* addStatSegment();
+  std::string statSegmentName(uint64_t segment);
   RpcBase* receiveRpc(bool block);
   void sendMessage(sockaddr_un& address, RpcBase& rpc);
 
   Options& options_;
+  Api::OsSysCalls& os_sys_calls_;
   SharedMemory& shmem_;
+  // The stat segments mapped in this process, in order.
+  std::vector<StatSegment*> stat_segments_;
   ProcessSharedMutex log_lock_;
   ProcessSharedMutex access_log_lock_;
   ProcessSharedMutex stat_lock_;
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <fstream>
+#include <map>
 #include <string>
 #include <unordered_set>
 
@@ -286,6 +287,49 @@ Http::Code AdminImpl::handlerStats(const std::string&, Buffer::Instance& respons
   return Http::Code::OK;
 }
 
+Http::Code AdminImpl::handlerDispatchers(const std::string&, Buffer::Instance& response) {
+  // Every dispatcher with stats has a set of loop stats under its own prefix, e.g.
+  // "server.worker_0.dispatcher.", so they are found by name. Only those are copied out of the
+  // store.
+  const std::string prefix = "dispatcher.loop_";
+  std::map<std::string, uint64_t> loop_stats;
+  for (const Stats::CounterSharedPtr& counter : server_.stats().counters()) {
+    if (counter->name().find(prefix) != std::string::npos) {
+      loop_stats.emplace(counter->name(), counter->value());
+    }
+  }
+
+  for (const Stats::GaugeSharedPtr& gauge : server_.stats().gauges()) {
+    if (gauge->name().find(prefix) != std::string::npos) {
+      loop_stats.emplace(gauge->name(), gauge->value());
+    }
+  }
+
+  const std::string iterations_suffix = prefix + "iterations";
+  for (const auto& stat : loop_stats) {
+    if (!StringUtil::endsWith(stat.first, iterations_suffix)) {
+      continue;
+    }
+
+    const std::string name = stat.first.substr(0, stat.first.size() - iterations_suffix.size());
+    auto value = [&](const std::string& stat_name) -> uint64_t {
+      auto it = loop_stats.find(name + prefix + stat_name);
+      return it == loop_stats.end() ? 0 : it->second;
+    };
+    const uint64_t iterations = stat.second;
+    const uint64_t events = value("events");
+    response.add(fmt::format(
+        "{}: utilization: {}%, iterations: {}, events_per_iteration: {:.1f}, busy_us: {}, "
+        "poll_wait_us: {}\n",
+        name.empty() || name.back() != '.' ? name : name.substr(0, name.size() - 1),
+        value("utilization"), iterations,
+        iterations == 0 ? 0.0 : static_cast<double>(events) / iterations, value("busy_us"),
+        value("poll_wait_us")));
+  }
+
+  return Http::Code::OK;
+}
+
 Http::Code AdminImpl::handlerQuitQuitQuit(const std::string&, Buffer::Instance& response) {
   server_.shutdown();
   response.add("OK\n");
@@ -351,6 +395,8 @@ AdminImpl::AdminImpl(const std::string& access_log_path, const std::string& prof
           {"/clusters", "upstream cluster status", MAKE_ADMIN_HANDLER(handlerClusters), false},
           {"/cpuprofiler", "enable/disable the CPU profiler",
            MAKE_ADMIN_HANDLER(handlerCpuProfiler), false},
+          {"/dispatchers", "print event loop load of the main thread and workers",
+           MAKE_ADMIN_HANDLER(handlerDispatchers), false},
           {"/healthcheck/fail", "cause the server to fail health checks",
            MAKE_ADMIN_HANDLER(handlerHealthcheckFail), false},
           {"/healthcheck/ok", "cause the server to pass health checks",
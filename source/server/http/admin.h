@@ -62,6 +62,7 @@ public:
   Http::FilterChainFactory& filterFactory() override { return *this; }
   bool generateRequestId() override { return false; }
   const Optional<std::chrono::milliseconds>& idleTimeout() override { return idle_timeout_; }
+  uint32_t maxPipelineDepth() override { return 1; }
   Router::RouteConfigProvider& routeConfigProvider() override { return route_config_provider_; }
   const std::string& serverName() override {
     return Server::Configuration::HttpConnectionManagerConfig::DEFAULT_SERVER_STRING;
@@ -122,6 +123,7 @@ private:
   Http::Code handlerCerts(const std::string& url, Buffer::Instance& response);
   Http::Code handlerClusters(const std::string& url, Buffer::Instance& response);
   Http::Code handlerCpuProfiler(const std::string& url, Buffer::Instance& response);
+  Http::Code handlerDispatchers(const std::string& url, Buffer::Instance& response);
   Http::Code handlerHealthcheckFail(const std::string& url, Buffer::Instance& response);
   Http::Code handlerHealthcheckOk(const std::string& url, Buffer::Instance& response);
   Http::Code handlerHotRestartVersion(const std::string& url, Buffer::Instance& response);
@@ -93,6 +93,14 @@ ListenerImpl::ListenerImpl(const envoy::api::v2::Listener& config, ListenerManag
 
   listener_scope_ =
       parent_.server_.stats().createScope(fmt::format("listener.{}.", address_->asString()));
+  connection_balancer_.reset(
+      new ConnectionBalancerImpl(parent_.server_.runtime(),
+                                 fmt::format("listener.{}.connection_balancing", name_),
+                                 *listener_scope_));
+  max_accepts_per_wakeup_key_ = fmt::format("listener.{}.max_accepts_per_wakeup", name_);
+  // The socket option is set when the listen socket is set up, so this one can only be read here.
+  tcp_defer_accept_seconds_ = parent_.server_.runtime().snapshot().getInteger(
+      fmt::format("listener.{}.tcp_defer_accept_seconds", name_), 0);
 
   if (filter_chain.has_tls_context()) {
     Ssl::ServerContextConfigImpl context_config(filter_chain.tls_context());
@@ -103,6 +111,11 @@ ListenerImpl::ListenerImpl(const envoy::api::v2::Listener& config, ListenerManag
   filter_factories_ = parent_.factory_.createFilterFactoryList(filter_chain.filters(), *this);
 }
 
+uint32_t ListenerImpl::maxAcceptsPerWakeup() {
+  return parent_.server_.runtime().snapshot().getInteger(max_accepts_per_wakeup_key_,
+                                                         DEFAULT_MAX_ACCEPTS_PER_WAKEUP);
+}
+
 ListenerImpl::~ListenerImpl() {
   // The filter factories may have pending initialize actions (like in the case of RDS). Those
   // actions will fire in the destructor to avoid blocking initial server startup. If we are using
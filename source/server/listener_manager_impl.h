@@ -7,6 +7,7 @@
 
 #include "common/common/logger.h"
 
+#include "server/connection_balancer_impl.h"
 #include "server/init_manager_impl.h"
 
 #include "api/lds.pb.h"
@@ -201,6 +202,9 @@ public:
   Stats::Scope& listenerScope() override { return *listener_scope_; }
   uint64_t listenerTag() override { return listener_tag_; }
   const std::string& name() const override { return name_; }
+  Network::ConnectionBalancer* connectionBalancer() override { return connection_balancer_.get(); }
+  uint32_t maxAcceptsPerWakeup() override;
+  uint32_t tcpDeferAcceptSeconds() override { return tcp_defer_accept_seconds_; }
 
   // Server::Configuration::FactoryContext
   AccessLog::AccessLogManager& accessLogManager() override {
@@ -231,12 +235,20 @@ public:
   bool createFilterChain(Network::Connection& connection) override;
 
 private:
+  // Large enough to not matter unless connections pile up in the accept queue, small enough to
+  // keep a worker responsive while they do.
+  static const uint32_t DEFAULT_MAX_ACCEPTS_PER_WAKEUP = 64;
+
   ListenerManagerImpl& parent_;
   Network::Address::InstanceConstSharedPtr address_;
   Network::ListenSocketSharedPtr socket_;
   Stats::ScopePtr global_scope_;   // Stats with global named scope, but needed for LDS cleanup.
   Stats::ScopePtr listener_scope_; // Stats with listener named scope.
   Ssl::ServerContextPtr ssl_context_;
+  std::unique_ptr<ConnectionBalancerImpl> connection_balancer_;
+  // Read from runtime when the listener is created.
+  std::string max_accepts_per_wakeup_key_;
+  uint32_t tcp_defer_accept_seconds_;
   const bool bind_to_port_;
   const bool use_proxy_proto_;
   const bool use_original_dst_;
@@ -6,6 +6,7 @@
 #include <string>
 
 #include "common/common/macros.h"
+#include "common/common/utility.h"
 #include "common/common/version.h"
 
 #include "fmt/format.h"
@@ -85,6 +86,11 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
   TCLAP::ValueArg<uint64_t> max_stat_name_len("", "max-stat-name-len",
                                               "Maximum name length for a stat", false,
                                               ENVOY_DEFAULT_MAX_STAT_NAME_LENGTH, "uint64_t", cmd);
+  TCLAP::ValueArg<std::string> sharded_counters(
+      "", "sharded-counters",
+      "Comma separated name suffixes of counters to shard per thread, e.g. "
+      "'downstream_rq_total,upstream_rq_total'",
+      false, "", "string", cmd);
 
   try {
     cmd.parse(argc, argv);
@@ -145,5 +151,6 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
   parent_shutdown_time_ = std::chrono::seconds(parent_shutdown_time_s.getValue());
   max_stats_ = max_stats.getValue();
   max_stat_name_length_ = max_stat_name_len.getValue();
+  sharded_counters_ = StringUtil::split(sharded_counters.getValue(), ",");
 }
 } // namespace Envoy
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/server/options.h"
 
@@ -37,6 +38,7 @@ public:
   const std::string& serviceZone() override { return service_zone_; }
   uint64_t maxStats() override { return max_stats_; }
   uint64_t maxStatNameLength() override { return max_stat_name_length_; }
+  const std::vector<std::string>& shardedCounters() override { return sharded_counters_; }
 
 private:
   uint64_t base_id_;
@@ -56,5 +58,6 @@ private:
   Server::Mode mode_;
   uint64_t max_stats_;
   uint64_t max_stat_name_length_;
+  std::vector<std::string> sharded_counters_;
 };
 } // namespace Envoy
@@ -47,7 +47,7 @@ InstanceImpl::InstanceImpl(Options& options, Network::Address::InstanceConstShar
       thread_local_(tls), api_(new Api::Impl(options.fileFlushIntervalMsec())),
       dispatcher_(api_->allocateDispatcher()), singleton_manager_(new Singleton::ManagerImpl()),
       handler_(new ConnectionHandlerImpl(ENVOY_LOGGER(), *dispatcher_)),
-      listener_component_factory_(*this), worker_factory_(thread_local_, *api_, hooks),
+      listener_component_factory_(*this), worker_factory_(thread_local_, *api_, hooks, store),
       dns_resolver_(dispatcher_->createDnsResolver({})),
       access_log_manager_(*api_, *dispatcher_, access_log_lock, store) {
 
@@ -106,31 +106,15 @@ void InstanceImpl::failHealthcheck(bool fail) {
 }
 
 void InstanceUtil::flushCountersAndGaugesToSinks(const std::list<Stats::SinkPtr>& sinks,
-                                                 Stats::Store& store) {
+                                                 Stats::Store& store,
+                                                 Stats::FlushSnapshot& snapshot) {
+  store.latch(snapshot);
   for (const auto& sink : sinks) {
-    sink->beginFlush();
+    sink->flush(snapshot);
   }
 
-  for (const Stats::CounterSharedPtr& counter : store.counters()) {
-    uint64_t delta = counter->latch();
-    if (counter->used()) {
-      for (const auto& sink : sinks) {
-        sink->flushCounter(*counter, delta);
-      }
-    }
-  }
-
-  for (const Stats::GaugeSharedPtr& gauge : store.gauges()) {
-    if (gauge->used()) {
-      for (const auto& sink : sinks) {
-        sink->flushGauge(*gauge, gauge->value());
-      }
-    }
-  }
-
-  for (const auto& sink : sinks) {
-    sink->endFlush();
-  }
+  // Don't hold on to stats of scopes that go away until the next flush.
+  snapshot.clear();
 }
 
 void InstanceImpl::flushStats() {
@@ -146,7 +130,8 @@ void InstanceImpl::flushStats() {
   server_stats_.days_until_first_cert_expiring_.set(
       sslContextManager().daysUntilFirstCertExpires());
 
-  InstanceUtil::flushCountersAndGaugesToSinks(config_->statsSinks(), stats_store_);
+  InstanceUtil::flushCountersAndGaugesToSinks(config_->statsSinks(), stats_store_,
+                                              flush_snapshot_);
   stat_flush_timer_->enableTimer(config_->statsFlushInterval());
 }
 
@@ -198,6 +183,8 @@ void InstanceImpl::initialize(Options& options,
 
   loadServerFlags(initial_config.flagsPath());
 
+  dispatcher_->initializeStats(stats_store_, "server.");
+
   // Workers get created first so they register for thread local updates.
   listener_manager_.reset(
       new ListenerManagerImpl(*this, listener_component_factory_, worker_factory_));
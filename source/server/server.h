@@ -78,13 +78,14 @@ public:
   static Runtime::LoaderPtr createRuntime(Instance& server, Server::Configuration::Initial& config);
 
   /**
-   * Helper for flushing counters and gauges to sinks. This takes care of calling beginFlush(),
-   * latching of counters and flushing, flushing of gauges, and calling endFlush(), on each sink.
+   * Helper for flushing counters and gauges to sinks. This latches the counters that changed and
+   * the used gauges of the store into a snapshot, and flushes the snapshot to each sink.
    * @param sinks supplies the list of sinks.
    * @param store supplies the store to flush.
+   * @param snapshot supplies the snapshot to latch into, reused across flushes.
    */
   static void flushCountersAndGaugesToSinks(const std::list<Stats::SinkPtr>& sinks,
-                                            Stats::Store& store);
+                                            Stats::Store& store, Stats::FlushSnapshot& snapshot);
 };
 
 /**
@@ -181,6 +182,7 @@ private:
   Stats::ScopePtr admin_scope_;
   Network::DnsResolverSharedPtr dns_resolver_;
   Event::TimerPtr stat_flush_timer_;
+  Stats::FlushSnapshot flush_snapshot_;
   LocalInfo::LocalInfoPtr local_info_;
   DrainManagerPtr drain_manager_;
   AccessLog::AccessLogManagerImpl access_log_manager_;
@@ -11,11 +11,14 @@
 
 #include "server/connection_handler_impl.h"
 
+#include "fmt/format.h"
+
 namespace Envoy {
 namespace Server {
 
 WorkerPtr ProdWorkerFactory::createWorker() {
   Event::DispatcherPtr dispatcher(api_.allocateDispatcher());
+  dispatcher->initializeStats(stats_scope_, fmt::format("server.worker_{}.", next_worker_index_++));
   return WorkerPtr{new WorkerImpl(
       tls_, hooks_, std::move(dispatcher),
       Network::ConnectionHandlerPtr{new ConnectionHandlerImpl(ENVOY_LOGGER(), *dispatcher)})};
@@ -47,7 +50,15 @@ void WorkerImpl::addListenerWorker(Listener& listener) {
                                                      .use_proxy_proto_ = listener.useProxyProto(),
                                                      .use_original_dst_ = listener.useOriginalDst(),
                                                      .per_connection_buffer_limit_bytes_ =
-                                                         listener.perConnectionBufferLimitBytes()};
+                                                         listener.perConnectionBufferLimitBytes(),
+                                                     .connection_balancer_ =
+                                                         listener.connectionBalancer(),
+                                                     .max_accepts_per_wakeup_ =
+                                                         [&listener]() -> uint32_t {
+                                                       return listener.maxAcceptsPerWakeup();
+                                                     },
+                                                     .tcp_defer_accept_seconds_ =
+                                                         listener.tcpDeferAcceptSeconds()};
   if (listener.sslContext()) {
     handler_->addSslListener(listener.filterChainFactory(), *listener.sslContext(),
                              listener.socket(), listener.listenerScope(), listener.listenerTag(),
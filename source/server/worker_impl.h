@@ -8,6 +8,7 @@
 #include "envoy/server/guarddog.h"
 #include "envoy/server/listener_manager.h"
 #include "envoy/server/worker.h"
+#include "envoy/stats/stats.h"
 #include "envoy/thread_local/thread_local.h"
 
 #include "common/common/logger.h"
@@ -20,8 +21,9 @@ namespace Server {
 
 class ProdWorkerFactory : public WorkerFactory, Logger::Loggable<Logger::Id::main> {
 public:
-  ProdWorkerFactory(ThreadLocal::Instance& tls, Api::Api& api, TestHooks& hooks)
-      : tls_(tls), api_(api), hooks_(hooks) {}
+  ProdWorkerFactory(ThreadLocal::Instance& tls, Api::Api& api, TestHooks& hooks,
+                    Stats::Scope& stats_scope)
+      : tls_(tls), api_(api), hooks_(hooks), stats_scope_(stats_scope) {}
 
   // Server::WorkerFactory
   WorkerPtr createWorker() override;
@@ -30,6 +32,8 @@ private:
   ThreadLocal::Instance& tls_;
   Api::Api& api_;
   TestHooks& hooks_;
+  Stats::Scope& stats_scope_;
+  uint32_t next_worker_index_{};
 };
 
 /**
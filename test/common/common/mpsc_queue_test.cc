@@ -0,0 +1,71 @@
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "common/common/mpsc_queue.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+
+struct TestNode : public MpscQueue::Node {
+  TestNode(uint32_t producer, uint32_t sequence) : producer_(producer), sequence_(sequence) {}
+
+  const uint32_t producer_;
+  const uint32_t sequence_;
+};
+
+TEST(MpscQueueTest, Fifo) {
+  MpscQueue queue;
+  EXPECT_EQ(nullptr, queue.pop());
+
+  TestNode node1(0, 1);
+  TestNode node2(0, 2);
+  TestNode node3(0, 3);
+  queue.push(&node1);
+  queue.push(&node2);
+  EXPECT_EQ(&node1, queue.pop());
+  queue.push(&node3);
+  EXPECT_EQ(&node2, queue.pop());
+  EXPECT_EQ(&node3, queue.pop());
+  EXPECT_EQ(nullptr, queue.pop());
+
+  // Nodes can be pushed again once popped.
+  queue.push(&node1);
+  EXPECT_EQ(&node1, queue.popKnownNonEmpty());
+  EXPECT_EQ(nullptr, queue.pop());
+}
+
+TEST(MpscQueueTest, MultipleProducers) {
+  const uint32_t num_producers = 4;
+  const uint32_t num_items = 100000;
+  MpscQueue queue;
+
+  std::vector<std::thread> producers;
+  for (uint32_t producer = 0; producer < num_producers; producer++) {
+    producers.emplace_back([&queue, producer]() -> void {
+      for (uint32_t i = 0; i < num_items; i++) {
+        queue.push(new TestNode(producer, i));
+      }
+    });
+  }
+
+  // Items from a single producer come out in the order they were pushed.
+  std::vector<uint32_t> next_sequence(num_producers);
+  uint32_t popped = 0;
+  while (popped < num_producers * num_items) {
+    std::unique_ptr<TestNode> node(static_cast<TestNode*>(queue.pop()));
+    if (node) {
+      EXPECT_EQ(next_sequence[node->producer_]++, node->sequence_);
+      popped++;
+    }
+  }
+
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  EXPECT_EQ(nullptr, queue.pop());
+}
+
+} // namespace Envoy
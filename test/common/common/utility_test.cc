@@ -33,6 +33,20 @@ TEST(DateUtil, All) {
   EXPECT_TRUE(DateUtil::timePointValid(std::chrono::system_clock::now()));
 }
 
+TEST(AccessLogDateTimeFormatter, appendTime) {
+  const SystemTime time =
+      std::chrono::system_clock::from_time_t(1508295607) + std::chrono::microseconds(7123456);
+  EXPECT_EQ("2017-10-18T03:00:14.123Z", AccessLogDateTimeFormatter::fromTime(time));
+
+  // Repeated calls within and across seconds, which use and refresh the cached second.
+  for (int64_t ms : {0, 1, 876, 877, 2000, 61005}) {
+    const SystemTime later = time + std::chrono::milliseconds(ms);
+    std::string out = "x";
+    AccessLogDateTimeFormatter::appendTime(later, out);
+    EXPECT_EQ("x" + AccessLogDateTimeFormatter::fromTime(later), out);
+  }
+}
+
 TEST(ProdSystemTimeSourceTest, All) {
   ProdSystemTimeSource source;
   source.currentTime();
@@ -0,0 +1,162 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/dynamo/dynamo_json_scanner.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Dynamo {
+
+class RecordingCallbacks : public JsonScanner::Callbacks {
+public:
+  // Dynamo::JsonScanner::Callbacks
+  void onKey(uint32_t depth, const std::string& key) override {
+    events_.push_back("key:" + std::to_string(depth) + ":" + key);
+  }
+  void onString(uint32_t depth, const std::string& value) override {
+    events_.push_back("string:" + std::to_string(depth) + ":" + value);
+  }
+  void onNumber(uint32_t depth, const std::string& value) override {
+    events_.push_back("number:" + std::to_string(depth) + ":" + value);
+  }
+
+  std::vector<std::string> events_;
+};
+
+class JsonScannerTest : public testing::Test {
+public:
+  JsonScanner::Result scan(const std::string& json, uint64_t max_bytes = 1024) {
+    JsonScanner scanner(callbacks_, max_bytes);
+    scanner.scan(json.c_str(), json.size());
+    return scanner.finish();
+  }
+
+  // Feed the input one byte at a time to exercise every possible chunk boundary.
+  JsonScanner::Result scanBytewise(const std::string& json) {
+    JsonScanner scanner(callbacks_, 1024);
+    for (char c : json) {
+      scanner.scan(&c, 1);
+    }
+    return scanner.finish();
+  }
+
+  RecordingCallbacks callbacks_;
+};
+
+TEST_F(JsonScannerTest, ObjectMembers) {
+  std::string json = R"EOF(
+{
+  "TableName": "locations",
+  "Count": 12.5e1,
+  "Nested": { "a": "b", "c": [1, "2", {"d": -3}] },
+  "Flags": [true, false, null],
+  "Empty": {}
+}
+)EOF";
+
+  std::vector<std::string> expected{"key:1:TableName", "string:1:locations", "key:1:Count",
+                                    "number:1:12.5e1", "key:1:Nested",       "key:2:a",
+                                    "string:2:b",      "key:2:c",            "key:4:d",
+                                    "number:4:-3",     "key:1:Flags",        "key:1:Empty"};
+
+  EXPECT_EQ(JsonScanner::Result::Complete, scan(json));
+  EXPECT_EQ(expected, callbacks_.events_);
+
+  callbacks_.events_.clear();
+  EXPECT_EQ(JsonScanner::Result::Complete, scanBytewise(json));
+  EXPECT_EQ(expected, callbacks_.events_);
+}
+
+TEST_F(JsonScannerTest, Buffer) {
+  Buffer::OwnedImpl buffer;
+  buffer.add("{\"Table");
+  buffer.add("Name\":\"loc");
+  buffer.add("ations\"}");
+
+  JsonScanner scanner(callbacks_, 1024);
+  scanner.scan(buffer);
+  EXPECT_EQ(25U, scanner.bytesScanned());
+  EXPECT_EQ(25U, buffer.length());
+  EXPECT_EQ(JsonScanner::Result::Complete, scanner.finish());
+  EXPECT_EQ((std::vector<std::string>{"key:1:TableName", "string:1:locations"}),
+            callbacks_.events_);
+}
+
+TEST_F(JsonScannerTest, Escapes) {
+  EXPECT_EQ(JsonScanner::Result::Complete,
+            scan(R"EOF({"a\"b": "\\\/\n\u0041\u00e9\u20ac\ud83d\ude00"})EOF"));
+  EXPECT_EQ((std::vector<std::string>{"key:1:a\"b", "string:1:\\/\nA\xc3\xa9\xe2\x82\xac"
+                                                    "\xf0\x9f\x98\x80"}),
+            callbacks_.events_);
+}
+
+TEST_F(JsonScannerTest, TopLevelScalars) {
+  EXPECT_EQ(JsonScanner::Result::Complete, scan("\"hello\""));
+  EXPECT_EQ(JsonScanner::Result::Complete, scan(" 42 "));
+  EXPECT_EQ(JsonScanner::Result::Complete, scan("42"));
+  EXPECT_EQ(JsonScanner::Result::Complete, scan("null"));
+  EXPECT_EQ(JsonScanner::Result::Complete, scan("[]"));
+  EXPECT_TRUE(callbacks_.events_.empty());
+}
+
+TEST_F(JsonScannerTest, LongStrings) {
+  std::string long_key(JsonScanner::MAX_STRING_LENGTH + 1, 'k');
+  std::string long_value(JsonScanner::MAX_STRING_LENGTH + 1, 'v');
+  EXPECT_EQ(JsonScanner::Result::Complete,
+            scan("{\"" + long_key + "\":\"" + long_value + "\",\"a\":\"b\"}"));
+  EXPECT_EQ((std::vector<std::string>{"key:1:", "string:1:", "key:1:a", "string:1:b"}),
+            callbacks_.events_);
+}
+
+TEST_F(JsonScannerTest, Invalid) {
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan("testtest2"));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan("{\"a\":\"b\"}}"));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan("{\"a\":\"b\""));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan("{\"a\" \"b\"}"));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan("{\"a\":\"b\",}"));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan("[1,]"));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan("[1}"));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan("{\"a\":01}"));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan("{\"a\":1.}"));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan("{\"a\":1e}"));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan("{\"a\":tru}"));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan("{\"a\":\"\\x\"}"));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan("{\"a\":\"\\u00g0\"}"));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan("{\"a\":\"\n\"}"));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan("{1:2}"));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan(""));
+  EXPECT_EQ(JsonScanner::Result::Invalid, scan(std::string(JsonScanner::MAX_DEPTH + 1, '[')));
+}
+
+TEST_F(JsonScannerTest, MaxDepth) {
+  std::string json = std::string(JsonScanner::MAX_DEPTH, '[') +
+                     std::string(JsonScanner::MAX_DEPTH, ']');
+  EXPECT_EQ(JsonScanner::Result::Complete, scan(json, json.size()));
+}
+
+TEST_F(JsonScannerTest, Truncated) {
+  std::string json = R"EOF({"TableName": "locations", "Item": {"key": "value"}})EOF";
+
+  EXPECT_EQ(JsonScanner::Result::Truncated, scan(json, 30));
+  EXPECT_EQ((std::vector<std::string>{"key:1:TableName", "string:1:locations"}),
+            callbacks_.events_);
+
+  // Trailing data after a complete value is not inspected past the limit.
+  callbacks_.events_.clear();
+  EXPECT_EQ(JsonScanner::Result::Complete, scan(json + "garbage", json.size()));
+
+  // Nothing is scanned once the limit has been reached.
+  callbacks_.events_.clear();
+  JsonScanner scanner(callbacks_, 10);
+  scanner.scan(json.c_str(), json.size());
+  scanner.scan(json.c_str(), json.size());
+  EXPECT_EQ(10U, scanner.bytesScanned());
+  EXPECT_EQ(JsonScanner::Result::Truncated, scanner.finish());
+  EXPECT_TRUE(callbacks_.events_.empty());
+}
+
+} // namespace Dynamo
+} // namespace Envoy
@@ -1,6 +1,7 @@
 #include <string>
 #include <vector>
 
+#include "common/buffer/buffer_impl.h"
 #include "common/dynamo/dynamo_request_parser.h"
 #include "common/http/header_map_impl.h"
 #include "common/json/json_loader.h"
@@ -261,5 +262,118 @@ TEST(DynamoRequestParser, parsePartitionIds) {
   }
 }
 
+TEST(DynamoRequestBodyScanner, tableDescriptor) {
+  {
+    RequestBodyScanner scanner(1024);
+    Buffer::OwnedImpl data("{\"TableName\":\"Pets\",\"Item\":{\"TableName\":\"Other\"}}");
+    scanner.scan(data);
+    EXPECT_EQ(JsonScanner::Result::Complete, scanner.finish());
+
+    RequestParser::TableDescriptor table = scanner.tableDescriptor("GetItem");
+    EXPECT_EQ("Pets", table.table_name);
+    EXPECT_TRUE(table.is_single_table);
+
+    table = scanner.tableDescriptor("GetInvalidOperation");
+    EXPECT_EQ("", table.table_name);
+    EXPECT_TRUE(table.is_single_table);
+  }
+  {
+    RequestBodyScanner scanner(1024);
+    Buffer::OwnedImpl data(R"EOF(
+    {
+      "RequestItems": {
+        "table_1": { "table_2": "something" },
+        "table_1": { "test2" : "something" }
+      }
+    }
+    )EOF");
+    scanner.scan(data);
+    EXPECT_EQ(JsonScanner::Result::Complete, scanner.finish());
+
+    RequestParser::TableDescriptor table = scanner.tableDescriptor("BatchWriteItem");
+    EXPECT_EQ("table_1", table.table_name);
+    EXPECT_TRUE(table.is_single_table);
+  }
+  {
+    RequestBodyScanner scanner(1024);
+    Buffer::OwnedImpl data(R"EOF(
+    {
+      "RequestItems": {
+        "table_1": { "test1" : "something" },
+        "table_2": { "test2" : "something" }
+      }
+    }
+    )EOF");
+    scanner.scan(data);
+    EXPECT_EQ(JsonScanner::Result::Complete, scanner.finish());
+
+    RequestParser::TableDescriptor table = scanner.tableDescriptor("BatchGetItem");
+    EXPECT_EQ("", table.table_name);
+    EXPECT_FALSE(table.is_single_table);
+  }
+  {
+    // The table name is found before the scan limit is hit.
+    RequestBodyScanner scanner(30);
+    Buffer::OwnedImpl data("{\"TableName\":\"Pets\",\"Item\":{\"key\":\"a very long value\"}}");
+    scanner.scan(data);
+    EXPECT_EQ(30U, scanner.bytesScanned());
+    EXPECT_EQ(JsonScanner::Result::Truncated, scanner.finish());
+    EXPECT_EQ("Pets", scanner.tableDescriptor("PutItem").table_name);
+  }
+}
+
+TEST(DynamoResponseBodyScanner, errorType) {
+  {
+    ResponseBodyScanner scanner(1024);
+    Buffer::OwnedImpl data(
+        "{\"__type\":\"com.amazonaws.dynamodb.v20120810#ValidationException\"}");
+    scanner.scan(data);
+    EXPECT_EQ(JsonScanner::Result::Complete, scanner.finish());
+    EXPECT_EQ("ValidationException", scanner.errorType());
+  }
+  {
+    ResponseBodyScanner scanner(1024);
+    Buffer::OwnedImpl data("{\"__type\":\"UnKnownError\"}");
+    scanner.scan(data);
+    EXPECT_EQ(JsonScanner::Result::Complete, scanner.finish());
+    EXPECT_EQ("", scanner.errorType());
+  }
+}
+
+TEST(DynamoResponseBodyScanner, unprocessedKeysAndPartitions) {
+  ResponseBodyScanner scanner(1024);
+  Buffer::OwnedImpl data(R"EOF(
+  {
+    "UnprocessedKeys": {
+      "table_1": { "test1" : "something" },
+      "table_2": { "test2" : "something" }
+    },
+    "ConsumedCapacity": {
+      "CapacityUnits": 7,
+      "Partitions": {
+        "partition_1" : 0.5,
+        "partition_2" : 3
+      }
+    }
+  }
+  )EOF");
+  scanner.scan(data);
+  EXPECT_EQ(JsonScanner::Result::Complete, scanner.finish());
+
+  EXPECT_EQ((std::vector<std::string>{"table_1", "table_2"}), scanner.unprocessedTables());
+  ASSERT_EQ(2U, scanner.partitions().size());
+  EXPECT_EQ("partition_1", scanner.partitions()[0].partition_id_);
+  EXPECT_EQ(1U, scanner.partitions()[0].capacity_);
+  EXPECT_EQ("partition_2", scanner.partitions()[1].partition_id_);
+  EXPECT_EQ(3U, scanner.partitions()[1].capacity_);
+}
+
+TEST(DynamoResponseBodyScanner, invalid) {
+  ResponseBodyScanner scanner(1024);
+  Buffer::OwnedImpl data("{\"UnprocessedKeys\":{}}}");
+  scanner.scan(data);
+  EXPECT_EQ(JsonScanner::Result::Invalid, scanner.finish());
+}
+
 } // namespace Dynamo
 } // namespace Envoy
@@ -1,6 +1,10 @@
+#include <chrono>
 #include <functional>
+#include <thread>
+#include <vector>
 
 #include "common/event/dispatcher_impl.h"
+#include "common/stats/stats_impl.h"
 
 #include "test/mocks/common.h"
 
@@ -51,5 +55,130 @@ TEST(DispatcherImplTest, DeferredDelete) {
   dispatcher.clearDeferredDeleteList();
 }
 
+TEST(DispatcherImplTest, Post) {
+  DispatcherImpl dispatcher;
+  Stats::IsolatedStoreImpl stats_store;
+  dispatcher.initializeStats(stats_store, "test.");
+
+  // Callbacks posted before the loop runs, including one posted by a callback.
+  std::vector<int> order;
+  dispatcher.post([&]() -> void {
+    order.push_back(1);
+    dispatcher.post([&]() -> void { order.push_back(3); });
+  });
+  dispatcher.post([&]() -> void { order.push_back(2); });
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), order);
+  EXPECT_EQ(3, stats_store.counter("test.dispatcher.post_callbacks").value());
+  EXPECT_EQ(0, stats_store.gauge("test.dispatcher.post_queue_depth").value());
+
+  // Callbacks posted from other threads wake up the loop. The timer keeps the loop running until
+  // the threads have posted.
+  TimerPtr keep_alive = dispatcher.createTimer([]() -> void {});
+  keep_alive->enableTimer(std::chrono::seconds(60));
+  const uint32_t num_threads = 4;
+  const uint32_t num_posts = 1000;
+  uint32_t received = 0;
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < num_threads; i++) {
+    threads.emplace_back([&]() -> void {
+      for (uint32_t j = 0; j < num_posts; j++) {
+        dispatcher.post([&]() -> void {
+          if (++received == num_threads * num_posts) {
+            dispatcher.exit();
+          }
+        });
+      }
+    });
+  }
+  dispatcher.run(Dispatcher::RunType::Block);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * num_posts, received);
+  EXPECT_EQ(3 + num_threads * num_posts,
+            stats_store.counter("test.dispatcher.post_callbacks").value());
+}
+
+TEST(DispatcherImplTest, Timer) {
+  DispatcherImpl dispatcher;
+  std::vector<int> order;
+  MonotonicTime start = std::chrono::steady_clock::now();
+  MonotonicTime fired;
+
+  TimerPtr timer1 = dispatcher.createTimer([&]() -> void { order.push_back(1); });
+  TimerPtr timer2 = dispatcher.createTimer([&]() -> void {
+    order.push_back(2);
+    fired = std::chrono::steady_clock::now();
+    dispatcher.exit();
+  });
+  TimerPtr timer3 = dispatcher.createTimer([&]() -> void { order.push_back(3); });
+  TimerPtr timer4 = dispatcher.createTimer([&]() -> void { order.push_back(4); });
+
+  timer2->enableTimer(std::chrono::milliseconds(20));
+  timer1->enableTimer(std::chrono::milliseconds(5));
+  // Re-armed, only the last expiry counts.
+  timer3->enableTimer(std::chrono::milliseconds(1));
+  timer3->enableTimer(std::chrono::milliseconds(10));
+  // Disabled before it fires, both when armed for later and for the current loop iteration.
+  timer4->enableTimer(std::chrono::milliseconds(2));
+  timer4->disableTimer();
+  timer4->enableTimer(std::chrono::milliseconds(0));
+  timer4->disableTimer();
+
+  dispatcher.run(Dispatcher::RunType::Block);
+  EXPECT_EQ((std::vector<int>{1, 3, 2}), order);
+  // Timers never fire early.
+  EXPECT_LE(std::chrono::milliseconds(20), fired - start);
+}
+
+TEST(DispatcherImplTest, TimerZeroDuration) {
+  DispatcherImpl dispatcher;
+  ReadyWatcher watcher;
+  TimerPtr timer = dispatcher.createTimer([&]() -> void { watcher.ready(); });
+
+  // A zero duration runs in the next loop iteration, and replaces a pending expiry.
+  timer->enableTimer(std::chrono::milliseconds(1000));
+  timer->enableTimer(std::chrono::milliseconds(0));
+  EXPECT_CALL(watcher, ready());
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+}
+
+TEST(DispatcherImplTest, LoopStats) {
+  DispatcherImpl dispatcher;
+  Stats::IsolatedStoreImpl stats_store;
+  dispatcher.initializeStats(stats_store, "test.");
+
+  // Three timers firing in at least two iterations, the last one also runs a deferred deletion.
+  uint32_t fired = 0;
+  TimerPtr timer1 = dispatcher.createTimer([&]() -> void { fired++; });
+  TimerPtr timer2 = dispatcher.createTimer([&]() -> void { fired++; });
+  TimerPtr timer3 = dispatcher.createTimer([&]() -> void {
+    fired++;
+    dispatcher.deferredDelete(DeferredDeletablePtr{new TestDeferredDeletable([]() -> void {})});
+    dispatcher.exit();
+  });
+  timer1->enableTimer(std::chrono::milliseconds(1));
+  timer2->enableTimer(std::chrono::milliseconds(1));
+  timer3->enableTimer(std::chrono::milliseconds(10));
+  dispatcher.run(Dispatcher::RunType::Block);
+  EXPECT_EQ(3U, fired);
+
+  const uint64_t iterations = stats_store.counter("test.dispatcher.loop_iterations").value();
+  EXPECT_LE(2U, iterations);
+  // The timer wheel and the deferred deletion are events of their own.
+  EXPECT_LE(3U, stats_store.counter("test.dispatcher.loop_events").value());
+  // Most of the time is spent waiting for the timers.
+  EXPECT_LE(9000U, stats_store.counter("test.dispatcher.loop_poll_wait_us").value());
+
+  // exit() only ends the current run.
+  TimerPtr timer4 = dispatcher.createTimer([&]() -> void { dispatcher.exit(); });
+  timer4->enableTimer(std::chrono::milliseconds(1));
+  dispatcher.run(Dispatcher::RunType::Block);
+  EXPECT_LT(iterations, stats_store.counter("test.dispatcher.loop_iterations").value());
+  // The deferred deletion has run by now, and is only counted when the window ends.
+  EXPECT_EQ(1U, stats_store.counter("test.dispatcher.deferred_deleted").value());
+}
+
 } // namespace Event
 } // namespace Envoy
@@ -0,0 +1,227 @@
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "common/event/timer_wheel.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Event {
+
+class TestEntry : public TimerWheel::Entry {
+public:
+  TestEntry(std::vector<std::pair<uint64_t, TestEntry*>>& fired, TimerWheel& wheel)
+      : fired_(fired), wheel_(wheel) {}
+
+  std::function<void()> on_expired_;
+
+private:
+  // TimerWheel::Entry
+  void onExpired() override {
+    fired_.emplace_back(wheel_.currentTick(), this);
+    if (on_expired_) {
+      on_expired_();
+    }
+  }
+
+  std::vector<std::pair<uint64_t, TestEntry*>>& fired_;
+  TimerWheel& wheel_;
+};
+
+class TimerWheelTest : public testing::Test {
+public:
+  TestEntry& newEntry() {
+    entries_.emplace_back(new TestEntry(fired_, wheel_));
+    return *entries_.back();
+  }
+
+  std::vector<std::pair<uint64_t, TestEntry*>> fired_;
+  std::vector<std::unique_ptr<TestEntry>> entries_;
+  // Destroyed first, entries may still be scheduled at the end of a test.
+  TimerWheel wheel_;
+};
+
+TEST_F(TimerWheelTest, Empty) {
+  EXPECT_FALSE(wheel_.nextWakeup().valid());
+  wheel_.advance(1000);
+  EXPECT_EQ(1000U, wheel_.currentTick());
+  EXPECT_FALSE(wheel_.nextWakeup().valid());
+}
+
+TEST_F(TimerWheelTest, ExpiresInOrder) {
+  TestEntry& a = newEntry();
+  TestEntry& b = newEntry();
+  TestEntry& c = newEntry();
+  TestEntry& d = newEntry();
+  wheel_.schedule(a, 300);
+  wheel_.schedule(b, 5);
+  wheel_.schedule(c, 100000);
+  wheel_.schedule(d, 255);
+  EXPECT_TRUE(a.scheduled());
+
+  EXPECT_EQ(5U, wheel_.nextWakeup().value());
+  wheel_.advance(4);
+  EXPECT_TRUE(fired_.empty());
+
+  wheel_.advance(1000000);
+  ASSERT_EQ(4U, fired_.size());
+  EXPECT_EQ(std::make_pair(5UL, &b), fired_[0]);
+  EXPECT_EQ(std::make_pair(255UL, &d), fired_[1]);
+  EXPECT_EQ(std::make_pair(300UL, &a), fired_[2]);
+  EXPECT_EQ(std::make_pair(100000UL, &c), fired_[3]);
+  EXPECT_FALSE(a.scheduled());
+  EXPECT_FALSE(wheel_.nextWakeup().valid());
+}
+
+TEST_F(TimerWheelTest, CancelAndReschedule) {
+  TestEntry& a = newEntry();
+  TestEntry& b = newEntry();
+  wheel_.schedule(a, 10);
+  wheel_.schedule(b, 20);
+  wheel_.cancel(a);
+  EXPECT_FALSE(a.scheduled());
+  // Cancelling twice is fine.
+  wheel_.cancel(a);
+  wheel_.schedule(b, 5000);
+  EXPECT_EQ(5000U, b.expiry());
+
+  wheel_.advance(4999);
+  EXPECT_TRUE(fired_.empty());
+  wheel_.advance(5000);
+  ASSERT_EQ(1U, fired_.size());
+  EXPECT_EQ(std::make_pair(5000UL, &b), fired_[0]);
+}
+
+TEST_F(TimerWheelTest, NextWakeupIsCascadeForFarEntries) {
+  TestEntry& a = newEntry();
+  wheel_.schedule(a, 1000);
+  // The entry sits in the second level until the 256 ticks block it is due in.
+  EXPECT_EQ(768U, wheel_.nextWakeup().value());
+  wheel_.advance(768);
+  EXPECT_TRUE(fired_.empty());
+  EXPECT_EQ(1000U, wheel_.nextWakeup().value());
+}
+
+TEST_F(TimerWheelTest, BeyondSpan) {
+  TestEntry& a = newEntry();
+  TestEntry& b = newEntry();
+  const uint64_t far = 3ULL << 32;
+  wheel_.advance(63ULL << 26);
+  wheel_.schedule(a, far);
+  wheel_.schedule(b, far + 1);
+
+  uint64_t wakeups = 0;
+  while (fired_.size() < 2) {
+    ASSERT_TRUE(wheel_.nextWakeup().valid());
+    wheel_.advance(wheel_.nextWakeup().value());
+    wakeups++;
+  }
+  EXPECT_EQ(std::make_pair(far, &a), fired_[0]);
+  EXPECT_EQ(std::make_pair(far + 1, &b), fired_[1]);
+  // Parking and cascading only, no wakeup for every top level slot.
+  EXPECT_GT(20U, wakeups);
+}
+
+TEST_F(TimerWheelTest, CallbacksModifyWheel) {
+  TestEntry& a = newEntry();
+  TestEntry& b = newEntry();
+  TestEntry& c = newEntry();
+  wheel_.schedule(a, 10);
+  wheel_.schedule(b, 10);
+  wheel_.schedule(c, 10);
+
+  // a cancels b, which is due at the same tick, and reschedules itself.
+  a.on_expired_ = [&]() -> void {
+    wheel_.cancel(b);
+    wheel_.schedule(a, 11);
+    a.on_expired_ = nullptr;
+  };
+  wheel_.advance(20);
+  ASSERT_EQ(3U, fired_.size());
+  EXPECT_EQ(std::make_pair(10UL, &a), fired_[0]);
+  EXPECT_EQ(std::make_pair(10UL, &c), fired_[1]);
+  EXPECT_EQ(std::make_pair(11UL, &a), fired_[2]);
+}
+
+TEST_F(TimerWheelTest, DestroyWithScheduledEntries) {
+  std::unique_ptr<TimerWheel> wheel(new TimerWheel());
+  TestEntry entry(fired_, *wheel);
+  wheel->schedule(entry, 1000);
+  wheel.reset();
+  EXPECT_FALSE(entry.scheduled());
+}
+
+// Random operations checked against a map of expiry to entries.
+TEST_F(TimerWheelTest, Random) {
+  std::mt19937_64 random(1);
+  const size_t num_entries = 1000;
+  for (size_t i = 0; i < num_entries; i++) {
+    newEntry();
+  }
+
+  std::multimap<uint64_t, TestEntry*> expected;
+  std::map<TestEntry*, uint64_t> expiries;
+  auto remove = [&](TestEntry& entry) -> void {
+    auto it = expiries.find(&entry);
+    if (it == expiries.end()) {
+      return;
+    }
+    auto range = expected.equal_range(it->second);
+    for (auto i = range.first; i != range.second; i++) {
+      if (i->second == &entry) {
+        expected.erase(i);
+        break;
+      }
+    }
+    expiries.erase(it);
+  };
+  for (size_t round = 0; round < 20000; round++) {
+    TestEntry& entry = *entries_[random() % num_entries];
+    switch (random() % 4) {
+    case 0:
+    case 1: {
+      // Mostly short delays, with the odd one spanning several levels.
+      const uint64_t delay = 1 + (random() % 8 == 0 ? random() % (1ULL << 30) : random() % 2000);
+      remove(entry);
+      wheel_.schedule(entry, wheel_.currentTick() + delay);
+      expiries[&entry] = wheel_.currentTick() + delay;
+      expected.emplace(wheel_.currentTick() + delay, &entry);
+      break;
+    }
+    case 2:
+      remove(entry);
+      wheel_.cancel(entry);
+      break;
+    case 3: {
+      const uint64_t tick = wheel_.currentTick() + random() % 500;
+      fired_.clear();
+      wheel_.advance(tick);
+      std::vector<uint64_t> due;
+      while (!expected.empty() && expected.begin()->first <= tick) {
+        due.push_back(expected.begin()->first);
+        expiries.erase(expected.begin()->second);
+        expected.erase(expected.begin());
+      }
+      ASSERT_EQ(due.size(), fired_.size());
+      for (size_t i = 0; i < due.size(); i++) {
+        EXPECT_EQ(due[i], fired_[i].first);
+        EXPECT_EQ(due[i], fired_[i].second->expiry());
+      }
+      break;
+    }
+    }
+  }
+
+  // Drain what is left.
+  fired_.clear();
+  wheel_.advance(UINT64_MAX >> 1);
+  EXPECT_EQ(expected.size(), fired_.size());
+  EXPECT_FALSE(wheel_.nextWakeup().valid());
+}
+
+} // namespace Event
+} // namespace Envoy
@@ -1,4 +1,6 @@
 #include <chrono>
+#include <map>
+#include <memory>
 #include <string>
 
 #include "common/api/os_sys_calls_impl.h"
@@ -33,7 +35,8 @@ TEST(FileSystemImpl, BadFile) {
   Api::OsSysCallsImpl os_sys_calls;
   EXPECT_CALL(dispatcher, createTimer_(_));
   EXPECT_THROW(Filesystem::FileImpl("", dispatcher, lock, os_sys_calls, store,
-                                    std::chrono::milliseconds(10000)),
+                                    std::chrono::milliseconds(10000),
+                                    std::make_shared<Filesystem::FlushThread>()),
                EnvoyException);
 }
 
@@ -71,7 +74,8 @@ TEST(FileSystemImpl, flushToLogFilePeriodically) {
 
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).WillOnce(Return(5));
   Filesystem::FileImpl file("", dispatcher, mutex, os_sys_calls, stats_store,
-                            std::chrono::milliseconds(40));
+                            std::chrono::milliseconds(40),
+                            std::make_shared<Filesystem::FlushThread>());
 
   EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(40)));
   EXPECT_CALL(os_sys_calls, write_(_, _, _))
@@ -124,7 +128,8 @@ TEST(FileSystemImpl, flushToLogFileOnDemand) {
 
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).WillOnce(Return(5));
   Filesystem::FileImpl file("", dispatcher, mutex, os_sys_calls, stats_store,
-                            std::chrono::milliseconds(40));
+                            std::chrono::milliseconds(40),
+                            std::make_shared<Filesystem::FlushThread>());
 
   EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(40)));
 
@@ -198,7 +203,8 @@ TEST(FileSystemImpl, reopenFile) {
   Sequence sq;
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).InSequence(sq).WillOnce(Return(5));
   Filesystem::FileImpl file("", dispatcher, mutex, os_sys_calls, stats_store,
-                            std::chrono::milliseconds(40));
+                            std::chrono::milliseconds(40),
+                            std::make_shared<Filesystem::FlushThread>());
 
   EXPECT_CALL(os_sys_calls, write_(_, _, _))
       .InSequence(sq)
@@ -267,7 +273,8 @@ TEST(FilesystemImpl, reopenThrows) {
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).InSequence(sq).WillOnce(Return(5));
 
   Filesystem::FileImpl file("", dispatcher, mutex, os_sys_calls, stats_store,
-                            std::chrono::milliseconds(40));
+                            std::chrono::milliseconds(40),
+                            std::make_shared<Filesystem::FlushThread>());
   EXPECT_CALL(os_sys_calls, close(5)).InSequence(sq);
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).InSequence(sq).WillOnce(Return(-1));
 
@@ -303,7 +310,8 @@ TEST(FilesystemImpl, bigDataChunkShouldBeFlushedWithoutTimer) {
   NiceMock<Api::MockOsSysCalls> os_sys_calls;
 
   Filesystem::FileImpl file("", dispatcher, mutex, os_sys_calls, stats_store,
-                            std::chrono::milliseconds(40));
+                            std::chrono::milliseconds(40),
+                            std::make_shared<Filesystem::FlushThread>());
 
   EXPECT_CALL(os_sys_calls, write_(_, _, _))
       .WillOnce(Invoke([](int fd, const void* buffer, size_t num_bytes) -> ssize_t {
@@ -348,4 +356,78 @@ TEST(FilesystemImpl, bigDataChunkShouldBeFlushedWithoutTimer) {
     }
   }
 }
+
+TEST(FilesystemImpl, filesShareFlushThread) {
+  NiceMock<Event::MockDispatcher> dispatcher;
+  Thread::MutexBasicLockable mutex;
+  Stats::IsolatedStoreImpl stats_store;
+  NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  Filesystem::FlushThreadSharedPtr flush_thread = std::make_shared<Filesystem::FlushThread>();
+  std::map<int, std::string> written;
+
+  EXPECT_CALL(os_sys_calls, open_(_, _, _)).WillOnce(Return(5)).WillOnce(Return(6));
+  EXPECT_CALL(os_sys_calls, write_(_, _, _))
+      .Times(4)
+      .WillRepeatedly(Invoke([&](int fd, const void* buffer, size_t num_bytes) -> ssize_t {
+        written[fd] = std::string(reinterpret_cast<const char*>(buffer), num_bytes);
+        return num_bytes;
+      }));
+
+  {
+    NiceMock<Event::MockTimer>* timer1 = new NiceMock<Event::MockTimer>(&dispatcher);
+    Filesystem::FileImpl file1("/var/log/envoy/a.log", dispatcher, mutex, os_sys_calls,
+                               stats_store, std::chrono::milliseconds(40), flush_thread);
+    NiceMock<Event::MockTimer>* timer2 = new NiceMock<Event::MockTimer>(&dispatcher);
+    Filesystem::FileImpl file2("/var/log/envoy/b.log", dispatcher, mutex, os_sys_calls,
+                               stats_store, std::chrono::milliseconds(40), flush_thread);
+
+    // The first write to each file is flushed right away.
+    file1.write("a1\n");
+    file2.write("b1\n");
+    {
+      std::unique_lock<Thread::BasicLockable> lock(os_sys_calls.write_mutex_);
+      while (os_sys_calls.num_writes_ != 2) {
+        os_sys_calls.write_event_.wait(os_sys_calls.write_mutex_);
+      }
+    }
+
+    // After that lines are buffered until a flush, and go out in one write.
+    file1.write("a2\n");
+    file1.write("a3\n");
+    file2.write("b2\n");
+    timer1->callback_();
+    timer2->callback_();
+
+    std::unique_lock<Thread::BasicLockable> lock(os_sys_calls.write_mutex_);
+    while (os_sys_calls.num_writes_ != 4) {
+      os_sys_calls.write_event_.wait(os_sys_calls.write_mutex_);
+    }
+  }
+
+  // Both files are gone, so the thread is done with them.
+  EXPECT_EQ("a2\na3\n", written[5]);
+  EXPECT_EQ("b2\n", written[6]);
+  const std::string prefix1 = Filesystem::fileStatsPrefix("/var/log/envoy/a.log");
+  const std::string prefix2 = Filesystem::fileStatsPrefix("/var/log/envoy/b.log");
+  EXPECT_EQ(2UL, stats_store.counter(prefix1 + "writes").value());
+  EXPECT_EQ(2UL, stats_store.counter(prefix2 + "writes").value());
+  EXPECT_EQ(0UL, stats_store.gauge(prefix1 + "write_queue_bytes").value());
+}
+
+TEST(FilesystemImpl, fileStatsPrefix) {
+  const std::string prefix = Filesystem::fileStatsPrefix("/var/log/envoy/a.log");
+  EXPECT_EQ(0U, prefix.find("filesystem.file.var_log_envoy_a_log_"));
+  EXPECT_EQ('.', prefix.back());
+
+  // Paths that look the same once sanitized get different stats.
+  EXPECT_NE(prefix, Filesystem::fileStatsPrefix("/var/log/envoy/a_log"));
+
+  // Long paths are cut so that the stat names stay unique and are not truncated.
+  const std::string directory = "/var/log/" + std::string(200, 'd');
+  const std::string long_prefix1 = Filesystem::fileStatsPrefix(directory + "/a.log");
+  const std::string long_prefix2 = Filesystem::fileStatsPrefix(directory + "/b.log");
+  EXPECT_NE(long_prefix1, long_prefix2);
+  EXPECT_EQ(Stats::RawStatData::maxNameLength(), (long_prefix1 + "write_queue_bytes").size());
+  EXPECT_NE(std::string::npos, long_prefix1.find("d_a_log_"));
+}
 } // namespace Envoy
@@ -0,0 +1,169 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/filter/tcp_proxy_route_index.h"
+#include "common/network/address_impl.h"
+#include "common/network/cidr_range.h"
+#include "common/network/utility.h"
+
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Filter {
+
+class TcpProxyRouteIndexTest : public testing::Test {
+public:
+  struct Route {
+    Network::Address::IpList source_ips_;
+    Network::PortRangeList source_port_ranges_;
+    Network::Address::IpList destination_ips_;
+    Network::PortRangeList destination_port_ranges_;
+  };
+
+  void addRoute(const std::vector<std::string>& source_ips, const std::string& source_ports,
+                const std::vector<std::string>& destination_ips,
+                const std::string& destination_ports) {
+    routes_.emplace_back();
+    Route& route = routes_.back();
+    route.source_ips_ = Network::Address::IpList(source_ips);
+    route.destination_ips_ = Network::Address::IpList(destination_ips);
+    if (!source_ports.empty()) {
+      Network::Utility::parsePortRangeList(source_ports, route.source_port_ranges_);
+    }
+    if (!destination_ports.empty()) {
+      Network::Utility::parsePortRangeList(destination_ports, route.destination_port_ranges_);
+    }
+  }
+
+  void buildIndex() {
+    std::vector<TcpProxyRouteIndex::RouteCriteria> criteria;
+    for (const Route& route : routes_) {
+      criteria.push_back({route.source_ips_, route.source_port_ranges_, route.destination_ips_,
+                          route.destination_port_ranges_});
+    }
+    index_.reset(new TcpProxyRouteIndex(criteria));
+  }
+
+  // The route table semantics the index has to preserve: the first route whose criteria all match.
+  Optional<uint32_t> linearMatch(const Network::Address::Instance& remote,
+                                 const Network::Address::Instance& local) {
+    for (uint32_t i = 0; i < routes_.size(); i++) {
+      const Route& route = routes_[i];
+      if ((route.source_port_ranges_.empty() ||
+           Network::Utility::portInRangeList(remote, route.source_port_ranges_)) &&
+          (route.source_ips_.empty() || route.source_ips_.contains(remote)) &&
+          (route.destination_port_ranges_.empty() ||
+           Network::Utility::portInRangeList(local, route.destination_port_ranges_)) &&
+          (route.destination_ips_.empty() || route.destination_ips_.contains(local))) {
+        return Optional<uint32_t>(i);
+      }
+    }
+    return Optional<uint32_t>();
+  }
+
+  Optional<uint32_t> match(const std::string& remote, uint32_t remote_port,
+                           const std::string& local, uint32_t local_port) {
+    Network::Address::InstanceConstSharedPtr remote_address =
+        Network::Utility::parseInternetAddress(remote, remote_port);
+    Network::Address::InstanceConstSharedPtr local_address =
+        Network::Utility::parseInternetAddress(local, local_port);
+    Optional<uint32_t> result = index_->firstMatch(*remote_address, *local_address);
+    EXPECT_EQ(linearMatch(*remote_address, *local_address), result);
+    return result;
+  }
+
+  std::vector<Route> routes_;
+  std::unique_ptr<TcpProxyRouteIndex> index_;
+};
+
+TEST_F(TcpProxyRouteIndexTest, Empty) {
+  buildIndex();
+  EXPECT_FALSE(match("1.2.3.4", 80, "5.6.7.8", 443).valid());
+}
+
+TEST_F(TcpProxyRouteIndexTest, FirstMatchWins) {
+  addRoute({}, "", {"10.0.0.0/8"}, "");
+  addRoute({}, "", {"10.1.0.0/16"}, "");
+  addRoute({"192.168.0.0/16"}, "", {"10.1.2.0/24"}, "443");
+  addRoute({}, "1024-65535", {"10.1.2.3/32"}, "");
+  addRoute({"::/0"}, "", {}, "");
+  addRoute({}, "", {}, "");
+  buildIndex();
+
+  // The /8 route comes first, so it shadows every more specific route below it.
+  EXPECT_EQ(Optional<uint32_t>(0), match("192.168.1.1", 2000, "10.1.2.3", 443));
+  EXPECT_EQ(Optional<uint32_t>(5), match("192.168.1.1", 2000, "11.1.2.3", 443));
+  EXPECT_EQ(Optional<uint32_t>(4), match("::1", 2000, "::2", 443));
+}
+
+TEST_F(TcpProxyRouteIndexTest, MoreSpecificRoutesFirst) {
+  addRoute({"192.168.0.0/16"}, "", {"10.1.2.0/24"}, "443");
+  addRoute({}, "1024-65535", {"10.1.2.3/32"}, "");
+  addRoute({}, "", {"10.1.0.0/16", "2001:abcd::/64"}, "");
+  addRoute({}, "", {"10.0.0.0/8"}, "1-1023,8080");
+  addRoute({"0.0.0.0/0"}, "", {}, "");
+  buildIndex();
+
+  EXPECT_EQ(Optional<uint32_t>(0), match("192.168.1.1", 2000, "10.1.2.3", 443));
+  EXPECT_EQ(Optional<uint32_t>(1), match("192.169.1.1", 2000, "10.1.2.3", 443));
+  EXPECT_EQ(Optional<uint32_t>(2), match("192.169.1.1", 1000, "10.1.2.3", 443));
+  EXPECT_EQ(Optional<uint32_t>(2), match("2001:abcd::1", 1000, "2001:abcd::2", 443));
+  EXPECT_FALSE(match("2001:abcd::1", 1000, "2001:abce::2", 443).valid());
+  EXPECT_EQ(Optional<uint32_t>(3), match("192.169.1.1", 1000, "10.2.2.3", 443));
+  EXPECT_EQ(Optional<uint32_t>(3), match("192.169.1.1", 1000, "10.2.2.3", 8080));
+  EXPECT_EQ(Optional<uint32_t>(4), match("192.169.1.1", 1000, "10.2.2.3", 8081));
+  EXPECT_EQ(Optional<uint32_t>(4), match("1.1.1.1", 1000, "1.1.1.1", 1));
+}
+
+TEST_F(TcpProxyRouteIndexTest, NonIpAddresses) {
+  addRoute({"0.0.0.0/0"}, "", {}, "");
+  addRoute({}, "", {}, "1-65535");
+  addRoute({}, "", {}, "");
+  buildIndex();
+
+  Network::Address::PipeInstance pipe("/foo");
+  EXPECT_EQ(Optional<uint32_t>(2), index_->firstMatch(pipe, pipe));
+}
+
+// Compare against the linear scan for random route tables and addresses drawn from a small space,
+// so that overlapping ranges and matches are common.
+TEST_F(TcpProxyRouteIndexTest, RandomTables) {
+  std::mt19937 random(42);
+  auto randomIp = [&]() -> std::string {
+    return fmt::format("10.{}.{}.{}", random() % 4, random() % 4, random() % 8);
+  };
+  auto randomPorts = [&]() -> std::string {
+    if (random() % 2) {
+      return "";
+    }
+    const uint32_t min = random() % 16;
+    return fmt::format("{}-{},{}", min, min + random() % 8, random() % 16);
+  };
+  auto randomIps = [&]() -> std::vector<std::string> {
+    std::vector<std::string> ips;
+    const uint32_t count = random() % 3;
+    for (uint32_t i = 0; i < count; i++) {
+      ips.push_back(fmt::format("{}/{}", randomIp(), 8 + random() % 25));
+    }
+    return ips;
+  };
+
+  for (uint32_t table = 0; table < 20; table++) {
+    routes_.clear();
+    const uint32_t num_routes = 1 + random() % 150;
+    for (uint32_t i = 0; i < num_routes; i++) {
+      addRoute(randomIps(), randomPorts(), randomIps(), randomPorts());
+    }
+    buildIndex();
+
+    for (uint32_t i = 0; i < 500; i++) {
+      match(randomIp(), random() % 16, randomIp(), random() % 16);
+    }
+  }
+}
+
+} // namespace Filter
+} // namespace Envoy
@@ -0,0 +1,134 @@
+// Compares TCP proxy route lookups through TcpProxyRouteIndex with a linear scan of the route
+// table over synthetic tables of CIDR based routes.
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/filter/tcp_proxy_route_index.h"
+#include "common/network/cidr_range.h"
+#include "common/network/utility.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Filter {
+namespace {
+
+struct Route {
+  Network::Address::IpList source_ips_;
+  Network::PortRangeList source_port_ranges_;
+  Network::Address::IpList destination_ips_;
+  Network::PortRangeList destination_port_ranges_;
+};
+
+bool linearMatch(const std::vector<Route>& routes, const Network::Address::Instance& remote,
+                 const Network::Address::Instance& local, uint32_t& match) {
+  for (uint32_t i = 0; i < routes.size(); i++) {
+    const Route& route = routes[i];
+    if ((route.source_port_ranges_.empty() ||
+         Network::Utility::portInRangeList(remote, route.source_port_ranges_)) &&
+        (route.source_ips_.empty() || route.source_ips_.contains(remote)) &&
+        (route.destination_port_ranges_.empty() ||
+         Network::Utility::portInRangeList(local, route.destination_port_ranges_)) &&
+        (route.destination_ips_.empty() || route.destination_ips_.contains(local))) {
+      match = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string randomIp(std::mt19937& random) {
+  return fmt::format("10.{}.{}.{}", random() % 256, random() % 256, random() % 256);
+}
+
+// Roughly what a large table looks like: mostly destination subnets, some of them restricted to
+// a source subnet or a port range, with a catch all route at the end.
+std::vector<Route> buildRoutes(uint32_t num_routes, std::mt19937& random) {
+  std::vector<Route> routes(num_routes);
+  for (uint32_t i = 0; i + 1 < num_routes; i++) {
+    Route& route = routes[i];
+    route.destination_ips_ = Network::Address::IpList(
+        std::vector<std::string>{fmt::format("{}/{}", randomIp(random), 16 + random() % 17)});
+    if (random() % 4 == 0) {
+      route.source_ips_ = Network::Address::IpList(
+          std::vector<std::string>{fmt::format("{}/{}", randomIp(random), 8 + random() % 17)});
+    }
+    if (random() % 4 == 0) {
+      const uint32_t port = 1 + random() % 60000;
+      Network::Utility::parsePortRangeList(fmt::format("{}-{}", port, port + random() % 1000),
+                                           route.destination_port_ranges_);
+    }
+  }
+  return routes;
+}
+
+void run(uint32_t num_routes) {
+  const uint32_t num_lookups = 100000;
+  std::mt19937 random(num_routes);
+  std::vector<Route> routes = buildRoutes(num_routes, random);
+
+  std::vector<TcpProxyRouteIndex::RouteCriteria> criteria;
+  for (const Route& route : routes) {
+    criteria.push_back({route.source_ips_, route.source_port_ranges_, route.destination_ips_,
+                        route.destination_port_ranges_});
+  }
+  auto build_start = std::chrono::steady_clock::now();
+  TcpProxyRouteIndex index(criteria);
+  auto build_end = std::chrono::steady_clock::now();
+
+  std::vector<Network::Address::InstanceConstSharedPtr> remote_addresses;
+  std::vector<Network::Address::InstanceConstSharedPtr> local_addresses;
+  for (uint32_t i = 0; i < 1024; i++) {
+    remote_addresses.push_back(
+        Network::Utility::parseInternetAddress(randomIp(random), 1024 + random() % 60000));
+    local_addresses.push_back(
+        Network::Utility::parseInternetAddress(randomIp(random), 1 + random() % 65535));
+  }
+
+  uint64_t checksum = 0;
+  auto index_start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < num_lookups; i++) {
+    Optional<uint32_t> match = index.firstMatch(*remote_addresses[i % remote_addresses.size()],
+                                                *local_addresses[i % local_addresses.size()]);
+    checksum += match.valid() ? match.value() : 0;
+  }
+  auto index_end = std::chrono::steady_clock::now();
+
+  uint64_t linear_checksum = 0;
+  auto linear_start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < num_lookups; i++) {
+    uint32_t match;
+    if (linearMatch(routes, *remote_addresses[i % remote_addresses.size()],
+                    *local_addresses[i % local_addresses.size()], match)) {
+      linear_checksum += match;
+    }
+  }
+  auto linear_end = std::chrono::steady_clock::now();
+
+  auto per_lookup = [num_lookups](std::chrono::steady_clock::duration duration) -> double {
+    return std::chrono::duration<double, std::nano>(duration).count() / num_lookups;
+  };
+  const auto build_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(build_end - build_start).count();
+  std::cout << fmt::format("routes={} build={}us index={:.1f}ns/lookup linear={:.1f}ns/lookup{}",
+                           num_routes, build_us, per_lookup(index_end - index_start),
+                           per_lookup(linear_end - linear_start),
+                           checksum == linear_checksum ? "" : " MISMATCH")
+            << std::endl;
+}
+
+} // namespace
+} // namespace Filter
+} // namespace Envoy
+
+int main() {
+  for (uint32_t num_routes : {1, 10, 100, 1000, 5000}) {
+    Envoy::Filter::run(num_routes);
+  }
+  return 0;
+}
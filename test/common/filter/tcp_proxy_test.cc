@@ -20,6 +20,7 @@
 #include "gtest/gtest.h"
 
 using testing::NiceMock;
+using testing::Ref;
 using testing::Return;
 using testing::ReturnRef;
 using testing::SaveArg;
@@ -427,6 +428,59 @@ TEST_F(TcpProxyTest, UpstreamDisconnect) {
   upstream_connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
 }
 
+TEST_F(TcpProxyTest, Splice) {
+  std::string json = R"EOF(
+    {
+      "stat_prefix": "name",
+      "splice": true,
+      "route_config": {
+        "routes": [
+          {
+            "cluster": "fake_cluster"
+          }
+        ]
+      }
+    }
+    )EOF";
+
+  Json::ObjectSharedPtr config = Json::Factory::loadFromString(json);
+  config_.reset(
+      new TcpProxyConfig(*config, cluster_manager_,
+                         cluster_manager_.thread_local_cluster_.cluster_.info_->stats_store_));
+  EXPECT_TRUE(config_->splice());
+  setup(true);
+
+  // Data received before the upstream connection is established is buffered as usual.
+  Buffer::OwnedImpl buffer("hello");
+  EXPECT_CALL(*upstream_connection_, write(BufferEqual(&buffer)));
+  filter_->onData(buffer);
+
+  EXPECT_CALL(filter_callbacks_.connection_, spliceTo(Ref(*upstream_connection_)))
+      .WillOnce(Return(true));
+  EXPECT_CALL(*upstream_connection_, spliceTo(Ref(filter_callbacks_.connection_)))
+      .WillOnce(Return(false));
+  upstream_connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_EQ(1U, config_->stats().downstream_cx_spliced_.value());
+
+  // The upstream direction could not be spliced and still goes through the filter.
+  Buffer::OwnedImpl response("world");
+  EXPECT_CALL(filter_callbacks_.connection_, write(BufferEqual(&response)));
+  upstream_read_filter_->onData(response);
+
+  EXPECT_CALL(filter_callbacks_.connection_, close(Network::ConnectionCloseType::FlushWrite));
+  upstream_connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+}
+
+TEST_F(TcpProxyTest, SpliceDisabledByDefault) {
+  setup(true);
+  EXPECT_FALSE(config_->splice());
+
+  EXPECT_CALL(filter_callbacks_.connection_, spliceTo(_)).Times(0);
+  EXPECT_CALL(*upstream_connection_, spliceTo(_)).Times(0);
+  upstream_connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_EQ(0U, config_->stats().downstream_cx_spliced_.value());
+}
+
 TEST_F(TcpProxyTest, DownstreamDisconnectRemote) {
   setup(true);
 
@@ -8,7 +8,9 @@
 
 #include "test/proto/helloworld.pb.h"
 #include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
 
+#include "fmt/format.h"
 #include "gtest/gtest.h"
 
 namespace Envoy {
@@ -164,5 +166,93 @@ TEST(GrpcCodecTest, decodeMultipleFrame) {
   }
 }
 
+class RecordingFrameCallbacks : public FrameCallbacks {
+public:
+  // Grpc::FrameCallbacks
+  void onFrameStart(uint8_t flags, uint32_t length) override {
+    events_.push_back(fmt::format("start {} {}", flags, length));
+  }
+  void onFrameData(Buffer::Instance& data) override {
+    events_.push_back(fmt::format("data {}", TestUtility::bufferToString(data)));
+  }
+  void onFrameEnd() override { events_.push_back("end"); }
+
+  std::vector<std::string> events_;
+};
+
+TEST(GrpcCodecTest, decodeStreaming) {
+  Buffer::OwnedImpl buffer;
+  std::array<uint8_t, 5> header;
+  Encoder encoder;
+  encoder.newFrame(GRPC_FH_DEFAULT, 10, header);
+  buffer.add(header.data(), 3);
+
+  RecordingFrameCallbacks callbacks;
+  Decoder decoder;
+  EXPECT_TRUE(decoder.decode(buffer, callbacks));
+  EXPECT_EQ(0, buffer.length());
+  EXPECT_TRUE(callbacks.events_.empty());
+
+  buffer.add(header.data() + 3, 2);
+  buffer.add("hello");
+  EXPECT_TRUE(decoder.decode(buffer, callbacks));
+  EXPECT_EQ(0, buffer.length());
+  EXPECT_EQ((std::vector<std::string>{"start 0 10", "data hello"}), callbacks.events_);
+  EXPECT_EQ(10, decoder.length());
+
+  // The rest of the message followed by an empty frame and the start of the next frame.
+  callbacks.events_.clear();
+  buffer.add("world");
+  encoder.newFrame(GRPC_FH_COMPRESSED, 0, header);
+  buffer.add(header.data(), 5);
+  encoder.newFrame(GRPC_FH_DEFAULT, 3, header);
+  buffer.add(header.data(), 5);
+  buffer.add("a");
+  EXPECT_TRUE(decoder.decode(buffer, callbacks));
+  EXPECT_EQ(0, buffer.length());
+  EXPECT_EQ((std::vector<std::string>{"data world", "end", "start 1 0", "end", "start 0 3",
+                                      "data a"}),
+            callbacks.events_);
+}
+
+TEST(GrpcCodecTest, decodeInvalidFrameAfterValidFrame) {
+  Buffer::OwnedImpl buffer;
+  std::array<uint8_t, 5> header;
+  Encoder encoder;
+  encoder.newFrame(GRPC_FH_DEFAULT, 5, header);
+  buffer.add(header.data(), 5);
+  buffer.add("hello");
+  encoder.newFrame(0b10u, 5, header);
+  buffer.add(header.data(), 5);
+  buffer.add("world");
+
+  std::vector<Frame> frames;
+  Decoder decoder;
+  EXPECT_FALSE(decoder.decode(buffer, frames));
+  EXPECT_EQ(10, buffer.length());
+  ASSERT_EQ(1, frames.size());
+  EXPECT_EQ("hello", TestUtility::bufferToString(*frames[0].data_));
+}
+
+TEST(GrpcCodecTest, decodeInvalidFrameAfterEmptyFrames) {
+  // Both empty frames and the invalid header are in one slice.
+  Buffer::OwnedImpl buffer;
+  std::array<uint8_t, 5> header;
+  Encoder encoder;
+  encoder.newFrame(GRPC_FH_DEFAULT, 0, header);
+  buffer.add(header.data(), 5);
+  buffer.add(header.data(), 5);
+  encoder.newFrame(0b10u, 5, header);
+  buffer.add(header.data(), 5);
+  buffer.add("world");
+
+  std::vector<Frame> frames;
+  Decoder decoder;
+  EXPECT_FALSE(decoder.decode(buffer, frames));
+  EXPECT_EQ(10, buffer.length());
+  EXPECT_EQ(2, frames.size());
+  EXPECT_EQ(0b10u, static_cast<uint8_t*>(buffer.linearize(1))[0]);
+}
+
 } // namespace Grpc
 } // namespace Envoy
@@ -313,6 +313,133 @@ TEST_F(GrpcJsonTranscoderFilterTest, TranscodingUnaryError) {
   EXPECT_EQ(0, request_data.length());
 }
 
+TEST_F(GrpcJsonTranscoderFilterTest, TranscodingServerStreamingIncrementally) {
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "GET"}, {":path", "/shelves/1/books"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, true));
+  EXPECT_EQ("/bookstore.Bookstore/ListBooks", request_headers.get_(":path"));
+
+  Http::TestHeaderMapImpl response_headers{{"content-type", "application/grpc"},
+                                           {":status", "200"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.encodeHeaders(response_headers, false));
+
+  bookstore::Book book;
+  book.set_id(1);
+  book.set_title("Book1");
+  auto book_data = Common::serializeBody(book);
+
+  // Half of the first message does not produce any output yet.
+  Buffer::OwnedImpl response_data;
+  response_data.move(*book_data, book_data->length() / 2);
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.encodeData(response_data, false));
+  EXPECT_EQ(0, response_data.length());
+
+  // The rest of it is translated right away, without waiting for the end of the stream.
+  response_data.move(*book_data);
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.encodeData(response_data, false));
+  EXPECT_NE(std::string::npos, TestUtility::bufferToString(response_data).find("\"Book1\""));
+
+  book.set_id(2);
+  book.set_title("Book2");
+  response_data.drain(response_data.length());
+  response_data.move(*Common::serializeBody(book));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.encodeData(response_data, false));
+  EXPECT_NE(std::string::npos, TestUtility::bufferToString(response_data).find("\"Book2\""));
+}
+
+TEST_F(GrpcJsonTranscoderFilterTest, TranscodingRequestOverBufferLimit) {
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "POST"}, {":path", "/shelf"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, false));
+
+  ON_CALL(decoder_callbacks_, decoderBufferLimit()).WillByDefault(Return(16));
+
+  // The incomplete message is held by the transcoder, up to the limit.
+  Buffer::OwnedImpl request_data{"{\"theme\": "};
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.decodeData(request_data, false));
+  EXPECT_EQ(0, request_data.length());
+
+  EXPECT_CALL(decoder_callbacks_, encodeHeaders_(_, false))
+      .WillOnce(Invoke([](Http::HeaderMap& headers, bool) {
+        EXPECT_STREQ("413", headers.Status()->value().c_str());
+      }));
+  EXPECT_CALL(decoder_callbacks_, encodeData(_, true));
+
+  Buffer::OwnedImpl more_request_data{"\"Children and young adults\""};
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer,
+            filter_.decodeData(more_request_data, false));
+}
+
+TEST_F(GrpcJsonTranscoderFilterTest, TranscodingStreamingRequestOverBufferLimit) {
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "POST"}, {":path", "/bulk/shelves"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, false));
+  EXPECT_EQ("/bookstore.Bookstore/BulkCreateShelf", request_headers.get_(":path"));
+
+  ON_CALL(decoder_callbacks_, decoderBufferLimit()).WillByDefault(Return(32));
+
+  // The first message is translated, and the start of the second one is read into the JSON
+  // parser, where it is no longer available from the input stream.
+  Buffer::OwnedImpl request_data{"[{\"theme\": \"A\"}, {\"theme\": \""};
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.decodeData(request_data, false));
+  EXPECT_NE(0, request_data.length());
+
+  EXPECT_CALL(decoder_callbacks_, encodeHeaders_(_, false))
+      .WillOnce(Invoke([](Http::HeaderMap& headers, bool) {
+        EXPECT_STREQ("413", headers.Status()->value().c_str());
+      }));
+  EXPECT_CALL(decoder_callbacks_, encodeData(_, true));
+
+  // The bytes held by the parser count against the limit along with the new ones.
+  Buffer::OwnedImpl more_request_data{"Children and young adults"};
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer,
+            filter_.decodeData(more_request_data, false));
+}
+
+TEST_F(GrpcJsonTranscoderFilterTest, TranscodingStreamingRequestLargeChunk) {
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "POST"}, {":path", "/bulk/shelves"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, false));
+
+  ON_CALL(decoder_callbacks_, decoderBufferLimit()).WillByDefault(Return(64));
+
+  // The chunk is over the limit, but each message in it is below it. Once the messages are
+  // translated, nothing is held.
+  const std::string shelf = "{\"theme\": \"" + std::string(20, 'a') + "\"}";
+  Buffer::OwnedImpl request_data{"[" + shelf + ", " + shelf + ", " + shelf + ", " + shelf + "]"};
+  EXPECT_CALL(decoder_callbacks_, encodeHeaders_(_, _)).Times(0);
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.decodeData(request_data, true));
+
+  // Each message is a 5 byte frame header followed by the 22 byte Shelf.
+  EXPECT_EQ(4 * 27, request_data.length());
+}
+
+TEST_F(GrpcJsonTranscoderFilterTest, TranscodingResponseOverBufferLimit) {
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "GET"}, {":path", "/shelves/1/books"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, true));
+
+  Http::TestHeaderMapImpl response_headers{{"content-type", "application/grpc"},
+                                           {":status", "200"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.encodeHeaders(response_headers, false));
+
+  ON_CALL(encoder_callbacks_, encoderBufferLimit()).WillByDefault(Return(64));
+
+  bookstore::Book book;
+  book.set_id(1);
+  for (int i = 0; i < 10; i++) {
+    book.add_quotes("To be, or not to be, that is the question");
+  }
+  auto book_data = Common::serializeBody(book);
+
+  // A single message larger than the limit can't be translated without holding all of it.
+  Buffer::OwnedImpl response_data;
+  response_data.move(*book_data, book_data->length() - 1);
+  EXPECT_CALL(encoder_callbacks_, resetStream());
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer,
+            filter_.encodeData(response_data, false));
+}
+
 struct GrpcJsonTranscoderFilterPrintTestParam {
   std::string config_json_;
   std::string expected_response_;
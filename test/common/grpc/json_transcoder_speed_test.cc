@@ -0,0 +1,119 @@
+// Measures JSON transcoding of large repeated field messages through JsonTranscoderFilter, both
+// for a unary response and for a server streaming response delivered in small chunks.
+//
+// Usage: json_transcoder_speed_test <path to bookstore.descriptor>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/grpc/common.h"
+#include "common/grpc/json_transcoder_filter.h"
+#include "common/http/header_map_impl.h"
+#include "common/json/json_loader.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/proto/bookstore.pb.h"
+#include "test/test_common/utility.h"
+
+#include "fmt/format.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Grpc {
+namespace {
+
+// Feeds the upstream response body to the filter in chunks of the given size, the way it would
+// arrive from the codec, and returns the number of JSON bytes produced.
+uint64_t transcodeResponse(JsonTranscoderConfig& config, const std::string& path,
+                           const Buffer::Instance& body, uint64_t chunk_size) {
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> encoder_callbacks;
+  JsonTranscoderFilter filter(config);
+  filter.setDecoderFilterCallbacks(decoder_callbacks);
+  filter.setEncoderFilterCallbacks(encoder_callbacks);
+
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "GET"}, {":path", path}};
+  filter.decodeHeaders(request_headers, true);
+  Http::TestHeaderMapImpl response_headers{{"content-type", "application/grpc"},
+                                           {":status", "200"}};
+  filter.encodeHeaders(response_headers, false);
+
+  Buffer::OwnedImpl remaining;
+  remaining.add(body);
+  uint64_t output = 0;
+  while (remaining.length() > 0) {
+    Buffer::OwnedImpl chunk;
+    chunk.move(remaining, std::min<uint64_t>(chunk_size, remaining.length()));
+    filter.encodeData(chunk, remaining.length() == 0);
+    output += chunk.length();
+  }
+  return output;
+}
+
+template <class Function> void time(const std::string& name, uint64_t input, Function function) {
+  const uint32_t iterations = 20;
+  uint64_t output = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    output += function();
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  const double seconds = std::chrono::duration<double>(end - start).count() / iterations;
+  std::cout << fmt::format("{}: {} bytes in, {} bytes out, {:.2f}ms, {:.1f}MB/s", name, input,
+                           output / iterations, seconds * 1000, input / seconds / 1000000)
+            << std::endl;
+}
+
+void run(const std::string& descriptor_path, uint32_t num_items) {
+  JsonTranscoderConfig config(*Json::Factory::loadFromString(fmt::format(
+      "{{\"proto_descriptor\": \"{}\", \"services\": [\"bookstore.Bookstore\"]}}",
+      descriptor_path)));
+
+  // Unary response with a large repeated message field.
+  bookstore::ListShelvesResponse shelves;
+  for (uint32_t i = 0; i < num_items; i++) {
+    bookstore::Shelf* shelf = shelves.add_shelves();
+    shelf->set_id(i);
+    shelf->set_theme(fmt::format("Theme number {}", i));
+  }
+  Buffer::InstancePtr unary_body = Common::serializeBody(shelves);
+  time(fmt::format("unary items={}", num_items), unary_body->length(),
+       [&]() { return transcodeResponse(config, "/shelves", *unary_body, 16384); });
+
+  // Server streaming response, each message with a large repeated string field.
+  Buffer::OwnedImpl streaming_body;
+  for (uint32_t i = 0; i < 10; i++) {
+    bookstore::Book book;
+    book.set_id(i);
+    book.set_title(fmt::format("Book {}", i));
+    for (uint32_t j = 0; j < num_items / 10; j++) {
+      book.add_quotes(fmt::format("Quote {} from book {}", j, i));
+    }
+    streaming_body.move(*Common::serializeBody(book));
+  }
+  time(fmt::format("streaming items={}", num_items), streaming_body.length(),
+       [&]() { return transcodeResponse(config, "/shelves/1/books", streaming_body, 16384); });
+}
+
+} // namespace
+} // namespace Grpc
+} // namespace Envoy
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " <path to bookstore.descriptor>" << std::endl;
+    return 1;
+  }
+
+  for (uint32_t num_items : {100, 10000, 100000}) {
+    Envoy::Grpc::run(argv[1], num_items);
+  }
+  return 0;
+}
@@ -0,0 +1,102 @@
+// Formats the default access log format and reports the time and the number of heap allocations
+// per log line for each way FormatterImpl can produce a line: returning a new string, appending to
+// a string that is reused across lines, and capturing a snapshot that is formatted afterwards.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "common/http/access_log/access_log_formatter.h"
+#include "common/http/access_log/request_info_impl.h"
+#include "common/http/header_map_impl.h"
+
+#include "fmt/format.h"
+
+namespace {
+std::atomic<uint64_t> allocations{};
+} // namespace
+
+void* operator new(size_t size) {
+  allocations++;
+  void* p = malloc(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+
+namespace Envoy {
+namespace Http {
+namespace AccessLog {
+namespace {
+
+const uint64_t ITERATIONS = 1000000;
+
+template <class Format> void run(const std::string& name, Format format) {
+  // One untimed line so that reused buffers have grown to the line length.
+  format();
+
+  const uint64_t start_allocations = allocations;
+  const auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < ITERATIONS; i++) {
+    format();
+  }
+  const double ns =
+      std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << fmt::format("{:>10} {:>12.0f} {:>18.2f}", name, ns / ITERATIONS,
+                           static_cast<double>(allocations - start_allocations) / ITERATIONS)
+            << std::endl;
+}
+
+} // namespace
+} // namespace AccessLog
+} // namespace Http
+} // namespace Envoy
+
+int main() {
+  using namespace Envoy::Http;
+  using namespace Envoy::Http::AccessLog;
+
+  HeaderMapImpl request_headers;
+  request_headers.addCopy(LowerCaseString(":method"), "GET");
+  request_headers.addCopy(LowerCaseString(":path"), "/v1/orders/1234567?expand=items");
+  request_headers.addCopy(LowerCaseString(":authority"), "api.example.com");
+  request_headers.addCopy(LowerCaseString("user-agent"), "curl/7.54.0");
+  request_headers.addCopy(LowerCaseString("x-forwarded-for"), "10.1.2.3");
+  request_headers.addCopy(LowerCaseString("x-request-id"), "0b6e2a4c-8d1f-4e3a-9b5c-7d2e1f0a3b4c");
+  HeaderMapImpl response_headers;
+  response_headers.addCopy(LowerCaseString("x-envoy-upstream-service-time"), "12");
+
+  RequestInfoImpl request_info(Protocol::Http11);
+  request_info.response_code_.value(200);
+  request_info.bytes_received_ = 512;
+  request_info.bytes_sent_ = 4096;
+
+  FormatterImplPtr formatter = AccessLogFormatUtils::defaultAccessLogFormatter();
+  std::string log_line;
+  std::string snapshot;
+
+  std::cout << fmt::format("{:>10} {:>12} {:>18}", "output", "ns_per_line", "allocs_per_line")
+            << std::endl;
+  run("string", [&]() -> void {
+    log_line = formatter->format(request_headers, response_headers, request_info);
+  });
+  run("buffer", [&]() -> void {
+    log_line.clear();
+    formatter->format(request_headers, response_headers, request_info, log_line);
+  });
+  run("snapshot", [&]() -> void {
+    snapshot.clear();
+    formatter->capture(request_headers, response_headers, request_info, snapshot);
+    log_line.clear();
+    formatter->format(snapshot.data(), snapshot.size(), log_line);
+  });
+  return 0;
+}
@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include <chrono>
 #include <cstdint>
 #include <string>
@@ -259,6 +261,70 @@ TEST(AccessLogFormatterTest, CompositeFormatterSuccess) {
 
     EXPECT_EQ("GET|G|PU|GET", formatter.format(request_header, response_header, request_info));
   }
+
+  {
+    FormatterImpl formatter("%REQ(first)% %REQ(not exist):0%|%RESPONSE_CODE%");
+    Optional<uint32_t> response_code{200};
+    EXPECT_CALL(request_info, responseCode()).WillRepeatedly(ReturnRef(response_code));
+
+    std::string log_line = "previous line\n";
+    formatter.format(request_header, response_header, request_info, log_line);
+    EXPECT_EQ("previous line\nGET |200", log_line);
+  }
+}
+
+TEST(AccessLogFormatterTest, SnapshotFormatsSameAsFormat) {
+  NiceMock<MockRequestInfo> request_info;
+  TestHeaderMapImpl request_header{{":method", "GET"},
+                                   {":path", "/"},
+                                   {"user-agent", "curl/7.54.0"},
+                                   {"x-request-id", "a121e9e1-feae-4136-9e0e-6fac343d56c9"}};
+  TestHeaderMapImpl response_header{{"x-envoy-upstream-service-time", "12"}};
+
+  tm fake_time;
+  memset(&fake_time, 0, sizeof(fake_time));
+  fake_time.tm_year = 117;
+  fake_time.tm_mon = 9;
+  fake_time.tm_mday = 12;
+  ON_CALL(request_info, startTime())
+      .WillByDefault(Return(std::chrono::system_clock::from_time_t(timegm(&fake_time)) +
+                            std::chrono::microseconds(123456)));
+  ON_CALL(request_info, requestReceivedDuration())
+      .WillByDefault(Return(std::chrono::microseconds(5000)));
+  ON_CALL(request_info, responseReceivedDuration())
+      .WillByDefault(Return(std::chrono::microseconds(10000)));
+  ON_CALL(request_info, duration()).WillByDefault(Return(std::chrono::microseconds(15000)));
+  ON_CALL(request_info, bytesReceived()).WillByDefault(Return(100));
+  ON_CALL(request_info, bytesSent()).WillByDefault(Return(200));
+  ON_CALL(request_info, protocol()).WillByDefault(Return(Protocol::Http2));
+  Optional<uint32_t> response_code{503};
+  ON_CALL(request_info, responseCode()).WillByDefault(ReturnRef(response_code));
+  ON_CALL(request_info, getResponseFlag(ResponseFlag::UpstreamConnectionFailure))
+      .WillByDefault(Return(true));
+  ON_CALL(request_info, getResponseFlag(ResponseFlag::RateLimited)).WillByDefault(Return(true));
+  const std::string upstream_cluster_name = "cluster_name";
+  ON_CALL(request_info.host_->cluster_, name()).WillByDefault(ReturnRef(upstream_cluster_name));
+
+  const std::string format = "%REQUEST_DURATION% %RESPONSE_DURATION% %UPSTREAM_CLUSTER% "
+                             "%REQ(:path):3% %RESP(X-NOT-THERE?X-ENVOY-UPSTREAM-SERVICE-TIME)%";
+  for (const FormatterImplPtr& formatter : {AccessLogFormatUtils::defaultAccessLogFormatter(),
+                                            FormatterImplPtr{new FormatterImpl(format)}}) {
+    std::string snapshot;
+    formatter->capture(request_header, response_header, request_info, snapshot);
+    std::string log_line = "previous line\n";
+    formatter->format(snapshot.data(), snapshot.size(), log_line);
+    EXPECT_EQ("previous line\n" + formatter->format(request_header, response_header, request_info),
+              log_line);
+  }
+
+  // Without an upstream host.
+  ON_CALL(request_info, upstreamHost()).WillByDefault(Return(nullptr));
+  FormatterImpl formatter("%UPSTREAM_HOST% %UPSTREAM_CLUSTER% %REQ(X-NOT-THERE)%");
+  std::string snapshot;
+  formatter.capture(request_header, response_header, request_info, snapshot);
+  std::string log_line;
+  formatter.format(snapshot.data(), snapshot.size(), log_line);
+  EXPECT_EQ("- - -", log_line);
 }
 
 TEST(AccessLogFormatterTest, ParserFailures) {
@@ -1,6 +1,7 @@
 #include <chrono>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include "envoy/upstream/cluster_manager.h"
@@ -26,6 +27,7 @@
 #include "test/mocks/filesystem/mocks.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/server/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/printers.h"
 #include "test/test_common/utility.h"
@@ -34,6 +36,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
 using testing::SaveArg;
@@ -197,6 +200,148 @@ TEST_F(AccessLogImplTest, UpstreamHost) {
             output_);
 }
 
+TEST_F(AccessLogImplTest, BackgroundFormatting) {
+  const std::string json = R"EOF(
+      {
+        "path": "/dev/null",
+        "format": "%RESPONSE_CODE% %RESPONSE_FLAGS% %REQ(:PATH)% %UPSTREAM_HOST%\n"
+      }
+      )EOF";
+
+  InstanceSharedPtr log = AccessLogFactory::fromProto(parseAccessLogFromJson(json), context_);
+  EXPECT_NE(nullptr, dynamic_cast<BackgroundFileAccessLog*>(log.get()));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("access_log.background_formatting", 0))
+      .WillRepeatedly(Return(1));
+
+  std::shared_ptr<Upstream::MockClusterInfo> cluster{new Upstream::MockClusterInfo()};
+  request_info_.upstream_host_ = Upstream::makeTestHostDescription(cluster, "tcp://10.0.0.5:1234");
+  request_info_.response_code_.value(200);
+  request_info_.response_flags_ = ResponseFlag::UpstreamConnectionFailure;
+
+  // Lines are written by the shared format thread, possibly batched, and all of them by the time
+  // the log is destroyed.
+  std::string written;
+  ON_CALL(*file_, write(_)).WillByDefault(Invoke([&written](const std::string& data) -> void {
+    written += data;
+  }));
+  log->log(&request_headers_, &response_headers_, request_info_);
+  request_info_.upstream_host_ = nullptr;
+  request_headers_.insertPath().value(std::string("/second"));
+  log->log(&request_headers_, &response_headers_, request_info_);
+  log.reset();
+
+  EXPECT_EQ("200 UF / 10.0.0.5:1234\n200 UF /second -\n", written);
+  EXPECT_EQ(2UL, context_.scope_.counter("access_log.background_captured").value());
+  EXPECT_EQ(0UL, context_.scope_.counter("access_log.background_ring_full").value());
+}
+
+// The runtime key is read for every line, and without it lines are written right away.
+TEST_F(AccessLogImplTest, BackgroundFormattingRuntimeKey) {
+  const std::string json = R"EOF(
+      {
+        "path": "/dev/null",
+        "format": "%REQ(:PATH)%\n"
+      }
+      )EOF";
+
+  InstanceSharedPtr log = AccessLogFactory::fromProto(parseAccessLogFromJson(json), context_);
+  EXPECT_CALL(*file_, write("/\n"));
+  log->log(&request_headers_, &response_headers_, request_info_);
+
+  // Lines are written both by this thread and by the format thread.
+  std::mutex written_lock;
+  std::string written;
+  EXPECT_CALL(*file_, write(_))
+      .WillRepeatedly(Invoke([&written_lock, &written](const std::string& data) -> void {
+        std::lock_guard<std::mutex> lock(written_lock);
+        written += data;
+      }));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("access_log.background_formatting", 0))
+      .WillOnce(Return(1))
+      .WillRepeatedly(Return(0));
+  request_headers_.insertPath().value(std::string("/background"));
+  log->log(&request_headers_, &response_headers_, request_info_);
+  request_headers_.insertPath().value(std::string("/sync"));
+  log->log(&request_headers_, &response_headers_, request_info_);
+  log.reset();
+
+  // The line written on the worker may go out before the one formatted in the background.
+  EXPECT_TRUE(written == "/background\n/sync\n" || written == "/sync\n/background\n");
+  EXPECT_EQ(1UL, context_.scope_.counter("access_log.background_captured").value());
+}
+
+// Logs that format in the background share one thread, which keeps running for the logs that
+// remain when one is destroyed.
+TEST(BackgroundFormatThreadTest, SharedByLogs) {
+  NiceMock<Envoy::AccessLog::MockAccessLogManager> log_manager;
+  NiceMock<ThreadLocal::MockInstance> tls;
+  NiceMock<Runtime::MockLoader> runtime;
+  ON_CALL(runtime.snapshot_, getInteger("access_log.background_formatting", 0))
+      .WillByDefault(Return(1));
+  Stats::IsolatedStoreImpl store;
+  std::shared_ptr<Filesystem::MockFile> files[2]{std::make_shared<Filesystem::MockFile>(),
+                                                 std::make_shared<Filesystem::MockFile>()};
+  std::string written[2];
+  for (size_t i = 0; i < 2; ++i) {
+    ON_CALL(*files[i], write(_)).WillByDefault(Invoke([&written, i](const std::string& data) {
+      written[i] += data;
+    }));
+  }
+  EXPECT_CALL(log_manager, createAccessLog(_))
+      .WillOnce(Return(files[0]))
+      .WillOnce(Return(files[1]));
+
+  BackgroundFormatThreadSharedPtr format_thread = std::make_shared<BackgroundFormatThread>();
+  std::unique_ptr<BackgroundFileAccessLog> logs[2];
+  for (size_t i = 0; i < 2; ++i) {
+    logs[i].reset(new BackgroundFileAccessLog(
+        "/dev/null", nullptr, FormatterImplPtr{new FormatterImpl("%REQ(:PATH)%\n")},
+        log_manager, tls, runtime, store, format_thread));
+  }
+
+  TestHeaderMapImpl first_headers{{":path", "/first"}};
+  TestHeaderMapImpl second_headers{{":path", "/second"}};
+  TestRequestInfo request_info;
+  logs[0]->log(&first_headers, nullptr, request_info);
+  logs[1]->log(&second_headers, nullptr, request_info);
+  logs[0].reset();
+  EXPECT_EQ("/first\n", written[0]);
+
+  logs[1]->log(&second_headers, nullptr, request_info);
+  logs[1].reset();
+  EXPECT_EQ("/second\n/second\n", written[1]);
+  EXPECT_EQ(3UL, store.counter("access_log.background_captured").value());
+}
+
+TEST(SnapshotRingTest, PushPop) {
+  SnapshotRing ring(64);
+  std::string record;
+  EXPECT_FALSE(ring.pop(record));
+
+  // Records wrap around the end of the ring.
+  for (size_t i = 0; i < 50; ++i) {
+    const std::string first(i % 20, 'a' + i % 26);
+    const std::string second = first + "x";
+    EXPECT_TRUE(ring.push(first));
+    EXPECT_TRUE(ring.push(second));
+    EXPECT_TRUE(ring.pop(record));
+    EXPECT_EQ(first, record);
+    EXPECT_TRUE(ring.pop(record));
+    EXPECT_EQ(second, record);
+    EXPECT_FALSE(ring.pop(record));
+  }
+
+  // Each record takes its size plus a 4 byte length.
+  EXPECT_FALSE(ring.push(std::string(61, 'z')));
+  EXPECT_TRUE(ring.push(std::string(60, 'z')));
+  EXPECT_FALSE(ring.push(""));
+  EXPECT_TRUE(ring.pop(record));
+  EXPECT_EQ(std::string(60, 'z'), record);
+  EXPECT_TRUE(ring.push(""));
+  EXPECT_TRUE(ring.pop(record));
+  EXPECT_EQ("", record);
+}
+
 TEST_F(AccessLogImplTest, WithFilterMiss) {
   const std::string json = R"EOF(
   {
@@ -0,0 +1,283 @@
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "common/api/os_sys_calls_impl.h"
+#include "common/common/utility.h"
+#include "common/http/access_log/binary_access_log.h"
+#include "common/http/header_map_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/access_log/mocks.h"
+#include "test/mocks/api/mocks.h"
+#include "test/mocks/http/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnRef;
+using testing::SaveArg;
+using testing::SetErrnoAndReturn;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+namespace AccessLog {
+namespace Binary {
+namespace {
+
+class BinaryAccessLogTest : public testing::Test {
+public:
+  BinaryAccessLogTest() {
+    start_time_ = SystemTime(std::chrono::microseconds(1507812345678901));
+    ON_CALL(request_info_, startTime()).WillByDefault(Return(start_time_));
+    ON_CALL(request_info_, requestReceivedDuration())
+        .WillByDefault(Return(std::chrono::microseconds(1000)));
+    ON_CALL(request_info_, responseReceivedDuration())
+        .WillByDefault(Return(std::chrono::microseconds(2000)));
+    ON_CALL(request_info_, duration()).WillByDefault(Return(std::chrono::microseconds(3000)));
+    ON_CALL(request_info_, bytesReceived()).WillByDefault(Return(512));
+    ON_CALL(request_info_, bytesSent()).WillByDefault(Return(4096));
+    ON_CALL(request_info_, protocol()).WillByDefault(Return(Protocol::Http2));
+    ON_CALL(request_info_, responseCode()).WillByDefault(ReturnRef(response_code_));
+    ON_CALL(request_info_, getDownstreamAddress()).WillByDefault(ReturnRef(downstream_address_));
+    response_code_.value(200);
+  }
+
+  Record decode(const std::string& data) {
+    Record record;
+    EXPECT_TRUE(RecordDecoder::decode(reinterpret_cast<const uint8_t*>(data.data()), data.size(),
+                                      record));
+    return record;
+  }
+
+  TestHeaderMapImpl request_headers_{
+      {":method", "GET"}, {":path", "/v1/orders"}, {"x-request-id", "abc"}, {"cookie", "a=b"}};
+  TestHeaderMapImpl response_headers_{{"x-envoy-upstream-service-time", "12"}};
+  NiceMock<MockRequestInfo> request_info_;
+  SystemTime start_time_;
+  Optional<uint32_t> response_code_;
+  std::string downstream_address_{"10.0.0.2"};
+  Stats::IsolatedStoreImpl store_;
+  NiceMock<Api::MockOsSysCalls> os_sys_calls_;
+};
+
+TEST_F(BinaryAccessLogTest, RoundTrip) {
+  EXPECT_CALL(request_info_, getResponseFlag(_)).WillRepeatedly(Return(false));
+  EXPECT_CALL(request_info_, getResponseFlag(ResponseFlag::UpstreamRequestTimeout))
+      .WillRepeatedly(Return(true));
+  EXPECT_CALL(request_info_, getResponseFlag(ResponseFlag::RateLimited))
+      .WillRepeatedly(Return(true));
+
+  RecordEncoder encoder(RecordEncoder::defaultHeaders());
+  std::string data;
+  encoder.encode(request_headers_, response_headers_, request_info_, data);
+  EXPECT_EQ(data.size(),
+            RecordDecoder::recordLength(reinterpret_cast<const uint8_t*>(data.data())));
+
+  Record record = decode(data);
+  EXPECT_EQ(1507812345678901UL, record.start_time_us_);
+  EXPECT_EQ(1000UL, record.request_received_duration_us_);
+  EXPECT_EQ(2000UL, record.response_received_duration_us_);
+  EXPECT_EQ(3000UL, record.duration_us_);
+  EXPECT_EQ(512UL, record.bytes_received_);
+  EXPECT_EQ(4096UL, record.bytes_sent_);
+  EXPECT_EQ(200U, record.response_code_);
+  EXPECT_EQ(static_cast<uint64_t>(ResponseFlag::UpstreamRequestTimeout | ResponseFlag::RateLimited),
+            record.response_flags_);
+  EXPECT_EQ(Protocol::Http2, record.protocol_);
+  EXPECT_FALSE(record.health_check_);
+  EXPECT_EQ("10.0.0.1:443", record.upstream_host_);
+  EXPECT_EQ("fake_cluster", record.upstream_cluster_);
+  EXPECT_EQ("10.0.0.2", record.downstream_address_);
+
+  // Only the selected headers that are present are in the record, in the selected order.
+  ASSERT_EQ(3U, record.request_headers_.size());
+  EXPECT_EQ(std::make_pair(std::string(":method"), std::string("GET")),
+            record.request_headers_[0]);
+  EXPECT_EQ(std::make_pair(std::string(":path"), std::string("/v1/orders")),
+            record.request_headers_[1]);
+  EXPECT_EQ(std::make_pair(std::string("x-request-id"), std::string("abc")),
+            record.request_headers_[2]);
+  ASSERT_EQ(1U, record.response_headers_.size());
+  EXPECT_EQ(std::make_pair(std::string("x-envoy-upstream-service-time"), std::string("12")),
+            record.response_headers_[0]);
+}
+
+TEST_F(BinaryAccessLogTest, NoUpstreamHostOrResponse) {
+  EXPECT_CALL(request_info_, upstreamHost()).WillRepeatedly(Return(nullptr));
+  EXPECT_CALL(request_info_, healthCheck()).WillRepeatedly(Return(true));
+  response_code_ = Optional<uint32_t>();
+
+  RecordEncoder encoder(RecordEncoder::parseHeaders("RESP(content-type)"));
+  std::string data;
+  encoder.encode(request_headers_, response_headers_, request_info_, data);
+
+  Record record = decode(data);
+  EXPECT_EQ(0U, record.response_code_);
+  EXPECT_TRUE(record.health_check_);
+  EXPECT_EQ("", record.upstream_host_);
+  EXPECT_EQ("", record.upstream_cluster_);
+  EXPECT_TRUE(record.request_headers_.empty());
+  EXPECT_TRUE(record.response_headers_.empty());
+}
+
+TEST_F(BinaryAccessLogTest, DecodeInvalid) {
+  RecordEncoder encoder(RecordEncoder::defaultHeaders());
+  std::string data;
+  encoder.encode(request_headers_, response_headers_, request_info_, data);
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data.data());
+
+  Record record;
+  EXPECT_FALSE(RecordDecoder::decode(bytes, 3, record));
+  EXPECT_FALSE(RecordDecoder::decode(bytes, data.size() - 1, record));
+
+  // A record that claims to be shorter than the data it came with.
+  std::string truncated = data;
+  truncated[3]--;
+  EXPECT_FALSE(RecordDecoder::decode(reinterpret_cast<const uint8_t*>(truncated.data()),
+                                     truncated.size() - 1, record));
+
+  std::string version = data;
+  version[4] = RecordEncoder::VERSION + 1;
+  EXPECT_FALSE(RecordDecoder::decode(reinterpret_cast<const uint8_t*>(version.data()),
+                                     version.size(), record));
+}
+
+TEST(BinaryAccessLogHeadersTest, Parse) {
+  SelectedHeaders headers = RecordEncoder::parseHeaders("REQ(X-Request-Id), RESP(:status)");
+  ASSERT_EQ(2U, headers.size());
+  EXPECT_EQ(HeaderType::Request, headers[0].type_);
+  EXPECT_EQ("x-request-id", headers[0].name_.get());
+  EXPECT_EQ(HeaderType::Response, headers[1].type_);
+  EXPECT_EQ(":status", headers[1].name_.get());
+
+  EXPECT_THROW_WITH_MESSAGE(RecordEncoder::parseHeaders("REQ(:path), "), EnvoyException,
+                            "Binary access log header '' is not REQ(name) or RESP(name)");
+  EXPECT_THROW_WITH_MESSAGE(RecordEncoder::parseHeaders("REQ()"), EnvoyException,
+                            "Binary access log header 'REQ()' is not REQ(name) or RESP(name)");
+  EXPECT_THROW_WITH_MESSAGE(RecordEncoder::parseHeaders("RESP(:status"), EnvoyException,
+                            "Binary access log header 'RESP(:status' is not REQ(name) or "
+                            "RESP(name)");
+}
+
+TEST_F(BinaryAccessLogTest, File) {
+  NiceMock<Envoy::AccessLog::MockAccessLogManager> log_manager;
+  EXPECT_CALL(log_manager, createAccessLog("/tmp/access.bin")).WillOnce(Return(log_manager.file_));
+  EXPECT_CALL(os_sys_calls_, socket(_, _, _)).Times(0);
+  BinaryAccessLog access_log("/tmp/access.bin", nullptr, RecordEncoder::defaultHeaders(),
+                             log_manager, os_sys_calls_, store_);
+
+  std::string output;
+  EXPECT_CALL(*log_manager.file_, write(_)).WillOnce(SaveArg<0>(&output));
+  access_log.log(&request_headers_, nullptr, request_info_);
+
+  Record record = decode(output);
+  EXPECT_EQ(3U, record.request_headers_.size());
+  EXPECT_TRUE(record.response_headers_.empty());
+  EXPECT_EQ(1UL, store_.counter("access_log.binary_records").value());
+}
+
+TEST_F(BinaryAccessLogTest, UnixSocket) {
+  const std::string path = TestEnvironment::unixDomainSocketPath("binary_access_log.sock");
+  ::unlink(path.c_str());
+  NiceMock<Envoy::AccessLog::MockAccessLogManager> log_manager;
+  EXPECT_CALL(log_manager, createAccessLog(_)).Times(0);
+  Api::OsSysCallsImpl os_sys_calls;
+  BinaryAccessLog access_log("unix://" + path, nullptr, RecordEncoder::defaultHeaders(),
+                             log_manager, os_sys_calls, store_);
+
+  // Nothing is bound to the path yet.
+  access_log.log(&request_headers_, &response_headers_, request_info_);
+  EXPECT_EQ(0UL, store_.counter("access_log.binary_records").value());
+  EXPECT_EQ(1UL, store_.counter("access_log.binary_dropped").value());
+
+  int fd = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+  ASSERT_NE(-1, fd);
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  StringUtil::strlcpy(&address.sun_path[0], path.c_str(), sizeof(address.sun_path));
+  ASSERT_EQ(0, ::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)));
+
+  access_log.log(&request_headers_, &response_headers_, request_info_);
+  EXPECT_EQ(1UL, store_.counter("access_log.binary_records").value());
+
+  char buffer[4096];
+  const ssize_t rc = ::recv(fd, buffer, sizeof(buffer), 0);
+  ASSERT_GT(rc, 0);
+  Record record = decode(std::string(buffer, rc));
+  EXPECT_EQ(3U, record.request_headers_.size());
+  EXPECT_EQ(1U, record.response_headers_.size());
+
+  ::close(fd);
+  ::unlink(path.c_str());
+}
+
+TEST_F(BinaryAccessLogTest, InvalidSocketPath) {
+  NiceMock<Envoy::AccessLog::MockAccessLogManager> log_manager;
+  EXPECT_THROW_WITH_MESSAGE(BinaryAccessLog("unix://", nullptr, RecordEncoder::defaultHeaders(),
+                                            log_manager, os_sys_calls_, store_),
+                            EnvoyException, "Invalid binary access log socket path ''");
+}
+
+TEST_F(BinaryAccessLogTest, SocketFailure) {
+  NiceMock<Envoy::AccessLog::MockAccessLogManager> log_manager;
+  EXPECT_CALL(os_sys_calls_, socket(AF_UNIX, SOCK_DGRAM, 0))
+      .WillOnce(SetErrnoAndReturn(EMFILE, -1));
+  EXPECT_CALL(os_sys_calls_, close(_)).Times(0);
+  EXPECT_THROW_WITH_MESSAGE(BinaryAccessLog("unix:///tmp/access.sock", nullptr,
+                                            RecordEncoder::defaultHeaders(), log_manager,
+                                            os_sys_calls_, store_),
+                            EnvoyException,
+                            "Unable to create binary access log socket for '/tmp/access.sock': " +
+                                std::string(strerror(EMFILE)));
+}
+
+TEST_F(BinaryAccessLogTest, SendFailure) {
+  NiceMock<Envoy::AccessLog::MockAccessLogManager> log_manager;
+  EXPECT_CALL(os_sys_calls_, socket(AF_UNIX, SOCK_DGRAM, 0)).WillOnce(Return(42));
+  BinaryAccessLog access_log("unix:///tmp/access.sock", nullptr, RecordEncoder::defaultHeaders(),
+                             log_manager, os_sys_calls_, store_);
+
+  // The receiver is behind, so the record is dropped rather than blocking the worker.
+  EXPECT_CALL(os_sys_calls_, sendto(42, _, _, MSG_DONTWAIT, _, sizeof(sockaddr_un)))
+      .WillOnce(SetErrnoAndReturn(EAGAIN, -1));
+  access_log.log(&request_headers_, &response_headers_, request_info_);
+  EXPECT_EQ(0UL, store_.counter("access_log.binary_records").value());
+  EXPECT_EQ(1UL, store_.counter("access_log.binary_dropped").value());
+
+  // A partial send is dropped too, since the receiver would get a truncated record.
+  EXPECT_CALL(os_sys_calls_, sendto(42, _, _, MSG_DONTWAIT, _, _))
+      .WillOnce(Invoke([](int, const void*, size_t length, int, const sockaddr*,
+                          socklen_t) -> ssize_t { return length - 1; }));
+  access_log.log(&request_headers_, &response_headers_, request_info_);
+  EXPECT_EQ(0UL, store_.counter("access_log.binary_records").value());
+  EXPECT_EQ(2UL, store_.counter("access_log.binary_dropped").value());
+
+  EXPECT_CALL(os_sys_calls_, sendto(42, _, _, MSG_DONTWAIT, _, _))
+      .WillOnce(Invoke([](int, const void*, size_t length, int, const sockaddr*,
+                          socklen_t) -> ssize_t { return length; }));
+  access_log.log(&request_headers_, &response_headers_, request_info_);
+  EXPECT_EQ(1UL, store_.counter("access_log.binary_records").value());
+  EXPECT_EQ(2UL, store_.counter("access_log.binary_dropped").value());
+
+  EXPECT_CALL(os_sys_calls_, close(42)).WillOnce(Return(0));
+}
+
+} // namespace
+} // namespace Binary
+} // namespace AccessLog
+} // namespace Http
+} // namespace Envoy
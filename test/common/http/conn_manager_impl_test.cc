@@ -38,6 +38,7 @@
 #include "gtest/gtest.h"
 
 using testing::AnyNumber;
+using testing::Assign;
 using testing::AtLeast;
 using testing::DoAll;
 using testing::InSequence;
@@ -223,6 +224,7 @@ public:
   FilterChainFactory& filterFactory() override { return filter_factory_; }
   bool generateRequestId() override { return true; }
   const Optional<std::chrono::milliseconds>& idleTimeout() override { return idle_timeout_; }
+  uint32_t maxPipelineDepth() override { return max_pipeline_depth_; }
   Router::RouteConfigProvider& routeConfigProvider() override { return route_config_provider_; }
   const std::string& serverName() override { return server_name_; }
   ConnectionManagerStats& stats() override { return stats_; }
@@ -258,6 +260,7 @@ public:
   std::vector<Http::ClientCertDetailsType> set_current_client_cert_details_;
   Optional<std::string> user_agent_;
   Optional<std::chrono::milliseconds> idle_timeout_;
+  uint32_t max_pipeline_depth_{1};
   NiceMock<Runtime::MockRandomGenerator> random_;
   NiceMock<LocalInfo::MockLocalInfo> local_info_;
   std::unique_ptr<Ssl::MockConnection> ssl_connection_;
@@ -340,6 +343,166 @@ TEST_F(HttpConnectionManagerImplTest, HeaderOnlyRequestAndResponse) {
   EXPECT_EQ(1U, listener_stats_.downstream_rq_2xx_.value());
 }
 
+TEST_F(HttpConnectionManagerImplTest, PipelinedRequests) {
+  max_pipeline_depth_ = 2;
+  setup(false, "");
+
+  std::vector<std::shared_ptr<MockStreamDecoderFilter>> filters;
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        filters.emplace_back(new NiceMock<MockStreamDecoderFilter>());
+        callbacks.addStreamDecoderFilter(filters.back());
+      }));
+
+  // Each dispatch decodes one headers only request.
+  const std::string request = "GET / HTTP/1.1\r\n\r\n";
+  NiceMock<MockStreamEncoder> encoder;
+  EXPECT_CALL(*codec_, dispatch(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](Buffer::Instance& data) -> void {
+        StreamDecoder& decoder = conn_manager_->newStream(encoder);
+        HeaderMapPtr headers{new TestHeaderMapImpl{
+            {":authority", "host"}, {":path", "/"}, {":method", "GET"}}};
+        decoder.decodeHeaders(std::move(headers), true);
+        data.drain(request.size());
+      }));
+
+  // The second request is dispatched while the first one is outstanding, after which the pipeline
+  // is full and reading stops.
+  EXPECT_CALL(filter_callbacks_.connection_, readDisable(true));
+  Buffer::OwnedImpl fake_input(request + request + request);
+  conn_manager_->onData(fake_input);
+  EXPECT_EQ(request.size(), fake_input.length());
+  EXPECT_EQ(1U, stats_.named_.downstream_rq_pipelined_.value());
+
+  // Completing the first request makes room in the pipeline.
+  EXPECT_CALL(filter_callbacks_.connection_, readDisable(false));
+  EXPECT_CALL(filter_callbacks_.connection_.dispatcher_, deferredDelete_(_)).Times(2);
+  filters[0]->callbacks_->encodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}},
+                                        true);
+  filters[1]->callbacks_->encodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}},
+                                        true);
+  EXPECT_EQ(2U, stats_.named_.downstream_rq_2xx_.value());
+}
+
+// A pipelined request that does not use a safe method, or that follows one which does not, is only
+// started once the requests ahead of it have completed.
+TEST_F(HttpConnectionManagerImplTest, PipelinedUnsafeRequestsWaitForEarlierRequests) {
+  max_pipeline_depth_ = 4;
+  setup(false, "");
+
+  std::vector<std::shared_ptr<MockStreamDecoderFilter>> filters;
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        filters.emplace_back(new NiceMock<MockStreamDecoderFilter>());
+        callbacks.addStreamDecoderFilter(filters.back());
+      }));
+
+  // Each dispatch decodes the request line at the front of the data as one headers only request.
+  const std::string get_request = "GET / HTTP/1.1\r\n\r\n";
+  const std::string post_request = "POST / HTTP/1.1\r\n\r\n";
+  NiceMock<MockStreamEncoder> encoder;
+  EXPECT_CALL(*codec_, dispatch(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([&](Buffer::Instance& data) -> void {
+        const bool get = TestUtility::bufferToString(data).find("GET ") == 0;
+        StreamDecoder& decoder = conn_manager_->newStream(encoder);
+        HeaderMapPtr headers{new TestHeaderMapImpl{
+            {":authority", "host"}, {":path", "/"}, {":method", get ? "GET" : "POST"}}};
+        decoder.decodeHeaders(std::move(headers), true);
+        data.drain(get ? get_request.size() : post_request.size());
+      }));
+
+  // The POST behind the first GET is held even though the pipeline has room.
+  EXPECT_CALL(filter_callbacks_.connection_, readDisable(true))
+      .WillOnce(Assign(&filter_callbacks_.connection_.read_enabled_, false));
+  Buffer::OwnedImpl fake_input(get_request + post_request + get_request);
+  conn_manager_->onData(fake_input);
+  EXPECT_EQ(1U, filters.size());
+  EXPECT_EQ(post_request.size() + get_request.size(), fake_input.length());
+
+  // Once the GET has completed, the POST is dispatched. The GET behind it is held because the POST
+  // is outstanding.
+  EXPECT_CALL(filter_callbacks_.connection_, readDisable(false))
+      .WillOnce(Assign(&filter_callbacks_.connection_.read_enabled_, true));
+  EXPECT_CALL(filter_callbacks_.connection_.dispatcher_, deferredDelete_(_));
+  filters[0]->callbacks_->encodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}},
+                                        true);
+  EXPECT_CALL(filter_callbacks_.connection_, readDisable(true))
+      .WillOnce(Assign(&filter_callbacks_.connection_.read_enabled_, false));
+  conn_manager_->onData(fake_input);
+  EXPECT_EQ(2U, filters.size());
+  EXPECT_EQ(get_request.size(), fake_input.length());
+
+  // The last GET only starts after the POST has completed.
+  EXPECT_CALL(filter_callbacks_.connection_, readDisable(false))
+      .WillOnce(Assign(&filter_callbacks_.connection_.read_enabled_, true));
+  EXPECT_CALL(filter_callbacks_.connection_.dispatcher_, deferredDelete_(_));
+  filters[1]->callbacks_->encodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}},
+                                        true);
+  conn_manager_->onData(fake_input);
+  EXPECT_EQ(3U, filters.size());
+  EXPECT_EQ(0U, fake_input.length());
+  EXPECT_EQ(0U, stats_.named_.downstream_rq_pipelined_.value());
+
+  EXPECT_CALL(filter_callbacks_.connection_.dispatcher_, deferredDelete_(_));
+  filters[2]->callbacks_->encodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}},
+                                        true);
+}
+
+// Only the response to the last pipelined request says that the connection is going to be closed.
+TEST_F(HttpConnectionManagerImplTest, PipelinedRequestsConnectionClose) {
+  max_pipeline_depth_ = 2;
+  setup(false, "");
+
+  std::vector<std::shared_ptr<MockStreamDecoderFilter>> filters;
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        filters.emplace_back(new NiceMock<MockStreamDecoderFilter>());
+        callbacks.addStreamDecoderFilter(filters.back());
+      }));
+
+  // The first request asks for the connection to be closed after it.
+  const std::string request = "GET / HTTP/1.1\r\n\r\n";
+  NiceMock<MockStreamEncoder> encoders[2];
+  uint32_t requests = 0;
+  EXPECT_CALL(*codec_, dispatch(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](Buffer::Instance& data) -> void {
+        StreamDecoder& decoder = conn_manager_->newStream(encoders[requests]);
+        HeaderMapPtr headers{new TestHeaderMapImpl{
+            {":authority", "host"}, {":path", "/"}, {":method", "GET"}}};
+        if (requests++ == 0) {
+          headers->addCopy(LowerCaseString("connection"), "close");
+        }
+        decoder.decodeHeaders(std::move(headers), true);
+        data.drain(request.size());
+      }));
+
+  Buffer::OwnedImpl fake_input(request + request);
+  conn_manager_->onData(fake_input);
+
+  EXPECT_CALL(encoders[0], encodeHeaders(_, true))
+      .WillOnce(Invoke([](const HeaderMap& headers, bool) -> void {
+        EXPECT_EQ(nullptr, headers.Connection());
+      }));
+  EXPECT_CALL(filter_callbacks_.connection_.dispatcher_, deferredDelete_(_)).Times(2);
+  filters[0]->callbacks_->encodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}},
+                                        true);
+
+  EXPECT_CALL(encoders[1], encodeHeaders(_, true))
+      .WillOnce(Invoke([](const HeaderMap& headers, bool) -> void {
+        ASSERT_NE(nullptr, headers.Connection());
+        EXPECT_STREQ("close", headers.Connection()->value().c_str());
+      }));
+  EXPECT_CALL(filter_callbacks_.connection_, close(Network::ConnectionCloseType::FlushWrite));
+  filters[1]->callbacks_->encodeHeaders(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}},
+                                        true);
+}
+
 TEST_F(HttpConnectionManagerImplTest, InvalidPathWithDualFilter) {
   InSequence s;
   setup(false, "");
@@ -407,7 +570,7 @@ TEST_F(HttpConnectionManagerImplTest, StartAndFinishSpanNormalFlow) {
 
   // Treat request as internal, otherwise x-request-id header will be overwritten.
   use_remote_address_ = false;
-  EXPECT_CALL(random_, uuid()).Times(0);
+  EXPECT_CALL(random_, fastUuid(_)).Times(0);
 
   StreamDecoder* decoder = nullptr;
   NiceMock<MockStreamEncoder> encoder;
@@ -541,7 +704,7 @@ TEST_F(HttpConnectionManagerImplTest, StartSpanOnlyHealthCheckRequest) {
 
   // Treat request as internal, otherwise x-request-id header will be overwritten.
   use_remote_address_ = false;
-  EXPECT_CALL(random_, uuid()).Times(0);
+  EXPECT_CALL(random_, fastUuid(_)).Times(0);
 
   StreamDecoder* decoder = nullptr;
   NiceMock<MockStreamEncoder> encoder;
@@ -1,3 +1,4 @@
+#include <cstring>
 #include <string>
 
 #include "common/http/conn_manager_utility.h"
@@ -19,6 +20,7 @@
 #include "gtest/gtest.h"
 
 using testing::InSequence;
+using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
 using testing::ReturnRef;
@@ -133,7 +135,7 @@ TEST_F(ConnectionManagerUtilityTest, InternalServiceForceTrace) {
     // Internal request, make traceable
     TestHeaderMapImpl headers{
         {"x-forwarded-for", "10.0.0.1"}, {"x-request-id", uuid}, {"x-envoy-force-trace", "true"}};
-    EXPECT_CALL(random_, uuid()).Times(0);
+    EXPECT_CALL(random_, fastUuid(_)).Times(0);
     EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.global_enabled", 100, _))
         .WillOnce(Return(true));
     ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
@@ -147,7 +149,7 @@ TEST_F(ConnectionManagerUtilityTest, InternalServiceForceTrace) {
     // Not internal request, force trace header should be cleaned.
     TestHeaderMapImpl headers{
         {"x-forwarded-for", "34.0.0.1"}, {"x-request-id", uuid}, {"x-envoy-force-trace", "true"}};
-    EXPECT_CALL(random_, uuid()).Times(0);
+    EXPECT_CALL(random_, fastUuid(_)).Times(0);
     EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.global_enabled", 100, _))
         .WillOnce(Return(true));
     ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
@@ -168,7 +170,7 @@ TEST_F(ConnectionManagerUtilityTest, EdgeRequestRegenerateRequestIdAndWipeDownst
   {
     TestHeaderMapImpl headers{{"x-envoy-downstream-service-cluster", "foo"},
                               {"x-request-id", "will_be_regenerated"}};
-    EXPECT_CALL(random_, uuid());
+    EXPECT_CALL(random_, fastUuid(_));
 
     EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.client_enabled", _)).Times(0);
     ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
@@ -185,7 +187,7 @@ TEST_F(ConnectionManagerUtilityTest, EdgeRequestRegenerateRequestIdAndWipeDownst
     TestHeaderMapImpl headers{{"x-envoy-downstream-service-cluster", "foo"},
                               {"x-request-id", "will_be_regenerated"},
                               {"x-client-trace-id", "trace-id"}};
-    EXPECT_CALL(random_, uuid());
+    EXPECT_CALL(random_, fastUuid(_));
     EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.client_enabled", 100))
         .WillOnce(Return(false));
 
@@ -202,7 +204,7 @@ TEST_F(ConnectionManagerUtilityTest, EdgeRequestRegenerateRequestIdAndWipeDownst
     TestHeaderMapImpl headers{{"x-envoy-downstream-service-cluster", "foo"},
                               {"x-request-id", "will_be_regenerated"},
                               {"x-client-trace-id", "trace-id"}};
-    EXPECT_CALL(random_, uuid());
+    EXPECT_CALL(random_, fastUuid(_));
     EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.client_enabled", 100))
         .WillOnce(Return(true));
 
@@ -270,19 +272,23 @@ TEST_F(ConnectionManagerUtilityTest, UserAgentSetNoIncomingUserAgent) {
 TEST_F(ConnectionManagerUtilityTest, RequestIdGeneratedWhenItsNotPresent) {
   {
     TestHeaderMapImpl headers{{":authority", "host"}, {":path", "/"}};
-    EXPECT_CALL(random_, uuid()).WillOnce(Return("generated_uuid"));
+    EXPECT_CALL(random_, fastUuid(_));
 
     ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
                                                    route_config_, random_, runtime_, local_info_);
-    EXPECT_EQ("generated_uuid", headers.get_("x-request-id"));
+    EXPECT_EQ(random_.uuid_, headers.get_("x-request-id"));
   }
 
   {
     Runtime::RandomGeneratorImpl rand;
     TestHeaderMapImpl headers{{"x-client-trace-id", "trace-id"}};
-    std::string uuid = rand.uuid();
+    char uuid_buffer[Runtime::RandomGeneratorImpl::UUID_LENGTH];
+    rand.fastUuid(uuid_buffer);
+    const std::string uuid(uuid_buffer, sizeof(uuid_buffer));
 
-    EXPECT_CALL(random_, uuid()).WillOnce(Return(uuid));
+    EXPECT_CALL(random_, fastUuid(_)).WillOnce(Invoke([&uuid](char* out) -> void {
+      memcpy(out, uuid.c_str(), uuid.size());
+    }));
 
     ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
                                                    route_config_, random_, runtime_, local_info_);
@@ -297,7 +303,7 @@ TEST_F(ConnectionManagerUtilityTest, DoNotOverrideRequestIdIfPresentWhenInternal
   EXPECT_CALL(connection_, remoteAddress()).WillRepeatedly(ReturnRef(local_remote_address));
 
   TestHeaderMapImpl headers{{"x-request-id", "original_request_id"}};
-  EXPECT_CALL(random_, uuid()).Times(0);
+  EXPECT_CALL(random_, fastUuid(_)).Times(0);
 
   ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
                                                  route_config_, random_, runtime_, local_info_);
@@ -309,12 +315,12 @@ TEST_F(ConnectionManagerUtilityTest, OverrideRequestIdForExternalRequests) {
   EXPECT_CALL(connection_, remoteAddress()).WillRepeatedly(ReturnRef(external_ip));
   TestHeaderMapImpl headers{{"x-request-id", "original"}};
 
-  EXPECT_CALL(random_, uuid()).WillOnce(Return("override"));
+  EXPECT_CALL(random_, fastUuid(_));
   ON_CALL(config_, useRemoteAddress()).WillByDefault(Return(true));
 
   ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
                                                  route_config_, random_, runtime_, local_info_);
-  EXPECT_EQ("override", headers.get_("x-request-id"));
+  EXPECT_EQ(random_.uuid_, headers.get_("x-request-id"));
 }
 
 TEST_F(ConnectionManagerUtilityTest, ExternalAddressExternalRequestUseRemote) {
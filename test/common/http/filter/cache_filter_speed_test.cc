@@ -0,0 +1,134 @@
+// Load test of the response cache: worker threads look up keys drawn from a Zipf distribution,
+// the way popular endpoints dominate real traffic, and store a response on each miss. This runs
+// with worker caches only and with a shared cache behind them, for LRU and TinyLFU, and reports
+// the hit ratio and the time per request.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/common/hash.h"
+#include "common/http/filter/cache_filter.h"
+#include "common/stats/stats_impl.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+const uint64_t NUM_KEYS = 100000;
+const uint64_t REQUESTS_PER_THREAD = 1000000;
+const uint64_t RESPONSE_SIZE = 4096;
+
+struct Result {
+  uint64_t hits_{};
+  double ns_per_request_{};
+};
+
+void run(uint32_t num_threads, uint64_t worker_bytes, uint64_t shared_bytes, bool tiny_lfu) {
+  Stats::IsolatedStoreImpl store;
+  CacheFilterStats stats{ALL_CACHE_FILTER_STATS(POOL_COUNTER(store), POOL_GAUGE(store))};
+  std::unique_ptr<SharedResponseCache> shared_cache;
+  if (shared_bytes > 0) {
+    shared_cache.reset(new SharedResponseCache(shared_bytes, tiny_lfu, stats));
+  }
+
+  std::vector<std::string> keys;
+  std::vector<uint64_t> hashes;
+  for (uint64_t i = 0; i < NUM_KEYS; i++) {
+    keys.push_back(fmt::format("api.example.com/v1/items/{}", i));
+    hashes.push_back(HashUtil::xxHash64(keys.back()));
+  }
+
+  // Cumulative Zipf(1) weights over the keys.
+  std::vector<double> cdf(NUM_KEYS);
+  double total = 0;
+  for (uint64_t i = 0; i < NUM_KEYS; i++) {
+    total += 1.0 / (i + 1);
+    cdf[i] = total;
+  }
+
+  std::vector<Result> results(num_threads);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() -> void {
+      std::mt19937_64 random(t);
+      std::uniform_real_distribution<double> uniform(0, total);
+      std::vector<uint64_t> requests(REQUESTS_PER_THREAD);
+      for (uint64_t& request : requests) {
+        request = std::lower_bound(cdf.begin(), cdf.end(), uniform(random)) - cdf.begin();
+      }
+
+      ResponseLru worker_cache(worker_bytes, tiny_lfu);
+      std::shared_ptr<CachedResponse> response = std::make_shared<CachedResponse>();
+      response->size_ = RESPONSE_SIZE;
+      uint64_t evicted = 0;
+      Result& result = results[t];
+      const auto start = std::chrono::steady_clock::now();
+      for (uint64_t request : requests) {
+        const std::string& key = keys[request];
+        const uint64_t hash = hashes[request];
+        if (worker_cache.lookup(key, hash)) {
+          result.hits_++;
+          continue;
+        }
+
+        CachedResponseConstSharedPtr shared;
+        if (shared_cache) {
+          shared = shared_cache->lookup(key, hash);
+        }
+        if (shared) {
+          result.hits_++;
+          worker_cache.insert(key, hash, shared, evicted);
+        } else {
+          worker_cache.insert(key, hash, response, evicted);
+          if (shared_cache) {
+            shared_cache->insert(key, hash, response);
+          }
+        }
+      }
+      result.ns_per_request_ = std::chrono::duration<double, std::nano>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count() /
+                               REQUESTS_PER_THREAD;
+    });
+  }
+
+  Result sum;
+  for (uint32_t t = 0; t < num_threads; t++) {
+    threads[t].join();
+    sum.hits_ += results[t].hits_;
+    sum.ns_per_request_ += results[t].ns_per_request_;
+  }
+
+  std::cout << fmt::format("{:>8} {:>8} {:>10} {:>10} {:>12.1f}% {:>14.0f}", num_threads,
+                           tiny_lfu ? "tinylfu" : "lru", worker_bytes / 1024, shared_bytes / 1024,
+                           100.0 * sum.hits_ / (num_threads * REQUESTS_PER_THREAD),
+                           sum.ns_per_request_ / num_threads)
+            << std::endl;
+}
+
+} // namespace
+} // namespace Http
+} // namespace Envoy
+
+int main() {
+  std::cout << fmt::format("{:>8} {:>8} {:>10} {:>10} {:>13} {:>14}", "threads", "eviction",
+                           "worker_kb", "shared_kb", "hit_ratio", "ns_per_request")
+            << std::endl;
+  const uint32_t num_threads = std::max(2U, std::thread::hardware_concurrency());
+  const uint64_t worker_bytes = 8 * 1024 * 1024;
+  const uint64_t shared_bytes = 64 * 1024 * 1024;
+  for (bool tiny_lfu : {false, true}) {
+    Envoy::Http::run(num_threads, worker_bytes, 0, tiny_lfu);
+    Envoy::Http::run(num_threads, worker_bytes, shared_bytes, tiny_lfu);
+  }
+  return 0;
+}
@@ -0,0 +1,467 @@
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/filter/cache_filter.h"
+#include "common/http/header_map_impl.h"
+#include "common/json/json_loader.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::ReturnPointee;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+
+TEST(CacheControlTest, Parse) {
+  CacheControl empty = CacheControl::parse(nullptr);
+  EXPECT_FALSE(empty.no_cache_ || empty.no_store_ || empty.private_);
+  EXPECT_EQ(-1, empty.max_age_);
+  EXPECT_EQ(-1, empty.s_maxage_);
+
+  TestHeaderMapImpl headers{
+      {"cache-control", "public, Max-Age = 60,s-maxage=\"30\", no-cache=\"set-cookie\",private"}};
+  CacheControl cache_control = CacheControl::parse(headers.CacheControl());
+  EXPECT_EQ(60, cache_control.max_age_);
+  EXPECT_EQ(30, cache_control.s_maxage_);
+  EXPECT_TRUE(cache_control.no_cache_);
+  EXPECT_TRUE(cache_control.private_);
+  EXPECT_FALSE(cache_control.no_store_);
+
+  TestHeaderMapImpl shared{{"cache-control", "public, must-revalidate"}};
+  cache_control = CacheControl::parse(shared.CacheControl());
+  EXPECT_TRUE(cache_control.public_);
+  EXPECT_TRUE(cache_control.must_revalidate_);
+  EXPECT_FALSE(empty.public_ || empty.must_revalidate_);
+
+  TestHeaderMapImpl bad{{"cache-control", "no-store, max-age=abc"}};
+  cache_control = CacheControl::parse(bad.CacheControl());
+  EXPECT_TRUE(cache_control.no_store_);
+  EXPECT_EQ(-1, cache_control.max_age_);
+}
+
+TEST(FrequencySketchTest, RecordAndAge) {
+  FrequencySketch sketch(64);
+  EXPECT_EQ(0U, sketch.estimate(1));
+  for (int i = 0; i < 5; i++) {
+    sketch.record(1);
+  }
+  EXPECT_EQ(5U, sketch.estimate(1));
+  EXPECT_EQ(0U, sketch.estimate(2));
+
+  // Counters saturate, and are halved once 10 accesses per counter have been recorded.
+  for (int i = 0; i < 100; i++) {
+    sketch.record(1);
+  }
+  EXPECT_EQ(15U, sketch.estimate(1));
+  for (int i = 0; i < 640 - 105; i++) {
+    sketch.record(1000 + i);
+  }
+  EXPECT_EQ(7U, sketch.estimate(1));
+}
+
+CachedResponseConstSharedPtr makeResponse(uint64_t size) {
+  std::shared_ptr<CachedResponse> response = std::make_shared<CachedResponse>();
+  response->size_ = size;
+  return response;
+}
+
+TEST(ResponseLruTest, Lru) {
+  ResponseLru lru(300, false);
+  uint64_t evicted = 0;
+  EXPECT_TRUE(lru.insert("a", 1, makeResponse(100), evicted));
+  EXPECT_TRUE(lru.insert("b", 2, makeResponse(100), evicted));
+  EXPECT_TRUE(lru.insert("c", 3, makeResponse(100), evicted));
+  EXPECT_EQ(300U, lru.bytes());
+  EXPECT_NE(nullptr, lru.lookup("a", 1));
+
+  // "b" is the least recently used.
+  EXPECT_TRUE(lru.insert("d", 4, makeResponse(150), evicted));
+  EXPECT_EQ(2U, evicted);
+  EXPECT_EQ(nullptr, lru.lookup("b", 2));
+  EXPECT_EQ(nullptr, lru.lookup("c", 3));
+  EXPECT_NE(nullptr, lru.lookup("a", 1));
+  EXPECT_EQ(250U, lru.bytes());
+
+  // Replacing an entry.
+  EXPECT_TRUE(lru.insert("a", 1, makeResponse(50), evicted));
+  EXPECT_EQ(200U, lru.bytes());
+  EXPECT_EQ(2U, evicted);
+
+  EXPECT_FALSE(lru.insert("e", 5, makeResponse(301), evicted));
+  lru.remove("a");
+  lru.remove("a");
+  EXPECT_EQ(150U, lru.bytes());
+}
+
+TEST(ResponseLruTest, TinyLfuAdmission) {
+  ResponseLru lru(200, true);
+  uint64_t evicted = 0;
+  EXPECT_TRUE(lru.insert("a", 1, makeResponse(100), evicted));
+  EXPECT_TRUE(lru.insert("b", 2, makeResponse(100), evicted));
+  for (int i = 0; i < 3; i++) {
+    lru.lookup("a", 1);
+    lru.lookup("b", 2);
+  }
+
+  // A key seen once does not displace popular ones.
+  EXPECT_EQ(nullptr, lru.lookup("c", 3));
+  EXPECT_FALSE(lru.insert("c", 3, makeResponse(100), evicted));
+  EXPECT_EQ(0U, evicted);
+
+  // Once it is more popular than the least recently used entry, it does.
+  for (int i = 0; i < 4; i++) {
+    lru.lookup("c", 3);
+  }
+  EXPECT_TRUE(lru.insert("c", 3, makeResponse(100), evicted));
+  EXPECT_EQ(1U, evicted);
+  EXPECT_EQ(nullptr, lru.lookup("a", 1));
+}
+
+TEST(ResponseLruTest, TinyLfuRejectEvictsNothing) {
+  ResponseLru lru(300, true);
+  uint64_t evicted = 0;
+  EXPECT_TRUE(lru.insert("a", 1, makeResponse(100), evicted));
+  EXPECT_TRUE(lru.insert("b", 2, makeResponse(100), evicted));
+  EXPECT_TRUE(lru.insert("c", 3, makeResponse(100), evicted));
+  for (int i = 0; i < 5; i++) {
+    lru.lookup("b", 2);
+    lru.lookup("c", 3);
+  }
+  for (int i = 0; i < 2; i++) {
+    EXPECT_EQ(nullptr, lru.lookup("d", 4));
+  }
+
+  // "d" is more popular than "a", but not than "b", which would have to go as well.
+  EXPECT_FALSE(lru.insert("d", 4, makeResponse(200), evicted));
+  EXPECT_EQ(0U, evicted);
+  EXPECT_EQ(300U, lru.bytes());
+  EXPECT_NE(nullptr, lru.lookup("a", 1));
+}
+
+class CacheFilterTest : public testing::Test {
+public:
+  CacheFilterTest() {
+    ON_CALL(time_source_, currentTime()).WillByDefault(ReturnPointee(&now_));
+    setup("{}");
+  }
+
+  void setup(const std::string& json) {
+    Json::ObjectSharedPtr config = Json::Factory::loadFromString(json);
+    config_.reset(new CacheFilterConfig(*config, "test.", store_, tls_, time_source_));
+  }
+
+  typedef std::vector<std::pair<std::string, std::string>> HeaderList;
+
+  struct Stream {
+    Stream(CacheFilterConfigSharedPtr config) : filter_(config) {
+      filter_.setDecoderFilterCallbacks(decoder_callbacks_);
+      filter_.setEncoderFilterCallbacks(encoder_callbacks_);
+    }
+
+    ~Stream() { filter_.onDestroy(); }
+
+    FilterHeadersStatus decodeHeaders(const std::string& path, const HeaderList& extra_headers) {
+      request_headers_.addCopy(":method", "GET");
+      request_headers_.addCopy(":authority", "example.com");
+      request_headers_.addCopy(":path", path);
+      for (const auto& header : extra_headers) {
+        request_headers_.addCopy(header.first, header.second);
+      }
+      return filter_.decodeHeaders(request_headers_, true);
+    }
+
+    CacheFilter filter_;
+    NiceMock<MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+    NiceMock<MockStreamEncoderFilterCallbacks> encoder_callbacks_;
+    TestHeaderMapImpl request_headers_;
+  };
+  typedef std::unique_ptr<Stream> StreamPtr;
+
+  StreamPtr request(const std::string& path, FilterHeadersStatus expected_status,
+                    const HeaderList& extra_headers = {}) {
+    StreamPtr stream(new Stream(config_));
+    EXPECT_EQ(expected_status, stream->decodeHeaders(path, extra_headers));
+    return stream;
+  }
+
+  // Sends a response through a stream that went upstream.
+  void respond(Stream& stream, const HeaderList& response_headers,
+               const std::string& body = "hello") {
+    TestHeaderMapImpl headers;
+    for (const auto& header : response_headers) {
+      headers.addCopy(header.first, header.second);
+    }
+    EXPECT_EQ(FilterHeadersStatus::Continue, stream.filter_.encodeHeaders(headers, body.empty()));
+    if (!body.empty()) {
+      Buffer::OwnedImpl data(body);
+      EXPECT_EQ(FilterDataStatus::Continue, stream.filter_.encodeData(data, true));
+    }
+  }
+
+  // Expects a stream to be served from the cache.
+  void expectServed(Stream& stream, const std::string& body = "hello",
+                    const std::string& age = "0") {
+    EXPECT_CALL(stream.decoder_callbacks_, encodeHeaders_(_, false))
+        .WillOnce(Invoke([age](HeaderMap& headers, bool) -> void {
+          EXPECT_STREQ("200", headers.Status()->value().c_str());
+          EXPECT_STREQ(age.c_str(), headers.get(Headers::get().Age)->value().c_str());
+        }));
+    EXPECT_CALL(stream.decoder_callbacks_, encodeData(_, true))
+        .WillOnce(Invoke([body](Buffer::Instance& data, bool) -> void {
+          EXPECT_EQ(body, TestUtility::bufferToString(data));
+        }));
+  }
+
+  void expectHit(const std::string& path, const std::string& body = "hello",
+                 const std::string& age = "0", const HeaderList& extra_headers = {}) {
+    Stream stream(config_);
+    expectServed(stream, body, age);
+    EXPECT_EQ(FilterHeadersStatus::StopIteration, stream.decodeHeaders(path, extra_headers));
+  }
+
+  // Stores a response for a path.
+  void populate(const std::string& path,
+                const HeaderList& response_headers = {{":status", "200"},
+                                                      {"cache-control", "max-age=10"}}) {
+    StreamPtr stream = request(path, FilterHeadersStatus::Continue);
+    respond(*stream, response_headers);
+  }
+
+  uint64_t counter(const std::string& name) { return store_.counter("test.cache." + name).value(); }
+
+  Stats::IsolatedStoreImpl store_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  MonotonicTime now_;
+  CacheFilterConfigSharedPtr config_;
+};
+
+TEST_F(CacheFilterTest, MissThenHit) {
+  populate("/a");
+  EXPECT_EQ(1U, counter("miss"));
+  EXPECT_EQ(1U, counter("insert"));
+
+  expectHit("/a");
+  EXPECT_EQ(1U, counter("hit"));
+
+  // Other paths are not affected.
+  request("/b", FilterHeadersStatus::Continue);
+  EXPECT_EQ(2U, counter("miss"));
+}
+
+TEST_F(CacheFilterTest, HeaderOnlyResponse) {
+  {
+    StreamPtr stream = request("/a", FilterHeadersStatus::Continue);
+    respond(*stream, {{":status", "200"}, {"cache-control", "max-age=10"}}, "");
+  }
+
+  StreamPtr stream(new Stream(config_));
+  EXPECT_CALL(stream->decoder_callbacks_, encodeHeaders_(_, true));
+  EXPECT_CALL(stream->decoder_callbacks_, encodeData(_, _)).Times(0);
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, stream->decodeHeaders("/a", {}));
+  // The served response is not stored again.
+  TestHeaderMapImpl served{{":status", "200"}, {"cache-control", "max-age=10"}};
+  stream->filter_.encodeHeaders(served, true);
+  EXPECT_EQ(1U, counter("insert"));
+}
+
+TEST_F(CacheFilterTest, Expiry) {
+  populate("/a", {{":status", "200"}, {"cache-control", "max-age=60, s-maxage=10"}, {"age", "2"}});
+
+  now_ += std::chrono::seconds(3);
+  expectHit("/a", "hello", "5");
+
+  // s-maxage wins over max-age, and the age the response had upstream counts.
+  now_ += std::chrono::seconds(5);
+  request("/a", FilterHeadersStatus::Continue);
+  EXPECT_EQ(2U, counter("miss"));
+}
+
+TEST_F(CacheFilterTest, NotCacheable) {
+  const std::vector<HeaderList> responses{
+      {{":status", "200"}},
+      {{":status", "200"}, {"cache-control", "max-age=0"}},
+      {{":status", "200"}, {"cache-control", "max-age=10, no-store"}},
+      {{":status", "200"}, {"cache-control", "max-age=10, no-cache"}},
+      {{":status", "200"}, {"cache-control", "private, max-age=10"}},
+      {{":status", "200"}, {"cache-control", "max-age=10"}, {"age", "10"}},
+      {{":status", "404"}, {"cache-control", "max-age=10"}},
+      {{":status", "200"}, {"cache-control", "max-age=10"}, {"set-cookie", "a=b"}},
+      {{":status", "200"}, {"cache-control", "max-age=10"}, {"vary", "*"}},
+      {{":status", "200"}, {"cache-control", "max-age=10"}, {"content-length", "2000000"}}};
+  for (const HeaderList& headers : responses) {
+    populate("/a", headers);
+  }
+
+  EXPECT_EQ(responses.size(), counter("not_cacheable"));
+  EXPECT_EQ(0U, counter("insert"));
+  request("/a", FilterHeadersStatus::Continue);
+}
+
+TEST_F(CacheFilterTest, Bypass) {
+  populate("/a");
+
+  StreamPtr stream(new Stream(config_));
+  TestHeaderMapImpl post{{":method", "POST"}, {":authority", "example.com"}, {":path", "/a"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, stream->filter_.decodeHeaders(post, true));
+  TestHeaderMapImpl get{{":method", "GET"}, {":authority", "example.com"}, {":path", "/a"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, stream->filter_.decodeHeaders(get, false));
+  request("/a", FilterHeadersStatus::Continue, {{"cache-control", "no-store"}});
+
+  // A no-cache request goes upstream, and its response replaces the stored one.
+  stream = request("/a", FilterHeadersStatus::Continue, {{"cache-control", "no-cache"}});
+  respond(*stream, {{":status", "200"}, {"cache-control", "max-age=10"}}, "updated");
+  EXPECT_EQ(4U, counter("bypass"));
+  expectHit("/a", "updated");
+}
+
+TEST_F(CacheFilterTest, Authorization) {
+  // A response to a request with credentials is only stored if it is marked as shareable.
+  const HeaderList authorization{{"authorization", "Bearer secret"}};
+  StreamPtr stream = request("/a", FilterHeadersStatus::Continue, authorization);
+  respond(*stream, {{":status", "200"}, {"cache-control", "max-age=10"}});
+  EXPECT_EQ(1U, counter("not_cacheable"));
+  request("/a", FilterHeadersStatus::Continue);
+
+  const HeaderList shareable{{"/b", "public, max-age=10"},
+                             {"/c", "s-maxage=10"},
+                             {"/d", "must-revalidate, max-age=10"}};
+  for (const auto& path_and_cache_control : shareable) {
+    stream = request(path_and_cache_control.first, FilterHeadersStatus::Continue, authorization);
+    respond(*stream, {{":status", "200"}, {"cache-control", path_and_cache_control.second}});
+    expectHit(path_and_cache_control.first);
+  }
+  EXPECT_EQ(3U, counter("insert"));
+
+  // Stored responses are used for requests with credentials.
+  expectHit("/b", "hello", "0", authorization);
+}
+
+TEST_F(CacheFilterTest, Vary) {
+  {
+    StreamPtr stream =
+        request("/a", FilterHeadersStatus::Continue, {{"accept-encoding", "gzip"}});
+    respond(*stream,
+            {{":status", "200"}, {"cache-control", "max-age=10"}, {"vary", "Accept-Encoding"}});
+  }
+
+  expectHit("/a", "hello", "0", {{"accept-encoding", "gzip"}});
+  request("/a", FilterHeadersStatus::Continue, {{"accept-encoding", "br"}});
+  request("/a", FilterHeadersStatus::Continue);
+}
+
+TEST_F(CacheFilterTest, Coalesce) {
+  StreamPtr leader = request("/a", FilterHeadersStatus::Continue);
+  StreamPtr follower1 = request("/a", FilterHeadersStatus::StopIteration);
+  StreamPtr follower2 = request("/a", FilterHeadersStatus::StopIteration);
+  StreamPtr gone = request("/a", FilterHeadersStatus::StopIteration);
+  EXPECT_EQ(3U, counter("coalesced"));
+  EXPECT_EQ(1U, counter("miss"));
+
+  // A waiting request that goes away is not woken up.
+  EXPECT_CALL(gone->decoder_callbacks_, continueDecoding()).Times(0);
+  gone.reset();
+
+  expectServed(*follower1, "hello world");
+  expectServed(*follower2, "hello world");
+  TestHeaderMapImpl headers{{":status", "200"}, {"cache-control", "max-age=10"}};
+  leader->filter_.encodeHeaders(headers, false);
+  Buffer::OwnedImpl data1("hello ");
+  leader->filter_.encodeData(data1, false);
+  Buffer::OwnedImpl data2("world");
+  leader->filter_.encodeData(data2, true);
+
+  // The next miss leads again.
+  now_ += std::chrono::seconds(20);
+  request("/a", FilterHeadersStatus::Continue);
+}
+
+TEST_F(CacheFilterTest, CoalesceNotCacheable) {
+  StreamPtr leader = request("/a", FilterHeadersStatus::Continue);
+  StreamPtr follower = request("/a", FilterHeadersStatus::StopIteration);
+
+  // The waiting request goes upstream itself, and can store its own response.
+  EXPECT_CALL(follower->decoder_callbacks_, continueDecoding());
+  respond(*leader, {{":status", "500"}});
+  respond(*follower, {{":status", "200"}, {"cache-control", "max-age=10"}});
+  expectHit("/a");
+}
+
+TEST_F(CacheFilterTest, CoalesceLeaderReset) {
+  StreamPtr leader = request("/a", FilterHeadersStatus::Continue);
+  StreamPtr follower = request("/a", FilterHeadersStatus::StopIteration);
+
+  EXPECT_CALL(follower->decoder_callbacks_, continueDecoding());
+  TestHeaderMapImpl headers{{":status", "200"}, {"cache-control", "max-age=10"}};
+  leader->filter_.encodeHeaders(headers, false);
+  leader.reset();
+}
+
+TEST_F(CacheFilterTest, CoalesceVaryMismatch) {
+  StreamPtr leader = request("/a", FilterHeadersStatus::Continue, {{"accept-encoding", "gzip"}});
+  StreamPtr follower = request("/a", FilterHeadersStatus::StopIteration);
+
+  EXPECT_CALL(follower->decoder_callbacks_, continueDecoding());
+  respond(*leader,
+          {{":status", "200"}, {"cache-control", "max-age=10"}, {"vary", "accept-encoding"}});
+}
+
+TEST_F(CacheFilterTest, LargeBody) {
+  setup(R"EOF({"max_entry_bytes": 8})EOF");
+  StreamPtr leader = request("/a", FilterHeadersStatus::Continue);
+  StreamPtr follower = request("/a", FilterHeadersStatus::StopIteration);
+
+  EXPECT_CALL(follower->decoder_callbacks_, continueDecoding());
+  respond(*leader, {{":status", "200"}, {"cache-control", "max-age=10"}}, "123456789");
+  EXPECT_EQ(1U, counter("not_cacheable"));
+}
+
+TEST_F(CacheFilterTest, Trailers) {
+  StreamPtr stream = request("/a", FilterHeadersStatus::Continue);
+  TestHeaderMapImpl headers{{":status", "200"}, {"cache-control", "max-age=10"}};
+  stream->filter_.encodeHeaders(headers, false);
+  Buffer::OwnedImpl data("hello");
+  stream->filter_.encodeData(data, false);
+  TestHeaderMapImpl trailers{{"grpc-status", "0"}};
+  EXPECT_EQ(FilterTrailersStatus::Continue, stream->filter_.encodeTrailers(trailers));
+  EXPECT_EQ(1U, counter("not_cacheable"));
+  request("/a", FilterHeadersStatus::Continue);
+}
+
+TEST_F(CacheFilterTest, SharedCache) {
+  // The worker cache only holds one response.
+  setup(R"EOF({"max_worker_bytes": 200, "max_shared_bytes": 1000000})EOF");
+  populate("/a");
+  populate("/b");
+  EXPECT_LT(0U, store_.gauge("test.cache.shared_bytes").value());
+
+  // "/a" was evicted from the worker cache.
+  expectHit("/a");
+  EXPECT_EQ(1U, counter("shared_hit"));
+  expectHit("/a");
+  EXPECT_EQ(1U, counter("shared_hit"));
+  EXPECT_EQ(2U, counter("hit"));
+
+  // Expired responses are dropped from the shared cache.
+  now_ += std::chrono::seconds(20);
+  request("/b", FilterHeadersStatus::Continue);
+  request("/a", FilterHeadersStatus::Continue);
+  EXPECT_EQ(0U, store_.gauge("test.cache.shared_bytes").value());
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,270 @@
+#include <memory>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/filter/gzip_filter.h"
+#include "common/http/header_map_impl.h"
+#include "common/json/json_loader.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+
+class GzipFilterTest : public testing::Test {
+public:
+  GzipFilterTest() { setup("{}"); }
+
+  void setup(const std::string& json) {
+    Json::ObjectSharedPtr config = Json::Factory::loadFromString(json);
+    config_.reset(new GzipFilterConfig(*config, "test.", store_, tls_));
+    newFilter();
+  }
+
+  void newFilter() {
+    filter_.reset(new GzipFilter(config_));
+    filter_->setDecoderFilterCallbacks(decoder_callbacks_);
+    filter_->setEncoderFilterCallbacks(encoder_callbacks_);
+  }
+
+  // Inflates data, which must hold a whole compressed stream unless complete is false.
+  static std::string inflate(const std::string& data, bool gzip, bool complete = true) {
+    z_stream zstream{};
+    EXPECT_EQ(Z_OK, inflateInit2(&zstream, gzip ? MAX_WBITS + 16 : MAX_WBITS));
+    zstream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zstream.avail_in = data.size();
+    std::string output;
+    int rc;
+    do {
+      char chunk[4096];
+      zstream.next_out = reinterpret_cast<Bytef*>(chunk);
+      zstream.avail_out = sizeof(chunk);
+      rc = ::inflate(&zstream, Z_NO_FLUSH);
+      output.append(chunk, sizeof(chunk) - zstream.avail_out);
+    } while (rc == Z_OK && (complete || zstream.avail_in > 0 || zstream.avail_out == 0));
+    if (complete) {
+      EXPECT_EQ(Z_STREAM_END, rc);
+    } else {
+      EXPECT_TRUE(rc == Z_OK || rc == Z_BUF_ERROR);
+      EXPECT_EQ(0U, zstream.avail_in);
+    }
+    inflateEnd(&zstream);
+    return output;
+  }
+
+  // Runs a response through the filter, returning the body the filter produced.
+  std::string encode(TestHeaderMapImpl& response_headers, const std::string& body,
+                     const std::string& accept_encoding = "gzip") {
+    TestHeaderMapImpl request_headers{{":method", "GET"}, {"accept-encoding", accept_encoding}};
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(response_headers, false));
+    Buffer::OwnedImpl data(body);
+    EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, true));
+    filter_->onDestroy();
+    return TestUtility::bufferToString(data);
+  }
+
+  uint64_t counter(const std::string& name) { return store_.counter("test.gzip." + name).value(); }
+
+  Stats::IsolatedStoreImpl store_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  GzipFilterConfigSharedPtr config_;
+  std::unique_ptr<GzipFilter> filter_;
+  NiceMock<MockStreamDecoderFilterCallbacks> decoder_callbacks_;
+  NiceMock<MockStreamEncoderFilterCallbacks> encoder_callbacks_;
+  const std::string body_{std::string(1000, 'a') + "some text to compress" + std::string(1000, 'b')};
+};
+
+TEST_F(GzipFilterTest, Negotiate) {
+  auto negotiate = [](const std::string& value) -> GzipEncoding {
+    TestHeaderMapImpl headers{{"accept-encoding", value}};
+    return GzipFilterConfig::negotiate(headers.AcceptEncoding());
+  };
+
+  EXPECT_EQ(GzipEncoding::None, GzipFilterConfig::negotiate(nullptr));
+  EXPECT_EQ(GzipEncoding::None, negotiate(""));
+  EXPECT_EQ(GzipEncoding::None, negotiate("identity, br"));
+  EXPECT_EQ(GzipEncoding::Gzip, negotiate("gzip"));
+  EXPECT_EQ(GzipEncoding::Gzip, negotiate("GZIP"));
+  EXPECT_EQ(GzipEncoding::Gzip, negotiate("deflate, gzip;q=0.5"));
+  EXPECT_EQ(GzipEncoding::Gzip, negotiate("br , gzip ; q=1.0 , deflate"));
+  EXPECT_EQ(GzipEncoding::Deflate, negotiate("deflate"));
+  EXPECT_EQ(GzipEncoding::Deflate, negotiate("gzip;q=0, deflate"));
+  EXPECT_EQ(GzipEncoding::Deflate, negotiate("gzip; q=0.000, deflate;q=0.1"));
+  EXPECT_EQ(GzipEncoding::None, negotiate("gzip;q=0, deflate;q=0"));
+  EXPECT_EQ(GzipEncoding::Gzip, negotiate("*"));
+  EXPECT_EQ(GzipEncoding::Deflate, negotiate("*, gzip;q=0, deflate"));
+  EXPECT_EQ(GzipEncoding::None, negotiate("*;q=0"));
+  EXPECT_EQ(GzipEncoding::None, negotiate("gzipped, xdeflate"));
+}
+
+TEST_F(GzipFilterTest, CompressGzip) {
+  TestHeaderMapImpl headers{{":status", "200"},
+                            {"content-type", "text/html; charset=UTF-8"},
+                            {"content-length", std::to_string(body_.size())}};
+  const std::string compressed = encode(headers, body_);
+
+  EXPECT_EQ(body_, inflate(compressed, true));
+  EXPECT_LT(compressed.size(), body_.size());
+  EXPECT_STREQ("gzip", headers.ContentEncoding()->value().c_str());
+  EXPECT_STREQ("Accept-Encoding", headers.Vary()->value().c_str());
+  EXPECT_EQ(nullptr, headers.ContentLength());
+
+  EXPECT_EQ(1U, counter("compressed"));
+  EXPECT_EQ(body_.size(), counter("total_uncompressed_bytes"));
+  EXPECT_EQ(compressed.size(), counter("total_compressed_bytes"));
+  EXPECT_EQ(1U, counter("zlib_stream_created"));
+}
+
+TEST_F(GzipFilterTest, CompressDeflate) {
+  TestHeaderMapImpl headers{{":status", "200"}, {"content-type", "application/json"}};
+  const std::string compressed = encode(headers, body_, "deflate");
+
+  EXPECT_EQ(body_, inflate(compressed, false));
+  EXPECT_STREQ("deflate", headers.ContentEncoding()->value().c_str());
+}
+
+TEST_F(GzipFilterTest, Streaming) {
+  TestHeaderMapImpl request_headers{{"accept-encoding", "gzip"}};
+  filter_->decodeHeaders(request_headers, true);
+  TestHeaderMapImpl headers{{":status", "200"}, {"content-type", "text/plain"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+
+  // Each chunk is compressed as it passes through and nothing is held back by the filter: the
+  // output so far always inflates to all of the input so far.
+  std::string compressed;
+  std::string expected;
+  for (int i = 0; i < 100; i++) {
+    const std::string chunk = std::to_string(i) + std::string(1000 + i, 'x');
+    expected += chunk;
+    Buffer::OwnedImpl data(chunk);
+    EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, i == 99));
+    EXPECT_NE(0U, data.length());
+    compressed += TestUtility::bufferToString(data);
+    EXPECT_EQ(expected, inflate(compressed, true, i == 99));
+  }
+  EXPECT_EQ(expected.size(), counter("total_uncompressed_bytes"));
+}
+
+TEST_F(GzipFilterTest, Trailers) {
+  TestHeaderMapImpl request_headers{{"accept-encoding", "gzip"}};
+  filter_->decodeHeaders(request_headers, true);
+  TestHeaderMapImpl headers{{":status", "200"}, {"content-type", "text/plain"}};
+  filter_->encodeHeaders(headers, false);
+
+  Buffer::OwnedImpl data(body_);
+  filter_->encodeData(data, false);
+  std::string compressed = TestUtility::bufferToString(data);
+
+  // The end of the compressed body is added before the trailers.
+  EXPECT_CALL(encoder_callbacks_, addEncodedData(_, true))
+      .WillOnce(Invoke([&](Buffer::Instance& data, bool) -> void {
+        compressed += TestUtility::bufferToString(data);
+      }));
+  TestHeaderMapImpl trailers{{"grpc-status", "0"}};
+  EXPECT_EQ(FilterTrailersStatus::Continue, filter_->encodeTrailers(trailers));
+  EXPECT_EQ(body_, inflate(compressed, true));
+}
+
+TEST_F(GzipFilterTest, StreamReuse) {
+  for (int i = 0; i < 3; i++) {
+    newFilter();
+    TestHeaderMapImpl headers{{":status", "200"}, {"content-type", "text/plain"}};
+    EXPECT_EQ(body_, inflate(encode(headers, body_), true));
+  }
+  EXPECT_EQ(1U, counter("zlib_stream_created"));
+  EXPECT_EQ(2U, counter("zlib_stream_reused"));
+
+  // A stream reset mid response returns the stream to the pool.
+  newFilter();
+  TestHeaderMapImpl request_headers{{"accept-encoding", "gzip"}};
+  filter_->decodeHeaders(request_headers, true);
+  TestHeaderMapImpl headers{{":status", "200"}, {"content-type", "text/plain"}};
+  filter_->encodeHeaders(headers, false);
+  Buffer::OwnedImpl data(body_);
+  filter_->encodeData(data, false);
+  filter_->onDestroy();
+
+  newFilter();
+  TestHeaderMapImpl headers2{{":status", "200"}, {"content-type", "text/plain"}};
+  EXPECT_EQ(body_, inflate(encode(headers2, body_), true));
+  EXPECT_EQ(1U, counter("zlib_stream_created"));
+  EXPECT_EQ(4U, counter("zlib_stream_reused"));
+}
+
+TEST_F(GzipFilterTest, NotAccepted) {
+  TestHeaderMapImpl headers{
+      {":status", "200"}, {"content-type", "text/plain"}, {"vary", "Origin"}};
+  EXPECT_EQ(body_, encode(headers, body_, "gzip;q=0"));
+  EXPECT_EQ(nullptr, headers.ContentEncoding());
+  EXPECT_STREQ("Origin, Accept-Encoding", headers.Vary()->value().c_str());
+  EXPECT_EQ(1U, counter("not_accepted"));
+}
+
+TEST_F(GzipFilterTest, NotCompressed) {
+  auto expectNotCompressed = [this](TestHeaderMapImpl&& headers) -> void {
+    newFilter();
+    EXPECT_EQ(body_, encode(headers, body_));
+    EXPECT_EQ(nullptr, headers.Vary());
+  };
+
+  expectNotCompressed({{":status", "200"}, {"content-type", "image/png"}});
+  expectNotCompressed({{":status", "200"}});
+  expectNotCompressed(
+      {{":status", "200"}, {"content-type", "text/plain"}, {"content-encoding", "br"}});
+  expectNotCompressed(
+      {{":status", "200"}, {"content-type", "text/plain"}, {"cache-control", "no-transform"}});
+  expectNotCompressed(
+      {{":status", "200"}, {"content-type", "text/plain"}, {"content-length", "29"}});
+  EXPECT_EQ(5U, counter("not_compressed"));
+  EXPECT_EQ(0U, counter("compressed"));
+
+  // Header only responses are left alone.
+  newFilter();
+  TestHeaderMapImpl request_headers{{"accept-encoding", "gzip"}};
+  filter_->decodeHeaders(request_headers, true);
+  TestHeaderMapImpl headers{{":status", "200"}, {"content-type", "text/plain"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, true));
+  EXPECT_EQ(nullptr, headers.ContentEncoding());
+}
+
+TEST_F(GzipFilterTest, Config) {
+  setup(R"EOF(
+  {
+    "compression_level": 1,
+    "min_content_length": 100,
+    "content_types": ["Application/Octet-Stream"]
+  }
+  )EOF");
+
+  TestHeaderMapImpl headers{{":status", "200"},
+                            {"content-type", "application/octet-stream"},
+                            {"content-length", std::to_string(body_.size())}};
+  EXPECT_EQ(body_, inflate(encode(headers, body_), true));
+
+  newFilter();
+  TestHeaderMapImpl headers2{
+      {":status", "200"}, {"content-type", "application/octet-stream"}, {"content-length", "99"}};
+  EXPECT_EQ(body_, encode(headers2, body_));
+
+  newFilter();
+  TestHeaderMapImpl headers3{{":status", "200"}, {"content-type", "text/html"}};
+  EXPECT_EQ(body_, encode(headers3, body_));
+
+  EXPECT_THROW(setup(R"EOF({"compression_level": 10})EOF"), Json::Exception);
+  EXPECT_THROW(setup(R"EOF({"unknown": 10})EOF"), Json::Exception);
+}
+
+} // namespace Http
+} // namespace Envoy
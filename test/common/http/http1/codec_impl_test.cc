@@ -1,4 +1,5 @@
 #include <string>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
 #include "envoy/event/dispatcher.h"
@@ -524,6 +525,353 @@ TEST_F(Http1ServerConnectionImplTest, WatermarkTest) {
       ->onUnderlyingConnectionBelowWriteBufferLowWatermark();
 }
 
+TEST_F(Http1ServerConnectionImplTest, FastParserSplitBody) {
+  codec_settings_.fast_request_parser_ = true;
+  initialize();
+
+  InSequence sequence;
+
+  Http::MockStreamDecoder decoder;
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(ReturnRef(decoder));
+
+  TestHeaderMapImpl expected_headers{
+      {"content-length", "10"}, {"x-foo", "Bar"}, {":path", "/a?b"}, {":method", "POST"}};
+  EXPECT_CALL(decoder, decodeHeaders_(HeaderMapEqual(&expected_headers), false)).Times(1);
+
+  Buffer::OwnedImpl expected_data1("12345");
+  EXPECT_CALL(decoder, decodeData(BufferEqual(&expected_data1), false)).Times(1);
+
+  Buffer::OwnedImpl buffer(
+      "POST /a?b HTTP/1.1\r\nContent-Length: 10\r\nX-Foo: Bar\r\n\r\n12345");
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+
+  Buffer::OwnedImpl expected_data2("67890");
+  EXPECT_CALL(decoder, decodeData(BufferEqual(&expected_data2), false)).Times(1);
+
+  Buffer::OwnedImpl expected_data3;
+  EXPECT_CALL(decoder, decodeData(BufferEqual(&expected_data3), true)).Times(1);
+
+  buffer.add("67890GET");
+  codec_->dispatch(buffer);
+  EXPECT_EQ(3U, buffer.length());
+}
+
+// Requests the fast parser does not handle are parsed by http_parser, and the fast parser takes
+// over again for the next request.
+TEST_F(Http1ServerConnectionImplTest, FastParserFallback) {
+  codec_settings_.fast_request_parser_ = true;
+  initialize();
+
+  InSequence sequence;
+
+  Http::MockStreamDecoder decoder;
+  Http::StreamEncoder* response_encoder = nullptr;
+  auto new_stream = [&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+    response_encoder = &encoder;
+    return decoder;
+  };
+
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(Invoke(new_stream));
+  TestHeaderMapImpl expected_headers1{{":path", "/1"}, {":method", "GET"}};
+  EXPECT_CALL(decoder, decodeHeaders_(HeaderMapEqual(&expected_headers1), true)).Times(1);
+
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(Invoke(new_stream));
+  TestHeaderMapImpl expected_headers2{
+      {"transfer-encoding", "chunked"}, {":path", "/2"}, {":method", "POST"}};
+  EXPECT_CALL(decoder, decodeHeaders_(HeaderMapEqual(&expected_headers2), false)).Times(1);
+  Buffer::OwnedImpl expected_data2("hello");
+  EXPECT_CALL(decoder, decodeData(BufferEqual(&expected_data2), false)).Times(1);
+  Buffer::OwnedImpl expected_data3;
+  EXPECT_CALL(decoder, decodeData(BufferEqual(&expected_data3), true)).Times(1);
+
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(Invoke(new_stream));
+  TestHeaderMapImpl expected_headers3{{":path", "/3"}, {":method", "GET"}};
+  EXPECT_CALL(decoder, decodeHeaders_(HeaderMapEqual(&expected_headers3), true)).Times(1);
+
+  Buffer::OwnedImpl buffer(
+      "GET /1 HTTP/1.1\r\n\r\n"
+      "POST /2 HTTP/1.1\r\ntransfer-encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n"
+      "GET /3 HTTP/1.1\r\n\r\n");
+  for (uint32_t i = 0; i < 3; i++) {
+    codec_->dispatch(buffer);
+    response_encoder->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+  }
+  EXPECT_EQ(0U, buffer.length());
+}
+
+TEST_F(Http1ServerConnectionImplTest, FastParserEofInBody) {
+  codec_settings_.fast_request_parser_ = true;
+  initialize();
+
+  std::string output;
+  ON_CALL(connection_, write(_)).WillByDefault(AddBufferToString(&output));
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(ReturnRef(decoder));
+
+  Buffer::OwnedImpl buffer("POST / HTTP/1.1\r\ncontent-length: 10\r\n\r\n12345");
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+
+  EXPECT_THROW(codec_->dispatch(buffer), CodecProtocolException);
+  EXPECT_EQ("HTTP/1.1 400 Bad Request\r\ncontent-length: 0\r\nconnection: close\r\n\r\n", output);
+}
+
+// Responses to pipelined requests are written in request order, whatever order they are encoded
+// in.
+TEST_F(Http1ServerConnectionImplTest, PipelinedResponsesInOrder) {
+  initialize();
+
+  std::string output;
+  ON_CALL(connection_, write(_)).WillByDefault(AddBufferToString(&output));
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  std::vector<Http::StreamEncoder*> response_encoders;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoders.push_back(&encoder);
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET /1 HTTP/1.1\r\n\r\nGET /2 HTTP/1.1\r\n\r\nGET /3 HTTP/1.1\r\n\r\n");
+  for (uint32_t i = 0; i < 3; i++) {
+    codec_->dispatch(buffer);
+  }
+  EXPECT_EQ(0U, buffer.length());
+  ASSERT_EQ(3U, response_encoders.size());
+
+  response_encoders[2]->encodeHeaders(TestHeaderMapImpl{{":status", "204"}}, true);
+  response_encoders[1]->encodeHeaders(TestHeaderMapImpl{{":status", "201"}}, false);
+  EXPECT_EQ("", output);
+
+  response_encoders[0]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+  EXPECT_EQ("HTTP/1.1 200 OK\r\ncontent-length: 0\r\n\r\n"
+            "HTTP/1.1 201 Created\r\ntransfer-encoding: chunked\r\n\r\n",
+            output);
+
+  Buffer::OwnedImpl data("hello");
+  response_encoders[1]->encodeData(data, true);
+  EXPECT_EQ("HTTP/1.1 200 OK\r\ncontent-length: 0\r\n\r\n"
+            "HTTP/1.1 201 Created\r\ntransfer-encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n"
+            "HTTP/1.1 204 No Content\r\ncontent-length: 0\r\n\r\n",
+            output);
+}
+
+// Resetting a pipelined request resets the requests behind it, while the response to the request
+// ahead of it is still written.
+TEST_F(Http1ServerConnectionImplTest, PipelinedReset) {
+  initialize();
+
+  std::string output;
+  ON_CALL(connection_, write(_)).WillByDefault(AddBufferToString(&output));
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  std::vector<Http::StreamEncoder*> response_encoders;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoders.push_back(&encoder);
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET /1 HTTP/1.1\r\n\r\nGET /2 HTTP/1.1\r\n\r\nGET /3 HTTP/1.1\r\n\r\n");
+  for (uint32_t i = 0; i < 3; i++) {
+    codec_->dispatch(buffer);
+  }
+  ASSERT_EQ(3U, response_encoders.size());
+
+  Http::MockStreamCallbacks stream_callbacks1;
+  response_encoders[0]->getStream().addCallbacks(stream_callbacks1);
+  Http::MockStreamCallbacks stream_callbacks2;
+  response_encoders[1]->getStream().addCallbacks(stream_callbacks2);
+  Http::MockStreamCallbacks stream_callbacks3;
+  response_encoders[2]->getStream().addCallbacks(stream_callbacks3);
+
+  response_encoders[1]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, false);
+  EXPECT_CALL(stream_callbacks1, onResetStream(_)).Times(0);
+  EXPECT_CALL(stream_callbacks2, onResetStream(StreamResetReason::LocalReset));
+  EXPECT_CALL(stream_callbacks3, onResetStream(StreamResetReason::LocalReset));
+  response_encoders[1]->getStream().resetStream(StreamResetReason::LocalReset);
+
+  response_encoders[0]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+  EXPECT_EQ("HTTP/1.1 200 OK\r\ncontent-length: 0\r\n\r\n", output);
+}
+
+// A request that has been answered in full while waiting behind another one is not reset with it,
+// as nothing refers to it any more.
+TEST_F(Http1ServerConnectionImplTest, PipelinedResetSkipsCompleteRequests) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  std::vector<Http::StreamEncoder*> response_encoders;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoders.push_back(&encoder);
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET /1 HTTP/1.1\r\n\r\nGET /2 HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer);
+  codec_->dispatch(buffer);
+  ASSERT_EQ(2U, response_encoders.size());
+
+  Http::MockStreamCallbacks stream_callbacks1;
+  response_encoders[0]->getStream().addCallbacks(stream_callbacks1);
+  Http::MockStreamCallbacks stream_callbacks2;
+  response_encoders[1]->getStream().addCallbacks(stream_callbacks2);
+
+  response_encoders[1]->encodeHeaders(TestHeaderMapImpl{{":status", "204"}}, true);
+  EXPECT_CALL(stream_callbacks1, onResetStream(StreamResetReason::LocalReset));
+  EXPECT_CALL(stream_callbacks2, onResetStream(_)).Times(0);
+  response_encoders[0]->getStream().resetStream(StreamResetReason::LocalReset);
+}
+
+// The error for a pipelined request that fails to parse is only written after the response to the
+// request ahead of it, so the client can't take it for that response.
+TEST_F(Http1ServerConnectionImplTest, PipelinedBadRequest) {
+  initialize();
+
+  std::string output;
+  ON_CALL(connection_, write(_)).WillByDefault(AddBufferToString(&output));
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  std::vector<Http::StreamEncoder*> response_encoders;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoders.push_back(&encoder);
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET /1 HTTP/1.1\r\n\r\nGg");
+  codec_->dispatch(buffer);
+  EXPECT_THROW(codec_->dispatch(buffer), CodecProtocolException);
+  ASSERT_EQ(2U, response_encoders.size());
+  EXPECT_EQ("", output);
+
+  response_encoders[0]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+  EXPECT_EQ("HTTP/1.1 200 OK\r\ncontent-length: 0\r\n\r\n"
+            "HTTP/1.1 400 Bad Request\r\ncontent-length: 0\r\nconnection: close\r\n\r\n",
+            output);
+}
+
+// The held response to a pipelined request applies back pressure once it goes over the buffer
+// limit, and releases it when written.
+TEST_F(Http1ServerConnectionImplTest, PipelinedHeldOutputWatermark) {
+  EXPECT_CALL(connection_, bufferLimit()).WillRepeatedly(Return(10));
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  std::vector<Http::StreamEncoder*> response_encoders;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoders.push_back(&encoder);
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET /1 HTTP/1.1\r\n\r\nGET /2 HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer);
+  codec_->dispatch(buffer);
+  ASSERT_EQ(2U, response_encoders.size());
+
+  Http::MockStreamCallbacks stream_callbacks1;
+  response_encoders[0]->getStream().addCallbacks(stream_callbacks1);
+  Http::MockStreamCallbacks stream_callbacks2;
+  response_encoders[1]->getStream().addCallbacks(stream_callbacks2);
+
+  // The held output stays over the limit. Going through the connection's output buffer on the way
+  // is reported to the request at the head of the pipeline.
+  EXPECT_CALL(stream_callbacks1, onAboveWriteBufferHighWatermark());
+  EXPECT_CALL(stream_callbacks1, onBelowWriteBufferLowWatermark());
+  EXPECT_CALL(stream_callbacks2, onAboveWriteBufferHighWatermark());
+  EXPECT_CALL(stream_callbacks2, onBelowWriteBufferLowWatermark()).Times(0);
+  response_encoders[1]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, false);
+
+  EXPECT_CALL(stream_callbacks1, onAboveWriteBufferHighWatermark());
+  EXPECT_CALL(stream_callbacks1, onBelowWriteBufferLowWatermark());
+  EXPECT_CALL(stream_callbacks2, onAboveWriteBufferHighWatermark());
+  EXPECT_CALL(stream_callbacks2, onBelowWriteBufferLowWatermark()).Times(2);
+  response_encoders[0]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+}
+
+// Releasing the held output of a complete response does not call back into its stream.
+TEST_F(Http1ServerConnectionImplTest, PipelinedHeldOutputOfCompleteResponse) {
+  EXPECT_CALL(connection_, bufferLimit()).WillRepeatedly(Return(10));
+  initialize();
+
+  std::string output;
+  ON_CALL(connection_, write(_)).WillByDefault(AddBufferToString(&output));
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  std::vector<Http::StreamEncoder*> response_encoders;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoders.push_back(&encoder);
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET /1 HTTP/1.1\r\n\r\nGET /2 HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer);
+  codec_->dispatch(buffer);
+  ASSERT_EQ(2U, response_encoders.size());
+
+  Http::MockStreamCallbacks stream_callbacks;
+  response_encoders[1]->getStream().addCallbacks(stream_callbacks);
+
+  EXPECT_CALL(stream_callbacks, onAboveWriteBufferHighWatermark());
+  response_encoders[1]->encodeHeaders(TestHeaderMapImpl{{":status", "204"}}, true);
+
+  EXPECT_CALL(stream_callbacks, onAboveWriteBufferHighWatermark()).Times(0);
+  EXPECT_CALL(stream_callbacks, onBelowWriteBufferLowWatermark()).Times(0);
+  response_encoders[0]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+  EXPECT_EQ("HTTP/1.1 200 OK\r\ncontent-length: 0\r\n\r\n"
+            "HTTP/1.1 204 No Content\r\ncontent-length: 0\r\n\r\n",
+            output);
+}
+
+// Watermarks of the connection only apply to the response that writes to it, and move on to the
+// next response along with the connection.
+TEST_F(Http1ServerConnectionImplTest, PipelinedConnectionWatermark) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  std::vector<Http::StreamEncoder*> response_encoders;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoders.push_back(&encoder);
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET /1 HTTP/1.1\r\n\r\nGET /2 HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer);
+  codec_->dispatch(buffer);
+  ASSERT_EQ(2U, response_encoders.size());
+
+  Http::MockStreamCallbacks stream_callbacks1;
+  response_encoders[0]->getStream().addCallbacks(stream_callbacks1);
+  Http::MockStreamCallbacks stream_callbacks2;
+  response_encoders[1]->getStream().addCallbacks(stream_callbacks2);
+
+  EXPECT_CALL(stream_callbacks1, onAboveWriteBufferHighWatermark());
+  EXPECT_CALL(stream_callbacks2, onAboveWriteBufferHighWatermark()).Times(0);
+  static_cast<ServerConnection*>(codec_.get())
+      ->onUnderlyingConnectionAboveWriteBufferHighWatermark();
+
+  EXPECT_CALL(stream_callbacks2, onAboveWriteBufferHighWatermark());
+  response_encoders[0]->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+
+  EXPECT_CALL(stream_callbacks1, onBelowWriteBufferLowWatermark()).Times(0);
+  EXPECT_CALL(stream_callbacks2, onBelowWriteBufferLowWatermark());
+  static_cast<ServerConnection*>(codec_.get())
+      ->onUnderlyingConnectionBelowWriteBufferLowWatermark();
+}
+
 class Http1ClientConnectionImplTest : public testing::Test {
 public:
   void initialize() { codec_.reset(new ClientConnectionImpl(connection_, callbacks_)); }
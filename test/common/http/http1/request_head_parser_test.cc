@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/http/http1/request_head_parser.h"
+
+#include "gtest/gtest.h"
+#include "http_parser.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+typedef std::vector<std::pair<std::string, std::string>> HeaderList;
+
+HeaderList toList(const HeaderMap& headers) {
+  HeaderList list;
+  headers.iterate(
+      [](const HeaderEntry& header, void* context) -> void {
+        static_cast<HeaderList*>(context)->emplace_back(header.key().c_str(),
+                                                        header.value().c_str());
+      },
+      &list);
+  return list;
+}
+
+RequestHeadParser::Result parse(const std::string& request, RequestHeadParser::RequestHead& head) {
+  return RequestHeadParser::parse(request.data(), request.size(), head);
+}
+
+TEST(RequestHeadParserTest, Get) {
+  const std::string request =
+      "GET /a/b?c=d HTTP/1.1\r\nHost: example.com\r\nX-Mixed-Case:  v v  \r\nEmpty:\r\n\r\n";
+  RequestHeadParser::RequestHead head;
+  ASSERT_EQ(RequestHeadParser::Result::Complete, parse(request, head));
+  EXPECT_EQ(HTTP_GET, head.method_);
+  EXPECT_EQ("/a/b?c=d", std::string(head.url_, head.url_length_));
+  EXPECT_EQ(0U, head.content_length_);
+  EXPECT_EQ(request.size(), head.length_);
+  EXPECT_EQ((HeaderList{{":authority", "example.com"}, {"x-mixed-case", "v v  "}, {"empty", ""}}),
+            toList(*head.headers_));
+}
+
+TEST(RequestHeadParserTest, PostWithBody) {
+  const std::string request =
+      "POST / HTTP/1.1\r\ncontent-length: 5\r\nConnection: Keep-Alive\r\n\r\nhelloGET / HTTP/1.1";
+  RequestHeadParser::RequestHead head;
+  ASSERT_EQ(RequestHeadParser::Result::Complete, parse(request, head));
+  EXPECT_EQ(HTTP_POST, head.method_);
+  EXPECT_EQ(5U, head.content_length_);
+  EXPECT_EQ(request.find("hello"), head.length_);
+}
+
+TEST(RequestHeadParserTest, Incomplete) {
+  RequestHeadParser::RequestHead head;
+  EXPECT_EQ(RequestHeadParser::Result::Incomplete, parse("", head));
+  EXPECT_EQ(RequestHeadParser::Result::Incomplete, parse("GET / HTTP/1.1\r\nHost: a\r\n", head));
+  EXPECT_EQ(RequestHeadParser::Result::Incomplete, parse("GET / HTTP/1.1\r\n\r", head));
+}
+
+TEST(RequestHeadParserTest, TooLarge) {
+  RequestHeadParser::RequestHead head;
+  const std::string request =
+      "GET / HTTP/1.1\r\nx: " + std::string(RequestHeadParser::MAX_HEAD_SIZE, 'a');
+  EXPECT_EQ(RequestHeadParser::Result::Unsupported, parse(request, head));
+  EXPECT_EQ(RequestHeadParser::Result::Unsupported, parse(request + "\r\n\r\n", head));
+}
+
+TEST(RequestHeadParserTest, Unsupported) {
+  const std::vector<std::string> requests = {
+      "CONNECT example.com:443 HTTP/1.1\r\n\r\n",
+      "PROPFIND / HTTP/1.1\r\n\r\n",
+      "get / HTTP/1.1\r\n\r\n",
+      "GET http://example.com/ HTTP/1.1\r\n\r\n",
+      "OPTIONS * HTTP/1.1\r\n\r\n",
+      "GET  / HTTP/1.1\r\n\r\n",
+      "GET / HTTP/1.0\r\n\r\n",
+      "GET / HTTP/1.1 \r\n\r\n",
+      "GET /a\x01 HTTP/1.1\r\n\r\n",
+      "GET /\xc3\xa9 HTTP/1.1\r\n\r\n",
+      "\r\nGET / HTTP/1.1\r\n\r\n",
+      "GET / HTTP/1.1\nHost: a\r\n\r\n",
+      "GET / HTTP/1.1\r\nHost: a\n\r\n\r\n",
+      "GET / HTTP/1.1\r\nHost a\r\n\r\n",
+      "GET / HTTP/1.1\r\n: a\r\n\r\n",
+      "GET / HTTP/1.1\r\nHost : a\r\n\r\n",
+      "GET / HTTP/1.1\r\nHo@st: a\r\n\r\n",
+      "GET / HTTP/1.1\r\nX: a\x01z\r\n\r\n",
+      "GET / HTTP/1.1\r\nX: a\x7fz\r\n\r\n",
+      "GET / HTTP/1.1\r\nX: a\rz\r\n\r\n",
+      "GET / HTTP/1.1\r\nX: a\r\n b\r\n\r\n",
+      "POST / HTTP/1.1\r\nContent-Length: 1\r\ncontent-length: 1\r\n\r\n",
+      "POST / HTTP/1.1\r\nContent-Length: 1a\r\n\r\n",
+      "POST / HTTP/1.1\r\nContent-Length: 1 \r\n\r\n",
+      "POST / HTTP/1.1\r\nContent-Length:\r\n\r\n",
+      "POST / HTTP/1.1\r\nContent-Length: 1234567890123456789\r\n\r\n",
+      "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n",
+      "GET / HTTP/1.1\r\nUpgrade: websocket\r\n\r\n",
+      "GET / HTTP/1.1\r\nConnection: close\r\n\r\n",
+      "GET / HTTP/1.1\r\nConnection: keep-alive, upgrade\r\n\r\n",
+      "GET / HTTP/1.1\r\nProxy-Connection: close\r\n\r\n",
+  };
+  for (const std::string& request : requests) {
+    RequestHeadParser::RequestHead head;
+    EXPECT_EQ(RequestHeadParser::Result::Unsupported, parse(request, head)) << request;
+  }
+}
+
+// Exercise every position of the vectorized scans and their scalar tails.
+TEST(RequestHeadParserTest, ScanLengths) {
+  for (size_t length = 0; length < 100; length++) {
+    const std::string url = "/" + std::string(length, 'u');
+    const std::string value(length, 'v');
+    const std::string request = "GET " + url + " HTTP/1.1\r\nx: " + value + "\r\n\r\n";
+    RequestHeadParser::RequestHead head;
+    ASSERT_EQ(RequestHeadParser::Result::Complete, parse(request, head));
+    EXPECT_EQ(url, std::string(head.url_, head.url_length_));
+    EXPECT_EQ((HeaderList{{"x", value}}), toList(*head.headers_));
+
+    for (size_t i = 0; i < length; i++) {
+      std::string bad_url = url;
+      bad_url[i + 1] = '\x1f';
+      EXPECT_EQ(RequestHeadParser::Result::Unsupported,
+                parse("GET " + bad_url + " HTTP/1.1\r\n\r\n", head));
+
+      std::string bad_value = value;
+      bad_value[i] = '\x7f';
+      EXPECT_EQ(RequestHeadParser::Result::Unsupported,
+                parse("GET / HTTP/1.1\r\nx: " + bad_value + "\r\n\r\n", head));
+
+      std::string tab_value = value;
+      tab_value[i] = '\t';
+      ASSERT_EQ(RequestHeadParser::Result::Complete,
+                parse("GET / HTTP/1.1\r\nx: a" + tab_value + "\r\n\r\n", head));
+      EXPECT_EQ((HeaderList{{"x", "a" + tab_value}}), toList(*head.headers_));
+    }
+  }
+}
+
+/**
+ * What http_parser makes of a request head.
+ */
+struct ParserResult {
+  bool complete_{};
+  http_method method_{};
+  std::string url_;
+  // As received, before they go into a header map.
+  HeaderList headers_;
+  bool in_value_{};
+  uint64_t content_length_{};
+  bool keep_alive_{};
+  bool chunked_or_upgrade_{};
+};
+
+ParserResult parseWithHttpParser(const std::string& request) {
+  static http_parser_settings settings = {
+      nullptr, // on_message_begin
+      [](http_parser* parser, const char* at, size_t length) -> int {
+        static_cast<ParserResult*>(parser->data)->url_.append(at, length);
+        return 0;
+      },
+      nullptr, // on_status
+      [](http_parser* parser, const char* at, size_t length) -> int {
+        ParserResult& result = *static_cast<ParserResult*>(parser->data);
+        if (result.headers_.empty() || result.in_value_) {
+          result.headers_.emplace_back();
+          result.in_value_ = false;
+        }
+        result.headers_.back().first.append(at, length);
+        return 0;
+      },
+      [](http_parser* parser, const char* at, size_t length) -> int {
+        ParserResult& result = *static_cast<ParserResult*>(parser->data);
+        result.in_value_ = true;
+        result.headers_.back().second.append(at, length);
+        return 0;
+      },
+      [](http_parser* parser) -> int {
+        ParserResult& result = *static_cast<ParserResult*>(parser->data);
+        result.complete_ = true;
+        result.method_ = static_cast<http_method>(parser->method);
+        result.content_length_ = parser->content_length;
+        result.keep_alive_ = http_should_keep_alive(parser) && parser->http_major == 1 &&
+                             parser->http_minor == 1;
+        result.chunked_or_upgrade_ = (parser->flags & F_CHUNKED) || parser->upgrade;
+        http_parser_pause(parser, 1);
+        return 0;
+      },
+      nullptr, // on_body
+      nullptr, // on_message_complete
+      nullptr, // on_chunk_header
+      nullptr  // on_chunk_complete
+  };
+
+  ParserResult result;
+  http_parser parser;
+  http_parser_init(&parser, HTTP_REQUEST);
+  parser.data = &result;
+  http_parser_execute(&parser, &settings, request.data(), request.size());
+  return result;
+}
+
+/**
+ * Builds requests that are mostly well formed, with the features and mistakes the parser has to
+ * tell apart.
+ */
+class RequestGenerator {
+public:
+  RequestGenerator(uint32_t seed) : random_(seed) {}
+
+  std::string generate() {
+    std::string request = pick({"GET", "POST", "PUT", "HEAD", "DELETE", "OPTIONS", "PATCH"},
+                               {"CONNECT", "PROPFIND", "get", "GETT"});
+    request += pick({" "}, {"  ", "\t"});
+    request += pick({"/"}, {"*", "http://example.com/"});
+    request += randomString("abcXYZ019/?#&=%-._~\"<>\\^`{}|", 40, true);
+    request +=
+        pick({" HTTP/1.1"}, {" HTTP/1.0", " HTTP/2.0", " http/1.1", "HTTP/1.1", " HTTP/1.1 "});
+    request += lineEnd();
+
+    const uint32_t num_headers = uniform(8);
+    for (uint32_t i = 0; i < num_headers; i++) {
+      const std::string name =
+          pick({"Host", "Content-Length", "content-length", "CONTENT-LENGTH", "Connection",
+                "Proxy-Connection", "Expect", "x-name", "", "", ""},
+               {"Transfer-Encoding", "Upgrade"});
+      request += name.empty() ? randomString("abcXYZ019-_!#~ @{", 12, true) : name;
+      request += pick({":"}, {" :", ""});
+      request += pick({"", " ", " ", "\t", "  \t"});
+      if (name == "Content-Length" || name == "content-length" || name == "CONTENT-LENGTH") {
+        request += randomString("0123456789", 20, false);
+        request += pick({""}, {" ", "a", "\t"});
+      } else if (name == "Connection" || name == "Proxy-Connection") {
+        request += pick({"keep-alive", "Keep-Alive"}, {"close", "upgrade", "keep-alive, upgrade"});
+      } else if (name == "Transfer-Encoding") {
+        request += pick({"chunked", "identity", "gzip, chunked"});
+      } else {
+        request += randomString("abc XYZ\t019,;=\"\x80\xff", 70, true);
+      }
+      request += lineEnd();
+    }
+    request += lineEnd();
+    request += randomString("body", 10, true);
+
+    // Occasionally corrupt a byte.
+    if (uniform(10) == 0) {
+      request[uniform(request.size() - 1)] = static_cast<char>(uniform(255));
+    }
+    return request;
+  }
+
+private:
+  uint32_t uniform(uint32_t max) {
+    return std::uniform_int_distribution<uint32_t>(0, max)(random_);
+  }
+
+  std::string pick(const std::vector<std::string>& choices) {
+    return choices[uniform(choices.size() - 1)];
+  }
+
+  // Picks one of the bad choices now and then.
+  std::string pick(const std::vector<std::string>& good, const std::vector<std::string>& bad) {
+    return uniform(20) == 0 ? pick(bad) : pick(good);
+  }
+
+  std::string lineEnd() { return uniform(50) == 0 ? "\n" : "\r\n"; }
+
+  std::string randomString(const std::string& alphabet, uint32_t max_length, bool allow_control) {
+    std::string result;
+    const uint32_t length = uniform(max_length);
+    for (uint32_t i = 0; i < length; i++) {
+      if (allow_control && uniform(200) == 0) {
+        result += static_cast<char>(uniform(0x20));
+      } else {
+        result += alphabet[uniform(alphabet.size() - 1)];
+      }
+    }
+    return result;
+  }
+
+  std::mt19937 random_;
+};
+
+// Every head the parser accepts must be accepted by http_parser with the same outcome.
+TEST(RequestHeadParserTest, DifferentialWithHttpParser) {
+  RequestGenerator generator(0);
+  uint32_t complete = 0;
+  for (uint32_t i = 0; i < 50000; i++) {
+    const std::string request = generator.generate();
+    RequestHeadParser::RequestHead head;
+    if (parse(request, head) != RequestHeadParser::Result::Complete) {
+      continue;
+    }
+    complete++;
+
+    const ParserResult expected = parseWithHttpParser(request);
+    ASSERT_TRUE(expected.complete_) << request;
+    EXPECT_EQ(expected.method_, head.method_) << request;
+    EXPECT_EQ(expected.url_, std::string(head.url_, head.url_length_)) << request;
+    // Build the header map the way the codec does for http_parser.
+    HeaderMapImpl expected_headers;
+    for (auto header : expected.headers_) {
+      HeaderString key;
+      key.setCopy(header.first.c_str(), header.first.size());
+      std::transform(key.buffer(), key.buffer() + key.size(), key.buffer(), ::tolower);
+      HeaderString value;
+      value.setCopy(header.second.c_str(), header.second.size());
+      expected_headers.addViaMove(std::move(key), std::move(value));
+    }
+    EXPECT_EQ(toList(expected_headers), toList(*head.headers_)) << request;
+    EXPECT_EQ(expected.content_length_ == ULLONG_MAX ? 0 : expected.content_length_,
+              head.content_length_)
+        << request;
+    EXPECT_TRUE(expected.keep_alive_) << request;
+    EXPECT_FALSE(expected.chunked_or_upgrade_) << request;
+  }
+
+  // Make sure the generator exercises the parser.
+  EXPECT_LT(1000U, complete);
+}
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
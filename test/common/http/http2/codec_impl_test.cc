@@ -270,6 +270,82 @@ TEST_P(Http2CodecImplTest, TrailingHeadersLargeBody) {
   response_encoder_->encodeTrailers(TestHeaderMapImpl{{"trailing", "header"}});
 }
 
+TEST_P(Http2CodecImplTest, SensitiveHeadersNeverIndexed) {
+  initialize();
+
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  request_headers.addCopy("authorization", "Bearer secret");
+  request_headers.addCopy("x-custom", "value");
+  // The server rebuilds the cookie header after all other headers.
+  request_headers.addCopy("cookie", "session=0123456789abcdef0123456789");
+  EXPECT_CALL(request_decoder_, decodeHeaders_(HeaderMapEqual(&request_headers), true));
+  request_encoder_->encodeHeaders(request_headers, true);
+  EXPECT_EQ(2U, stats_store_.counter("http2.tx_headers_never_indexed").value());
+
+  TestHeaderMapImpl response_headers{{":status", "200"}, {"set-cookie", "session=0123456789"}};
+  EXPECT_CALL(response_decoder_, decodeHeaders_(HeaderMapEqual(&response_headers), true));
+  response_encoder_->encodeHeaders(response_headers, true);
+  EXPECT_EQ(3U, stats_store_.counter("http2.tx_headers_never_indexed").value());
+}
+
+TEST_P(Http2CodecImplTest, HpackStats) {
+  initialize();
+
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  request_headers.addCopy("x-custom", std::string(100, 'a'));
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, true));
+  request_encoder_->encodeHeaders(request_headers, true);
+
+  const uint64_t raw_bytes = stats_store_.counter("http2.tx_headers_raw_bytes").value();
+  const uint64_t encoded_bytes = stats_store_.counter("http2.tx_headers_encoded_bytes").value();
+  EXPECT_EQ(request_headers.byteSize(), raw_bytes);
+  EXPECT_LT(0U, encoded_bytes);
+
+  TestHeaderMapImpl response_headers{{":status", "200"}};
+  EXPECT_CALL(response_decoder_, decodeHeaders_(_, true));
+  response_encoder_->encodeHeaders(response_headers, true);
+  const uint64_t raw_bytes2 = stats_store_.counter("http2.tx_headers_raw_bytes").value();
+  const uint64_t encoded_bytes2 = stats_store_.counter("http2.tx_headers_encoded_bytes").value();
+  EXPECT_EQ(raw_bytes + response_headers.byteSize(), raw_bytes2);
+
+  // With a dynamic table, the same headers on a second stream are mostly indices into it.
+  MockStreamDecoder response_decoder2;
+  StreamEncoder* request_encoder2 = &client_.newStream(response_decoder2);
+  MockStreamDecoder request_decoder2;
+  EXPECT_CALL(server_callbacks_, newStream(_))
+      .WillOnce(Invoke([&](StreamEncoder&) -> StreamDecoder& { return request_decoder2; }));
+  EXPECT_CALL(request_decoder2, decodeHeaders_(HeaderMapEqual(&request_headers), true));
+  request_encoder2->encodeHeaders(request_headers, true);
+
+  EXPECT_EQ(raw_bytes2 + raw_bytes, stats_store_.counter("http2.tx_headers_raw_bytes").value());
+  if (server_http2settings_.hpack_table_size_ != Http2Settings::MIN_HPACK_TABLE_SIZE) {
+    EXPECT_GT(encoded_bytes / 4,
+              stats_store_.counter("http2.tx_headers_encoded_bytes").value() - encoded_bytes2);
+  }
+}
+
+// A response encoded while the server is dispatching is only sent once dispatch completes, so
+// its headers must be copied: the header map may be gone by then.
+TEST_P(Http2CodecImplTest, ResponseHeadersEncodedDuringDispatch) {
+  initialize();
+
+  TestHeaderMapImpl expected_headers{{":status", "200"}, {"x-custom", std::string(100, 'a')}};
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, true))
+      .WillOnce(Invoke([&](HeaderMapPtr&, bool) -> void {
+        TestHeaderMapImpl response_headers{{":status", "200"},
+                                           {"x-custom", std::string(100, 'a')}};
+        response_encoder_->encodeHeaders(response_headers, true);
+        response_headers.remove(LowerCaseString("x-custom"));
+        response_headers.addCopy("x-custom", std::string(100, 'b'));
+      }));
+  EXPECT_CALL(response_decoder_, decodeHeaders_(HeaderMapEqual(&expected_headers), true));
+  request_encoder_->encodeHeaders(request_headers, true);
+}
+
 class Http2CodecImplDeferredResetTest : public Http2CodecImplTest {};
 
 TEST_P(Http2CodecImplDeferredResetTest, DeferredResetClient) {
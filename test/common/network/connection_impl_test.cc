@@ -573,6 +573,66 @@ TEST_P(ConnectionImplTest, BindFailureTest) {
   dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
 }
 
+#ifdef __linux__
+// Splice everything the server reads back to the client, i.e. an echo server that never copies the
+// data into user space.
+TEST_P(ConnectionImplTest, SpliceEcho) {
+  setUpBasicConnection();
+  connect();
+
+  std::shared_ptr<MockReadFilter> client_read_filter(new NiceMock<MockReadFilter>());
+  client_connection_->addReadFilter(client_read_filter);
+  EXPECT_TRUE(server_connection_->spliceTo(*client_connection_));
+  EXPECT_FALSE(server_connection_->spliceTo(*client_connection_));
+
+  std::string data_to_write;
+  for (uint32_t i = 0; i < 512 * 1024; i++) {
+    data_to_write.push_back('a' + i % 26);
+  }
+  std::string data_read;
+  EXPECT_CALL(*read_filter_, onData(_)).Times(0);
+  EXPECT_CALL(*client_read_filter, onData(_))
+      .WillRepeatedly(Invoke([&](Buffer::Instance& data) -> FilterStatus {
+        data_read.append(TestUtility::bufferToString(data));
+        data.drain(data.length());
+        if (data_read.size() == data_to_write.size()) {
+          dispatcher_->exit();
+        }
+        return FilterStatus::StopIteration;
+      }));
+
+  Buffer::OwnedImpl buffer(data_to_write);
+  client_connection_->write(buffer);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  EXPECT_EQ(data_to_write, data_read);
+
+  disconnect(true);
+}
+
+// Data written to the peer through write() must not overtake spliced data, so splicing stops and
+// the server's read filters see the data again.
+TEST_P(ConnectionImplTest, SpliceStopsOnWrite) {
+  setUpBasicConnection();
+  connect();
+
+  std::shared_ptr<MockReadFilter> client_read_filter(new NiceMock<MockReadFilter>());
+  client_connection_->addReadFilter(client_read_filter);
+  EXPECT_TRUE(server_connection_->spliceTo(*client_connection_));
+
+  EXPECT_CALL(*read_filter_, onData(BufferStringEqual("hello")))
+      .WillOnce(Invoke([&](Buffer::Instance& data) -> FilterStatus {
+        data.drain(data.length());
+        dispatcher_->exit();
+        return FilterStatus::StopIteration;
+      }));
+  Buffer::OwnedImpl buffer("hello");
+  client_connection_->write(buffer);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+
+  disconnect(true);
+}
+#endif
+
 class ReadBufferLimitTest : public ConnectionImplTest {
 public:
   void readBufferLimitTest(uint32_t read_buffer_limit, uint32_t expected_chunk_size) {
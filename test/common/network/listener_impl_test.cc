@@ -1,3 +1,11 @@
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <chrono>
+#include <vector>
+
 #include "common/network/address_impl.h"
 #include "common/network/listener_impl.h"
 #include "common/network/utility.h"
@@ -327,5 +335,226 @@ TEST_P(ListenerImplTest, WildcardListenerUseActualDst) {
   dispatcher.run(Event::Dispatcher::RunType::Block);
 }
 
+TEST_P(ListenerImplTest, HandOffConnection) {
+  Stats::IsolatedStoreImpl stats_store;
+  Event::DispatcherImpl dispatcher;
+  Network::TcpListenSocket socket(Network::Test::getCanonicalLoopbackAddress(version_), true);
+  Network::TcpListenSocket socket_other(alt_address_, false);
+  Network::MockConnectionHandler connection_handler;
+  Network::MockConnectionBalancer balancer;
+  Network::MockListenerCallbacks listener_callbacks;
+  Network::MockListenerCallbacks listener_callbacks_other;
+  EXPECT_CALL(balancer, registerHandler(_)).Times(2);
+  EXPECT_CALL(balancer, unregisterHandler(_)).Times(2);
+  Network::TestListenerImpl listener(connection_handler, dispatcher, socket, listener_callbacks,
+                                     stats_store,
+                                     {.bind_to_port_ = true,
+                                      .use_proxy_proto_ = false,
+                                      .use_original_dst_ = false,
+                                      .per_connection_buffer_limit_bytes_ = 0,
+                                      .connection_balancer_ = &balancer});
+  // Stands in for the listener of another worker.
+  Network::TestListenerImpl listener_other(connection_handler, dispatcher, socket_other,
+                                           listener_callbacks_other, stats_store,
+                                           {.bind_to_port_ = false,
+                                            .use_proxy_proto_ = false,
+                                            .use_original_dst_ = false,
+                                            .per_connection_buffer_limit_bytes_ = 0,
+                                            .connection_balancer_ = &balancer});
+
+  Network::ClientConnectionPtr client_connection = dispatcher.createClientConnection(
+      socket.localAddress(), Network::Address::InstanceConstSharedPtr());
+  client_connection->connect();
+
+  EXPECT_CALL(connection_handler, numConnections()).WillRepeatedly(Return(0));
+  EXPECT_CALL(balancer, rebalance(_, _, _, _, _))
+      .WillOnce(Invoke([&](BalancedConnectionHandler& current_handler, int fd,
+                           Address::InstanceConstSharedPtr remote_address,
+                           Address::InstanceConstSharedPtr local_address,
+                           bool using_original_dst) -> bool {
+        EXPECT_EQ(&listener, &current_handler);
+        listener_other.post(fd, remote_address, local_address, using_original_dst);
+        EXPECT_EQ(1U, listener_other.numConnections());
+        return true;
+      }));
+  EXPECT_CALL(listener_callbacks, onNewConnection_(_)).Times(0);
+  EXPECT_CALL(listener_callbacks_other, onNewConnection_(_))
+      .WillOnce(Invoke([&](Network::ConnectionPtr& conn) -> void {
+        EXPECT_EQ(0U, listener_other.numConnections());
+        client_connection->close(ConnectionCloseType::NoFlush);
+        conn->close(ConnectionCloseType::NoFlush);
+        dispatcher.exit();
+      }));
+
+  dispatcher.run(Event::Dispatcher::RunType::Block);
+}
+
+TEST_P(ListenerImplTest, HandOffToDestroyedListener) {
+  Stats::IsolatedStoreImpl stats_store;
+  Event::DispatcherImpl dispatcher;
+  Network::TcpListenSocket socket(Network::Test::getCanonicalLoopbackAddress(version_), true);
+  Network::TcpListenSocket socket_other(alt_address_, false);
+  Network::MockConnectionHandler connection_handler;
+  Network::MockConnectionBalancer balancer;
+  Network::MockListenerCallbacks listener_callbacks;
+  Network::MockListenerCallbacks listener_callbacks_other;
+  EXPECT_CALL(balancer, registerHandler(_)).Times(2);
+  EXPECT_CALL(balancer, unregisterHandler(_)).Times(2);
+  Network::TestListenerImpl listener(connection_handler, dispatcher, socket, listener_callbacks,
+                                     stats_store,
+                                     {.bind_to_port_ = true,
+                                      .use_proxy_proto_ = false,
+                                      .use_original_dst_ = false,
+                                      .per_connection_buffer_limit_bytes_ = 0,
+                                      .connection_balancer_ = &balancer});
+  std::unique_ptr<Network::TestListenerImpl> listener_other(new Network::TestListenerImpl(
+      connection_handler, dispatcher, socket_other, listener_callbacks_other, stats_store,
+      {.bind_to_port_ = false,
+       .use_proxy_proto_ = false,
+       .use_original_dst_ = false,
+       .per_connection_buffer_limit_bytes_ = 0,
+       .connection_balancer_ = &balancer}));
+
+  Network::ClientConnectionPtr client_connection = dispatcher.createClientConnection(
+      socket.localAddress(), Network::Address::InstanceConstSharedPtr());
+  Network::MockConnectionCallbacks client_callbacks;
+  client_connection->addConnectionCallbacks(client_callbacks);
+  client_connection->connect();
+
+  // The other listener goes away before it gets to create the connection, which closes it.
+  EXPECT_CALL(balancer, rebalance(_, _, _, _, _))
+      .WillOnce(Invoke([&](BalancedConnectionHandler&, int fd,
+                           Address::InstanceConstSharedPtr remote_address,
+                           Address::InstanceConstSharedPtr local_address,
+                           bool using_original_dst) -> bool {
+        listener_other->post(fd, remote_address, local_address, using_original_dst);
+        listener_other.reset();
+        return true;
+      }));
+  EXPECT_CALL(listener_callbacks, onNewConnection_(_)).Times(0);
+  EXPECT_CALL(listener_callbacks_other, onNewConnection_(_)).Times(0);
+  EXPECT_CALL(client_callbacks, onEvent(ConnectionEvent::Connected));
+  EXPECT_CALL(client_callbacks, onEvent(ConnectionEvent::RemoteClose))
+      .WillOnce(Invoke([&](ConnectionEvent) -> void { dispatcher.exit(); }));
+
+  dispatcher.run(Event::Dispatcher::RunType::Block);
+}
+
+TEST_P(ListenerImplTest, HandOffToExitedDispatcher) {
+  Stats::IsolatedStoreImpl stats_store;
+  std::unique_ptr<Event::DispatcherImpl> dispatcher_other(new Event::DispatcherImpl());
+  Network::TcpListenSocket socket_other(alt_address_, false);
+  Network::MockConnectionHandler connection_handler;
+  Network::MockConnectionBalancer balancer;
+  Network::MockListenerCallbacks listener_callbacks_other;
+  EXPECT_CALL(balancer, registerHandler(_));
+  EXPECT_CALL(balancer, unregisterHandler(_));
+  std::unique_ptr<Network::TestListenerImpl> listener_other(new Network::TestListenerImpl(
+      connection_handler, *dispatcher_other, socket_other, listener_callbacks_other, stats_store,
+      {.bind_to_port_ = false,
+       .use_proxy_proto_ = false,
+       .use_original_dst_ = false,
+       .per_connection_buffer_limit_bytes_ = 0,
+       .connection_balancer_ = &balancer}));
+
+  // The other worker shuts down without running the handoff, which closes the fd.
+  const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_NE(-1, fd);
+  EXPECT_CALL(listener_callbacks_other, onNewConnection_(_)).Times(0);
+  listener_other->post(fd, alt_address_, alt_address_, false);
+  listener_other.reset();
+  dispatcher_other.reset();
+  EXPECT_EQ(-1, ::fcntl(fd, F_GETFD));
+  EXPECT_EQ(EBADF, errno);
+}
+
+TEST_P(ListenerImplTest, MaxAcceptsPerWakeup) {
+  uint32_t max_accepts = 2;
+  Stats::IsolatedStoreImpl stats_store;
+  Event::DispatcherImpl dispatcher;
+  Network::TcpListenSocket socket(Network::Test::getCanonicalLoopbackAddress(version_), true);
+  Network::MockListenerCallbacks listener_callbacks;
+  Network::MockConnectionHandler connection_handler;
+  Network::TestListenerImpl listener(connection_handler, dispatcher, socket, listener_callbacks,
+                                     stats_store,
+                                     {.bind_to_port_ = true,
+                                      .use_proxy_proto_ = false,
+                                      .use_original_dst_ = false,
+                                      .per_connection_buffer_limit_bytes_ = 0,
+                                      .connection_balancer_ = nullptr,
+                                      .max_accepts_per_wakeup_ = [&max_accepts]() -> uint32_t {
+                                        return max_accepts;
+                                      },
+                                      .tcp_defer_accept_seconds_ = 0});
+
+  // Loopback connections are in the accept queue as soon as connect() returns.
+  std::vector<Network::ClientConnectionPtr> client_connections;
+  for (uint32_t i = 0; i < 5; i++) {
+    client_connections.push_back(dispatcher.createClientConnection(
+        socket.localAddress(), Network::Address::InstanceConstSharedPtr()));
+    client_connections.back()->connect();
+  }
+
+  // A zero timer enabled by the first accept of a wakeup runs before the listener wakes up again.
+  // The limit is read on every wakeup, so lifting it after the first one lets the second wakeup
+  // accept the rest.
+  std::vector<Network::ConnectionPtr> server_connections;
+  size_t accepted_in_first_wakeup = 0;
+  size_t accepted_in_second_wakeup = 0;
+  Event::TimerPtr timer1 = dispatcher.createTimer([&]() -> void {
+    accepted_in_first_wakeup = server_connections.size();
+    max_accepts = 0;
+  });
+  Event::TimerPtr timer2 = dispatcher.createTimer([&]() -> void {
+    accepted_in_second_wakeup = server_connections.size() - accepted_in_first_wakeup;
+    dispatcher.exit();
+  });
+  EXPECT_CALL(listener_callbacks, onNewConnection_(_))
+      .Times(5)
+      .WillRepeatedly(Invoke([&](Network::ConnectionPtr& conn) -> void {
+        server_connections.push_back(std::move(conn));
+        if (server_connections.size() == 1) {
+          timer1->enableTimer(std::chrono::milliseconds(0));
+        } else if (server_connections.size() == 3) {
+          timer2->enableTimer(std::chrono::milliseconds(0));
+        }
+      }));
+
+  dispatcher.run(Event::Dispatcher::RunType::Block);
+  EXPECT_EQ(2U, accepted_in_first_wakeup);
+  EXPECT_EQ(3U, accepted_in_second_wakeup);
+  EXPECT_EQ(0U, stats_store.counter("downstream_cx_accept_queue_full").value());
+
+  for (Network::ConnectionPtr& conn : server_connections) {
+    conn->close(ConnectionCloseType::NoFlush);
+  }
+  for (Network::ClientConnectionPtr& conn : client_connections) {
+    conn->close(ConnectionCloseType::NoFlush);
+  }
+}
+
+TEST_P(ListenerImplTest, TcpDeferAccept) {
+  Stats::IsolatedStoreImpl stats_store;
+  Event::DispatcherImpl dispatcher;
+  Network::TcpListenSocket socket(Network::Test::getCanonicalLoopbackAddress(version_), true);
+  Network::MockListenerCallbacks listener_callbacks;
+  Network::MockConnectionHandler connection_handler;
+  Network::TestListenerImpl listener(connection_handler, dispatcher, socket, listener_callbacks,
+                                     stats_store,
+                                     {.bind_to_port_ = true,
+                                      .use_proxy_proto_ = false,
+                                      .use_original_dst_ = false,
+                                      .per_connection_buffer_limit_bytes_ = 0,
+                                      .connection_balancer_ = nullptr,
+                                      .max_accepts_per_wakeup_ = nullptr,
+                                      .tcp_defer_accept_seconds_ = 5});
+
+  // The kernel rounds the timeout to its retransmission schedule.
+  int seconds = 0;
+  socklen_t seconds_len = sizeof(seconds);
+  EXPECT_EQ(0, getsockopt(socket.fd(), IPPROTO_TCP, TCP_DEFER_ACCEPT, &seconds, &seconds_len));
+  EXPECT_LT(0, seconds);
+}
+
 } // namespace Network
 } // namespace Envoy
@@ -1,3 +1,4 @@
+#include <cctype>
 #include <memory>
 #include <string>
 
@@ -61,6 +62,49 @@ TEST(UUID, sanityCheckOfUniqueness) {
   EXPECT_EQ(num_of_uuids, uuids.size());
 }
 
+TEST(UUID, fastUuidFormat) {
+  RandomGeneratorImpl random;
+
+  for (size_t i = 0; i < 1000; ++i) {
+    char out[RandomGeneratorImpl::UUID_LENGTH];
+    random.fastUuid(out);
+    const std::string uuid(out, sizeof(out));
+
+    for (size_t j = 0; j < uuid.size(); ++j) {
+      if (j == 8 || j == 13 || j == 18 || j == 23) {
+        EXPECT_EQ('-', uuid[j]);
+      } else {
+        EXPECT_TRUE(isxdigit(uuid[j]) && !isupper(uuid[j])) << uuid;
+      }
+    }
+    EXPECT_EQ('4', uuid[14]);
+    EXPECT_TRUE(uuid[19] == '8' || uuid[19] == '9' || uuid[19] == 'a' || uuid[19] == 'b');
+  }
+}
+
+TEST(UUID, sanityCheckOfUniquenessFastUuid) {
+  std::set<std::string> uuids;
+  const size_t num_of_uuids = 100000;
+
+  RandomGeneratorImpl random;
+  for (size_t i = 0; i < num_of_uuids; ++i) {
+    char out[RandomGeneratorImpl::UUID_LENGTH];
+    random.fastUuid(out);
+    uuids.emplace(out, sizeof(out));
+  }
+
+  EXPECT_EQ(num_of_uuids, uuids.size());
+}
+
+TEST(UUID, DISABLED_benchmarkFastUuid) {
+  RandomGeneratorImpl random;
+
+  char out[RandomGeneratorImpl::UUID_LENGTH];
+  for (size_t i = 0; i < 100000000; ++i) {
+    random.fastUuid(out);
+  }
+}
+
 class RuntimeImplTest : public testing::Test {
 public:
   static void SetUpTestCase() {
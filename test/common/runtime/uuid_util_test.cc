@@ -33,6 +33,22 @@ TEST(UUIDUtilsTest, mod) {
 
   EXPECT_TRUE(UuidUtils::uuidModBy("ffffffff-0012-0110-00ff-0c00400600ff", result, 10000));
   EXPECT_EQ(7295, result);
+
+  EXPECT_TRUE(UuidUtils::uuidModBy("FFFFFFFF-0012-0110-00ff-0c00400600ff", result, 10000));
+  EXPECT_EQ(7295, result);
+
+  // Only the leading 8 chars are parsed, and they all have to be hex digits.
+  EXPECT_FALSE(UuidUtils::uuidModBy("0000000", result, 100));
+  EXPECT_FALSE(UuidUtils::uuidModBy("0000000g-0000-0000-0000-000000000000", result, 100));
+  EXPECT_FALSE(UuidUtils::uuidModBy("-0000000-0000-0000-0000-000000000000", result, 100));
+  EXPECT_FALSE(UuidUtils::uuidModBy(" 0000000-0000-0000-0000-000000000000", result, 100));
+  EXPECT_FALSE(UuidUtils::uuidModBy("0x000000-0000-0000-0000-000000000000", result, 100));
+
+  // The length is taken from the caller, not from a null terminator.
+  const char header_value[] = "000000ff-0000-0000-0000-000000000000";
+  EXPECT_TRUE(UuidUtils::uuidModBy(header_value, 8, result, 100));
+  EXPECT_EQ(55, result);
+  EXPECT_FALSE(UuidUtils::uuidModBy(header_value, 7, result, 100));
 }
 
 TEST(UUIDUtilsTest, checkDistribution) {
@@ -91,4 +107,20 @@ TEST(UUIDUtilsTest, setAndCheckTraceable) {
   std::string invalid_uuid = "";
   EXPECT_FALSE(UuidUtils::setTraceableUuid(invalid_uuid, UuidTraceStatus::Forced));
 }
+
+TEST(UUIDUtilsTest, setAndCheckTraceableInPlace) {
+  Runtime::RandomGeneratorImpl random;
+
+  char uuid[Runtime::RandomGeneratorImpl::UUID_LENGTH];
+  random.fastUuid(uuid);
+  EXPECT_EQ(UuidTraceStatus::NoTrace, UuidUtils::isTraceableUuid(uuid, sizeof(uuid)));
+
+  EXPECT_TRUE(UuidUtils::setTraceableUuid(uuid, sizeof(uuid), UuidTraceStatus::Sampled));
+  EXPECT_EQ(UuidTraceStatus::Sampled, UuidUtils::isTraceableUuid(uuid, sizeof(uuid)));
+  EXPECT_EQ(UuidTraceStatus::Sampled, UuidUtils::isTraceableUuid(std::string(uuid, sizeof(uuid))));
+
+  EXPECT_FALSE(UuidUtils::setTraceableUuid(uuid, sizeof(uuid) - 1, UuidTraceStatus::Forced));
+  EXPECT_EQ(UuidTraceStatus::NoTrace, UuidUtils::isTraceableUuid(uuid, sizeof(uuid) - 1));
+  EXPECT_EQ(UuidTraceStatus::Sampled, UuidUtils::isTraceableUuid(uuid, sizeof(uuid)));
+}
 } // namespace Envoy
@@ -0,0 +1,255 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "common/network/address_impl.h"
+#include "common/stats/binary_sink.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/stats/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/network_utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::_;
+
+namespace Envoy {
+namespace Stats {
+namespace Binary {
+
+typedef std::tuple<MetricType, std::string, uint64_t> Metric;
+
+std::vector<Metric> decodeFrames(const FrameEncoder& encoder) {
+  std::vector<Metric> metrics;
+  for (const auto& frame : encoder.frames()) {
+    EXPECT_TRUE(FrameDecoder::decode(encoder.data() + frame.first, frame.second,
+                                     [&](MetricType type, const std::string& name,
+                                         uint64_t value) -> void {
+                                       metrics.emplace_back(type, name, value);
+                                     }));
+  }
+  return metrics;
+}
+
+bool decodeBytes(const std::vector<uint8_t>& frame) {
+  return FrameDecoder::decode(frame.data(), frame.size(),
+                              [](MetricType, const std::string&, uint64_t) -> void {});
+}
+
+TEST(BinaryFrameTest, RoundTrip) {
+  FrameEncoder encoder(1432);
+  encoder.add(MetricType::Counter, "cluster.foo.upstream_rq_2xx", 1);
+  encoder.add(MetricType::Counter, "cluster.foo.upstream_rq_5xx", 300);
+  encoder.add(MetricType::Gauge, "cluster.bar.membership_total", 0);
+  encoder.add(MetricType::Timer, "a", UINT64_MAX);
+  encoder.add(MetricType::Gauge, "", 7);
+  EXPECT_NE(0U, encoder.pendingBytes());
+  encoder.finish();
+  EXPECT_EQ(0U, encoder.pendingBytes());
+  ASSERT_EQ(1U, encoder.frames().size());
+
+  std::vector<Metric> expected{Metric{MetricType::Counter, "cluster.foo.upstream_rq_2xx", 1},
+                               Metric{MetricType::Counter, "cluster.foo.upstream_rq_5xx", 300},
+                               Metric{MetricType::Gauge, "cluster.bar.membership_total", 0},
+                               Metric{MetricType::Timer, "a", UINT64_MAX},
+                               Metric{MetricType::Gauge, "", 7}};
+  EXPECT_EQ(expected, decodeFrames(encoder));
+}
+
+TEST(BinaryFrameTest, PrefixCompression) {
+  FrameEncoder encoder(1432);
+  encoder.add(MetricType::Counter, "cluster.foo.upstream_rq_2xx", 1);
+  const size_t first = encoder.pendingBytes();
+  encoder.add(MetricType::Counter, "cluster.foo.upstream_rq_5xx", 1);
+  // Type, shared length, suffix length, "5xx" and value.
+  EXPECT_EQ(7U, encoder.pendingBytes() - first);
+}
+
+TEST(BinaryFrameTest, FrameSplitting) {
+  const size_t max_frame_size = 64;
+  FrameEncoder encoder(max_frame_size);
+  std::vector<Metric> expected;
+  for (uint64_t i = 0; i < 100; i++) {
+    const std::string name = fmt::format("cluster.c{}.upstream_cx_total", i);
+    encoder.add(MetricType::Counter, name, i);
+    expected.emplace_back(MetricType::Counter, name, i);
+  }
+  encoder.finish();
+
+  EXPECT_LT(1U, encoder.frames().size());
+  size_t offset = 0;
+  for (const auto& frame : encoder.frames()) {
+    EXPECT_EQ(offset, frame.first);
+    EXPECT_GE(max_frame_size, frame.second);
+    offset += frame.second;
+  }
+  EXPECT_EQ(expected, decodeFrames(encoder));
+
+  // Buffers are reused after clear().
+  encoder.clear();
+  EXPECT_TRUE(encoder.frames().empty());
+  encoder.add(MetricType::Gauge, "g", 1);
+  encoder.finish();
+  EXPECT_EQ(std::vector<Metric>{Metric(MetricType::Gauge, "g", 1)}, decodeFrames(encoder));
+}
+
+TEST(BinaryFrameTest, OversizedEntry) {
+  FrameEncoder encoder(16);
+  const std::string name(100, 'a');
+  encoder.add(MetricType::Counter, "c", 1);
+  encoder.add(MetricType::Counter, name, 2);
+  encoder.add(MetricType::Counter, "c", 3);
+  encoder.finish();
+
+  ASSERT_EQ(3U, encoder.frames().size());
+  EXPECT_LT(16U, encoder.frames()[1].second);
+  std::vector<Metric> expected{Metric{MetricType::Counter, "c", 1},
+                               Metric{MetricType::Counter, name, 2},
+                               Metric{MetricType::Counter, "c", 3}};
+  EXPECT_EQ(expected, decodeFrames(encoder));
+}
+
+TEST(BinaryFrameTest, Malformed) {
+  // Too short for a header.
+  EXPECT_FALSE(decodeBytes({0, 0, 0, 4}));
+  // Length mismatch.
+  EXPECT_FALSE(decodeBytes({0, 0, 0, 6, FrameEncoder::VERSION}));
+  // Unknown version.
+  EXPECT_FALSE(decodeBytes({0, 0, 0, 5, FrameEncoder::VERSION + 1}));
+  // Empty frame.
+  EXPECT_TRUE(decodeBytes({0, 0, 0, 5, FrameEncoder::VERSION}));
+  // Well formed entry.
+  EXPECT_TRUE(decodeBytes({0, 0, 0, 10, FrameEncoder::VERSION, 0, 0, 1, 'a', 5}));
+  // Unknown type.
+  EXPECT_FALSE(decodeBytes({0, 0, 0, 10, FrameEncoder::VERSION, 3, 0, 1, 'a', 5}));
+  // Shared prefix longer than the previous name.
+  EXPECT_FALSE(decodeBytes({0, 0, 0, 10, FrameEncoder::VERSION, 0, 1, 1, 'a', 5}));
+  // Suffix past the end of the frame.
+  EXPECT_FALSE(decodeBytes({0, 0, 0, 10, FrameEncoder::VERSION, 0, 0, 3, 'a', 5}));
+  // Truncated value varint.
+  EXPECT_FALSE(decodeBytes({0, 0, 0, 10, FrameEncoder::VERSION, 0, 0, 1, 'a', 0x85}));
+  // Missing value.
+  EXPECT_FALSE(decodeBytes({0, 0, 0, 9, FrameEncoder::VERSION, 0, 0, 1, 'a'}));
+}
+
+class UdpBinarySinkTest : public testing::TestWithParam<Network::Address::IpVersion> {
+public:
+  UdpBinarySinkTest() {
+    std::tie(server_address_, server_fd_) =
+        Network::Test::bindFreeLoopbackPort(GetParam(), Network::Address::SocketType::Datagram);
+  }
+
+  ~UdpBinarySinkTest() { close(server_fd_); }
+
+  // Decodes all datagrams received so far. Loopback UDP delivery is synchronous with the send.
+  std::vector<Metric> receive() {
+    std::vector<Metric> metrics;
+    std::vector<uint8_t> buffer(65536);
+    datagrams_ = 0;
+    ssize_t rc;
+    while ((rc = recv(server_fd_, buffer.data(), buffer.size(), MSG_DONTWAIT)) >= 0) {
+      datagrams_++;
+      EXPECT_GE(UdpBinarySink::MAX_DATAGRAM_SIZE, static_cast<size_t>(rc));
+      EXPECT_TRUE(FrameDecoder::decode(buffer.data(), rc,
+                                       [&](MetricType type, const std::string& name,
+                                           uint64_t value) -> void {
+                                         metrics.emplace_back(type, name, value);
+                                       }));
+    }
+    return metrics;
+  }
+
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  Network::Address::InstanceConstSharedPtr server_address_;
+  int server_fd_;
+  size_t datagrams_{};
+};
+
+INSTANTIATE_TEST_CASE_P(IpVersions, UdpBinarySinkTest,
+                        testing::ValuesIn(TestEnvironment::getIpVersionsForTest()));
+
+TEST_P(UdpBinarySinkTest, Flush) {
+  UdpBinarySink sink(tls_, server_address_);
+  EXPECT_EQ(server_address_->asString(),
+            Network::Address::peerAddressFromFd(sink.getFdForTests())->asString());
+
+  std::vector<std::shared_ptr<NiceMock<MockCounter>>> counters;
+  FlushSnapshot snapshot;
+  std::vector<Metric> expected;
+  for (uint64_t i = 0; i < 200; i++) {
+    counters.emplace_back(std::make_shared<NiceMock<MockCounter>>());
+    counters.back()->name_ = fmt::format("cluster.cluster_{}.upstream_rq_total", i);
+    snapshot.counters_.emplace_back(counters.back(), i + 1);
+    expected.emplace_back(MetricType::Counter, counters.back()->name_, i + 1);
+  }
+  auto gauge = std::make_shared<NiceMock<MockGauge>>();
+  gauge->name_ = "server.live";
+  snapshot.gauges_.emplace_back(gauge, 1);
+  expected.emplace_back(MetricType::Gauge, "server.live", 1);
+
+  sink.flush(snapshot);
+  EXPECT_EQ(expected, receive());
+  // 200 stats don't fit in a single datagram.
+  EXPECT_LT(1U, datagrams_);
+
+  // Nothing is kept between flushes.
+  snapshot.clear();
+  snapshot.gauges_.emplace_back(gauge, 0);
+  sink.flush(snapshot);
+  EXPECT_EQ(std::vector<Metric>{Metric(MetricType::Gauge, "server.live", 0)}, receive());
+  EXPECT_EQ(1U, datagrams_);
+
+  tls_.shutdownThread();
+}
+
+TEST_P(UdpBinarySinkTest, Histograms) {
+  Event::MockTimer* timer = new Event::MockTimer(&tls_.dispatcher_);
+  UdpBinarySink sink(tls_, server_address_);
+
+  NiceMock<MockHistogram> histogram;
+  histogram.name_ = "http.ingress.downstream_rq_time";
+
+  // The first value arms the timer, following ones are buffered.
+  EXPECT_CALL(*timer, enableTimer(UdpBinarySink::TIMER_FLUSH_INTERVAL));
+  sink.onHistogramComplete(histogram, 1);
+  sink.onHistogramComplete(histogram, 2);
+  EXPECT_EQ(std::vector<Metric>{}, receive());
+
+  timer->callback_();
+  std::vector<Metric> expected{Metric{MetricType::Timer, histogram.name_, 1},
+                               Metric{MetricType::Timer, histogram.name_, 2}};
+  EXPECT_EQ(expected, receive());
+  EXPECT_EQ(1U, datagrams_);
+
+  // Once a frame is full everything buffered is sent right away and the timer disarmed.
+  EXPECT_CALL(*timer, enableTimer(UdpBinarySink::TIMER_FLUSH_INTERVAL));
+  EXPECT_CALL(*timer, disableTimer());
+  expected.clear();
+  std::vector<uint8_t> buffer(65536);
+  for (uint64_t i = 0; recv(server_fd_, buffer.data(), buffer.size(), MSG_PEEK | MSG_DONTWAIT) < 0;
+       i++) {
+    sink.onHistogramComplete(histogram, 1000 + i);
+    expected.emplace_back(MetricType::Timer, histogram.name_, 1000 + i);
+  }
+  EXPECT_EQ(expected, receive());
+  EXPECT_EQ(2U, datagrams_);
+
+  // Nothing is left for the timer.
+  timer->callback_();
+  EXPECT_EQ(std::vector<Metric>{}, receive());
+
+  tls_.shutdownThread();
+}
+
+} // namespace Binary
+} // namespace Stats
+} // namespace Envoy
@@ -1,4 +1,6 @@
 #include <chrono>
+#include <thread>
+#include <vector>
 
 #include "envoy/stats/stats_macros.h"
 
@@ -69,5 +71,46 @@ TEST(StatsMacros, All) {
   EXPECT_EQ("test.test_histogram", histogram.name());
 }
 
+TEST(StatsCounterImplTest, Sharded) {
+  HeapRawStatDataAllocator alloc;
+  RawStatData& data = *alloc.alloc("sharded");
+  CounterImpl counter(data, alloc, 3);
+  EXPECT_EQ(4U, counter.shards());
+  EXPECT_FALSE(counter.used());
+
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < 6; i++) {
+    threads.emplace_back([&counter]() -> void {
+      for (uint32_t j = 0; j < 1000; j++) {
+        counter.inc();
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // Increments stay in the shards until the counter is latched.
+  EXPECT_TRUE(counter.used());
+  EXPECT_EQ(6000U, counter.value());
+  EXPECT_EQ(0U, data.value_);
+  EXPECT_EQ(6000U, counter.latch());
+  EXPECT_EQ(6000U, data.value_);
+  EXPECT_EQ(6000U, counter.value());
+  EXPECT_EQ(0U, counter.latch());
+
+  // Increments of another process sharing the data during a hot restart.
+  counter.add(2);
+  data.value_ += 5;
+  data.pending_increment_ += 5;
+  EXPECT_EQ(6007U, counter.value());
+  EXPECT_EQ(7U, counter.latch());
+
+  counter.inc();
+  counter.reset();
+  EXPECT_EQ(0U, counter.value());
+  EXPECT_EQ(0U, counter.latch());
+}
+
 } // namespace Stats
 } // namespace Envoy
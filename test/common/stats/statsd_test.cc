@@ -52,33 +52,31 @@ public:
   std::unique_ptr<TcpStatsdSink> sink_;
   NiceMock<LocalInfo::MockLocalInfo> local_info_;
   Network::MockClientConnection* connection_{};
+  FlushSnapshot snapshot_;
 };
 
 TEST_F(TcpStatsdSinkTest, EmptyFlush) {
   InSequence s;
 
-  sink_->beginFlush();
   expectCreateConnection();
   EXPECT_CALL(*connection_, write(BufferStringEqual("")));
-  sink_->endFlush();
+  sink_->flush(snapshot_);
 }
 
 TEST_F(TcpStatsdSinkTest, BasicFlow) {
   InSequence s;
-  NiceMock<MockCounter> counter;
-  counter.name_ = "test_counter";
+  auto counter = std::make_shared<NiceMock<MockCounter>>();
+  counter->name_ = "test_counter";
+  snapshot_.counters_.emplace_back(counter, 1);
 
-  NiceMock<MockGauge> gauge;
-  gauge.name_ = "test_gauge";
-
-  sink_->beginFlush();
-  sink_->flushCounter(counter, 1);
-  sink_->flushGauge(gauge, 2);
+  auto gauge = std::make_shared<NiceMock<MockGauge>>();
+  gauge->name_ = "test_gauge";
+  snapshot_.gauges_.emplace_back(gauge, 2);
 
   expectCreateConnection();
   EXPECT_CALL(*connection_,
               write(BufferStringEqual("envoy.test_counter:1|c\nenvoy.test_gauge:2|g\n")));
-  sink_->endFlush();
+  sink_->flush(snapshot_);
 
   // Test a disconnect. We should connect again.
   connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
@@ -97,12 +95,10 @@ TEST_F(TcpStatsdSinkTest, BasicFlow) {
 TEST_F(TcpStatsdSinkTest, BufferReallocate) {
   InSequence s;
 
-  NiceMock<MockCounter> counter;
-  counter.name_ = "test_counter";
-
-  sink_->beginFlush();
+  auto counter = std::make_shared<NiceMock<MockCounter>>();
+  counter->name_ = "test_counter";
   for (int i = 0; i < 2000; i++) {
-    sink_->flushCounter(counter, 1);
+    snapshot_.counters_.emplace_back(counter, 1);
   }
 
   expectCreateConnection();
@@ -113,38 +109,33 @@ TEST_F(TcpStatsdSinkTest, BufferReallocate) {
     }
     EXPECT_EQ(compare, TestUtility::bufferToString(buffer));
   }));
-  sink_->endFlush();
+  sink_->flush(snapshot_);
 }
 
 TEST_F(TcpStatsdSinkTest, Overflow) {
   InSequence s;
 
-  NiceMock<MockCounter> counter;
-  counter.name_ = "test_counter";
+  auto counter = std::make_shared<NiceMock<MockCounter>>();
+  counter->name_ = "test_counter";
+  snapshot_.counters_.emplace_back(counter, 1);
 
   // Synthetically set buffer above high watermark. Make sure we don't write anything.
   cluster_manager_.thread_local_cluster_.cluster_.info_->stats().upstream_cx_tx_bytes_buffered_.set(
       1024 * 1024 * 17);
-  sink_->beginFlush();
-  sink_->flushCounter(counter, 1);
-  sink_->endFlush();
+  sink_->flush(snapshot_);
 
   // Lower and make sure we write.
   cluster_manager_.thread_local_cluster_.cluster_.info_->stats().upstream_cx_tx_bytes_buffered_.set(
       1024 * 1024 * 15);
-  sink_->beginFlush();
-  sink_->flushCounter(counter, 1);
   expectCreateConnection();
   EXPECT_CALL(*connection_, write(BufferStringEqual("envoy.test_counter:1|c\n")));
-  sink_->endFlush();
+  sink_->flush(snapshot_);
 
   // Raise and make sure we don't write and kill connection.
   cluster_manager_.thread_local_cluster_.cluster_.info_->stats().upstream_cx_tx_bytes_buffered_.set(
       1024 * 1024 * 17);
-  sink_->beginFlush();
-  sink_->flushCounter(counter, 1);
   EXPECT_CALL(*connection_, close(Network::ConnectionCloseType::NoFlush));
-  sink_->endFlush();
+  sink_->flush(snapshot_);
 
   EXPECT_EQ(2UL, cluster_manager_.thread_local_cluster_.cluster_.info_->stats_store_
                      .counter("statsd.cx_overflow")
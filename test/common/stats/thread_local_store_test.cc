@@ -302,6 +302,96 @@ TEST_F(StatsThreadLocalStoreTest, OverlappingScopes) {
   EXPECT_CALL(*this, free(_)).Times(3);
 }
 
+TEST_F(StatsThreadLocalStoreTest, Latch) {
+  InSequence s;
+  store_->initializeThreading(main_thread_dispatcher_, tls_);
+
+  ScopePtr scope1 = store_->createScope("scope1.");
+  ScopePtr scope2 = store_->createScope("scope1.");
+
+  EXPECT_CALL(*this, alloc(_)).Times(5);
+  Counter& c1 = scope1->counter("c");
+  Counter& c2 = scope2->counter("c");
+  Counter& unchanged = store_->counter("unchanged");
+  scope1->gauge("unused");
+  Gauge& g2 = scope2->gauge("g");
+  c1.inc();
+  c2.inc();
+  unchanged.inc();
+  g2.set(5);
+
+  // Overlapping scopes are only latched once, and the snapshot only keeps changed counters.
+  FlushSnapshot snapshot;
+  store_->latch(snapshot);
+  ASSERT_EQ(2UL, snapshot.counters_.size());
+  EXPECT_EQ("scope1.c", snapshot.counters_[0].first->name());
+  EXPECT_EQ(2UL, snapshot.counters_[0].second);
+  EXPECT_EQ("unchanged", snapshot.counters_[1].first->name());
+  EXPECT_EQ(1UL, snapshot.counters_[1].second);
+  ASSERT_EQ(1UL, snapshot.gauges_.size());
+  EXPECT_EQ("scope1.g", snapshot.gauges_[0].first->name());
+  EXPECT_EQ(5UL, snapshot.gauges_[0].second);
+
+  // The stats of scope 1 are replaced by those of scope 2.
+  snapshot.clear();
+  EXPECT_CALL(*this, free(_)).Times(2);
+  scope1.reset();
+  c2.inc();
+  store_->latch(snapshot);
+  ASSERT_EQ(1UL, snapshot.counters_.size());
+  EXPECT_EQ("scope1.c", snapshot.counters_[0].first->name());
+  EXPECT_EQ(1UL, snapshot.counters_[0].second);
+  EXPECT_EQ(1UL, snapshot.gauges_.size());
+
+  // Once scope 2 goes away only the store's own stats are left.
+  snapshot.clear();
+  EXPECT_CALL(*this, free(_)).Times(2);
+  scope2.reset();
+  unchanged.inc();
+  store_->latch(snapshot);
+  ASSERT_EQ(1UL, snapshot.counters_.size());
+  EXPECT_EQ("unchanged", snapshot.counters_[0].first->name());
+  EXPECT_TRUE(snapshot.gauges_.empty());
+  snapshot.clear();
+
+  store_->shutdownThreading();
+  tls_.shutdownThread();
+
+  // Includes overflow stat.
+  EXPECT_CALL(*this, free(_)).Times(2);
+}
+
+TEST_F(StatsThreadLocalStoreTest, ShardedCounters) {
+  InSequence s;
+  store_->initializeThreading(main_thread_dispatcher_, tls_);
+  store_->shardCounters({"rq_total"}, 4);
+
+  EXPECT_CALL(*this, alloc(_)).Times(3);
+  ScopePtr scope = store_->createScope("http.");
+  Counter& sharded = scope->counter("rq_total");
+  EXPECT_EQ(4U, dynamic_cast<CounterImpl&>(sharded).shards());
+  EXPECT_EQ(4U, dynamic_cast<CounterImpl&>(store_->counter("rq_total")).shards());
+  EXPECT_EQ(0U, dynamic_cast<CounterImpl&>(scope->counter("downstream_rq_total")).shards());
+
+  sharded.inc();
+  EXPECT_EQ(1UL, sharded.value());
+  FlushSnapshot snapshot;
+  store_->latch(snapshot);
+  ASSERT_EQ(1UL, snapshot.counters_.size());
+  EXPECT_EQ("http.rq_total", snapshot.counters_[0].first->name());
+  EXPECT_EQ(1UL, snapshot.counters_[0].second);
+  snapshot.clear();
+
+  EXPECT_CALL(*this, free(_)).Times(2);
+  scope.reset();
+
+  store_->shutdownThreading();
+  tls_.shutdownThread();
+
+  // Includes overflow stat.
+  EXPECT_CALL(*this, free(_)).Times(2);
+}
+
 TEST_F(StatsThreadLocalStoreTest, AllocFailed) {
   InSequence s;
   store_->initializeThreading(main_thread_dispatcher_, tls_);
@@ -34,13 +34,14 @@ TEST_P(UdpStatsdSinkTest, InitWithIpAddress) {
   EXPECT_NE(fd, -1);
 
   // Check that fd has not changed.
-  NiceMock<MockCounter> counter;
-  counter.name_ = "test_counter";
-  sink.flushCounter(counter, 1);
-
-  NiceMock<MockGauge> gauge;
-  counter.name_ = "test_gauge";
-  sink.flushGauge(gauge, 1);
+  auto counter = std::make_shared<NiceMock<MockCounter>>();
+  counter->name_ = "test_counter";
+  auto gauge = std::make_shared<NiceMock<MockGauge>>();
+  gauge->name_ = "test_gauge";
+  FlushSnapshot snapshot;
+  snapshot.counters_.emplace_back(counter, 1);
+  snapshot.gauges_.emplace_back(gauge, 1);
+  sink.flush(snapshot);
 
   NiceMock<MockHistogram> timer;
   timer.name_ = "test_timer";
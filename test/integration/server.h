@@ -6,6 +6,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "envoy/server/options.h"
 
@@ -52,6 +53,7 @@ public:
   const std::string& serviceZone() override { return service_zone_; }
   uint64_t maxStats() override { return 16384; }
   uint64_t maxStatNameLength() override { return 127; }
+  const std::vector<std::string>& shardedCounters() override { return sharded_counters_; }
 
 private:
   const std::string config_path_;
@@ -61,6 +63,7 @@ private:
   const std::string service_node_name_;
   const std::string service_zone_;
   const std::string log_path_;
+  const std::vector<std::string> sharded_counters_;
 };
 
 class TestDrainManager : public DrainManager {
@@ -161,6 +164,10 @@ public:
     std::unique_lock<std::mutex> lock(lock_);
     return store_.gauges();
   }
+  void latch(FlushSnapshot& snapshot) override {
+    std::unique_lock<std::mutex> lock(lock_);
+    store_.latch(snapshot);
+  }
 
   // Stats::StoreRoot
   void addSink(Sink&) override {}
@@ -41,8 +41,13 @@ public:
 
   // Filesystem::OsSysCalls
   ssize_t write(int fd, const void* buffer, size_t num_bytes) override;
+  // Passes the gathered data to write_() as one buffer, so tests can check what a call wrote.
+  ssize_t writev(int fd, const iovec* iov, int iovcnt) override;
   int open(const std::string& full_path, int flags, int mode) override;
   MOCK_METHOD3(bind, int(int sockfd, const sockaddr* addr, socklen_t addrlen));
+  MOCK_METHOD3(socket, int(int domain, int type, int protocol));
+  MOCK_METHOD6(sendto, ssize_t(int sockfd, const void* buffer, size_t length, int flags,
+                               const sockaddr* addr, socklen_t addrlen));
   MOCK_METHOD1(close, int(int));
   MOCK_METHOD3(open_, int(const std::string& full_path, int flags, int mode));
   MOCK_METHOD3(write_, ssize_t(int, const void*, size_t));
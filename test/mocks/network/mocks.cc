@@ -142,5 +142,11 @@ MockListener::~MockListener() { onDestroy(); }
 MockConnectionHandler::MockConnectionHandler() {}
 MockConnectionHandler::~MockConnectionHandler() {}
 
+MockBalancedConnectionHandler::MockBalancedConnectionHandler() {}
+MockBalancedConnectionHandler::~MockBalancedConnectionHandler() {}
+
+MockConnectionBalancer::MockConnectionBalancer() {}
+MockConnectionBalancer::~MockConnectionBalancer() {}
+
 } // namespace Network
 } // namespace Envoy
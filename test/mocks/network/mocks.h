@@ -5,6 +5,7 @@
 #include <string>
 
 #include "envoy/network/connection.h"
+#include "envoy/network/connection_balancer.h"
 #include "envoy/network/drain_decision.h"
 #include "envoy/network/filter.h"
 
@@ -73,6 +74,7 @@ public:
   MOCK_CONST_METHOD0(bufferLimit, uint32_t());
   MOCK_CONST_METHOD0(usingOriginalDst, bool());
   MOCK_CONST_METHOD0(aboveHighWatermark, bool());
+  MOCK_METHOD1(spliceTo, bool(Connection& peer));
 };
 
 /**
@@ -109,6 +111,7 @@ public:
   MOCK_CONST_METHOD0(bufferLimit, uint32_t());
   MOCK_CONST_METHOD0(usingOriginalDst, bool());
   MOCK_CONST_METHOD0(aboveHighWatermark, bool());
+  MOCK_METHOD1(spliceTo, bool(Connection& peer));
 
   // Network::ClientConnection
   MOCK_METHOD0(connect, void());
@@ -249,5 +252,28 @@ public:
   MOCK_METHOD0(stopListeners, void());
 };
 
+class MockBalancedConnectionHandler : public BalancedConnectionHandler {
+public:
+  MockBalancedConnectionHandler();
+  ~MockBalancedConnectionHandler();
+
+  MOCK_METHOD0(numConnections, uint64_t());
+  MOCK_METHOD4(post, void(int fd, Address::InstanceConstSharedPtr remote_address,
+                          Address::InstanceConstSharedPtr local_address, bool using_original_dst));
+};
+
+class MockConnectionBalancer : public ConnectionBalancer {
+public:
+  MockConnectionBalancer();
+  ~MockConnectionBalancer();
+
+  MOCK_METHOD1(registerHandler, void(BalancedConnectionHandler& handler));
+  MOCK_METHOD1(unregisterHandler, void(BalancedConnectionHandler& handler));
+  MOCK_METHOD5(rebalance, bool(BalancedConnectionHandler& current_handler, int fd,
+                               Address::InstanceConstSharedPtr remote_address,
+                               Address::InstanceConstSharedPtr local_address,
+                               bool using_original_dst));
+};
+
 } // namespace Network
 } // namespace Envoy
@@ -1,8 +1,11 @@
 #include "mocks.h"
 
+#include <cstring>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::Invoke;
 using testing::Return;
 using testing::ReturnArg;
 using testing::_;
@@ -10,7 +13,12 @@ using testing::_;
 namespace Envoy {
 namespace Runtime {
 
-MockRandomGenerator::MockRandomGenerator() { ON_CALL(*this, uuid()).WillByDefault(Return(uuid_)); }
+MockRandomGenerator::MockRandomGenerator() {
+  ON_CALL(*this, uuid()).WillByDefault(Return(uuid_));
+  ON_CALL(*this, fastUuid(_)).WillByDefault(Invoke([this](char* out) -> void {
+    memcpy(out, uuid_.c_str(), uuid_.size());
+  }));
+}
 
 MockRandomGenerator::~MockRandomGenerator() {}
 
@@ -17,6 +17,7 @@ public:
 
   MOCK_METHOD0(random, uint64_t());
   MOCK_METHOD0(uuid, std::string());
+  MOCK_METHOD1(fastUuid, void(char* out));
 
   const std::string uuid_{"a121e9e1-feae-4136-9e0e-6fac343d56c9"};
 };
@@ -27,6 +27,7 @@ MockOptions::MockOptions(const std::string& config_path)
   ON_CALL(*this, logPath()).WillByDefault(ReturnRef(log_path_));
   ON_CALL(*this, maxStats()).WillByDefault(Return(1000));
   ON_CALL(*this, maxStatNameLength()).WillByDefault(Return(150));
+  ON_CALL(*this, shardedCounters()).WillByDefault(ReturnRef(sharded_counters_));
 }
 MockOptions::~MockOptions() {}
 
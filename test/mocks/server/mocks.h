@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <list>
 #include <string>
+#include <vector>
 
 #include "envoy/server/admin.h"
 #include "envoy/server/configuration.h"
@@ -60,6 +61,7 @@ public:
   MOCK_METHOD0(serviceZone, const std::string&());
   MOCK_METHOD0(maxStats, uint64_t());
   MOCK_METHOD0(maxStatNameLength, uint64_t());
+  MOCK_METHOD0(shardedCounters, const std::vector<std::string>&());
 
   std::string config_path_;
   std::string admin_address_path_;
@@ -67,6 +69,7 @@ public:
   std::string service_node_name_;
   std::string service_zone_name_;
   std::string log_path_;
+  std::vector<std::string> sharded_counters_;
 };
 
 class MockAdmin : public Admin {
@@ -183,6 +186,9 @@ public:
   MOCK_METHOD0(listenerScope, Stats::Scope&());
   MOCK_METHOD0(listenerTag, uint64_t());
   MOCK_CONST_METHOD0(name, const std::string&());
+  MOCK_METHOD0(connectionBalancer, Network::ConnectionBalancer*());
+  MOCK_METHOD0(maxAcceptsPerWakeup, uint32_t());
+  MOCK_METHOD0(tcpDeferAcceptSeconds, uint32_t());
 
   testing::NiceMock<Network::MockFilterChainFactory> filter_chain_factory_;
   testing::NiceMock<Network::MockListenSocket> socket_;
@@ -69,10 +69,7 @@ public:
   MockSink();
   ~MockSink();
 
-  MOCK_METHOD0(beginFlush, void());
-  MOCK_METHOD2(flushCounter, void(const Counter& counter, uint64_t delta));
-  MOCK_METHOD2(flushGauge, void(const Gauge& gauge, uint64_t value));
-  MOCK_METHOD0(endFlush, void());
+  MOCK_METHOD1(flush, void(const FlushSnapshot& snapshot));
   MOCK_METHOD2(onHistogramComplete, void(const Histogram& histogram, uint64_t value));
 };
 
@@ -90,6 +87,7 @@ public:
   MOCK_METHOD1(gauge, Gauge&(const std::string&));
   MOCK_CONST_METHOD0(gauges, std::list<GaugeSharedPtr>());
   MOCK_METHOD1(histogram, Histogram&(const std::string& name));
+  MOCK_METHOD1(latch, void(FlushSnapshot& snapshot));
 
   testing::NiceMock<MockCounter> counter_;
   std::vector<std::unique_ptr<MockHistogram>> histograms_;
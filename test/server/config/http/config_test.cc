@@ -4,15 +4,19 @@
 
 #include "common/config/well_known_names.h"
 #include "common/http/access_log/access_log_impl.h"
+#include "common/http/access_log/binary_access_log.h"
 #include "common/protobuf/protobuf.h"
 #include "common/protobuf/utility.h"
 
+#include "server/config/http/binary_access_log.h"
 #include "server/config/http/buffer.h"
+#include "server/config/http/cache.h"
 #include "server/config/http/dynamo.h"
 #include "server/config/http/fault.h"
 #include "server/config/http/file_access_log.h"
 #include "server/config/http/grpc_http1_bridge.h"
 #include "server/config/http/grpc_web.h"
+#include "server/config/http/gzip.h"
 #include "server/config/http/ip_tagging.h"
 #include "server/config/http/ratelimit.h"
 #include "server/config/http/router.h"
@@ -65,6 +69,67 @@ TEST(HttpFilterConfigTest, BadBufferFilterConfig) {
   EXPECT_THROW(factory.createFilterFactory(*json_config, "stats", context), Json::Exception);
 }
 
+TEST(HttpFilterConfigTest, GzipFilter) {
+  std::string json_string = R"EOF(
+  {
+    "compression_level" : 9,
+    "content_types" : ["text/html"]
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  GzipFilterConfig factory;
+  HttpFilterFactoryCb cb = factory.createFilterFactory(*json_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+TEST(HttpFilterConfigTest, BadGzipFilterConfig) {
+  std::string json_string = R"EOF(
+  {
+    "compression_level" : 0
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  GzipFilterConfig factory;
+  EXPECT_THROW(factory.createFilterFactory(*json_config, "stats", context), Json::Exception);
+}
+
+TEST(HttpFilterConfigTest, CacheFilter) {
+  std::string json_string = R"EOF(
+  {
+    "max_worker_bytes" : 1048576,
+    "max_shared_bytes" : 16777216,
+    "eviction" : "tinylfu"
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  CacheFilterConfig factory;
+  HttpFilterFactoryCb cb = factory.createFilterFactory(*json_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+TEST(HttpFilterConfigTest, BadCacheFilterConfig) {
+  std::string json_string = R"EOF(
+  {
+    "eviction" : "fifo"
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  CacheFilterConfig factory;
+  EXPECT_THROW(factory.createFilterFactory(*json_config, "stats", context), Json::Exception);
+}
+
 TEST(HttpFilterConfigTest, RateLimitFilter) {
   std::string json_string = R"EOF(
   {
@@ -313,6 +378,34 @@ TEST(AccessLogConfigTest, FileAccessLogTest) {
   EXPECT_NE(nullptr, dynamic_cast<Http::AccessLog::FileAccessLog*>(instance.get()));
 }
 
+TEST(AccessLogConfigTest, BinaryAccessLogTest) {
+  auto factory = Registry::FactoryRegistry<AccessLogInstanceFactory>::getFactory(
+      Config::AccessLogNames::get().BINARY);
+  ASSERT_NE(nullptr, factory);
+
+  ProtobufTypes::MessagePtr message = factory->createEmptyConfigProto();
+  ASSERT_NE(nullptr, message);
+
+  envoy::api::v2::filter::FileAccessLog file_access_log;
+  file_access_log.set_path("/dev/null");
+  file_access_log.set_format("REQ(:path), RESP(content-type)");
+  MessageUtil::jsonConvert(file_access_log, *message);
+
+  Http::AccessLog::FilterPtr filter;
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+
+  Http::AccessLog::InstanceSharedPtr instance =
+      factory->createAccessLogInstance(*message, std::move(filter), context);
+  EXPECT_NE(nullptr, instance);
+  EXPECT_NE(nullptr, dynamic_cast<Http::AccessLog::Binary::BinaryAccessLog*>(instance.get()));
+
+  file_access_log.set_format("%START_TIME%");
+  MessageUtil::jsonConvert(file_access_log, *message);
+  EXPECT_THROW_WITH_MESSAGE(
+      factory->createAccessLogInstance(*message, nullptr, context), EnvoyException,
+      "Binary access log header '%START_TIME%' is not REQ(name) or RESP(name)");
+}
+
 } // namespace Configuration
 } // namespace Server
 } // namespace Envoy
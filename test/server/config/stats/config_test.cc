@@ -4,8 +4,10 @@
 
 #include "common/config/well_known_names.h"
 #include "common/protobuf/utility.h"
+#include "common/stats/binary_sink.h"
 #include "common/stats/statsd.h"
 
+#include "server/config/stats/binary.h"
 #include "server/config/stats/statsd.h"
 
 #include "test/mocks/server/mocks.h"
@@ -86,6 +88,45 @@ TEST(StatsConfigTest, EmptyConfig) {
       "No tcp_cluster_name or address provided for envoy.statsd Stats::Sink config");
 }
 
+TEST_P(StatsConfigLoopbackTest, ValidUdpIpBinary) {
+  const std::string name = Config::StatsSinkNames::get().BINARY;
+
+  envoy::api::v2::StatsdSink sink_config;
+  envoy::api::v2::Address& address = *sink_config.mutable_address();
+  envoy::api::v2::SocketAddress& socket_address = *address.mutable_socket_address();
+  socket_address.set_protocol(envoy::api::v2::SocketAddress::UDP);
+  auto loopback_flavor = Network::Test::getCanonicalLoopbackAddress(GetParam());
+  socket_address.set_address(loopback_flavor->ip()->addressAsString());
+  socket_address.set_port_value(8125);
+
+  StatsSinkFactory* factory = Registry::FactoryRegistry<StatsSinkFactory>::getFactory(name);
+  ASSERT_NE(factory, nullptr);
+
+  ProtobufTypes::MessagePtr message = factory->createEmptyConfigProto();
+  MessageUtil::jsonConvert(sink_config, *message);
+
+  NiceMock<MockInstance> server;
+  Stats::SinkPtr sink = factory->createStatsSink(*message, server);
+  EXPECT_NE(sink, nullptr);
+  EXPECT_NE(dynamic_cast<Stats::Binary::UdpBinarySink*>(sink.get()), nullptr);
+}
+
+TEST(StatsConfigTest, BinaryRequiresAddress) {
+  const std::string name = Config::StatsSinkNames::get().BINARY;
+
+  envoy::api::v2::StatsdSink sink_config;
+  sink_config.set_tcp_cluster_name("fake_cluster");
+
+  StatsSinkFactory* factory = Registry::FactoryRegistry<StatsSinkFactory>::getFactory(name);
+  ASSERT_NE(factory, nullptr);
+
+  ProtobufTypes::MessagePtr message = factory->createEmptyConfigProto();
+  MessageUtil::jsonConvert(sink_config, *message);
+  NiceMock<MockInstance> server;
+  EXPECT_THROW_WITH_MESSAGE(factory->createStatsSink(*message, server), EnvoyException,
+                            "No address provided for envoy.binary_stats Stats::Sink config");
+}
+
 } // namespace Configuration
 } // namespace Server
 } // namespace Envoy
@@ -0,0 +1,90 @@
+#include <cstdint>
+
+#include "common/network/address_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "server/connection_balancer_impl.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::_;
+
+namespace Envoy {
+namespace Server {
+
+class ConnectionBalancerImplTest : public testing::Test {
+public:
+  ConnectionBalancerImplTest() : balancer_(runtime_, "listener.foo.connection_balancing", stats_) {
+    ON_CALL(runtime_.snapshot_, featureEnabled("listener.foo.connection_balancing", 0))
+        .WillByDefault(Return(true));
+    balancer_.registerHandler(handler_a_);
+    balancer_.registerHandler(handler_b_);
+    balancer_.registerHandler(handler_c_);
+  }
+
+  bool rebalance(Network::BalancedConnectionHandler& current_handler) {
+    return balancer_.rebalance(current_handler, 10, remote_address_, local_address_, false);
+  }
+
+  NiceMock<Runtime::MockLoader> runtime_;
+  Stats::IsolatedStoreImpl stats_;
+  ConnectionBalancerImpl balancer_;
+  NiceMock<Network::MockBalancedConnectionHandler> handler_a_;
+  NiceMock<Network::MockBalancedConnectionHandler> handler_b_;
+  NiceMock<Network::MockBalancedConnectionHandler> handler_c_;
+  Network::Address::InstanceConstSharedPtr remote_address_{
+      new Network::Address::Ipv4Instance("10.0.0.1", 5000)};
+  Network::Address::InstanceConstSharedPtr local_address_{
+      new Network::Address::Ipv4Instance("10.0.0.2", 80)};
+};
+
+TEST_F(ConnectionBalancerImplTest, HandOffToLeastLoaded) {
+  ON_CALL(handler_a_, numConnections()).WillByDefault(Return(10));
+  ON_CALL(handler_b_, numConnections()).WillByDefault(Return(7));
+  ON_CALL(handler_c_, numConnections()).WillByDefault(Return(3));
+
+  EXPECT_CALL(handler_a_, post(_, _, _, _)).Times(0);
+  EXPECT_CALL(handler_c_, post(10, remote_address_, local_address_, false));
+  EXPECT_TRUE(rebalance(handler_a_));
+  EXPECT_EQ(1UL, stats_.counter("downstream_cx_handoff").value());
+}
+
+TEST_F(ConnectionBalancerImplTest, KeepOnLeastLoaded) {
+  // Ties stay with the accepting handler.
+  ON_CALL(handler_a_, numConnections()).WillByDefault(Return(3));
+  ON_CALL(handler_b_, numConnections()).WillByDefault(Return(7));
+  ON_CALL(handler_c_, numConnections()).WillByDefault(Return(3));
+
+  EXPECT_CALL(handler_c_, post(_, _, _, _)).Times(0);
+  EXPECT_FALSE(rebalance(handler_a_));
+  EXPECT_EQ(0UL, stats_.counter("downstream_cx_handoff").value());
+}
+
+TEST_F(ConnectionBalancerImplTest, Disabled) {
+  ON_CALL(runtime_.snapshot_, featureEnabled("listener.foo.connection_balancing", 0))
+      .WillByDefault(Return(false));
+  ON_CALL(handler_a_, numConnections()).WillByDefault(Return(10));
+
+  EXPECT_CALL(handler_b_, post(_, _, _, _)).Times(0);
+  EXPECT_FALSE(rebalance(handler_a_));
+}
+
+TEST_F(ConnectionBalancerImplTest, Unregister) {
+  ON_CALL(handler_a_, numConnections()).WillByDefault(Return(10));
+  ON_CALL(handler_b_, numConnections()).WillByDefault(Return(7));
+  ON_CALL(handler_c_, numConnections()).WillByDefault(Return(3));
+  balancer_.unregisterHandler(handler_c_);
+
+  EXPECT_CALL(handler_c_, post(_, _, _, _)).Times(0);
+  EXPECT_CALL(handler_b_, post(10, _, _, false));
+  EXPECT_TRUE(rebalance(handler_a_));
+}
+
+} // namespace Server
+} // namespace Envoy
@@ -1,3 +1,8 @@
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+
 #include "server/hot_restart_impl.h"
 
 #include "test/mocks/api/mocks.h"
@@ -35,6 +40,34 @@ public:
     hot_restart_->drainParentListeners();
   }
 
+  // Back additional shared memory regions with buffers. The region opened by setup() is fd 0.
+  void fakeRegions() {
+    EXPECT_CALL(os_sys_calls_, shmUnlink(_)).WillRepeatedly(Return(0));
+    EXPECT_CALL(os_sys_calls_, shmOpen(_, _, _))
+        .WillRepeatedly(Invoke([this](const char* name, int, mode_t) -> int {
+          if (std::string(name) == "/envoy_shared_memory_0") {
+            return 0;
+          }
+          auto it = region_fds_.find(name);
+          if (it != region_fds_.end()) {
+            return it->second;
+          }
+          const int fd = 100 + region_fds_.size();
+          region_fds_[name] = fd;
+          return fd;
+        }));
+    EXPECT_CALL(os_sys_calls_, ftruncate(_, _))
+        .WillRepeatedly(Invoke([this](int fd, off_t size) -> int {
+          regions_[fd].resize(size);
+          return 0;
+        }));
+    EXPECT_CALL(os_sys_calls_, mmap(_, _, _, _, _, _))
+        .WillRepeatedly(Invoke([this](void*, size_t, int, int, int fd, off_t) -> void* {
+          return fd == 0 ? buffer_.data() : regions_[fd].data();
+        }));
+    EXPECT_CALL(os_sys_calls_, close(_)).WillRepeatedly(Return(0));
+  }
+
   void TearDown() {
     // Configure it back so that later tests don't get the wonky values
     // used here
@@ -45,6 +78,8 @@ public:
   Api::MockOsSysCalls os_sys_calls_;
   NiceMock<MockOptions> options_;
   std::vector<uint8_t> buffer_;
+  std::map<std::string, int> region_fds_;
+  std::map<int, std::vector<uint8_t>> regions_;
   std::unique_ptr<HotRestartImpl> hot_restart_;
 };
 
@@ -84,12 +119,112 @@ TEST_F(HotRestartImplTest, allocFail) {
   EXPECT_CALL(options_, maxStats()).WillRepeatedly(Return(2));
   setup();
 
+  // No more shared memory can be added.
+  EXPECT_CALL(os_sys_calls_, shmUnlink(_));
+  EXPECT_CALL(os_sys_calls_, shmOpen(_, _, _)).WillOnce(Return(-1));
+
   Stats::RawStatData* s1 = hot_restart_->alloc("1");
   Stats::RawStatData* s2 = hot_restart_->alloc("2");
   Stats::RawStatData* s3 = hot_restart_->alloc("3");
   EXPECT_NE(s1, nullptr);
   EXPECT_NE(s2, nullptr);
   EXPECT_EQ(s3, nullptr);
+
+  // Freed slots are reused.
+  hot_restart_->free(*s1);
+  s3 = hot_restart_->alloc("3");
+  EXPECT_EQ(s1, s3);
+  EXPECT_TRUE(s3->matches("3"));
+}
+
+// Allocate and free stats at random, checking that the hash index keeps finding every live stat
+// while entries are removed from the middle of probe sequences.
+TEST_F(HotRestartImplTest, allocFreeChurn) {
+  const uint64_t max_stats = 64;
+  EXPECT_CALL(options_, maxStats()).WillRepeatedly(Return(max_stats));
+  setup();
+  EXPECT_CALL(os_sys_calls_, shmUnlink(_)).WillRepeatedly(Return(0));
+  EXPECT_CALL(os_sys_calls_, shmOpen(_, _, _)).WillRepeatedly(Return(-1));
+
+  std::mt19937 random(1);
+  std::map<std::string, Stats::RawStatData*> live;
+  for (uint32_t i = 0; i < 20000; i++) {
+    const std::string name = fmt::format("cluster.c{}.upstream_rq_total", random() % 100);
+    auto it = live.find(name);
+    if (it != live.end()) {
+      hot_restart_->free(*it->second);
+      live.erase(it);
+    } else {
+      Stats::RawStatData* stat = hot_restart_->alloc(name);
+      if (live.size() == max_stats) {
+        EXPECT_EQ(nullptr, stat);
+        continue;
+      }
+      ASSERT_NE(nullptr, stat);
+      EXPECT_TRUE(stat->matches(name));
+      EXPECT_EQ(1, stat->ref_count_);
+      live[name] = stat;
+    }
+
+    if (i % 100 == 0) {
+      std::set<Stats::RawStatData*> used;
+      for (auto& stat : live) {
+        EXPECT_EQ(stat.second, hot_restart_->alloc(stat.first));
+        EXPECT_EQ(2, stat.second->ref_count_);
+        hot_restart_->free(*stat.second);
+        EXPECT_TRUE(used.insert(stat.second).second);
+      }
+    }
+  }
+}
+
+// Stats that don't fit in --max-stats go to additional shared memory regions, which a hot
+// restarted process maps at startup and its parent maps when it needs them.
+TEST_F(HotRestartImplTest, statSegments) {
+  EXPECT_CALL(options_, maxStats()).WillRepeatedly(Return(4));
+  setup();
+  fakeRegions();
+
+  // 4 + 4 + 8 stats.
+  std::vector<Stats::RawStatData*> stats;
+  for (uint32_t i = 0; i < 16; i++) {
+    stats.push_back(hot_restart_->alloc(fmt::format("stat{}", i)));
+    ASSERT_NE(nullptr, stats.back());
+  }
+  EXPECT_EQ(2U, regions_.size());
+  EXPECT_EQ(16U, std::set<Stats::RawStatData*>(stats.begin(), stats.end()).size());
+
+  EXPECT_CALL(options_, restartEpoch()).WillRepeatedly(Return(1));
+  EXPECT_CALL(os_sys_calls_, bind(_, _, _));
+  HotRestartImpl hot_restart2(options_, os_sys_calls_);
+  for (uint32_t i = 0; i < 16; i++) {
+    EXPECT_EQ(stats[i], hot_restart2.alloc(fmt::format("stat{}", i)));
+    EXPECT_EQ(2, stats[i]->ref_count_);
+  }
+
+  // The child adds a region, the parent finds the stat there.
+  Stats::RawStatData* stat16 = hot_restart2.alloc("stat16");
+  EXPECT_EQ(3U, regions_.size());
+  EXPECT_EQ(stat16, hot_restart_->alloc("stat16"));
+
+  // Slots in additional regions are reused.
+  hot_restart_->free(*stats[15]);
+  hot_restart2.free(*stats[15]);
+  EXPECT_EQ(stats[15], hot_restart_->alloc("stat17"));
+  EXPECT_TRUE(stats[15]->matches("stat17"));
+}
+
+TEST_F(HotRestartImplTest, statSegmentsLimit) {
+  EXPECT_CALL(options_, maxStats()).WillRepeatedly(Return(1));
+  setup();
+  fakeRegions();
+
+  // 1 + 1 + 2 + ... + 64 stats.
+  for (uint32_t i = 0; i < 128; i++) {
+    EXPECT_NE(nullptr, hot_restart_->alloc(fmt::format("stat{}", i)));
+  }
+  EXPECT_EQ(nullptr, hot_restart_->alloc("stat128"));
+  EXPECT_EQ(SharedMemory::MAX_STAT_SEGMENTS - 1, regions_.size());
 }
 
 // Because the shared memory is managed manually, make sure it meets
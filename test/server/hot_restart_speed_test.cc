@@ -0,0 +1,100 @@
+// Allocates up to 100k stats in the hot restart shared memory segment, then looks all of them up
+// again the way a hot restarted process does, and frees them. For comparison, a sample of the
+// lookups is also done with a linear scan of the slots, which is what allocation used to do.
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "server/hot_restart_impl.h"
+
+#include "test/mocks/api/mocks.h"
+#include "test/mocks/server/mocks.h"
+
+#include "fmt/format.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::_;
+
+namespace Envoy {
+namespace Server {
+namespace {
+
+template <class Function> double nsPerOp(uint64_t ops, Function f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / ops;
+}
+
+void run(uint64_t num_stats) {
+  NiceMock<MockOptions> options;
+  ON_CALL(options, maxStats()).WillByDefault(Return(num_stats));
+  Stats::RawStatData::configureForTestsOnly(options);
+
+  std::vector<uint8_t> buffer;
+  NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  ON_CALL(os_sys_calls, ftruncate(_, _)).WillByDefault(testing::Invoke([&](int, off_t size) {
+    buffer.resize(size);
+    return 0;
+  }));
+  ON_CALL(os_sys_calls, mmap(_, _, _, _, _, _))
+      .WillByDefault(testing::InvokeWithoutArgs([&]() { return buffer.data(); }));
+  HotRestartImpl hot_restart(options, os_sys_calls);
+
+  std::vector<std::string> names;
+  for (uint64_t i = 0; i < num_stats; i++) {
+    names.push_back(fmt::format("cluster.cluster_{}.upstream_rq_{}", i / 100, i % 100));
+  }
+
+  std::vector<Stats::RawStatData*> stats(num_stats);
+  const double alloc_ns = nsPerOp(num_stats, [&]() -> void {
+    for (uint64_t i = 0; i < num_stats; i++) {
+      stats[i] = hot_restart.alloc(names[i]);
+    }
+  });
+
+  const double lookup_ns = nsPerOp(num_stats, [&]() -> void {
+    for (uint64_t i = 0; i < num_stats; i++) {
+      RELEASE_ASSERT(hot_restart.alloc(names[i]) == stats[i]);
+    }
+  });
+
+  const uint64_t samples = 1000;
+  const double linear_ns = nsPerOp(samples, [&]() -> void {
+    for (uint64_t i = 0; i < samples; i++) {
+      const std::string& name = names[(i * 7919) % num_stats];
+      for (Stats::RawStatData* stat : stats) {
+        if (stat->matches(name)) {
+          break;
+        }
+      }
+    }
+  });
+
+  const double free_ns = nsPerOp(num_stats * 2, [&]() -> void {
+    for (uint64_t i = 0; i < num_stats; i++) {
+      hot_restart.free(*stats[i]);
+      hot_restart.free(*stats[i]);
+    }
+  });
+
+  std::cout << fmt::format("stats={} alloc={:.1f}ns/op lookup={:.1f}ns/op free={:.1f}ns/op "
+                           "linear_lookup={:.1f}ns/op",
+                           num_stats, alloc_ns, lookup_ns, free_ns, linear_ns)
+            << std::endl;
+}
+
+} // namespace
+} // namespace Server
+} // namespace Envoy
+
+int main() {
+  for (uint64_t num_stats : {1000, 10000, 100000}) {
+    Envoy::Server::run(num_stats);
+  }
+  return 0;
+}
@@ -146,5 +146,25 @@ TEST_P(AdminInstanceTest, CustomHandler) {
   EXPECT_EQ(Http::Code::Accepted, admin_.runCallback("/foo/bar", response));
 }
 
+TEST_P(AdminInstanceTest, Dispatchers) {
+  Stats::Store& store = server_.stats_store_;
+  store.counter("server.dispatcher.loop_iterations").add(10);
+  store.counter("server.dispatcher.loop_events").add(15);
+  store.counter("server.dispatcher.loop_busy_us").add(100);
+  store.counter("server.dispatcher.loop_poll_wait_us").add(900);
+  store.gauge("server.dispatcher.loop_utilization").set(10);
+  store.counter("server.worker_0.dispatcher.loop_iterations").add(4);
+  store.counter("server.worker_0.dispatcher.loop_events").add(20);
+  store.gauge("server.worker_0.dispatcher.loop_utilization").set(75);
+
+  Buffer::OwnedImpl response;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/dispatchers", response));
+  EXPECT_EQ("server: utilization: 10%, iterations: 10, events_per_iteration: 1.5, busy_us: 100, "
+            "poll_wait_us: 900\n"
+            "server.worker_0: utilization: 75%, iterations: 4, events_per_iteration: 5.0, "
+            "busy_us: 0, poll_wait_us: 0\n",
+            TestUtility::bufferToString(response));
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -12,7 +12,7 @@
 #include "gtest/gtest.h"
 
 using testing::InSequence;
-using testing::Property;
+using testing::Invoke;
 using testing::SaveArg;
 using testing::StrictMock;
 using testing::_;
@@ -25,16 +25,30 @@ TEST(ServerInstanceUtil, flushHelper) {
 
   Stats::IsolatedStoreImpl store;
   store.counter("hello").inc();
+  store.counter("unchanged");
   store.gauge("world").set(5);
-  std::unique_ptr<Stats::MockSink> sink(new StrictMock<Stats::MockSink>());
-  EXPECT_CALL(*sink, beginFlush());
-  EXPECT_CALL(*sink, flushCounter(Property(&Stats::Metric::name, "hello"), 1));
-  EXPECT_CALL(*sink, flushGauge(Property(&Stats::Metric::name, "world"), 5));
-  EXPECT_CALL(*sink, endFlush());
+  Stats::MockSink* sink = new StrictMock<Stats::MockSink>();
+  EXPECT_CALL(*sink, flush(_)).WillOnce(Invoke([](const Stats::FlushSnapshot& snapshot) -> void {
+    ASSERT_EQ(1U, snapshot.counters_.size());
+    EXPECT_EQ("hello", snapshot.counters_[0].first->name());
+    EXPECT_EQ(1U, snapshot.counters_[0].second);
+    ASSERT_EQ(1U, snapshot.gauges_.size());
+    EXPECT_EQ("world", snapshot.gauges_[0].first->name());
+    EXPECT_EQ(5U, snapshot.gauges_[0].second);
+  }));
 
   std::list<Stats::SinkPtr> sinks;
-  sinks.emplace_back(std::move(sink));
-  InstanceUtil::flushCountersAndGaugesToSinks(sinks, store);
+  sinks.emplace_back(sink);
+  Stats::FlushSnapshot snapshot;
+  InstanceUtil::flushCountersAndGaugesToSinks(sinks, store, snapshot);
+  EXPECT_TRUE(snapshot.counters_.empty());
+
+  // Nothing changed since the previous flush.
+  EXPECT_CALL(*sink, flush(_)).WillOnce(Invoke([](const Stats::FlushSnapshot& snapshot) -> void {
+    EXPECT_TRUE(snapshot.counters_.empty());
+    EXPECT_EQ(1U, snapshot.gauges_.size());
+  }));
+  InstanceUtil::flushCountersAndGaugesToSinks(sinks, store, snapshot);
 }
 
 class RunHelperTest : public testing::Test {
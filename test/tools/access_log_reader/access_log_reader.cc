@@ -0,0 +1,199 @@
+// NOLINT(namespace-envoy)
+//
+// Reader for the binary access log. Prints every record as one JSON object per line on stdout. It
+// reads a file written by the log, or stdin if the file is -, or binds a unix datagram socket and
+// prints the records sent to it, e.g.:
+//
+//   access_log_reader /var/log/envoy/access.bin
+//   access_log_reader unix:///var/run/envoy/access_log.sock
+//
+// Malformed records are reported on stderr. A file is read to the end; a truncated record at the
+// end is reported as well, since it may still be in the middle of being written.
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/http/access_log/binary_access_log.h"
+
+using Envoy::Http::AccessLog::Binary::BinaryAccessLog;
+using Envoy::Http::AccessLog::Binary::Record;
+using Envoy::Http::AccessLog::Binary::RecordDecoder;
+using Envoy::Http::AccessLog::Binary::RecordEncoder;
+using Envoy::Http::Protocol;
+
+namespace {
+
+// Records hold at most the headers of one request and its response, which the codecs limit to far
+// less than this. A larger length comes from a corrupt file, so nothing is allocated for it.
+const uint32_t MAX_RECORD_SIZE = 1024 * 1024;
+
+void printString(const std::string& value) {
+  std::cout << '"';
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      std::cout << '\\' << c;
+    } else if (static_cast<uint8_t>(c) < 0x20) {
+      char escaped[7];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      std::cout << escaped;
+    } else {
+      std::cout << c;
+    }
+  }
+  std::cout << '"';
+}
+
+void printHeaders(const std::vector<std::pair<std::string, std::string>>& headers) {
+  std::cout << "{";
+  for (size_t i = 0; i < headers.size(); i++) {
+    std::cout << (i == 0 ? "" : ",");
+    printString(headers[i].first);
+    std::cout << ":";
+    printString(headers[i].second);
+  }
+  std::cout << "}";
+}
+
+void print(const Record& record) {
+  static const char* const protocols[] = {"HTTP/1.0", "HTTP/1.1", "HTTP/2"};
+  std::cout << "{\"start_time_us\":" << record.start_time_us_
+            << ",\"request_received_duration_us\":" << record.request_received_duration_us_
+            << ",\"response_received_duration_us\":" << record.response_received_duration_us_
+            << ",\"duration_us\":" << record.duration_us_
+            << ",\"bytes_received\":" << record.bytes_received_
+            << ",\"bytes_sent\":" << record.bytes_sent_
+            << ",\"response_code\":" << record.response_code_
+            << ",\"response_flags\":" << record.response_flags_ << ",\"protocol\":\""
+            << protocols[static_cast<uint8_t>(record.protocol_)] << "\",\"health_check\":"
+            << (record.health_check_ ? "true" : "false") << ",\"upstream_host\":";
+  printString(record.upstream_host_);
+  std::cout << ",\"upstream_cluster\":";
+  printString(record.upstream_cluster_);
+  std::cout << ",\"downstream_address\":";
+  printString(record.downstream_address_);
+  std::cout << ",\"request_headers\":";
+  printHeaders(record.request_headers_);
+  std::cout << ",\"response_headers\":";
+  printHeaders(record.response_headers_);
+  std::cout << "}\n";
+}
+
+bool decodeAndPrint(const uint8_t* data, size_t size) {
+  Record record;
+  if (!RecordDecoder::decode(data, size, record)) {
+    std::cerr << "malformed record of " << size << " bytes" << std::endl;
+    return false;
+  }
+  print(record);
+  return true;
+}
+
+int readStream(std::istream& input) {
+  std::vector<uint8_t> record;
+  while (true) {
+    record.resize(RecordEncoder::HEADER_SIZE);
+    input.read(reinterpret_cast<char*>(record.data()), record.size());
+    if (input.gcount() == 0) {
+      return EXIT_SUCCESS;
+    }
+
+    const uint32_t length = input.gcount() == static_cast<std::streamsize>(record.size())
+                                ? RecordDecoder::recordLength(record.data())
+                                : 0;
+    if (length > MAX_RECORD_SIZE) {
+      std::cerr << "record of " << length << " bytes is larger than " << MAX_RECORD_SIZE
+                << " bytes" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (length >= RecordEncoder::HEADER_SIZE) {
+      record.resize(length);
+      input.read(reinterpret_cast<char*>(record.data() + RecordEncoder::HEADER_SIZE),
+                 length - RecordEncoder::HEADER_SIZE);
+    }
+    if (length < RecordEncoder::HEADER_SIZE || !input) {
+      std::cerr << "truncated record at the end of the input" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // The length of a malformed record can't be trusted to find the next one.
+    if (!decodeAndPrint(record.data(), record.size())) {
+      return EXIT_FAILURE;
+    }
+  }
+}
+
+int readSocket(const std::string& path) {
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  if (path.size() >= sizeof(address.sun_path)) {
+    std::cerr << "socket path too long: " << path << std::endl;
+    return EXIT_FAILURE;
+  }
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  unlink(path.c_str());
+  const int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (fd == -1 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1) {
+    std::cerr << "unable to bind to " << path << ": " << strerror(errno) << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<uint8_t> datagram;
+  while (true) {
+    // Peek at the size of the next datagram first, so that a large one is not truncated.
+    ssize_t rc = recv(fd, nullptr, 0, MSG_PEEK | MSG_TRUNC);
+    if (rc >= 0) {
+      datagram.resize(std::max<size_t>(rc, 1));
+      rc = recv(fd, datagram.data(), datagram.size(), 0);
+    }
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      std::cerr << "recv failed: " << strerror(errno) << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    decodeAndPrint(datagram.data(), rc);
+    std::cout << std::flush;
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " <file, - for stdin, or unix://<socket path>>"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::string path = argv[1];
+  if (path.compare(0, BinaryAccessLog::UNIX_SOCKET_PREFIX.size(),
+                   BinaryAccessLog::UNIX_SOCKET_PREFIX) == 0) {
+    return readSocket(path.substr(BinaryAccessLog::UNIX_SOCKET_PREFIX.size()));
+  }
+  if (path == "-") {
+    return readStream(std::cin);
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    std::cerr << "unable to open " << path << std::endl;
+    return EXIT_FAILURE;
+  }
+  return readStream(file);
+}
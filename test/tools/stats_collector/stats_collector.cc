@@ -0,0 +1,88 @@
+// NOLINT(namespace-envoy)
+//
+// Local collector for the binary stats sink. Listens on a UDP port and prints every metric it
+// receives on stdout in statsd line format, e.g.:
+//
+//   stats_collector 8125 127.0.0.1
+//   cluster.foo.upstream_rq_total:12|c
+//
+// Malformed datagrams are reported on stderr.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/stats/binary_sink.h"
+
+using Envoy::Stats::Binary::FrameDecoder;
+using Envoy::Stats::Binary::MetricType;
+
+int main(int argc, char* argv[]) {
+  if (argc < 2 || argc > 3) {
+    std::cerr << "usage: " << argv[0] << " <port> [<IPv4 or IPv6 address, default ::>]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const uint16_t port = static_cast<uint16_t>(std::atoi(argv[1]));
+  const std::string address = argc == 3 ? argv[2] : "::";
+
+  sockaddr_storage storage;
+  memset(&storage, 0, sizeof(storage));
+  socklen_t length;
+  int fd;
+  sockaddr_in* v4 = reinterpret_cast<sockaddr_in*>(&storage);
+  sockaddr_in6* v6 = reinterpret_cast<sockaddr_in6*>(&storage);
+  if (inet_pton(AF_INET, address.c_str(), &v4->sin_addr) == 1) {
+    v4->sin_family = AF_INET;
+    v4->sin_port = htons(port);
+    length = sizeof(sockaddr_in);
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+  } else if (inet_pton(AF_INET6, address.c_str(), &v6->sin6_addr) == 1) {
+    v6->sin6_family = AF_INET6;
+    v6->sin6_port = htons(port);
+    length = sizeof(sockaddr_in6);
+    fd = socket(AF_INET6, SOCK_DGRAM, 0);
+  } else {
+    std::cerr << "invalid address: " << address << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (fd == -1 || bind(fd, reinterpret_cast<sockaddr*>(&storage), length) == -1) {
+    std::cerr << "unable to bind to " << address << " port " << port << ": " << strerror(errno)
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const FrameDecoder::MetricCb print = [](MetricType type, const std::string& name,
+                                          uint64_t value) -> void {
+    static const char* const suffixes[] = {"c", "g", "ms"};
+    std::cout << name << ":" << value << "|" << suffixes[static_cast<uint8_t>(type)] << "\n";
+  };
+
+  std::vector<uint8_t> datagram(65536);
+  while (true) {
+    const ssize_t rc = recv(fd, datagram.data(), datagram.size(), 0);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      std::cerr << "recv failed: " << strerror(errno) << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if (!FrameDecoder::decode(datagram.data(), rc, print)) {
+      std::cerr << "malformed datagram of " << rc << " bytes" << std::endl;
+    }
+    std::cout << std::flush;
+  }
+}